@@ -51,6 +51,18 @@
 #define FARMHASH_ASSUME_AVX 1
 #endif
 
+// HyScan: farmhashxo::Hash64 is built in several variants, the best one for
+// the current CPU is selected at load time.  All variants are compiled from the
+// same portable code, so the result does not depend on the CPU.
+#if !defined(FARMHASH_TARGET_CLONES)
+#if defined(__GNUC__) && !defined(__clang__) && defined(__linux__) && \
+    (defined(__x86_64) || defined(__x86_64__))
+#define FARMHASH_TARGET_CLONES __attribute__((target_clones("arch=haswell", "default")))
+#else
+#define FARMHASH_TARGET_CLONES
+#endif
+#endif
+
 #if !defined(FARMHASH_CAN_USE_CXX11) && defined(LANG_CXX11)
 #define FARMHASH_CAN_USE_CXX11 1
 #else
@@ -729,6 +741,7 @@ STATIC_INLINE uint64_t HashLen65to96(const char *s, size_t len) {
   return (h2 * 9 + (h0 >> 17) + (h1 >> 21)) * mul1;
 }
 
+FARMHASH_TARGET_CLONES
 uint64_t Hash64(const char *s, size_t len) {
   if (len <= 32) {
     if (len <= 16) {
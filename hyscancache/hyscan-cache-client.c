@@ -40,16 +40,58 @@
  * HyScanCacheClient реализация интерфейса #HyScanCache предназначенная для
  * работы с сервером кэширования #HyScanCacheServer.
  *
- * Создать клиента системы кэширования можно с помощью функции
- * #hyscan_cache_client_new.
+ * Создать клиента системы кэширования можно с помощью функций
+ * #hyscan_cache_client_new и #hyscan_cache_client_new_full.
+ *
+ * Клиент может использоваться из нескольких потоков одновременно. Запросы
+ * передаются серверу через пул каналов RPC, размер которого задаётся при
+ * создании клиента. Каждому потоку назначается свой канал, поэтому потоки
+ * не ожидают друг друга, пока число потоков не превышает размер пула.
+ * Каналы подключаются к серверу при первом использовании. Если подключить
+ * дополнительный канал не удалось, например из-за ограничения числа
+ * клиентов сервера, используется основной канал.
+ *
+ * Функцией #hyscan_cache_client_set_near_cache можно включить ближний кэш
+ * в памяти процесса. Объекты, прочитанные с сервера, сохраняются в нём и
+ * при повторном чтении не запрашиваются у сервера. Сервер не уведомляет
+ * клиентов об изменении объектов, поэтому объект хранится в ближнем кэше
+ * не дольше заданного времени аренды: изменения, сделанные другими
+ * клиентами, становятся видны не позднее её окончания. Объекты, изменяемые
+ * через этот клиент, удаляются из ближнего кэша сразу. Чтение части данных
+ * объекта и запросы информации об объектах всегда выполняются сервером.
+ *
+ * Функции #hyscan_cache_client_get_data и #hyscan_cache_client_get_datai
+ * считывают данные объекта сразу в память вызывающей стороны, исключая
+ * копирование через промежуточный #HyScanBuffer.
+ *
+ * Объекты, не помещающиеся в одно сообщение RPC, передаются частями. При
+ * записи сервер собирает объект из частей и помещает его в кэш только после
+ * получения всех данных. При чтении сервер сохраняет копию объекта, поэтому
+ * его изменение во время передачи не приводит к чтению смеси данных.
+ *
+ * Функции #hyscan_cache_set_batch и #hyscan_cache_get_batch передают
+ * серверу сразу несколько объектов, упакованных в одно сообщение RPC, и
+ * выполняются за один обмен с сервером на каждый пакет. Объекты, размер
+ * которых превышает размер пакета, передаются по одному.
+ *
+ * Статистика, возвращаемая функцией #hyscan_cache_get_stats, собирается на
+ * стороне клиента и учитывает только его запросы, включая время передачи
+ * данных. Объём используемой памяти и число объектов в ней не заполняются.
+ * Статистику работы сервера можно узнать функцией
+ * #hyscan_cache_client_get_server_stats.
  */
 
 #include "hyscan-cache-client.h"
 #include "hyscan-cache-rpc.h"
+#include "hyscan-cache-counters.h"
+#include "hyscan-cache-near.h"
+#include "hyscan-hash.h"
 
 #include <string.h>
 #include <urpc-client.h>
 
+#define MAX_CHANNELS       64                  /* Максимальный размер пула каналов. */
+
 #define hyscan_cache_client_lock_error()   do { \
                                              g_warning ("%s: can't lock rpc transport to '%s'", __FUNCTION__, priv->uri); \
                                              goto exit; \
@@ -73,14 +115,24 @@
 enum
 {
   PROP_O,
-  PROP_URI
+  PROP_URI,
+  PROP_N_CHANNELS
 };
 
 /* Внутренние данные объекта. */
 struct _HyScanCacheClientPrivate
 {
   gchar               *uri;
-  uRpcClient          *rpc;
+  uRpcClient          *rpc;                    /* Основной канал RPC. */
+
+  guint                n_channels;             /* Размер пула каналов. */
+  uRpcClient         **channels;               /* Пул каналов RPC. */
+  gboolean            *failed;                 /* Признаки ошибки подключения каналов. */
+  GMutex               pool_lock;              /* Блокировка подключения каналов. */
+
+  HyScanCacheNear     *ncache;                 /* Ближний кэш. */
+
+  HyScanCacheCounters *counters;               /* Счётчики статистики. */
 };
 
 static void    hyscan_cache_client_interface_init      (HyScanCacheInterface *iface);
@@ -91,6 +143,13 @@ static void    hyscan_cache_client_set_property        (GObject              *ob
 static void    hyscan_cache_client_object_constructed  (GObject              *object);
 static void    hyscan_cache_client_object_finalize     (GObject              *object);
 
+static uRpcClient *hyscan_cache_client_connect         (const gchar          *uri);
+static uRpcClient *hyscan_cache_client_channel         (HyScanCacheClientPrivate *priv);
+
+/* Порядковый номер потока для выбора канала. */
+static GPrivate hyscan_cache_client_thread_id;
+static volatile gint hyscan_cache_client_n_threads = 0;
+
 G_DEFINE_TYPE_WITH_CODE (HyScanCacheClient, hyscan_cache_client, G_TYPE_OBJECT,
                          G_ADD_PRIVATE (HyScanCacheClient)
                          G_IMPLEMENT_INTERFACE (HYSCAN_TYPE_CACHE, hyscan_cache_client_interface_init));
@@ -107,6 +166,11 @@ hyscan_cache_client_class_init (HyScanCacheClientClass *klass)
   g_object_class_install_property (object_class, PROP_URI,
                                    g_param_spec_string ("uri", "Uri", "HyScan cache uri", NULL,
                                                         G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
+
+  g_object_class_install_property (object_class, PROP_N_CHANNELS,
+                                   g_param_spec_uint ("n-channels", "Channels", "Number of rpc channels",
+                                                      1, MAX_CHANNELS, 1,
+                                                      G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
 }
 
 static void
@@ -129,6 +193,10 @@ hyscan_cache_client_set_property (GObject      *object,
       cachec->priv->uri = g_value_dup_string (value);
       break;
 
+    case PROP_N_CHANNELS:
+      cachec->priv->n_channels = g_value_get_uint (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -140,31 +208,70 @@ hyscan_cache_client_object_constructed (GObject *object)
 {
   HyScanCacheClient *cachec = HYSCAN_CACHE_CLIENT (object);
   HyScanCacheClientPrivate *priv = cachec->priv;
+
+  priv->counters = hyscan_cache_counters_new (HYSCAN_CACHE_COUNTER_LAST);
+  priv->ncache = hyscan_cache_near_new ();
+
+  /* Пул каналов, основной канал подключается сразу. */
+  g_mutex_init (&priv->pool_lock);
+  priv->channels = g_new0 (uRpcClient *, priv->n_channels);
+  priv->failed = g_new0 (gboolean, priv->n_channels);
+
+  priv->rpc = hyscan_cache_client_connect (priv->uri);
+  priv->channels[0] = priv->rpc;
+}
+
+static void
+hyscan_cache_client_object_finalize (GObject *object)
+{
+  HyScanCacheClient *cachec = HYSCAN_CACHE_CLIENT (object);
+  HyScanCacheClientPrivate *priv = cachec->priv;
+  guint i;
+
+  for (i = 0; i < priv->n_channels; i++)
+    if (priv->channels[i] != NULL)
+      urpc_client_destroy (priv->channels[i]);
+
+  g_free (priv->channels);
+  g_free (priv->failed);
+  g_mutex_clear (&priv->pool_lock);
+
+  g_free (priv->uri);
+  hyscan_cache_counters_free (priv->counters);
+  hyscan_cache_near_free (priv->ncache);
+
+  G_OBJECT_CLASS (hyscan_cache_client_parent_class)->finalize (object);
+}
+
+/* Функция подключается к RPC серверу и проверяет его версию. */
+static uRpcClient *
+hyscan_cache_client_connect (const gchar *uri)
+{
+  uRpcClient *rpc;
   uRpcData *urpc_data;
   guint32 version;
 
-  /* Подключаемся к RPC серверу. */
-  priv->rpc = urpc_client_create (priv->uri, URPC_MAX_DATA_SIZE, URPC_DEFAULT_DATA_TIMEOUT);
-  if (priv->rpc == NULL)
-    return;
+  rpc = urpc_client_create (uri, URPC_MAX_DATA_SIZE, URPC_DEFAULT_DATA_TIMEOUT);
+  if (rpc == NULL)
+    return NULL;
 
-  if (urpc_client_connect (priv->rpc) != 0)
+  if (urpc_client_connect (rpc) != 0)
     {
-      g_warning ("HyScanCacheClient: can't connect to '%s'", priv->uri);
+      g_warning ("HyScanCacheClient: can't connect to '%s'", uri);
       goto fail;
     }
 
   /* Проверка версии сервера кэша данных. */
-  urpc_data = urpc_client_lock (priv->rpc);
+  urpc_data = urpc_client_lock (rpc);
   if (urpc_data == NULL)
     {
-      g_warning ("HyScanCacheClient: can't lock rpc transport to '%s'", priv->uri);
+      g_warning ("HyScanCacheClient: can't lock rpc transport to '%s'", uri);
       goto fail;
     }
 
-  if (urpc_client_exec (priv->rpc, HYSCAN_CACHE_RPC_PROC_VERSION) != URPC_STATUS_OK)
+  if (urpc_client_exec (rpc, HYSCAN_CACHE_RPC_PROC_VERSION) != URPC_STATUS_OK)
     {
-      urpc_client_unlock (priv->rpc);
+      urpc_client_unlock (rpc);
       g_warning ("HyScanCacheClient: can't execute procedure");
       goto fail;
     }
@@ -174,181 +281,1695 @@ hyscan_cache_client_object_constructed (GObject *object)
     {
       g_warning ("HyScanCacheClient: server version mismatch: need %d, got: %d",
                  HYSCAN_CACHE_RPC_VERSION, version);
-      urpc_client_unlock (priv->rpc);
+      urpc_client_unlock (rpc);
       goto fail;
     }
 
-  urpc_client_unlock (priv->rpc);
-  return;
+  urpc_client_unlock (rpc);
+
+  return rpc;
 
 fail:
-  urpc_client_destroy (priv->rpc);
-  priv->rpc = NULL;
+  urpc_client_destroy (rpc);
+
+  return NULL;
 }
 
-static void
-hyscan_cache_client_object_finalize (GObject *object)
+/* Функция возвращает канал RPC текущего потока. Канал выбирается по
+   порядковому номеру потока и подключается при первом использовании. */
+static uRpcClient *
+hyscan_cache_client_channel (HyScanCacheClientPrivate *priv)
 {
-  HyScanCacheClient *cachec = HYSCAN_CACHE_CLIENT (object);
-  HyScanCacheClientPrivate *priv = cachec->priv;
+  uRpcClient *rpc;
+  guint thread_id;
+  guint index;
 
-  if (priv->rpc != NULL)
-    urpc_client_destroy (priv->rpc);
+  if (priv->rpc == NULL || priv->n_channels == 1)
+    return priv->rpc;
 
-  g_free (priv->uri);
+  thread_id = GPOINTER_TO_UINT (g_private_get (&hyscan_cache_client_thread_id));
+  if (thread_id == 0)
+    {
+      thread_id = g_atomic_int_add (&hyscan_cache_client_n_threads, 1) + 1;
+      g_private_set (&hyscan_cache_client_thread_id, GUINT_TO_POINTER (thread_id));
+    }
 
-  G_OBJECT_CLASS (hyscan_cache_client_parent_class)->finalize (object);
+  index = (thread_id - 1) % priv->n_channels;
+  rpc = g_atomic_pointer_get (&priv->channels[index]);
+  if (rpc != NULL)
+    return rpc;
+
+  /* Подключение канала. При ошибке используется основной канал. */
+  g_mutex_lock (&priv->pool_lock);
+
+  rpc = priv->channels[index];
+  if (rpc == NULL && !priv->failed[index])
+    {
+      rpc = hyscan_cache_client_connect (priv->uri);
+      if (rpc != NULL)
+        g_atomic_pointer_set (&priv->channels[index], rpc);
+      else
+        priv->failed[index] = TRUE;
+    }
+
+  g_mutex_unlock (&priv->pool_lock);
+
+  return (rpc != NULL) ? rpc : priv->rpc;
 }
 
 /* Все функции этого класса реализованы одинаково:
+    - выбирается канал передачи данных RPC текущего потока;
     - блокируется канал передачи данных RPC;
     - устанавливаются значения параметров вызываемой функции;
     - производится вызов RPC функции;
     - считывается результат вызова функции;
     - освобождается канал передачи. */
 
-/* Функция добавляет или изменяет объект в кэше. */
+/* Функция записывает в параметры RPC старшую половину 128-ми битного ключа
+   и строку ключа для проверки на сервере. Слишком длинные строки ключей
+   не передаются. */
 static gboolean
-hyscan_cache_client_set (HyScanCache  *cache,
-                         guint64       key,
-                         guint64       detail,
-                         HyScanBuffer *buffer1,
-                         HyScanBuffer *buffer2)
+hyscan_cache_client_set_key_hi (uRpcData    *urpc_data,
+                                guint64      key_hi,
+                                const gchar *key_string)
+{
+  if (urpc_data_set_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY_HI, key_hi) != 0)
+    return FALSE;
+
+  if (key_string != NULL && strlen (key_string) < HYSCAN_CACHE_RPC_MAX_KEY_STRING)
+    return (urpc_data_set_string (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY_STRING, key_string) == 0);
+
+  return TRUE;
+}
+
+/* Функция записывает объект, не помещающийся в одно сообщение RPC, частями.
+   Параметры ключа объекта должны быть уже записаны в urpc_data. Результат
+   записи объекта в кэш возвращается в параметре статуса последнего вызова. */
+static gboolean
+hyscan_cache_client_upload (uRpcClient    *rpc,
+                            uRpcData      *urpc_data,
+                            guint32        size,
+                            HyScanBuffer **buffers,
+                            guint          n_buffers)
+{
+  guint32 exec_status;
+  guint32 offset = 0;
+  guint32 part_offset = 0;
+  guint i = 0;
+
+  if (urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_SIZE, size) != 0)
+    return FALSE;
+
+  if (urpc_client_exec (rpc, HYSCAN_CACHE_RPC_PROC_SET_BEGIN) != URPC_STATUS_OK)
+    return FALSE;
+
+  if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, &exec_status) != 0 ||
+      exec_status != HYSCAN_CACHE_RPC_STATUS_OK)
+    {
+      return FALSE;
+    }
+
+  while (offset < size)
+    {
+      guint32 chunk = MIN (size - offset, HYSCAN_CACHE_RPC_MAX_CHUNK);
+      guint32 filled = 0;
+      guint8 *data;
+
+      if (urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_OFFSET, offset) != 0)
+        return FALSE;
+
+      data = urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, NULL, chunk);
+      if (data == NULL)
+        return FALSE;
+
+      /* Часть данных может состоять из данных нескольких буферов. */
+      while (filled < chunk && i < n_buffers)
+        {
+          guint8 *part_data = NULL;
+          guint32 part = 0;
+          guint32 n_bytes;
+
+          if (buffers[i] != NULL)
+            part_data = hyscan_buffer_get (buffers[i], NULL, &part);
+
+          if (part_data == NULL || part_offset >= part)
+            {
+              part_offset = 0;
+              i += 1;
+              continue;
+            }
+
+          n_bytes = MIN (part - part_offset, chunk - filled);
+          memcpy (data + filled, part_data + part_offset, n_bytes);
+          part_offset += n_bytes;
+          filled += n_bytes;
+        }
+
+      if (urpc_client_exec (rpc, HYSCAN_CACHE_RPC_PROC_SET_CHUNK) != URPC_STATUS_OK)
+        return FALSE;
+
+      if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, &exec_status) != 0 ||
+          exec_status != HYSCAN_CACHE_RPC_STATUS_OK)
+        {
+          return FALSE;
+        }
+
+      offset += chunk;
+    }
+
+  return (urpc_client_exec (rpc, HYSCAN_CACHE_RPC_PROC_SET_COMMIT) == URPC_STATUS_OK);
+}
+
+/* Функция считывает частями объект, копия которого сохранена сервером
+   в сессии клиента. Данные последовательно записываются в области памяти
+   targets размером parts, области с targets[i] = NULL пропускаются. */
+static gboolean
+hyscan_cache_client_download (uRpcClient     *rpc,
+                              uRpcData       *urpc_data,
+                              guint32         size,
+                              guint8        **targets,
+                              const guint32  *parts,
+                              guint           n_parts)
+{
+  guint32 offset = 0;
+  guint32 part_offset = 0;
+  guint i = 0;
+
+  while (offset < size)
+    {
+      guint32 exec_status;
+      guint8 *data;
+      guint32 chunk;
+
+      if (urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_OFFSET, offset) != 0)
+        return FALSE;
+
+      if (urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_SIZE, size - offset) != 0)
+        return FALSE;
+
+      if (urpc_client_exec (rpc, HYSCAN_CACHE_RPC_PROC_GET_CHUNK) != URPC_STATUS_OK)
+        return FALSE;
+
+      if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, &exec_status) != 0 ||
+          exec_status != HYSCAN_CACHE_RPC_STATUS_OK)
+        {
+          return FALSE;
+        }
+
+      data = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, &chunk);
+      if (data == NULL || chunk == 0 || chunk > size - offset)
+        return FALSE;
+
+      offset += chunk;
+
+      /* Часть данных может относиться к нескольким областям. */
+      while (chunk > 0 && i < n_parts)
+        {
+          guint32 n_bytes = MIN (parts[i] - part_offset, chunk);
+
+          if (targets[i] != NULL)
+            memcpy (targets[i] + part_offset, data, n_bytes);
+
+          data += n_bytes;
+          chunk -= n_bytes;
+          part_offset += n_bytes;
+
+          if (part_offset == parts[i])
+            {
+              part_offset = 0;
+              i += 1;
+            }
+        }
+    }
+
+  return TRUE;
+}
+
+/* Функция отказывается от чтения объекта частями. Сервер освобождает копию
+   объекта после чтения последней части, поэтому запрашивается часть нулевого
+   размера в конце объекта. Результат запроса не важен: при ошибке сервер
+   также освобождает копию. */
+static void
+hyscan_cache_client_download_cancel (uRpcClient *rpc,
+                                     uRpcData   *urpc_data,
+                                     guint32     size)
+{
+  if (urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_OFFSET, size) != 0 ||
+      urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_SIZE, 0) != 0)
+    {
+      return;
+    }
+
+  urpc_client_exec (rpc, HYSCAN_CACHE_RPC_PROC_GET_CHUNK);
+}
+
+/* Функция считывает частями объект в буферы. Данные распределяются по
+   буферам так же, как функцией hyscan_cache_client_fetch. */
+static gboolean
+hyscan_cache_client_download_buffers (uRpcClient     *rpc,
+                                      uRpcData       *urpc_data,
+                                      guint32         size,
+                                      const guint32  *sizes,
+                                      HyScanBuffer  **buffers,
+                                      guint           n_buffers)
+{
+  gboolean status = FALSE;
+  guint32 *parts;
+  guint8 **targets;
+  guint32 remain = size;
+  guint i;
+
+  parts = g_new0 (guint32, n_buffers);
+  targets = g_new0 (guint8 *, n_buffers);
+
+  for (i = 0; i < n_buffers; i++)
+    {
+      parts[i] = remain;
+      if (i + 1 < n_buffers)
+        parts[i] = MIN (parts[i], sizes[i]);
+      remain -= parts[i];
+
+      if (buffers[i] == NULL)
+        continue;
+
+      if (!hyscan_buffer_set_data_size (buffers[i], parts[i]))
+        goto exit;
+
+      targets[i] = hyscan_buffer_get (buffers[i], NULL, NULL);
+    }
+
+  status = hyscan_cache_client_download (rpc, urpc_data, size, targets, parts, n_buffers);
+
+exit:
+  g_free (parts);
+  g_free (targets);
+
+  return status;
+}
+
+/* Функция добавляет или изменяет объект в кэше. Данные из всех буферов
+   записываются в параметр RPC за один проход. Если задана старшая половина
+   ключа key_hi, объект записывается по 128-ми битному ключу. */
+static gboolean
+hyscan_cache_client_store (HyScanCacheClient  *cachec,
+                           guint64             key,
+                           const guint64      *key_hi,
+                           const gchar        *key_string,
+                           guint64             detail,
+                           HyScanBuffer      **buffers,
+                           guint               n_buffers)
 {
-  HyScanCacheClient *cachec = HYSCAN_CACHE_CLIENT (cache);
   HyScanCacheClientPrivate *priv = cachec->priv;
+  uRpcClient *rpc;
   uRpcData *urpc_data;
   guint32 exec_status;
 
   guint8 *data;
-  gpointer data1 = NULL;
-  gpointer data2 = NULL;
-  guint32 size1 = 0;
-  guint32 size2 = 0;
+  guint64 size = 0;
+  guint i;
 
   gboolean status = FALSE;
+  gint64 start = hyscan_cache_counters_now ();
 
-  if (buffer1 != NULL)
-    data1 = hyscan_buffer_get (buffer1, NULL, &size1);
-  if (buffer2 != NULL)
-    data2 = hyscan_buffer_get (buffer2, NULL, &size2);
-
-  if (priv->rpc == NULL)
+  rpc = hyscan_cache_client_channel (priv);
+  if (rpc == NULL)
     return FALSE;
 
-  if ((size1 + size2) > URPC_MAX_DATA_SIZE - 1024 )
-    return FALSE;
+  for (i = 0; i < n_buffers; i++)
+    {
+      guint32 part = 0;
+
+      if (buffers[i] != NULL && hyscan_buffer_get (buffers[i], NULL, &part) != NULL)
+        size += part;
+    }
+
+  if (size > G_MAXUINT32)
+    {
+      hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_REJECTED, 1);
+      return FALSE;
+    }
 
-  urpc_data = urpc_client_lock (priv->rpc);
+  urpc_data = urpc_client_lock (rpc);
   if (urpc_data == NULL)
     hyscan_cache_client_lock_error ();
 
   if (urpc_data_set_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY, key) != 0)
     hyscan_cache_client_set_error ("key");
 
+  if (key_hi != NULL && !hyscan_cache_client_set_key_hi (urpc_data, *key_hi, key_string))
+    hyscan_cache_client_set_error ("key-hi");
+
   if (urpc_data_set_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_DETAIL, detail) != 0)
     hyscan_cache_client_set_error ("detail");
 
-  data = urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, NULL, size1 + size2);
+  /* Большие объекты передаются частями. */
+  if (size > HYSCAN_CACHE_RPC_MAX_CHUNK)
+    {
+      if (!hyscan_cache_client_upload (rpc, urpc_data, size, buffers, n_buffers))
+        hyscan_cache_client_exec_error ("set-chunk");
+
+      goto result;
+    }
+
+  data = urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, NULL, size);
   if (data == NULL)
     hyscan_cache_client_set_error ("data");
 
-  if (size1 > 0 && data1 != NULL)
-    memcpy (data, data1, size1);
+  for (i = 0; i < n_buffers; i++)
+    {
+      gpointer part_data;
+      guint32 part = 0;
+
+      if (buffers[i] == NULL)
+        continue;
+
+      part_data = hyscan_buffer_get (buffers[i], NULL, &part);
+      if (part_data == NULL || part == 0)
+        continue;
 
-  if (size2 > 0 && data2 != NULL)
-    memcpy (data + size1, data2, size2);
+      memcpy (data, part_data, part);
+      data += part;
+    }
 
-  if (urpc_client_exec (priv->rpc, HYSCAN_CACHE_RPC_PROC_SET) != URPC_STATUS_OK)
+  if (urpc_client_exec (rpc, key_hi != NULL ? HYSCAN_CACHE_RPC_PROC_SET128 :
+                                                    HYSCAN_CACHE_RPC_PROC_SET) != URPC_STATUS_OK)
     hyscan_cache_client_exec_error ("set");
 
+result:
   if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, &exec_status) != 0)
     hyscan_cache_client_get_error ("exec_status");
   if (exec_status != HYSCAN_CACHE_RPC_STATUS_OK)
-    goto exit;
+    {
+      hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_REJECTED, 1);
+      goto exit;
+    }
 
   status = TRUE;
 
 exit:
-  urpc_client_unlock (priv->rpc);
+  urpc_client_unlock (rpc);
+
+  /* Объект мог быть изменён, даже если ответ не получен. */
+  hyscan_cache_near_invalidate (priv->ncache, key);
+
+  if (status)
+    {
+      /* Удаление объекта не учитывается как запись. */
+      if (size > 0)
+        hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_SETS, 1);
+      hyscan_cache_counters_add_latency (priv->counters,
+                                         HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_OP_SET * HYSCAN_CACHE_STATS_N_BINS,
+                                         start);
+    }
 
   return status;
 }
 
-/* Функция считывает объект из кэша. */
-gboolean
-hyscan_cache_client_get (HyScanCache  *cache,
+/* Функция добавляет или изменяет объект в кэше. */
+static gboolean
+hyscan_cache_client_setv (HyScanCache   *cache,
+                          guint64        key,
+                          guint64        detail,
+                          HyScanBuffer **buffers,
+                          guint          n_buffers)
+{
+  return hyscan_cache_client_store (HYSCAN_CACHE_CLIENT (cache), key, NULL, NULL, detail, buffers, n_buffers);
+}
+
+/* Функция добавляет или изменяет объект в кэше. */
+static gboolean
+hyscan_cache_client_set (HyScanCache  *cache,
                          guint64       key,
                          guint64       detail,
-                         guint32       size1,
                          HyScanBuffer *buffer1,
                          HyScanBuffer *buffer2)
+{
+  HyScanBuffer *buffers[2] = { buffer1, buffer2 };
+
+  return hyscan_cache_client_setv (cache, key, detail, buffers, 2);
+}
+
+/* Функция добавляет или изменяет объект в кэше по 128-ми битному ключу. */
+static gboolean
+hyscan_cache_client_set128 (HyScanCache  *cache,
+                            guint64       key_lo,
+                            guint64       key_hi,
+                            const gchar  *key,
+                            guint64       detail,
+                            HyScanBuffer *buffer1,
+                            HyScanBuffer *buffer2)
+{
+  HyScanBuffer *buffers[2] = { buffer1, buffer2 };
+
+  return hyscan_cache_client_store (HYSCAN_CACHE_CLIENT (cache), key_lo, &key_hi, key, detail, buffers, 2);
+}
+
+/* Функция добавляет данные в конец объекта. */
+static gboolean
+hyscan_cache_client_append (HyScanCache  *cache,
+                            guint64       key,
+                            guint64       detail,
+                            HyScanBuffer *buffer)
 {
   HyScanCacheClient *cachec = HYSCAN_CACHE_CLIENT (cache);
   HyScanCacheClientPrivate *priv = cachec->priv;
+  uRpcClient *rpc;
+  uRpcData *urpc_data;
+  guint32 exec_status;
+
+  gpointer data;
+  guint32 size;
+
+  gboolean status = FALSE;
+  gint64 start = hyscan_cache_counters_now ();
+
+  data = hyscan_buffer_get (buffer, NULL, &size);
+
+  rpc = hyscan_cache_client_channel (priv);
+  if (rpc == NULL)
+    return FALSE;
+
+  if (size == 0)
+    return TRUE;
+
+  if (size > URPC_MAX_DATA_SIZE - 1024)
+    {
+      hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_REJECTED, 1);
+      return FALSE;
+    }
+
+  urpc_data = urpc_client_lock (rpc);
+  if (urpc_data == NULL)
+    hyscan_cache_client_lock_error ();
+
+  if (urpc_data_set_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY, key) != 0)
+    hyscan_cache_client_set_error ("key");
+
+  if (urpc_data_set_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_DETAIL, detail) != 0)
+    hyscan_cache_client_set_error ("detail");
+
+  if (urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, data, size) == NULL)
+    hyscan_cache_client_set_error ("data");
+
+  if (urpc_client_exec (rpc, HYSCAN_CACHE_RPC_PROC_APPEND) != URPC_STATUS_OK)
+    hyscan_cache_client_exec_error ("append");
+
+  if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, &exec_status) != 0)
+    hyscan_cache_client_get_error ("exec_status");
+  if (exec_status != HYSCAN_CACHE_RPC_STATUS_OK)
+    {
+      hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_REJECTED, 1);
+      goto exit;
+    }
+
+  status = TRUE;
+
+exit:
+  urpc_client_unlock (rpc);
+
+  hyscan_cache_near_invalidate (priv->ncache, key);
+
+  if (status)
+    {
+      hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_SETS, 1);
+      hyscan_cache_counters_add_latency (priv->counters,
+                                         HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_OP_APPEND * HYSCAN_CACHE_STATS_N_BINS,
+                                         start);
+    }
+
+  return status;
+}
+
+/* Функция считывает объект из кэша. Данные последовательно распределяются
+   по буферам без промежуточного копирования. Если задана старшая половина
+   ключа key_hi, объект считывается по 128-ми битному ключу. */
+static gboolean
+hyscan_cache_client_fetch (HyScanCacheClient  *cachec,
+                           guint64             key,
+                           const guint64      *key_hi,
+                           const gchar        *key_string,
+                           guint64             detail,
+                           const guint32      *sizes,
+                           HyScanBuffer      **buffers,
+                           guint               n_buffers)
+{
+  HyScanCacheClientPrivate *priv = cachec->priv;
+  uRpcClient *rpc;
   uRpcData *urpc_data;
   guint32 exec_status;
 
   gboolean status = FALSE;
+  gboolean miss = FALSE;
+  guint generation;
   guint8 *data;
   guint32 size;
+  guint i;
 
-  if (priv->rpc == NULL)
-    return FALSE;
+  gint64 start = hyscan_cache_counters_now ();
 
-  if (buffer1 == NULL && buffer2 != NULL)
+  rpc = hyscan_cache_client_channel (priv);
+  if (rpc == NULL)
     return FALSE;
 
-  urpc_data = urpc_client_lock (priv->rpc);
+  /* Объект в ближнем кэше. */
+  if (hyscan_cache_near_lookup (priv->ncache, key, key_hi, detail, sizes, buffers, n_buffers))
+    {
+      hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_HITS, 1);
+      hyscan_cache_counters_add_latency (priv->counters,
+                                         HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_OP_GET * HYSCAN_CACHE_STATS_N_BINS,
+                                         start);
+
+      return TRUE;
+    }
+
+  generation = hyscan_cache_near_get_generation (priv->ncache);
+
+  urpc_data = urpc_client_lock (rpc);
   if (urpc_data == NULL)
     hyscan_cache_client_lock_error ();
 
   if (urpc_data_set_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY, key) != 0)
     hyscan_cache_client_set_error ("key");
 
+  if (key_hi != NULL && !hyscan_cache_client_set_key_hi (urpc_data, *key_hi, key_string))
+    hyscan_cache_client_set_error ("key-hi");
+
   if (urpc_data_set_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_DETAIL, detail) != 0)
     hyscan_cache_client_set_error ("detail");
 
-  if (urpc_client_exec (priv->rpc, HYSCAN_CACHE_RPC_PROC_GET) != URPC_STATUS_OK)
+  if (urpc_client_exec (rpc, key_hi != NULL ? HYSCAN_CACHE_RPC_PROC_GET128 :
+                                                    HYSCAN_CACHE_RPC_PROC_GET) != URPC_STATUS_OK)
     hyscan_cache_client_exec_error ("get");
 
   if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, &exec_status) != 0)
     hyscan_cache_client_get_error ("exec_status");
+
+  /* Объект не поместился в ответ и считывается частями. В ближний
+     кэш такие объекты не помещаются. */
+  if (exec_status == HYSCAN_CACHE_RPC_STATUS_CHUNKED)
+    {
+      if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_SIZE, &size) != 0)
+        hyscan_cache_client_get_error ("size");
+
+      if (!hyscan_cache_client_download_buffers (rpc, urpc_data, size, sizes, buffers, n_buffers))
+        hyscan_cache_client_exec_error ("get-chunk");
+
+      status = TRUE;
+      goto exit;
+    }
+
   if (exec_status != HYSCAN_CACHE_RPC_STATUS_OK)
-    goto exit;
+    {
+      miss = TRUE;
+      goto exit;
+    }
 
   data = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, &size);
   if (data == NULL)
     hyscan_cache_client_get_error ("data");
 
-  size1 = MIN (size, size1);
-  hyscan_buffer_set (buffer1, HYSCAN_DATA_BLOB, data, size1);
+  hyscan_cache_near_insert (priv->ncache, generation, key, key_hi, detail, data, size);
+
+  for (i = 0; i < n_buffers; i++)
+    {
+      guint32 part = size;
+
+      if (i + 1 < n_buffers)
+        part = MIN (part, sizes[i]);
 
-  if (buffer2 != NULL)
-    hyscan_buffer_set (buffer2, HYSCAN_DATA_BLOB, data + size1, size - size1);
+      if (buffers[i] != NULL)
+        hyscan_buffer_set (buffers[i], HYSCAN_DATA_BLOB, data, part);
+
+      data += part;
+      size -= part;
+    }
 
   status = TRUE;
 
 exit:
-  urpc_client_unlock (priv->rpc);
+  urpc_client_unlock (rpc);
+
+  if (status || miss)
+    {
+      hyscan_cache_counters_add (priv->counters,
+                                 status ? HYSCAN_CACHE_COUNTER_HITS : HYSCAN_CACHE_COUNTER_MISSES, 1);
+      hyscan_cache_counters_add_latency (priv->counters,
+                                         HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_OP_GET * HYSCAN_CACHE_STATS_N_BINS,
+                                         start);
+    }
 
   return status;
 }
 
-/**
- * hyscan_cache_client_new:
- * @uri: адрес сервера
- *
- * Функция создаёт новый объект #HyScanCacheClient.
- *
- * Returns: #HyScanCacheClient. Для удаления #g_object_unref.
- */
-HyScanCacheClient *
-hyscan_cache_client_new (const gchar *uri)
+/* Функция считывает объект из кэша. */
+static gboolean
+hyscan_cache_client_getv (HyScanCache    *cache,
+                          guint64         key,
+                          guint64         detail,
+                          const guint32  *sizes,
+                          HyScanBuffer  **buffers,
+                          guint           n_buffers)
 {
-  return g_object_new (HYSCAN_TYPE_CACHE_CLIENT,
-                       "uri", uri,
-                       NULL);
+  return hyscan_cache_client_fetch (HYSCAN_CACHE_CLIENT (cache), key, NULL, NULL, detail, sizes, buffers, n_buffers);
+}
+
+/* Функция считывает объект из кэша. */
+gboolean
+hyscan_cache_client_get (HyScanCache  *cache,
+                         guint64       key,
+                         guint64       detail,
+                         guint32       size1,
+                         HyScanBuffer *buffer1,
+                         HyScanBuffer *buffer2)
+{
+  HyScanBuffer *buffers[2] = { buffer1, buffer2 };
+
+  if (buffer1 == NULL && buffer2 != NULL)
+    return FALSE;
+
+  return hyscan_cache_client_getv (cache, key, detail, &size1, buffers, 2);
+}
+
+/* Функция считывает объект из кэша по 128-ми битному ключу. */
+static gboolean
+hyscan_cache_client_get128 (HyScanCache  *cache,
+                            guint64       key_lo,
+                            guint64       key_hi,
+                            const gchar  *key,
+                            guint64       detail,
+                            guint32       size1,
+                            HyScanBuffer *buffer1,
+                            HyScanBuffer *buffer2)
+{
+  HyScanBuffer *buffers[2] = { buffer1, buffer2 };
+
+  if (buffer1 == NULL && buffer2 != NULL)
+    return FALSE;
+
+  return hyscan_cache_client_fetch (HYSCAN_CACHE_CLIENT (cache), key_lo, &key_hi, key, detail, &size1, buffers, 2);
+}
+
+/* Функция считывает часть данных объекта из кэша. */
+static gboolean
+hyscan_cache_client_get_range (HyScanCache  *cache,
+                               guint64       key,
+                               guint64       detail,
+                               guint32       offset,
+                               guint32       size,
+                               HyScanBuffer *buffer)
+{
+  HyScanCacheClient *cachec = HYSCAN_CACHE_CLIENT (cache);
+  HyScanCacheClientPrivate *priv = cachec->priv;
+  uRpcClient *rpc;
+  uRpcData *urpc_data;
+  guint32 exec_status;
+
+  gboolean status = FALSE;
+  gboolean miss = FALSE;
+  gpointer data;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  rpc = hyscan_cache_client_channel (priv);
+  if (rpc == NULL)
+    return FALSE;
+
+  urpc_data = urpc_client_lock (rpc);
+  if (urpc_data == NULL)
+    hyscan_cache_client_lock_error ();
+
+  if (urpc_data_set_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY, key) != 0)
+    hyscan_cache_client_set_error ("key");
+
+  if (urpc_data_set_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_DETAIL, detail) != 0)
+    hyscan_cache_client_set_error ("detail");
+
+  if (urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_OFFSET, offset) != 0)
+    hyscan_cache_client_set_error ("offset");
+
+  if (urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_SIZE, size) != 0)
+    hyscan_cache_client_set_error ("size");
+
+  if (urpc_client_exec (rpc, HYSCAN_CACHE_RPC_PROC_GET_RANGE) != URPC_STATUS_OK)
+    hyscan_cache_client_exec_error ("get-range");
+
+  if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, &exec_status) != 0)
+    hyscan_cache_client_get_error ("exec_status");
+  if (exec_status != HYSCAN_CACHE_RPC_STATUS_OK)
+    {
+      miss = TRUE;
+      goto exit;
+    }
+
+  data = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, &size);
+  if (data == NULL)
+    hyscan_cache_client_get_error ("data");
+
+  hyscan_buffer_set (buffer, HYSCAN_DATA_BLOB, data, size);
+
+  status = TRUE;
+
+exit:
+  urpc_client_unlock (rpc);
+
+  if (status || miss)
+    {
+      hyscan_cache_counters_add (priv->counters,
+                                 status ? HYSCAN_CACHE_COUNTER_HITS : HYSCAN_CACHE_COUNTER_MISSES, 1);
+      hyscan_cache_counters_add_latency (priv->counters,
+                                         HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_OP_GET * HYSCAN_CACHE_STATS_N_BINS,
+                                         start);
+    }
+
+  return status;
+}
+
+/* Функция возвращает информацию об объекте. */
+static gboolean
+hyscan_cache_client_query (HyScanCache *cache,
+                           guint64      key,
+                           guint64     *detail,
+                           guint32     *size)
+{
+  HyScanCacheClient *cachec = HYSCAN_CACHE_CLIENT (cache);
+  HyScanCacheClientPrivate *priv = cachec->priv;
+  uRpcClient *rpc;
+  uRpcData *urpc_data;
+  guint32 exec_status;
+
+  gboolean status = FALSE;
+
+  rpc = hyscan_cache_client_channel (priv);
+  if (rpc == NULL)
+    return FALSE;
+
+  urpc_data = urpc_client_lock (rpc);
+  if (urpc_data == NULL)
+    hyscan_cache_client_lock_error ();
+
+  if (urpc_data_set_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY, key) != 0)
+    hyscan_cache_client_set_error ("key");
+
+  if (urpc_client_exec (rpc, HYSCAN_CACHE_RPC_PROC_QUERY) != URPC_STATUS_OK)
+    hyscan_cache_client_exec_error ("query");
+
+  if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, &exec_status) != 0)
+    hyscan_cache_client_get_error ("exec_status");
+  if (exec_status != HYSCAN_CACHE_RPC_STATUS_OK)
+    goto exit;
+
+  if (urpc_data_get_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_DETAIL, detail) != 0)
+    hyscan_cache_client_get_error ("detail");
+
+  if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_SIZE, size) != 0)
+    hyscan_cache_client_get_error ("size");
+
+  status = TRUE;
+
+exit:
+  urpc_client_unlock (rpc);
+
+  return status;
+}
+
+/* Функция проверяет наличие в кэше нескольких объектов. Ключи передаются
+   серверу частями, ограниченными размером буфера RPC. */
+static guint
+hyscan_cache_client_contains_batch (HyScanCache   *cache,
+                                    const guint64 *keys,
+                                    guint          n_keys,
+                                    gboolean      *found)
+{
+  HyScanCacheClient *cachec = HYSCAN_CACHE_CLIENT (cache);
+  HyScanCacheClientPrivate *priv = cachec->priv;
+  uRpcClient *rpc;
+  uRpcData *urpc_data;
+  guint32 exec_status;
+
+  guint n_found = 0;
+  guint done = 0;
+
+  rpc = hyscan_cache_client_channel (priv);
+  if (rpc == NULL)
+    return 0;
+
+  urpc_data = urpc_client_lock (rpc);
+  if (urpc_data == NULL)
+    hyscan_cache_client_lock_error ();
+
+  while (done < n_keys)
+    {
+      guint n_part = MIN (n_keys - done, HYSCAN_CACHE_RPC_MAX_BATCH_KEYS);
+      guint64 *data;
+      guint8 *result;
+      guint32 size;
+      guint i;
+
+      data = urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEYS, NULL, n_part * sizeof (guint64));
+      if (data == NULL)
+        hyscan_cache_client_set_error ("keys");
+
+      for (i = 0; i < n_part; i++)
+        data[i] = GUINT64_TO_LE (keys[done + i]);
+
+      if (urpc_client_exec (rpc, HYSCAN_CACHE_RPC_PROC_CONTAINS_BATCH) != URPC_STATUS_OK)
+        hyscan_cache_client_exec_error ("contains-batch");
+
+      if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, &exec_status) != 0)
+        hyscan_cache_client_get_error ("exec_status");
+      if (exec_status != HYSCAN_CACHE_RPC_STATUS_OK)
+        goto exit;
+
+      result = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_FOUND, &size);
+      if (result == NULL || size != n_part)
+        hyscan_cache_client_get_error ("found");
+
+      for (i = 0; i < n_part; i++)
+        {
+          if (found != NULL)
+            found[done + i] = (result[i] != 0);
+          if (result[i] != 0)
+            n_found += 1;
+        }
+
+      done += n_part;
+    }
+
+exit:
+  urpc_client_unlock (rpc);
+
+  /* При ошибке объекты, наличие которых не проверено, считаются отсутствующими. */
+  if (found != NULL && done < n_keys)
+    memset (found + done, 0, (n_keys - done) * sizeof (gboolean));
+
+  return n_found;
+}
+
+/* Функция записывает несколько объектов за один обмен с сервером. Суммарный
+   размер данных объектов total не должен превышать размер пакета. */
+static guint
+hyscan_cache_client_mset (HyScanCacheClientPrivate  *priv,
+                          uRpcClient                *rpc,
+                          const guint64             *keys,
+                          const guint64             *details,
+                          HyScanBuffer             **buffers,
+                          guint                      n_keys,
+                          guint32                    total,
+                          gboolean                  *stored)
+{
+  uRpcData *urpc_data;
+  guint32 exec_status;
+
+  guint64 *key_data;
+  guint64 *detail_data;
+  guint32 *size_data;
+  guint8 *data = NULL;
+  guint8 *result;
+  guint32 size;
+  guint n_stored = 0;
+  guint n_sets = 0;
+  guint i;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  urpc_data = urpc_client_lock (rpc);
+  if (urpc_data == NULL)
+    hyscan_cache_client_lock_error ();
+
+  key_data = urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEYS, NULL, n_keys * sizeof (guint64));
+  if (key_data == NULL)
+    hyscan_cache_client_set_error ("keys");
+
+  if (details != NULL)
+    {
+      detail_data = urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_DETAILS, NULL, n_keys * sizeof (guint64));
+      if (detail_data == NULL)
+        hyscan_cache_client_set_error ("details");
+
+      for (i = 0; i < n_keys; i++)
+        detail_data[i] = GUINT64_TO_LE (details[i]);
+    }
+
+  size_data = urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_SIZES, NULL, n_keys * sizeof (guint32));
+  if (size_data == NULL)
+    hyscan_cache_client_set_error ("sizes");
+
+  if (total > 0)
+    {
+      data = urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, NULL, total);
+      if (data == NULL)
+        hyscan_cache_client_set_error ("data");
+    }
+
+  for (i = 0; i < n_keys; i++)
+    {
+      gpointer part_data = NULL;
+      guint32 part = 0;
+
+      key_data[i] = GUINT64_TO_LE (keys[i]);
+
+      if (buffers[i] == NULL)
+        {
+          size_data[i] = GUINT32_TO_LE (HYSCAN_CACHE_RPC_REMOVE_SIZE);
+          continue;
+        }
+
+      part_data = hyscan_buffer_get (buffers[i], NULL, &part);
+      if (part_data == NULL)
+        part = 0;
+
+      if (part > 0)
+        {
+          memcpy (data, part_data, part);
+          data += part;
+        }
+
+      size_data[i] = GUINT32_TO_LE (part);
+    }
+
+  if (urpc_client_exec (rpc, HYSCAN_CACHE_RPC_PROC_MSET) != URPC_STATUS_OK)
+    hyscan_cache_client_exec_error ("mset");
+
+  if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, &exec_status) != 0)
+    hyscan_cache_client_get_error ("exec_status");
+  if (exec_status != HYSCAN_CACHE_RPC_STATUS_OK)
+    goto exit;
+
+  result = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_FOUND, &size);
+  if (result == NULL || size != n_keys)
+    hyscan_cache_client_get_error ("found");
+
+  for (i = 0; i < n_keys; i++)
+    {
+      guint32 part = 0;
+
+      if (stored != NULL)
+        stored[i] = (result[i] != 0);
+      if (result[i] == 0)
+        continue;
+
+      /* Удаление объекта не учитывается как запись. */
+      n_stored += 1;
+      if (buffers[i] != NULL && hyscan_buffer_get (buffers[i], NULL, &part) != NULL && part > 0)
+        n_sets += 1;
+    }
+
+exit:
+  urpc_client_unlock (rpc);
+
+  /* Объекты могли быть изменены, даже если ответ не получен. */
+  for (i = 0; i < n_keys; i++)
+    hyscan_cache_near_invalidate (priv->ncache, keys[i]);
+
+  hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_SETS, n_sets);
+  hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_REJECTED, n_keys - n_stored);
+  hyscan_cache_counters_add_latency (priv->counters,
+                                     HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_OP_SET * HYSCAN_CACHE_STATS_N_BINS,
+                                     start);
+
+  return n_stored;
+}
+
+/* Функция помещает в кэш несколько объектов. Объекты передаются серверу
+   пакетами, ограниченными размером буфера RPC. Объект, не помещающийся
+   в пакет, записывается отдельно. */
+static guint
+hyscan_cache_client_set_batch (HyScanCache    *cache,
+                               const guint64  *keys,
+                               const guint64  *details,
+                               HyScanBuffer  **buffers,
+                               guint           n_keys,
+                               gboolean       *stored)
+{
+  HyScanCacheClient *cachec = HYSCAN_CACHE_CLIENT (cache);
+  HyScanCacheClientPrivate *priv = cachec->priv;
+  uRpcClient *rpc;
+
+  guint n_stored = 0;
+  guint done = 0;
+
+  /* Объекты пакета, который не удалось записать, считаются не записанными. */
+  if (stored != NULL)
+    memset (stored, 0, n_keys * sizeof (gboolean));
+
+  rpc = hyscan_cache_client_channel (priv);
+  if (rpc == NULL)
+    return 0;
+
+  while (done < n_keys)
+    {
+      guint32 total = 0;
+      guint n_part = 0;
+
+      while (done + n_part < n_keys && n_part < HYSCAN_CACHE_RPC_MAX_MULTI_KEYS)
+        {
+          HyScanBuffer *buffer = buffers[done + n_part];
+          guint32 part = 0;
+
+          if (buffer != NULL && hyscan_buffer_get (buffer, NULL, &part) == NULL)
+            part = 0;
+
+          if (part > HYSCAN_CACHE_RPC_MAX_MULTI_DATA - total)
+            break;
+
+          total += part;
+          n_part += 1;
+        }
+
+      if (n_part == 0)
+        {
+          guint64 detail = (details != NULL) ? details[done] : 0;
+          gboolean status;
+
+          status = hyscan_cache_client_store (cachec, keys[done], NULL, NULL, detail, buffers + done, 1);
+          if (stored != NULL)
+            stored[done] = status;
+          if (status)
+            n_stored += 1;
+
+          done += 1;
+          continue;
+        }
+
+      n_stored += hyscan_cache_client_mset (priv, rpc, keys + done,
+                                            (details != NULL) ? details + done : NULL,
+                                            buffers + done, n_part, total,
+                                            (stored != NULL) ? stored + done : NULL);
+      done += n_part;
+    }
+
+  return n_stored;
+}
+
+/* Функция считывает несколько объектов за один обмен с сервером. Индексы
+   объектов в массивах keys, details и buffers задаются массивом order.
+   Сервер обрабатывает ключи по порядку, пока данные помещаются в ответ,
+   число обработанных ключей возвращается в n_done. */
+static gboolean
+hyscan_cache_client_mget (HyScanCacheClientPrivate  *priv,
+                          uRpcClient                *rpc,
+                          const guint64             *keys,
+                          const guint64             *details,
+                          HyScanBuffer             **buffers,
+                          const guint               *order,
+                          guint                      n_keys,
+                          gboolean                  *found,
+                          guint                     *n_done,
+                          guint                     *n_found)
+{
+  uRpcData *urpc_data;
+  guint32 exec_status;
+
+  gboolean status = FALSE;
+  guint64 *key_data;
+  guint64 *detail_data;
+  guint32 *size_data;
+  guint8 *result;
+  guint8 *data;
+  guint32 size;
+  guint32 offset = 0;
+  guint32 count;
+  guint generation;
+  guint hits = 0;
+  guint misses = 0;
+  guint i;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  generation = hyscan_cache_near_get_generation (priv->ncache);
+
+  urpc_data = urpc_client_lock (rpc);
+  if (urpc_data == NULL)
+    hyscan_cache_client_lock_error ();
+
+  key_data = urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEYS, NULL, n_keys * sizeof (guint64));
+  if (key_data == NULL)
+    hyscan_cache_client_set_error ("keys");
+
+  for (i = 0; i < n_keys; i++)
+    key_data[i] = GUINT64_TO_LE (keys[order[i]]);
+
+  if (details != NULL)
+    {
+      detail_data = urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_DETAILS, NULL, n_keys * sizeof (guint64));
+      if (detail_data == NULL)
+        hyscan_cache_client_set_error ("details");
+
+      for (i = 0; i < n_keys; i++)
+        detail_data[i] = GUINT64_TO_LE (details[order[i]]);
+    }
+
+  if (urpc_client_exec (rpc, HYSCAN_CACHE_RPC_PROC_MGET) != URPC_STATUS_OK)
+    hyscan_cache_client_exec_error ("mget");
+
+  if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, &exec_status) != 0)
+    hyscan_cache_client_get_error ("exec_status");
+  if (exec_status != HYSCAN_CACHE_RPC_STATUS_OK)
+    goto exit;
+
+  if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_COUNT, &count) != 0 || count > n_keys)
+    hyscan_cache_client_get_error ("count");
+
+  result = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_FOUND, &size);
+  if (result == NULL || size != n_keys)
+    hyscan_cache_client_get_error ("found");
+
+  size_data = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_SIZES, &size);
+  if (size_data == NULL || size != n_keys * sizeof (guint32))
+    hyscan_cache_client_get_error ("sizes");
+
+  data = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, &size);
+  if (data == NULL)
+    size = 0;
+
+  for (i = 0; i < count; i++)
+    {
+      guint64 detail = (details != NULL) ? details[order[i]] : 0;
+      guint32 part = GUINT32_FROM_LE (size_data[i]);
+
+      if (result[i] == 0)
+        {
+          misses += 1;
+          continue;
+        }
+
+      if (part > size - offset)
+        hyscan_cache_client_get_error ("data");
+
+      hyscan_buffer_set (buffers[order[i]], HYSCAN_DATA_BLOB, data + offset, part);
+      hyscan_cache_near_insert (priv->ncache, generation, keys[order[i]], NULL, detail, data + offset, part);
+
+      if (found != NULL)
+        found[order[i]] = TRUE;
+
+      offset += part;
+      hits += 1;
+    }
+
+  *n_done = count;
+  *n_found += hits;
+  status = TRUE;
+
+exit:
+  urpc_client_unlock (rpc);
+
+  hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_HITS, hits);
+  hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_MISSES, misses);
+  hyscan_cache_counters_add_latency (priv->counters,
+                                     HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_OP_GET * HYSCAN_CACHE_STATS_N_BINS,
+                                     start);
+
+  return status;
+}
+
+/* Функция считывает из кэша несколько объектов. Объекты, найденные в ближнем
+   кэше, на сервере не запрашиваются. Остальные запрашиваются пакетами, пока
+   сервер не обработает все ключи. Если в ответ не поместился даже первый
+   объект пакета, он считывается отдельно. */
+static guint
+hyscan_cache_client_get_batch (HyScanCache    *cache,
+                               const guint64  *keys,
+                               const guint64  *details,
+                               HyScanBuffer  **buffers,
+                               guint           n_keys,
+                               gboolean       *found)
+{
+  HyScanCacheClient *cachec = HYSCAN_CACHE_CLIENT (cache);
+  HyScanCacheClientPrivate *priv = cachec->priv;
+  uRpcClient *rpc;
+
+  guint32 max_size = G_MAXUINT32;
+  guint *pending;
+  guint n_pending = 0;
+  guint n_found = 0;
+  guint done = 0;
+  guint i;
+
+  rpc = hyscan_cache_client_channel (priv);
+  if (rpc == NULL)
+    return 0;
+
+  if (found != NULL)
+    memset (found, 0, n_keys * sizeof (gboolean));
+
+  pending = g_new (guint, n_keys);
+  for (i = 0; i < n_keys; i++)
+    {
+      guint64 detail = (details != NULL) ? details[i] : 0;
+
+      if (buffers[i] == NULL)
+        continue;
+
+      if (hyscan_cache_near_lookup (priv->ncache, keys[i], NULL, detail, &max_size, buffers + i, 1))
+        {
+          hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_HITS, 1);
+          if (found != NULL)
+            found[i] = TRUE;
+          n_found += 1;
+        }
+      else
+        {
+          pending[n_pending++] = i;
+        }
+    }
+
+  while (done < n_pending)
+    {
+      guint n_part = MIN (n_pending - done, HYSCAN_CACHE_RPC_MAX_MULTI_KEYS);
+      guint n_done = 0;
+
+      if (!hyscan_cache_client_mget (priv, rpc, keys, details, buffers, pending + done,
+                                     n_part, found, &n_done, &n_found))
+        {
+          break;
+        }
+
+      if (n_done == 0)
+        {
+          guint object = pending[done];
+          guint64 detail = (details != NULL) ? details[object] : 0;
+
+          if (hyscan_cache_client_fetch (cachec, keys[object], NULL, NULL, detail,
+                                         &max_size, buffers + object, 1))
+            {
+              if (found != NULL)
+                found[object] = TRUE;
+              n_found += 1;
+            }
+
+          n_done = 1;
+        }
+
+      done += n_done;
+    }
+
+  g_free (pending);
+
+  return n_found;
+}
+
+/* Функция возвращает статистику запросов клиента. */
+static gboolean
+hyscan_cache_client_get_stats (HyScanCache      *cache,
+                               HyScanCacheStats *stats)
+{
+  HyScanCacheClient *cachec = HYSCAN_CACHE_CLIENT (cache);
+
+  hyscan_cache_counters_get_stats (cachec->priv->counters, stats);
+
+  return TRUE;
+}
+
+/* Функция считывает count 64-х битных чисел из массива статистики. */
+static const guint64 *
+hyscan_cache_client_read_stats (const guint64 *data,
+                                const guint64 *end,
+                                guint64       *values,
+                                guint          n_values,
+                                guint          count)
+{
+  guint i;
+
+  if (data + count > end)
+    return NULL;
+
+  for (i = 0; i < count; i++)
+    if (i < n_values)
+      values[i] = GUINT64_FROM_LE (data[i]);
+
+  return data + count;
+}
+
+/**
+ * hyscan_cache_client_new:
+ * @uri: адрес сервера
+ *
+ * Функция создаёт новый объект #HyScanCacheClient.
+ *
+ * Returns: #HyScanCacheClient. Для удаления #g_object_unref.
+ */
+HyScanCacheClient *
+hyscan_cache_client_new (const gchar *uri)
+{
+  return g_object_new (HYSCAN_TYPE_CACHE_CLIENT,
+                       "uri", uri,
+                       NULL);
+}
+
+/**
+ * hyscan_cache_client_new_full:
+ * @uri: адрес сервера
+ * @n_channels: размер пула каналов RPC
+ *
+ * Функция создаёт новый объект #HyScanCacheClient с пулом из нескольких
+ * каналов RPC для одновременной работы из разных потоков. Размер пула
+ * ограничен 64 каналами.
+ *
+ * Returns: #HyScanCacheClient. Для удаления #g_object_unref.
+ */
+HyScanCacheClient *
+hyscan_cache_client_new_full (const gchar *uri,
+                              guint        n_channels)
+{
+  n_channels = CLAMP (n_channels, 1, MAX_CHANNELS);
+
+  return g_object_new (HYSCAN_TYPE_CACHE_CLIENT,
+                       "uri", uri,
+                       "n-channels", n_channels,
+                       NULL);
+}
+
+/**
+ * hyscan_cache_client_set_near_cache:
+ * @client: указатель на #HyScanCacheClient
+ * @size: объём памяти ближнего кэша, байт
+ * @lifetime: время аренды объектов, мс
+ *
+ * Функция включает ближний кэш объектов в памяти процесса. Объекты хранятся
+ * в нём не дольше lifetime миллисекунд, после чего снова запрашиваются у
+ * сервера. Объекты размером больше 1/8 объёма ближнего кэша в нём не
+ * сохраняются. При изменении параметров ближний кэш очищается. Для
+ * выключения необходимо передать size = 0.
+ */
+void
+hyscan_cache_client_set_near_cache (HyScanCacheClient *client,
+                                    gsize              size,
+                                    guint              lifetime)
+{
+  g_return_if_fail (HYSCAN_IS_CACHE_CLIENT (client));
+
+  hyscan_cache_near_configure (client->priv->ncache, size, (gint64) lifetime * G_TIME_SPAN_MILLISECOND);
+}
+
+/**
+ * hyscan_cache_client_get_near_stats:
+ * @client: указатель на #HyScanCacheClient
+ * @hits: (out) (nullable): число попаданий в ближний кэш
+ * @expired: (out) (nullable): число объектов с истёкшим временем аренды
+ *
+ * Функция возвращает статистику ближнего кэша.
+ */
+void
+hyscan_cache_client_get_near_stats (HyScanCacheClient *client,
+                                    guint64           *hits,
+                                    guint64           *expired)
+{
+  g_return_if_fail (HYSCAN_IS_CACHE_CLIENT (client));
+
+  hyscan_cache_near_get_stats (client->priv->ncache, hits, expired);
+}
+
+/**
+ * hyscan_cache_client_get_data:
+ * @client: указатель на #HyScanCacheClient
+ * @key: ключ объекта
+ * @detail: (nullable): вспомогательная информация
+ * @data: (out caller-allocates) (array length=size): память для данных объекта
+ * @size: (inout): размер памяти data на входе, размер объекта на выходе
+ *
+ * Функция считывает данные объекта непосредственно в память вызывающей
+ * стороны, минуя промежуточный #HyScanBuffer. Если объект не помещается
+ * в data, данные не копируются, функция возвращает %FALSE, а в size
+ * записывается размер объекта.
+ *
+ * Returns: %TRUE если данные считаны, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_client_get_data (HyScanCacheClient *client,
+                              const gchar       *key,
+                              const gchar       *detail,
+                              gpointer           data,
+                              guint32           *size)
+{
+  return hyscan_cache_client_get_datai (client, hyscan_hash64 (key), hyscan_hash64 (detail), data, size);
+}
+
+/**
+ * hyscan_cache_client_get_datai:
+ * @client: указатель на #HyScanCacheClient
+ * @key: ключ объекта
+ * @detail: вспомогательная информация
+ * @data: (out caller-allocates) (array length=size): память для данных объекта
+ * @size: (inout): размер памяти data на входе, размер объекта на выходе
+ *
+ * Функция считывает данные объекта непосредственно в память вызывающей
+ * стороны. Функция работает аналогично функции #hyscan_cache_client_get_data.
+ *
+ * Returns: %TRUE если данные считаны, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_client_get_datai (HyScanCacheClient *client,
+                               guint64            key,
+                               guint64            detail,
+                               gpointer           data,
+                               guint32           *size)
+{
+  HyScanCacheClientPrivate *priv;
+  uRpcClient *rpc;
+  uRpcData *urpc_data;
+  guint32 exec_status;
+
+  gboolean status = FALSE;
+  gboolean miss = FALSE;
+  guint32 capacity;
+  guint32 object_size;
+  gpointer object;
+  guint generation;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  g_return_val_if_fail (HYSCAN_IS_CACHE_CLIENT (client), FALSE);
+  g_return_val_if_fail (size != NULL, FALSE);
+
+  priv = client->priv;
+  capacity = *size;
+
+  rpc = hyscan_cache_client_channel (priv);
+  if (rpc == NULL)
+    return FALSE;
+
+  /* Объект в ближнем кэше. */
+  object_size = capacity;
+  if (hyscan_cache_near_lookup_data (priv->ncache, key, detail, data, &object_size))
+    {
+      *size = object_size;
+      if (object_size > capacity)
+        return FALSE;
+
+      hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_HITS, 1);
+      hyscan_cache_counters_add_latency (priv->counters,
+                                         HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_OP_GET * HYSCAN_CACHE_STATS_N_BINS,
+                                         start);
+
+      return TRUE;
+    }
+
+  generation = hyscan_cache_near_get_generation (priv->ncache);
+
+  urpc_data = urpc_client_lock (rpc);
+  if (urpc_data == NULL)
+    hyscan_cache_client_lock_error ();
+
+  if (urpc_data_set_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY, key) != 0)
+    hyscan_cache_client_set_error ("key");
+
+  if (urpc_data_set_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_DETAIL, detail) != 0)
+    hyscan_cache_client_set_error ("detail");
+
+  if (urpc_client_exec (rpc, HYSCAN_CACHE_RPC_PROC_GET) != URPC_STATUS_OK)
+    hyscan_cache_client_exec_error ("get");
+
+  if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, &exec_status) != 0)
+    hyscan_cache_client_get_error ("exec_status");
+
+  if (exec_status == HYSCAN_CACHE_RPC_STATUS_CHUNKED)
+    {
+      if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_SIZE, &object_size) != 0)
+        hyscan_cache_client_get_error ("size");
+
+      /* Объект не помещается в память пользователя, копия объекта
+         на сервере больше не нужна. */
+      *size = object_size;
+      if (object_size > capacity)
+        {
+          hyscan_cache_client_download_cancel (rpc, urpc_data, object_size);
+          goto exit;
+        }
+
+      if (!hyscan_cache_client_download (rpc, urpc_data, object_size, (guint8 **) &data, &object_size, 1))
+        hyscan_cache_client_exec_error ("get-chunk");
+
+      status = TRUE;
+      goto exit;
+    }
+
+  if (exec_status != HYSCAN_CACHE_RPC_STATUS_OK)
+    {
+      miss = TRUE;
+      goto exit;
+    }
+
+  object = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, &object_size);
+  if (object == NULL)
+    object_size = 0;
+
+  *size = object_size;
+  if (object_size > capacity)
+    goto exit;
+
+  /* Данные копируются из буфера RPC сразу в память пользователя. */
+  if (object_size > 0)
+    memcpy (data, object, object_size);
+
+  hyscan_cache_near_insert (priv->ncache, generation, key, NULL, detail, object, object_size);
+
+  status = TRUE;
+
+exit:
+  urpc_client_unlock (rpc);
+
+  if (status || miss)
+    {
+      hyscan_cache_counters_add (priv->counters,
+                                 status ? HYSCAN_CACHE_COUNTER_HITS : HYSCAN_CACHE_COUNTER_MISSES, 1);
+      hyscan_cache_counters_add_latency (priv->counters,
+                                         HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_OP_GET * HYSCAN_CACHE_STATS_N_BINS,
+                                         start);
+    }
+
+  return status;
+}
+
+/**
+ * hyscan_cache_client_get_server_stats:
+ * @client: указатель на #HyScanCacheClient
+ *
+ * Функция запрашивает статистику работы у сервера кэширования.
+ *
+ * Returns: (transfer full) (nullable): #HyScanCacheServerStats или %NULL
+ * в случае ошибки. Для удаления #hyscan_cache_server_stats_free.
+ */
+HyScanCacheServerStats *
+hyscan_cache_client_get_server_stats (HyScanCacheClient *client)
+{
+  HyScanCacheClientPrivate *priv;
+  HyScanCacheServerStats *stats = NULL;
+  uRpcClient *rpc;
+  uRpcData *urpc_data;
+  guint32 exec_status;
+
+  const guint64 *data;
+  const guint64 *end;
+  guint64 header[2];
+  guint32 size;
+  guint i;
+
+  g_return_val_if_fail (HYSCAN_IS_CACHE_CLIENT (client), NULL);
+
+  priv = client->priv;
+
+  rpc = hyscan_cache_client_channel (priv);
+  if (rpc == NULL)
+    return NULL;
+
+  urpc_data = urpc_client_lock (rpc);
+  if (urpc_data == NULL)
+    hyscan_cache_client_lock_error ();
+
+  if (urpc_client_exec (rpc, HYSCAN_CACHE_RPC_PROC_STATS) != URPC_STATUS_OK)
+    hyscan_cache_client_exec_error ("stats");
+
+  if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, &exec_status) != 0)
+    hyscan_cache_client_get_error ("exec_status");
+  if (exec_status != HYSCAN_CACHE_RPC_STATUS_OK)
+    goto exit;
+
+  stats = g_new0 (HyScanCacheServerStats, 1);
+
+  /* Статистика кэша. Число операций и интервалов гистограмм у сервера
+   * может отличаться, лишние значения пропускаются. */
+  data = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_CACHE_STATS, &size);
+  if (data == NULL)
+    hyscan_cache_client_get_error ("cache-stats");
+  end = data + size / sizeof (guint64);
+
+  if ((data = hyscan_cache_client_read_stats (data, end, header, 2, 2)) == NULL ||
+      (data = hyscan_cache_client_read_stats (data, end, &stats->cache.hits,
+                                              HYSCAN_CACHE_RPC_CACHE_STATS_FIELDS,
+                                              HYSCAN_CACHE_RPC_CACHE_STATS_FIELDS)) == NULL)
+    {
+      hyscan_cache_client_get_error ("cache-stats");
+    }
+
+  for (i = 0; i < header[0]; i++)
+    {
+      guint64 *latency = (i < HYSCAN_CACHE_N_OPS) ? stats->cache.latency[i] : NULL;
+
+      data = hyscan_cache_client_read_stats (data, end, latency, latency != NULL ? HYSCAN_CACHE_STATS_N_BINS : 0,
+                                             header[1]);
+      if (data == NULL)
+        hyscan_cache_client_get_error ("cache-stats");
+    }
+
+  /* Статистика процедур. */
+  data = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_PROC_STATS, &size);
+  if (data == NULL)
+    hyscan_cache_client_get_error ("proc-stats");
+  end = data + size / sizeof (guint64);
+
+  if ((data = hyscan_cache_client_read_stats (data, end, header, 2, 2)) == NULL)
+    hyscan_cache_client_get_error ("proc-stats");
+
+  for (i = 0; i < header[0]; i++)
+    {
+      gboolean known = (i < HYSCAN_CACHE_SERVER_N_PROCS);
+
+      data = hyscan_cache_client_read_stats (data, end, known ? &stats->requests[i] : NULL, known ? 1 : 0, 1);
+      if (data != NULL)
+        {
+          data = hyscan_cache_client_read_stats (data, end, known ? stats->latency[i] : NULL,
+                                                 known ? HYSCAN_CACHE_STATS_N_BINS : 0, header[1]);
+        }
+      if (data == NULL)
+        hyscan_cache_client_get_error ("proc-stats");
+    }
+
+  /* Статистика сессий. */
+  data = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_SESSION_STATS, &size);
+  if (data == NULL)
+    hyscan_cache_client_get_error ("session-stats");
+  end = data + size / sizeof (guint64);
+
+  if ((data = hyscan_cache_client_read_stats (data, end, header, 1, 1)) == NULL ||
+      header[0] > (guint64) (end - data) / 3)
+    {
+      hyscan_cache_client_get_error ("session-stats");
+    }
+
+  stats->n_sessions = header[0];
+  stats->sessions = g_new0 (HyScanCacheServerSession, stats->n_sessions + 1);
+  for (i = 0; i < stats->n_sessions; i++)
+    {
+      guint64 values[3];
+
+      data = hyscan_cache_client_read_stats (data, end, values, 3, 3);
+
+      stats->sessions[i].id = values[0];
+      stats->sessions[i].requests = values[1];
+      stats->sessions[i].duration = (gdouble) values[2] / G_USEC_PER_SEC;
+    }
+
+  urpc_client_unlock (rpc);
+
+  return stats;
+
+exit:
+  if (urpc_data != NULL)
+    urpc_client_unlock (rpc);
+
+  hyscan_cache_server_stats_free (stats);
+
+  return NULL;
 }
 
 static void
@@ -356,4 +1977,15 @@ hyscan_cache_client_interface_init (HyScanCacheInterface *iface)
 {
   iface->set = hyscan_cache_client_set;
   iface->get = hyscan_cache_client_get;
+  iface->get_stats = hyscan_cache_client_get_stats;
+  iface->append = hyscan_cache_client_append;
+  iface->get_range = hyscan_cache_client_get_range;
+  iface->setv = hyscan_cache_client_setv;
+  iface->getv = hyscan_cache_client_getv;
+  iface->query = hyscan_cache_client_query;
+  iface->contains_batch = hyscan_cache_client_contains_batch;
+  iface->set128 = hyscan_cache_client_set128;
+  iface->get128 = hyscan_cache_client_get128;
+  iface->set_batch = hyscan_cache_client_set_batch;
+  iface->get_batch = hyscan_cache_client_get_batch;
 }
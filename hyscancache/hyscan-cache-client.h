@@ -35,7 +35,7 @@
 #ifndef __HYSCAN_CACHE_CLIENT_H__
 #define __HYSCAN_CACHE_CLIENT_H__
 
-#include <hyscan-cache.h>
+#include <hyscan-cache-server.h>
 
 G_BEGIN_DECLS
 
@@ -68,6 +68,37 @@ GType                  hyscan_cache_client_get_type    (void);
 HYSCAN_API
 HyScanCacheClient     *hyscan_cache_client_new         (const gchar           *uri);
 
+HYSCAN_API
+HyScanCacheClient     *hyscan_cache_client_new_full    (const gchar           *uri,
+                                                        guint                  n_channels);
+
+HYSCAN_API
+void                   hyscan_cache_client_set_near_cache (HyScanCacheClient  *client,
+                                                        gsize                  size,
+                                                        guint                  lifetime);
+
+HYSCAN_API
+void                   hyscan_cache_client_get_near_stats (HyScanCacheClient  *client,
+                                                        guint64               *hits,
+                                                        guint64               *expired);
+
+HYSCAN_API
+gboolean               hyscan_cache_client_get_data    (HyScanCacheClient     *client,
+                                                        const gchar           *key,
+                                                        const gchar           *detail,
+                                                        gpointer               data,
+                                                        guint32               *size);
+
+HYSCAN_API
+gboolean               hyscan_cache_client_get_datai   (HyScanCacheClient     *client,
+                                                        guint64                key,
+                                                        guint64                detail,
+                                                        gpointer               data,
+                                                        guint32               *size);
+
+HYSCAN_API
+HyScanCacheServerStats *hyscan_cache_client_get_server_stats (HyScanCacheClient *client);
+
 G_END_DECLS
 
 #endif /* __HYSCAN_CACHE_CLIENT_H__ */
@@ -0,0 +1,197 @@
+/* hyscan-cache-counters.c
+ *
+ * Copyright 2015-2019 Screen LLC, Andrei Fadeev <andrei@webcontrol.ru>
+ *
+ * This file is part of HyScanCache.
+ *
+ * HyScanCache is dual-licensed: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HyScanCache is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Alternatively, you can license this code under a commercial license.
+ * Contact the Screen LLC in this case - <info@screen-co.ru>.
+ */
+
+/* HyScanCache имеет двойную лицензию.
+ *
+ * Во-первых, вы можете распространять HyScanCache на условиях Стандартной
+ * Общественной Лицензии GNU версии 3, либо по любой более поздней версии
+ * лицензии (по вашему выбору). Полные положения лицензии GNU приведены в
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Во-вторых, этот программный код можно использовать по коммерческой
+ * лицензии. Для этого свяжитесь с ООО Экран - <info@screen-co.ru>.
+ */
+
+
+/*
+ * Счётчики статистики для реализаций HyScanCache.
+ *
+ * Каждый счётчик хранится в нескольких копиях, по одной на каждый процессор.
+ * Копии разных процессоров размещаются в разных строках кэша процессора,
+ * поэтому увеличение счётчиков из разных потоков не приводит к конкуренции
+ * за общую память. Значение счётчика равно сумме всех его копий.
+ *
+ * Гистограммы времени выполнения операций хранятся как последовательность
+ * из HYSCAN_CACHE_STATS_N_BINS счётчиков, элемент с номером i содержит число
+ * операций, выполненных за время от 2^i до 2^(i+1) наносекунд.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#include <sched.h>
+#endif
+
+#include "hyscan-cache-counters.h"
+
+#include <string.h>
+#include <time.h>
+
+#define CACHE_LINE_SIZE        64
+#define MAX_SLOTS              256
+
+struct _HyScanCacheCounters
+{
+  gpointer             mem;                    /* Выделенная память. */
+  guint64             *values;                 /* Копии счётчиков, выровненные на строку кэша. */
+  guint                stride;                 /* Расстояние между копиями одного счётчика. */
+  guint                mask;                   /* Маска номера копии. */
+};
+
+/* Функция возвращает номер копии счётчиков для текущего потока. */
+static inline guint
+hyscan_cache_counters_slot (HyScanCacheCounters *counters)
+{
+#ifdef __linux__
+  gint cpu = sched_getcpu ();
+
+  if (cpu >= 0)
+    return cpu & counters->mask;
+#endif
+
+  return (GPOINTER_TO_SIZE (g_thread_self ()) / CACHE_LINE_SIZE) & counters->mask;
+}
+
+/* Функция создаёт набор из n_counters счётчиков. */
+HyScanCacheCounters *
+hyscan_cache_counters_new (guint n_counters)
+{
+  HyScanCacheCounters *counters;
+  guint n_slots = 1;
+
+  while (n_slots < (guint) g_get_num_processors () && n_slots < MAX_SLOTS)
+    n_slots *= 2;
+
+  counters = g_new0 (HyScanCacheCounters, 1);
+  counters->stride = (n_counters * sizeof (guint64) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE;
+  counters->stride *= CACHE_LINE_SIZE / sizeof (guint64);
+  counters->mask = n_slots - 1;
+
+  counters->mem = g_malloc0 (n_slots * counters->stride * sizeof (guint64) + CACHE_LINE_SIZE);
+  counters->values = GSIZE_TO_POINTER ((GPOINTER_TO_SIZE (counters->mem) + CACHE_LINE_SIZE - 1) &
+                                       ~((gsize) CACHE_LINE_SIZE - 1));
+
+  return counters;
+}
+
+/* Функция удаляет счётчики. */
+void
+hyscan_cache_counters_free (HyScanCacheCounters *counters)
+{
+  if (counters == NULL)
+    return;
+
+  g_free (counters->mem);
+  g_free (counters);
+}
+
+/* Функция увеличивает значение счётчика. */
+void
+hyscan_cache_counters_add (HyScanCacheCounters *counters,
+                           guint                index,
+                           guint64              value)
+{
+  guint64 *values = counters->values + hyscan_cache_counters_slot (counters) * counters->stride;
+
+  __atomic_fetch_add (&values[index], value, __ATOMIC_RELAXED);
+}
+
+/* Функция учитывает время выполнения операции, начатой в момент start,
+   в гистограмме, начинающейся со счётчика index. */
+void
+hyscan_cache_counters_add_latency (HyScanCacheCounters *counters,
+                                   guint                index,
+                                   gint64               start)
+{
+  gint64 elapsed = hyscan_cache_counters_now () - start;
+  guint bin = 0;
+
+  if (elapsed > 0)
+    bin = MIN (g_bit_storage (elapsed) - 1, HYSCAN_CACHE_STATS_N_BINS - 1);
+
+  hyscan_cache_counters_add (counters, index + bin, 1);
+}
+
+/* Функция суммирует копии n_counters счётчиков, начиная с first. */
+void
+hyscan_cache_counters_sum (HyScanCacheCounters *counters,
+                           guint                first,
+                           guint                n_counters,
+                           guint64             *values)
+{
+  guint i, j;
+
+  memset (values, 0, n_counters * sizeof (guint64));
+
+  for (i = 0; i <= counters->mask; i++)
+    {
+      guint64 *slot = counters->values + i * counters->stride + first;
+
+      for (j = 0; j < n_counters; j++)
+        values[j] += __atomic_load_n (&slot[j], __ATOMIC_RELAXED);
+    }
+}
+
+/* Функция заполняет статистику по счётчикам, созданным с номерами
+   HYSCAN_CACHE_COUNTER_*. Поля используемой памяти не изменяются. */
+void
+hyscan_cache_counters_get_stats (HyScanCacheCounters *counters,
+                                 HyScanCacheStats    *stats)
+{
+  guint64 values[HYSCAN_CACHE_COUNTER_LAST];
+
+  hyscan_cache_counters_sum (counters, 0, HYSCAN_CACHE_COUNTER_LAST, values);
+
+  stats->hits = values[HYSCAN_CACHE_COUNTER_HITS];
+  stats->misses = values[HYSCAN_CACHE_COUNTER_MISSES];
+  stats->detail_mismatches = values[HYSCAN_CACHE_COUNTER_DETAIL_MISMATCHES];
+  stats->sets = values[HYSCAN_CACHE_COUNTER_SETS];
+  stats->evictions = values[HYSCAN_CACHE_COUNTER_EVICTIONS];
+  stats->rejected = values[HYSCAN_CACHE_COUNTER_REJECTED];
+
+  memcpy (stats->latency, values + HYSCAN_CACHE_COUNTER_LATENCY, sizeof (stats->latency));
+}
+
+/* Функция возвращает монотонное время в наносекундах. */
+gint64
+hyscan_cache_counters_now (void)
+{
+#ifdef G_OS_UNIX
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return (gint64) ts.tv_sec * G_GINT64_CONSTANT (1000000000) + ts.tv_nsec;
+#else
+  return g_get_monotonic_time () * 1000;
+#endif
+}
@@ -0,0 +1,82 @@
+/* hyscan-cache-counters.h
+ *
+ * Copyright 2015-2019 Screen LLC, Andrei Fadeev <andrei@webcontrol.ru>
+ *
+ * This file is part of HyScanCache.
+ *
+ * HyScanCache is dual-licensed: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HyScanCache is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Alternatively, you can license this code under a commercial license.
+ * Contact the Screen LLC in this case - <info@screen-co.ru>.
+ */
+
+/* HyScanCache имеет двойную лицензию.
+ *
+ * Во-первых, вы можете распространять HyScanCache на условиях Стандартной
+ * Общественной Лицензии GNU версии 3, либо по любой более поздней версии
+ * лицензии (по вашему выбору). Полные положения лицензии GNU приведены в
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Во-вторых, этот программный код можно использовать по коммерческой
+ * лицензии. Для этого свяжитесь с ООО Экран - <info@screen-co.ru>.
+ */
+
+
+#ifndef __HYSCAN_CACHE_COUNTERS_H__
+#define __HYSCAN_CACHE_COUNTERS_H__
+
+#include <hyscan-cache.h>
+
+G_BEGIN_DECLS
+
+/* Номера счётчиков статистики HyScanCacheStats. */
+enum
+{
+  HYSCAN_CACHE_COUNTER_HITS,
+  HYSCAN_CACHE_COUNTER_MISSES,
+  HYSCAN_CACHE_COUNTER_DETAIL_MISMATCHES,
+  HYSCAN_CACHE_COUNTER_SETS,
+  HYSCAN_CACHE_COUNTER_EVICTIONS,
+  HYSCAN_CACHE_COUNTER_REJECTED,
+  HYSCAN_CACHE_COUNTER_LATENCY,
+  HYSCAN_CACHE_COUNTER_LAST = HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_N_OPS * HYSCAN_CACHE_STATS_N_BINS
+};
+
+typedef struct _HyScanCacheCounters HyScanCacheCounters;
+
+HyScanCacheCounters   *hyscan_cache_counters_new               (guint                  n_counters);
+
+void                   hyscan_cache_counters_free              (HyScanCacheCounters   *counters);
+
+void                   hyscan_cache_counters_add               (HyScanCacheCounters   *counters,
+                                                                guint                  index,
+                                                                guint64                value);
+
+void                   hyscan_cache_counters_add_latency       (HyScanCacheCounters   *counters,
+                                                                guint                  index,
+                                                                gint64                 start);
+
+void                   hyscan_cache_counters_sum               (HyScanCacheCounters   *counters,
+                                                                guint                  first,
+                                                                guint                  n_counters,
+                                                                guint64               *values);
+
+void                   hyscan_cache_counters_get_stats         (HyScanCacheCounters   *counters,
+                                                                HyScanCacheStats      *stats);
+
+gint64                 hyscan_cache_counters_now               (void);
+
+G_END_DECLS
+
+#endif /* __HYSCAN_CACHE_COUNTERS_H__ */
@@ -0,0 +1,153 @@
+/* hyscan-cache-key.c
+ *
+ * Copyright 2015-2019 Screen LLC, Andrei Fadeev <andrei@webcontrol.ru>
+ *
+ * This file is part of HyScanCache.
+ *
+ * HyScanCache is dual-licensed: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HyScanCache is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Alternatively, you can license this code under a commercial license.
+ * Contact the Screen LLC in this case - <info@screen-co.ru>.
+ */
+
+/* HyScanCache имеет двойную лицензию.
+ *
+ * Во-первых, вы можете распространять HyScanCache на условиях Стандартной
+ * Общественной Лицензии GNU версии 3, либо по любой более поздней версии
+ * лицензии (по вашему выбору). Полные положения лицензии GNU приведены в
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Во-вторых, этот программный код можно использовать по коммерческой
+ * лицензии. Для этого свяжитесь с ООО Экран - <info@screen-co.ru>.
+ */
+
+
+/**
+ * SECTION: hyscan-cache-key
+ * @Short_description: построение ключей объектов
+ * @Title: HyScanCacheKey
+ *
+ * Структура #HyScanCacheKey предназначена для построения ключей объектов
+ * без форматирования строк. Ключ состоит из постоянного префикса и
+ * изменяемых составляющих, например:
+ *
+ * - префикс - "Project.Track.Channel";
+ * - составляющие - номер строки и индекс.
+ *
+ * Хэш префикса вычисляется один раз функцией #hyscan_cache_key_init, после
+ * чего структуру можно копировать и добавлять к копии составляющие функциями
+ * #hyscan_cache_key_add_int и #hyscan_cache_key_add_string. Значение ключа
+ * для функций #hyscan_cache_set2i, #hyscan_cache_get2i и т.п. возвращает
+ * функция #hyscan_cache_key_get.
+ *
+ * |[<!-- language="C" -->
+ * HyScanCacheKey prefix, key;
+ *
+ * hyscan_cache_key_init (&prefix, "Project.Track.Channel");
+ *
+ * key = prefix;
+ * hyscan_cache_key_add_int (&key, line);
+ * hyscan_cache_key_add_int (&key, index);
+ * hyscan_cache_get2i (cache, hyscan_cache_key_get (&key), detail, size1, buffer1, buffer2);
+ * ]|
+ *
+ * Значение ключа зависит от порядка добавления составляющих. Ключи,
+ * построенные таким образом, не совпадают с ключами, полученными
+ * хэшированием строки вида "Project.Track.Channel.Line.Index".
+ */
+
+#include "hyscan-cache-key.h"
+#include "hyscan-hash.h"
+
+/* Функция объединяет два 64-х битных значения. Используется та же
+   функция перемешивания, что и в Hash128to64 из FarmHash. */
+static inline guint64
+hyscan_cache_key_combine (guint64 hash,
+                          guint64 value)
+{
+  const guint64 mul = G_GUINT64_CONSTANT (0x9ddfea08eb382d69);
+  guint64 a, b;
+
+  a = (value ^ hash) * mul;
+  a ^= (a >> 47);
+  b = (hash ^ a) * mul;
+  b ^= (b >> 47);
+  b *= mul;
+
+  return b;
+}
+
+/**
+ * hyscan_cache_key_init:
+ * @key: указатель на #HyScanCacheKey
+ * @prefix: (nullable): префикс ключа
+ *
+ * Функция инициализирует ключ значением хэша префикса.
+ */
+void
+hyscan_cache_key_init (HyScanCacheKey *key,
+                       const gchar    *prefix)
+{
+  g_return_if_fail (key != NULL);
+
+  key->hash = hyscan_hash64 (prefix);
+}
+
+/**
+ * hyscan_cache_key_add_int:
+ * @key: указатель на #HyScanCacheKey
+ * @value: целочисленная составляющая ключа
+ *
+ * Функция добавляет к ключу целочисленную составляющую.
+ */
+void
+hyscan_cache_key_add_int (HyScanCacheKey *key,
+                          guint64         value)
+{
+  g_return_if_fail (key != NULL);
+
+  key->hash = hyscan_cache_key_combine (key->hash, value);
+}
+
+/**
+ * hyscan_cache_key_add_string:
+ * @key: указатель на #HyScanCacheKey
+ * @value: (nullable): строковая составляющая ключа
+ *
+ * Функция добавляет к ключу строковую составляющую.
+ */
+void
+hyscan_cache_key_add_string (HyScanCacheKey *key,
+                             const gchar    *value)
+{
+  g_return_if_fail (key != NULL);
+
+  key->hash = hyscan_cache_key_combine (key->hash, hyscan_hash64 (value));
+}
+
+/**
+ * hyscan_cache_key_get:
+ * @key: указатель на #HyScanCacheKey
+ *
+ * Функция возвращает значение ключа объекта.
+ *
+ * Returns: Значение ключа объекта.
+ */
+guint64
+hyscan_cache_key_get (const HyScanCacheKey *key)
+{
+  g_return_val_if_fail (key != NULL, 0);
+
+  return key->hash;
+}
@@ -0,0 +1,371 @@
+/* hyscan-cache-near.c
+ *
+ * Copyright 2015-2019 Screen LLC, Andrei Fadeev <andrei@webcontrol.ru>
+ *
+ * This file is part of HyScanCache.
+ *
+ * HyScanCache is dual-licensed: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HyScanCache is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Alternatively, you can license this code under a commercial license.
+ * Contact the Screen LLC in this case - <info@screen-co.ru>.
+ */
+
+/* HyScanCache имеет двойную лицензию.
+ *
+ * Во-первых, вы можете распространять HyScanCache на условиях Стандартной
+ * Общественной Лицензии GNU версии 3, либо по любой более поздней версии
+ * лицензии (по вашему выбору). Полные положения лицензии GNU приведены в
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Во-вторых, этот программный код можно использовать по коммерческой
+ * лицензии. Для этого свяжитесь с ООО Экран - <info@screen-co.ru>.
+ */
+
+/*
+ * Ближний кэш объектов клиента HyScanCacheClient.
+ *
+ * Объекты, прочитанные с сервера, сохраняются в памяти процесса и при
+ * повторном чтении возвращаются без обращения к серверу. Объём памяти
+ * ближнего кэша ограничен, при его превышении удаляются давно
+ * использованные объекты.
+ *
+ * Сервер не уведомляет клиентов об изменении объектов, поэтому каждый
+ * объект хранится в ближнем кэше не дольше заданного времени (аренды).
+ * Изменение объекта другим клиентом становится видно не позднее окончания
+ * аренды. Объекты, изменяемые самим клиентом, удаляются из ближнего кэша
+ * сразу.
+ *
+ * Чтение с сервера может завершиться после того, как другой поток клиента
+ * изменил объект и удалил его из ближнего кэша. Чтобы прочитанные ранее
+ * данные не были сохранены после удаления, каждое удаление увеличивает номер
+ * поколения ближнего кэша. Номер запоминается перед обращением к серверу,
+ * и если он изменился, прочитанные данные не сохраняются.
+ */
+
+#include "hyscan-cache-near.h"
+
+#include <string.h>
+
+/* Объект ближнего кэша. */
+typedef struct
+{
+  GList                link;                   /* Элемент списка используемых объектов. */
+  guint64              key;                    /* Ключ объекта. */
+  guint64              key_hi;                 /* Старшая половина 128-ми битного ключа. */
+  gboolean             has_hi;                 /* Признак 128-ми битного ключа. */
+  guint64              detail;                 /* Дополнительная информация, 0 - неизвестна. */
+  gint64               expires;                /* Время окончания аренды. */
+  guint32              size;                   /* Размер данных. */
+  guint8               data[];                 /* Данные объекта. */
+} HyScanCacheNearObject;
+
+struct _HyScanCacheNear
+{
+  GMutex               lock;                   /* Блокировка доступа. */
+  GHashTable          *objects;                /* Объекты по ключам. */
+  GQueue               used;                   /* Объекты в порядке использования. */
+
+  volatile gsize       size;                   /* Максимальный объём данных. */
+  gsize                used_size;              /* Объём данных объектов. */
+  gint64               lifetime;               /* Время аренды объектов, мкс. */
+  volatile gint        generation;             /* Номер поколения, изменяется при удалении объектов. */
+
+  guint64              hits;                   /* Число попаданий. */
+  guint64              expired;                /* Число объектов с истёкшей арендой. */
+};
+
+/* Функция удаляет объект. Вызывается при захваченной блокировке. */
+static void
+hyscan_cache_near_remove (HyScanCacheNear       *ncache,
+                          HyScanCacheNearObject *object)
+{
+  g_hash_table_remove (ncache->objects, &object->key);
+  g_queue_unlink (&ncache->used, &object->link);
+  ncache->used_size -= sizeof (HyScanCacheNearObject) + object->size;
+  g_free (object);
+}
+
+/* Функция удаляет все объекты. Вызывается при захваченной блокировке. */
+static void
+hyscan_cache_near_clear (HyScanCacheNear *ncache)
+{
+  while (ncache->used.tail != NULL)
+    hyscan_cache_near_remove (ncache, ncache->used.tail->data);
+}
+
+/* Функция создаёт ближний кэш. По умолчанию ближний кэш выключен. */
+HyScanCacheNear *
+hyscan_cache_near_new (void)
+{
+  HyScanCacheNear *ncache;
+
+  ncache = g_new0 (HyScanCacheNear, 1);
+  g_mutex_init (&ncache->lock);
+  ncache->objects = g_hash_table_new (g_int64_hash, g_int64_equal);
+  g_queue_init (&ncache->used);
+
+  return ncache;
+}
+
+/* Функция удаляет ближний кэш. */
+void
+hyscan_cache_near_free (HyScanCacheNear *ncache)
+{
+  if (ncache == NULL)
+    return;
+
+  hyscan_cache_near_clear (ncache);
+  g_hash_table_unref (ncache->objects);
+  g_mutex_clear (&ncache->lock);
+  g_free (ncache);
+}
+
+/* Функция задаёт объём памяти ближнего кэша и время аренды объектов.
+   Если объём равен нулю, ближний кэш выключается. */
+void
+hyscan_cache_near_configure (HyScanCacheNear *ncache,
+                             gsize            size,
+                             gint64           lifetime)
+{
+  g_atomic_int_inc (&ncache->generation);
+
+  g_mutex_lock (&ncache->lock);
+
+  hyscan_cache_near_clear (ncache);
+  ncache->lifetime = lifetime;
+  g_atomic_pointer_set (&ncache->size, size);
+
+  g_mutex_unlock (&ncache->lock);
+}
+
+/* Функция считывает объект из ближнего кэша. Данные распределяются по
+   буферам так же, как при чтении с сервера. */
+gboolean
+hyscan_cache_near_lookup (HyScanCacheNear  *ncache,
+                          guint64           key,
+                          const guint64    *key_hi,
+                          guint64           detail,
+                          const guint32    *sizes,
+                          HyScanBuffer    **buffers,
+                          guint             n_buffers)
+{
+  HyScanCacheNearObject *object;
+  gboolean status = FALSE;
+  guint32 offset = 0;
+  guint i;
+
+  if (g_atomic_pointer_get (&ncache->size) == 0)
+    return FALSE;
+
+  g_mutex_lock (&ncache->lock);
+
+  object = g_hash_table_lookup (ncache->objects, &key);
+  if (object == NULL)
+    goto exit;
+
+  /* Аренда объекта истекла. */
+  if (g_get_monotonic_time () > object->expires)
+    {
+      hyscan_cache_near_remove (ncache, object);
+      ncache->expired += 1;
+      goto exit;
+    }
+
+  /* Объект записан по другому ключу или с другой дополнительной информацией. */
+  if ((key_hi != NULL) != object->has_hi || (key_hi != NULL && *key_hi != object->key_hi))
+    goto exit;
+  if (detail != 0 && object->detail != detail)
+    goto exit;
+
+  for (i = 0; i < n_buffers; i++)
+    {
+      guint32 part = object->size - offset;
+
+      if (i + 1 < n_buffers)
+        part = MIN (part, sizes[i]);
+
+      if (buffers[i] != NULL)
+        hyscan_buffer_set (buffers[i], HYSCAN_DATA_BLOB, object->data + offset, part);
+
+      offset += part;
+    }
+
+  /* Перемещаем объект в начало списка используемых. */
+  g_queue_unlink (&ncache->used, &object->link);
+  g_queue_push_head_link (&ncache->used, &object->link);
+
+  ncache->hits += 1;
+  status = TRUE;
+
+exit:
+  g_mutex_unlock (&ncache->lock);
+
+  return status;
+}
+
+/* Функция считывает объект из ближнего кэша в память вызывающей стороны.
+   На входе size содержит размер области data, на выходе размер объекта.
+   Если объект найден, но не помещается в data, данные не копируются. */
+gboolean
+hyscan_cache_near_lookup_data (HyScanCacheNear *ncache,
+                               guint64          key,
+                               guint64          detail,
+                               gpointer         data,
+                               guint32         *size)
+{
+  HyScanCacheNearObject *object;
+  gboolean status = FALSE;
+
+  if (g_atomic_pointer_get (&ncache->size) == 0)
+    return FALSE;
+
+  g_mutex_lock (&ncache->lock);
+
+  object = g_hash_table_lookup (ncache->objects, &key);
+  if (object == NULL)
+    goto exit;
+
+  if (g_get_monotonic_time () > object->expires)
+    {
+      hyscan_cache_near_remove (ncache, object);
+      ncache->expired += 1;
+      goto exit;
+    }
+
+  if (object->has_hi || (detail != 0 && object->detail != detail))
+    goto exit;
+
+  if (object->size <= *size)
+    {
+      if (object->size > 0)
+        memcpy (data, object->data, object->size);
+
+      g_queue_unlink (&ncache->used, &object->link);
+      g_queue_push_head_link (&ncache->used, &object->link);
+
+      ncache->hits += 1;
+    }
+
+  *size = object->size;
+  status = TRUE;
+
+exit:
+  g_mutex_unlock (&ncache->lock);
+
+  return status;
+}
+
+/* Функция возвращает номер поколения ближнего кэша. Номер необходимо
+   получить до обращения к серверу и передать в hyscan_cache_near_insert. */
+guint
+hyscan_cache_near_get_generation (HyScanCacheNear *ncache)
+{
+  return g_atomic_int_get (&ncache->generation);
+}
+
+/* Функция сохраняет объект, прочитанный с сервера. Объекты размером больше
+   1/8 объёма ближнего кэша не сохраняются. Объект не сохраняется, если после
+   получения номера поколения generation объекты удалялись. */
+void
+hyscan_cache_near_insert (HyScanCacheNear *ncache,
+                          guint            generation,
+                          guint64          key,
+                          const guint64   *key_hi,
+                          guint64          detail,
+                          gconstpointer    data,
+                          guint32          size)
+{
+  HyScanCacheNearObject *object;
+  gsize object_size;
+  gsize max_size;
+
+  max_size = g_atomic_pointer_get (&ncache->size);
+  object_size = sizeof (HyScanCacheNearObject) + size;
+  if (max_size == 0 || object_size > max_size / 8)
+    return;
+
+  g_mutex_lock (&ncache->lock);
+
+  /* Номер поколения проверяется под блокировкой: удаление увеличивает его
+     до захвата блокировки, поэтому либо объект не будет сохранён, либо
+     будет удалён после сохранения. */
+  if ((guint) g_atomic_int_get (&ncache->generation) != generation)
+    {
+      g_mutex_unlock (&ncache->lock);
+      return;
+    }
+
+  object = g_hash_table_lookup (ncache->objects, &key);
+  if (object != NULL)
+    hyscan_cache_near_remove (ncache, object);
+
+  /* Удаляем давно использованные объекты. */
+  while (ncache->used.tail != NULL && ncache->used_size + object_size > ncache->size)
+    hyscan_cache_near_remove (ncache, ncache->used.tail->data);
+
+  object = g_malloc (object_size);
+  object->link.data = object;
+  object->link.prev = NULL;
+  object->link.next = NULL;
+  object->key = key;
+  object->key_hi = (key_hi != NULL) ? *key_hi : 0;
+  object->has_hi = (key_hi != NULL);
+  object->detail = detail;
+  object->expires = g_get_monotonic_time () + ncache->lifetime;
+  object->size = size;
+  memcpy (object->data, data, size);
+
+  g_hash_table_insert (ncache->objects, &object->key, object);
+  g_queue_push_head_link (&ncache->used, &object->link);
+  ncache->used_size += object_size;
+
+  g_mutex_unlock (&ncache->lock);
+}
+
+/* Функция удаляет объект из ближнего кэша. */
+void
+hyscan_cache_near_invalidate (HyScanCacheNear *ncache,
+                              guint64          key)
+{
+  HyScanCacheNearObject *object;
+
+  g_atomic_int_inc (&ncache->generation);
+
+  if (g_atomic_pointer_get (&ncache->size) == 0)
+    return;
+
+  g_mutex_lock (&ncache->lock);
+
+  object = g_hash_table_lookup (ncache->objects, &key);
+  if (object != NULL)
+    hyscan_cache_near_remove (ncache, object);
+
+  g_mutex_unlock (&ncache->lock);
+}
+
+/* Функция возвращает статистику ближнего кэша. */
+void
+hyscan_cache_near_get_stats (HyScanCacheNear *ncache,
+                             guint64         *hits,
+                             guint64         *expired)
+{
+  g_mutex_lock (&ncache->lock);
+
+  if (hits != NULL)
+    *hits = ncache->hits;
+  if (expired != NULL)
+    *expired = ncache->expired;
+
+  g_mutex_unlock (&ncache->lock);
+}
@@ -0,0 +1,85 @@
+/* hyscan-cache-near.h
+ *
+ * Copyright 2015-2019 Screen LLC, Andrei Fadeev <andrei@webcontrol.ru>
+ *
+ * This file is part of HyScanCache.
+ *
+ * HyScanCache is dual-licensed: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HyScanCache is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Alternatively, you can license this code under a commercial license.
+ * Contact the Screen LLC in this case - <info@screen-co.ru>.
+ */
+
+/* HyScanCache имеет двойную лицензию.
+ *
+ * Во-первых, вы можете распространять HyScanCache на условиях Стандартной
+ * Общественной Лицензии GNU версии 3, либо по любой более поздней версии
+ * лицензии (по вашему выбору). Полные положения лицензии GNU приведены в
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Во-вторых, этот программный код можно использовать по коммерческой
+ * лицензии. Для этого свяжитесь с ООО Экран - <info@screen-co.ru>.
+ */
+
+#ifndef __HYSCAN_CACHE_NEAR_H__
+#define __HYSCAN_CACHE_NEAR_H__
+
+#include <hyscan-buffer.h>
+
+G_BEGIN_DECLS
+
+typedef struct _HyScanCacheNear HyScanCacheNear;
+
+HyScanCacheNear       *hyscan_cache_near_new                   (void);
+
+void                   hyscan_cache_near_free                  (HyScanCacheNear       *ncache);
+
+void                   hyscan_cache_near_configure             (HyScanCacheNear       *ncache,
+                                                                gsize                  size,
+                                                                gint64                 lifetime);
+
+gboolean               hyscan_cache_near_lookup                (HyScanCacheNear       *ncache,
+                                                                guint64                key,
+                                                                const guint64         *key_hi,
+                                                                guint64                detail,
+                                                                const guint32         *sizes,
+                                                                HyScanBuffer         **buffers,
+                                                                guint                  n_buffers);
+
+gboolean               hyscan_cache_near_lookup_data           (HyScanCacheNear       *ncache,
+                                                                guint64                key,
+                                                                guint64                detail,
+                                                                gpointer               data,
+                                                                guint32               *size);
+
+guint                  hyscan_cache_near_get_generation        (HyScanCacheNear       *ncache);
+
+void                   hyscan_cache_near_insert                (HyScanCacheNear       *ncache,
+                                                                guint                  generation,
+                                                                guint64                key,
+                                                                const guint64         *key_hi,
+                                                                guint64                detail,
+                                                                gconstpointer          data,
+                                                                guint32                size);
+
+void                   hyscan_cache_near_invalidate            (HyScanCacheNear       *ncache,
+                                                                guint64                key);
+
+void                   hyscan_cache_near_get_stats             (HyScanCacheNear       *ncache,
+                                                                guint64               *hits,
+                                                                guint64               *expired);
+
+G_END_DECLS
+
+#endif /* __HYSCAN_CACHE_NEAR_H__ */
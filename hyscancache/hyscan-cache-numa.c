@@ -0,0 +1,976 @@
+/* hyscan-cache-numa.c
+ *
+ * Copyright 2015-2019 Screen LLC, Andrei Fadeev <andrei@webcontrol.ru>
+ *
+ * This file is part of HyScanCache.
+ *
+ * HyScanCache is dual-licensed: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HyScanCache is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Alternatively, you can license this code under a commercial license.
+ * Contact the Screen LLC in this case - <info@screen-co.ru>.
+ */
+
+/* HyScanCache имеет двойную лицензию.
+ *
+ * Во-первых, вы можете распространять HyScanCache на условиях Стандартной
+ * Общественной Лицензии GNU версии 3, либо по любой более поздней версии
+ * лицензии (по вашему выбору). Полные положения лицензии GNU приведены в
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Во-вторых, этот программный код можно использовать по коммерческой
+ * лицензии. Для этого свяжитесь с ООО Экран - <info@screen-co.ru>.
+ */
+
+
+/**
+ * SECTION: hyscan-cache-numa
+ * @Short_description: кэширование данных с учётом NUMA
+ * @Title: HyScanCacheNuma
+ *
+ * HyScanCacheNuma реализация интерфейса #HyScanCache для многопроцессорных
+ * систем с неоднородным доступом к памяти (NUMA). Кэш разделяется на части
+ * по числу NUMA узлов, каждая часть является объектом #HyScanCached.
+ *
+ * Объекты сохраняются в часть кэша узла, на котором выполняется поток,
+ * записывающий данные. Так как память выделяется и заполняется этим же
+ * потоком, ядро размещает её на этом узле. Копия объекта в частях других
+ * узлов при этом удаляется. Чтение данных выполняется сначала из части
+ * кэша текущего узла, а при её отсутствии - из частей других узлов.
+ * Число попаданий в локальную и удалённые части кэша можно узнать
+ * функцией #hyscan_cache_numa_get_hits.
+ *
+ * Размещение работает, если потоки не мигрируют между узлами. Закрепить
+ * поток за узлом можно функцией #hyscan_cache_numa_bind_thread, сервер
+ * #HyScanCacheServer делает это для своих потоков автоматически.
+ *
+ * Информация о NUMA узлах определяется только в Linux, в остальных
+ * системах используется один узел.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#include <sched.h>
+#endif
+
+#include "hyscan-cache-numa.h"
+#include "hyscan-cached.h"
+#include "hyscan-cache-counters.h"
+#include "hyscan-cached-scan.h"
+
+#include <stdlib.h>
+
+#ifdef CPU_ARCH_X32
+  #define MIN_CACHE_SIZE   64
+  #define MAX_CACHE_SIZE   2048
+#else
+  #define MIN_CACHE_SIZE   64
+  #define MAX_CACHE_SIZE   131072
+#endif
+
+#define MAX_NODES          64
+#define N_SET_LOCKS        64
+
+enum
+{
+  PROP_O,
+  PROP_CACHE_SIZE
+};
+
+/* Внутренние данные объекта. */
+struct _HyScanCacheNumaPrivate
+{
+  guint32              cache_size;             /* Общий объём памяти, Мб. */
+
+  guint                n_nodes;                /* Число NUMA узлов. */
+  HyScanCache        **shards;                 /* Части кэша NUMA узлов. */
+  GArray             **node_cpus;              /* Процессоры NUMA узлов. */
+  guint               *cpu_nodes;              /* NUMA узлы процессоров. */
+  guint                n_cpus;                 /* Число элементов в cpu_nodes. */
+
+  GMutex               set_locks[N_SET_LOCKS]; /* Блокировки записи объектов. */
+
+  volatile gsize       local_hits;             /* Число попаданий в часть кэша текущего узла. */
+  volatile gsize       remote_hits;            /* Число попаданий в части кэша других узлов. */
+  volatile gsize       misses;                 /* Число промахов. */
+
+  HyScanCacheCounters *counters;               /* Счётчики статистики. */
+  HyScanCachedScan    *scan;                   /* Обнаружение последовательного просмотра. */
+};
+
+static void            hyscan_cache_numa_interface_init        (HyScanCacheInterface   *iface);
+static void            hyscan_cache_numa_set_property          (GObject                *object,
+                                                                guint                   prop_id,
+                                                                const GValue           *value,
+                                                                GParamSpec             *pspec);
+static void            hyscan_cache_numa_object_constructed    (GObject                *object);
+static void            hyscan_cache_numa_object_finalize       (GObject                *object);
+
+static void            hyscan_cache_numa_load_topology         (HyScanCacheNumaPrivate *priv);
+static guint           hyscan_cache_numa_current_node          (HyScanCacheNumaPrivate *priv);
+
+G_DEFINE_TYPE_WITH_CODE (HyScanCacheNuma, hyscan_cache_numa, G_TYPE_OBJECT,
+                         G_ADD_PRIVATE (HyScanCacheNuma)
+                         G_IMPLEMENT_INTERFACE (HYSCAN_TYPE_CACHE, hyscan_cache_numa_interface_init));
+
+static void
+hyscan_cache_numa_class_init (HyScanCacheNumaClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->set_property = hyscan_cache_numa_set_property;
+  object_class->constructed = hyscan_cache_numa_object_constructed;
+  object_class->finalize = hyscan_cache_numa_object_finalize;
+
+  g_object_class_install_property (object_class, PROP_CACHE_SIZE,
+                                   g_param_spec_uint ("cache-size", "Cache size", "Cache size, Mb",
+                                                      MIN_CACHE_SIZE, MAX_CACHE_SIZE, MIN_CACHE_SIZE,
+                                                      G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
+}
+
+static void
+hyscan_cache_numa_init (HyScanCacheNuma *numa)
+{
+  numa->priv = hyscan_cache_numa_get_instance_private (numa);
+}
+
+static void
+hyscan_cache_numa_set_property (GObject      *object,
+                                guint         prop_id,
+                                const GValue *value,
+                                GParamSpec   *pspec)
+{
+  HyScanCacheNuma *numa = HYSCAN_CACHE_NUMA (object);
+  HyScanCacheNumaPrivate *priv = numa->priv;
+
+  switch (prop_id)
+    {
+    case PROP_CACHE_SIZE:
+      priv->cache_size = g_value_get_uint (value);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+hyscan_cache_numa_object_constructed (GObject *object)
+{
+  HyScanCacheNuma *numa = HYSCAN_CACHE_NUMA (object);
+  HyScanCacheNumaPrivate *priv = numa->priv;
+  guint32 shard_size;
+  guint i;
+
+  for (i = 0; i < N_SET_LOCKS; i++)
+    g_mutex_init (&priv->set_locks[i]);
+
+  priv->counters = hyscan_cache_counters_new (HYSCAN_CACHE_COUNTER_LAST);
+  priv->scan = hyscan_cached_scan_new ();
+
+  hyscan_cache_numa_load_topology (priv);
+
+  /* Части кэша NUMA узлов. */
+  shard_size = MAX (priv->cache_size / priv->n_nodes, MIN_CACHE_SIZE);
+  priv->shards = g_new0 (HyScanCache *, priv->n_nodes);
+  /* Промахи учитываются для кэша в целом, а не при поиске в каждой части. */
+  for (i = 0; i < priv->n_nodes; i++)
+    {
+      priv->shards[i] = HYSCAN_CACHE (hyscan_cached_new (shard_size));
+      hyscan_cached_set_scan (HYSCAN_CACHED (priv->shards[i]), priv->scan);
+    }
+}
+
+static void
+hyscan_cache_numa_object_finalize (GObject *object)
+{
+  HyScanCacheNuma *numa = HYSCAN_CACHE_NUMA (object);
+  HyScanCacheNumaPrivate *priv = numa->priv;
+  guint i;
+
+  for (i = 0; i < priv->n_nodes; i++)
+    {
+      g_object_unref (priv->shards[i]);
+      g_array_unref (priv->node_cpus[i]);
+    }
+
+  g_free (priv->shards);
+  g_free (priv->node_cpus);
+  g_free (priv->cpu_nodes);
+  hyscan_cache_counters_free (priv->counters);
+  hyscan_cached_scan_free (priv->scan);
+
+  for (i = 0; i < N_SET_LOCKS; i++)
+    g_mutex_clear (&priv->set_locks[i]);
+
+  G_OBJECT_CLASS (hyscan_cache_numa_parent_class)->finalize (object);
+}
+
+/* Функция определяет NUMA узлы и принадлежащие им процессоры. */
+static void
+hyscan_cache_numa_load_topology (HyScanCacheNumaPrivate *priv)
+{
+  guint max_cpu = 0;
+  guint i, j;
+
+  priv->node_cpus = g_new0 (GArray *, MAX_NODES);
+
+#ifdef __linux__
+  for (i = 0; i < MAX_NODES; i++)
+    {
+      gchar *path;
+      gchar *cpulist;
+      gchar **ranges;
+      GArray *cpus;
+
+      path = g_strdup_printf ("/sys/devices/system/node/node%u/cpulist", i);
+      if (!g_file_get_contents (path, &cpulist, NULL, NULL))
+        {
+          g_free (path);
+          break;
+        }
+      g_free (path);
+
+      /* Список процессоров в виде "0-7,16-23". */
+      cpus = g_array_new (FALSE, FALSE, sizeof (guint));
+      ranges = g_strsplit (g_strstrip (cpulist), ",", -1);
+      for (j = 0; ranges[j] != NULL; j++)
+        {
+          gchar *end;
+          guint first, last, cpu;
+
+          if (*ranges[j] == '\0')
+            continue;
+
+          first = g_ascii_strtoull (ranges[j], &end, 10);
+          last = (*end == '-') ? g_ascii_strtoull (end + 1, NULL, 10) : first;
+
+          for (cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+            {
+              g_array_append_val (cpus, cpu);
+              max_cpu = MAX (max_cpu, cpu);
+            }
+        }
+
+      g_strfreev (ranges);
+      g_free (cpulist);
+
+      priv->node_cpus[i] = cpus;
+    }
+
+  priv->n_nodes = i;
+#endif
+
+  /* Информации о NUMA нет, используем один узел. */
+  if (priv->n_nodes == 0)
+    {
+      priv->n_nodes = 1;
+      priv->node_cpus[0] = g_array_new (FALSE, FALSE, sizeof (guint));
+    }
+
+  /* Таблица соответствия процессоров узлам. */
+  priv->n_cpus = max_cpu + 1;
+  priv->cpu_nodes = g_new0 (guint, priv->n_cpus);
+  for (i = 0; i < priv->n_nodes; i++)
+    {
+      for (j = 0; j < priv->node_cpus[i]->len; j++)
+        priv->cpu_nodes[g_array_index (priv->node_cpus[i], guint, j)] = i;
+    }
+}
+
+/* Функция возвращает NUMA узел, на котором выполняется текущий поток. */
+static guint
+hyscan_cache_numa_current_node (HyScanCacheNumaPrivate *priv)
+{
+#ifdef __linux__
+  gint cpu;
+
+  if (priv->n_nodes == 1)
+    return 0;
+
+  cpu = sched_getcpu ();
+  if (cpu >= 0 && (guint) cpu < priv->n_cpus)
+    return priv->cpu_nodes[cpu];
+#endif
+
+  return 0;
+}
+
+/**
+ * hyscan_cache_numa_new:
+ * @cache_size: максимальный объём памяти, Мб
+ *
+ * Функция создаёт новый объект #HyScanCacheNuma. Объём памяти делится
+ * поровну между NUMA узлами.
+ *
+ * Returns: #HyScanCacheNuma. Для удаления #g_object_unref.
+ */
+HyScanCacheNuma *
+hyscan_cache_numa_new (guint32 cache_size)
+{
+  return g_object_new (HYSCAN_TYPE_CACHE_NUMA, "cache-size", cache_size, NULL);
+}
+
+/**
+ * hyscan_cache_numa_get_n_nodes:
+ * @numa: указатель на #HyScanCacheNuma
+ *
+ * Функция возвращает число NUMA узлов.
+ *
+ * Returns: Число NUMA узлов.
+ */
+guint
+hyscan_cache_numa_get_n_nodes (HyScanCacheNuma *numa)
+{
+  g_return_val_if_fail (HYSCAN_IS_CACHE_NUMA (numa), 0);
+
+  return numa->priv->n_nodes;
+}
+
+/**
+ * hyscan_cache_numa_bind_thread:
+ * @numa: указатель на #HyScanCacheNuma
+ * @node: номер NUMA узла
+ *
+ * Функция закрепляет текущий поток за процессорами NUMA узла.
+ *
+ * Returns: %TRUE если поток закреплён, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_numa_bind_thread (HyScanCacheNuma *numa,
+                               guint            node)
+{
+#ifdef __linux__
+  HyScanCacheNumaPrivate *priv;
+  cpu_set_t cpu_set;
+  guint i;
+
+  g_return_val_if_fail (HYSCAN_IS_CACHE_NUMA (numa), FALSE);
+
+  priv = numa->priv;
+
+  if (node >= priv->n_nodes || priv->node_cpus[node]->len == 0)
+    return FALSE;
+
+  CPU_ZERO (&cpu_set);
+  for (i = 0; i < priv->node_cpus[node]->len; i++)
+    CPU_SET (g_array_index (priv->node_cpus[node], guint, i), &cpu_set);
+
+  return (sched_setaffinity (0, sizeof (cpu_set), &cpu_set) == 0);
+#else
+  return FALSE;
+#endif
+}
+
+/**
+ * hyscan_cache_numa_get_hits:
+ * @numa: указатель на #HyScanCacheNuma
+ * @local_hits: (out) (nullable): число попаданий в часть кэша текущего узла
+ * @remote_hits: (out) (nullable): число попаданий в части кэша других узлов
+ * @misses: (out) (nullable): число промахов
+ *
+ * Функция возвращает статистику чтения данных из кэша.
+ */
+void
+hyscan_cache_numa_get_hits (HyScanCacheNuma *numa,
+                            guint64         *local_hits,
+                            guint64         *remote_hits,
+                            guint64         *misses)
+{
+  HyScanCacheNumaPrivate *priv;
+
+  g_return_if_fail (HYSCAN_IS_CACHE_NUMA (numa));
+
+  priv = numa->priv;
+
+  if (local_hits != NULL)
+    *local_hits = g_atomic_pointer_get (&priv->local_hits);
+  if (remote_hits != NULL)
+    *remote_hits = g_atomic_pointer_get (&priv->remote_hits);
+  if (misses != NULL)
+    *misses = g_atomic_pointer_get (&priv->misses);
+}
+
+/**
+ * hyscan_cache_numa_set_key_verification:
+ * @numa: указатель на #HyScanCacheNuma
+ * @enable: признак проверки ключей
+ *
+ * Функция включает проверку ключей объектов, записанных по 128-ми битному
+ * ключу, во всех частях кэша (см. #hyscan_cached_set_key_verification).
+ */
+void
+hyscan_cache_numa_set_key_verification (HyScanCacheNuma *numa,
+                                        gboolean         enable)
+{
+  HyScanCacheNumaPrivate *priv;
+  guint i;
+
+  g_return_if_fail (HYSCAN_IS_CACHE_NUMA (numa));
+
+  priv = numa->priv;
+
+  for (i = 0; i < priv->n_nodes; i++)
+    hyscan_cached_set_key_verification (HYSCAN_CACHED (priv->shards[i]), enable);
+}
+
+/**
+ * hyscan_cache_numa_set_checksums:
+ * @numa: указатель на #HyScanCacheNuma
+ * @enable: признак вычисления контрольных сумм
+ *
+ * Функция включает вычисление контрольных сумм данных объектов во всех
+ * частях кэша (см. #hyscan_cached_set_checksums).
+ */
+void
+hyscan_cache_numa_set_checksums (HyScanCacheNuma *numa,
+                                 gboolean         enable)
+{
+  HyScanCacheNumaPrivate *priv;
+  guint i;
+
+  g_return_if_fail (HYSCAN_IS_CACHE_NUMA (numa));
+
+  priv = numa->priv;
+
+  for (i = 0; i < priv->n_nodes; i++)
+    hyscan_cached_set_checksums (HYSCAN_CACHED (priv->shards[i]), enable);
+}
+
+/**
+ * hyscan_cache_numa_set_scrub_rate:
+ * @numa: указатель на #HyScanCacheNuma
+ * @rate: объём проверяемых данных в секунду, Мб
+ *
+ * Функция включает фоновую проверку контрольных сумм объектов в каждой
+ * части кэша (см. #hyscan_cached_set_scrub_rate). Скорость проверки
+ * задаётся для каждой части кэша отдельно.
+ */
+void
+hyscan_cache_numa_set_scrub_rate (HyScanCacheNuma *numa,
+                                  guint            rate)
+{
+  HyScanCacheNumaPrivate *priv;
+  guint i;
+
+  g_return_if_fail (HYSCAN_IS_CACHE_NUMA (numa));
+
+  priv = numa->priv;
+
+  for (i = 0; i < priv->n_nodes; i++)
+    hyscan_cached_set_scrub_rate (HYSCAN_CACHED (priv->shards[i]), rate);
+}
+
+/**
+ * hyscan_cache_numa_set_scan_threshold:
+ * @numa: указатель на #HyScanCacheNuma
+ * @threshold: число промахов подряд
+ *
+ * Функция задаёт порог обнаружения последовательного просмотра данных
+ * (см. #hyscan_cached_set_scan_threshold). Промахом считается отсутствие
+ * объекта во всех частях кэша. По умолчанию обнаружение выключено.
+ */
+void
+hyscan_cache_numa_set_scan_threshold (HyScanCacheNuma *numa,
+                                      guint            threshold)
+{
+  g_return_if_fail (HYSCAN_IS_CACHE_NUMA (numa));
+
+  hyscan_cached_scan_set_threshold (numa->priv->scan, threshold);
+}
+
+/* Функция учитывает результат записи объекта. Удаление объекта, то есть
+   запись без данных, не учитывается. */
+static void
+hyscan_cache_numa_count_set (HyScanCacheNumaPrivate  *priv,
+                             gboolean                 status,
+                             HyScanBuffer           **buffers,
+                             guint                    n_buffers)
+{
+  guint i;
+
+  if (!status)
+    {
+      hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_REJECTED, 1);
+      return;
+    }
+
+  for (i = 0; i < n_buffers; i++)
+    {
+      guint32 part = 0;
+
+      if (buffers[i] != NULL && hyscan_buffer_get (buffers[i], NULL, &part) != NULL && part > 0)
+        {
+          hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_SETS, 1);
+          return;
+        }
+    }
+}
+
+/* Функция добавляет или изменяет объект в кэше. */
+static gboolean
+hyscan_cache_numa_setv (HyScanCache   *cache,
+                        guint64        key,
+                        guint64        detail,
+                        HyScanBuffer **buffers,
+                        guint          n_buffers)
+{
+  HyScanCacheNuma *numa = HYSCAN_CACHE_NUMA (cache);
+  HyScanCacheNumaPrivate *priv = numa->priv;
+  GMutex *lock = &priv->set_locks[key % N_SET_LOCKS];
+  gboolean status;
+  guint node;
+  guint i;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  node = hyscan_cache_numa_current_node (priv);
+
+  /* Запись одного объекта с разных узлов выполняется последовательно,
+     чтобы в кэше осталась только одна его копия. */
+  g_mutex_lock (lock);
+
+  for (i = 0; i < priv->n_nodes; i++)
+    {
+      if (i != node)
+        hyscan_cache_set2i (priv->shards[i], key, 0, NULL, NULL);
+    }
+
+  status = hyscan_cache_setvi (priv->shards[node], key, detail, buffers, n_buffers);
+
+  g_mutex_unlock (lock);
+
+  hyscan_cache_numa_count_set (priv, status, buffers, n_buffers);
+  hyscan_cache_counters_add_latency (priv->counters,
+                                     HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_OP_SET * HYSCAN_CACHE_STATS_N_BINS,
+                                     start);
+
+  return status;
+}
+
+/* Функция добавляет или изменяет объект в кэше. */
+static gboolean
+hyscan_cache_numa_set (HyScanCache  *cache,
+                       guint64       key,
+                       guint64       detail,
+                       HyScanBuffer *buffer1,
+                       HyScanBuffer *buffer2)
+{
+  HyScanBuffer *buffers[2] = { buffer1, buffer2 };
+
+  return hyscan_cache_numa_setv (cache, key, detail, buffers, 2);
+}
+
+/* Функция добавляет или изменяет объект в кэше по 128-ми битному ключу.
+   Объект в частях кэша других узлов удаляется по младшей половине ключа. */
+static gboolean
+hyscan_cache_numa_set128 (HyScanCache  *cache,
+                          guint64       key_lo,
+                          guint64       key_hi,
+                          const gchar  *key,
+                          guint64       detail,
+                          HyScanBuffer *buffer1,
+                          HyScanBuffer *buffer2)
+{
+  HyScanCacheNuma *numa = HYSCAN_CACHE_NUMA (cache);
+  HyScanCacheNumaPrivate *priv = numa->priv;
+  GMutex *lock = &priv->set_locks[key_lo % N_SET_LOCKS];
+  HyScanBuffer *buffers[2] = { buffer1, buffer2 };
+  gboolean status;
+  guint node;
+  guint i;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  node = hyscan_cache_numa_current_node (priv);
+
+  g_mutex_lock (lock);
+
+  for (i = 0; i < priv->n_nodes; i++)
+    {
+      if (i != node)
+        hyscan_cache_set2i (priv->shards[i], key_lo, 0, NULL, NULL);
+    }
+
+  status = hyscan_cache_set128i (priv->shards[node], key_lo, key_hi, key, detail, buffer1, buffer2);
+
+  g_mutex_unlock (lock);
+
+  hyscan_cache_numa_count_set (priv, status, buffers, 2);
+  hyscan_cache_counters_add_latency (priv->counters,
+                                     HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_OP_SET * HYSCAN_CACHE_STATS_N_BINS,
+                                     start);
+
+  return status;
+}
+
+/* Функция добавляет данные в конец объекта. */
+static gboolean
+hyscan_cache_numa_append (HyScanCache  *cache,
+                          guint64       key,
+                          guint64       detail,
+                          HyScanBuffer *buffer)
+{
+  HyScanCacheNuma *numa = HYSCAN_CACHE_NUMA (cache);
+  HyScanCacheNumaPrivate *priv = numa->priv;
+  GMutex *lock = &priv->set_locks[key % N_SET_LOCKS];
+  HyScanBuffer *current = NULL;
+  gboolean status = FALSE;
+  guint node;
+  guint i;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  node = hyscan_cache_numa_current_node (priv);
+
+  g_mutex_lock (lock);
+
+  /* Если объект находится в части кэша другого узла, переносим его
+     в часть кэша текущего узла вместе с новыми данными. Объект с другой
+     дополнительной информацией устарел и удаляется. */
+  for (i = 0; i < priv->n_nodes; i++)
+    {
+      guint64 current_detail;
+
+      if (i == node)
+        continue;
+
+      if (!hyscan_cache_queryi (priv->shards[i], key, &current_detail, NULL))
+        continue;
+
+      if (detail != 0 && current_detail != detail)
+        {
+          hyscan_cache_set2i (priv->shards[i], key, 0, NULL, NULL);
+          continue;
+        }
+
+      if (current == NULL)
+        current = hyscan_buffer_new ();
+
+      if (hyscan_cache_get2i (priv->shards[i], key, 0, G_MAXUINT32, current, NULL))
+        {
+          hyscan_cache_set2i (priv->shards[i], key, 0, NULL, NULL);
+          status = hyscan_cache_set2i (priv->shards[node], key, detail, current, buffer);
+          goto exit;
+        }
+    }
+
+  status = hyscan_cache_appendi (priv->shards[node], key, detail, buffer);
+
+exit:
+  g_mutex_unlock (lock);
+
+  g_clear_object (&current);
+
+  hyscan_cache_counters_add (priv->counters,
+                             status ? HYSCAN_CACHE_COUNTER_SETS : HYSCAN_CACHE_COUNTER_REJECTED, 1);
+  hyscan_cache_counters_add_latency (priv->counters,
+                                     HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_OP_APPEND * HYSCAN_CACHE_STATS_N_BINS,
+                                     start);
+
+  return status;
+}
+
+/* Функция считывает объект из кэша в несколько буферов. */
+static gboolean
+hyscan_cache_numa_getv (HyScanCache    *cache,
+                        guint64         key,
+                        guint64         detail,
+                        const guint32  *sizes,
+                        HyScanBuffer  **buffers,
+                        guint           n_buffers)
+{
+  HyScanCacheNuma *numa = HYSCAN_CACHE_NUMA (cache);
+  HyScanCacheNumaPrivate *priv = numa->priv;
+  gboolean status = TRUE;
+  guint node;
+  guint i;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  node = hyscan_cache_numa_current_node (priv);
+
+  /* Сначала ищем объект в части кэша текущего узла. */
+  if (hyscan_cache_getvi (priv->shards[node], key, detail, sizes, buffers, n_buffers))
+    {
+      g_atomic_pointer_add (&priv->local_hits, 1);
+      goto exit;
+    }
+
+  /* Затем в частях кэша других узлов. */
+  for (i = 0; i < priv->n_nodes; i++)
+    {
+      if (i == node)
+        continue;
+
+      if (hyscan_cache_getvi (priv->shards[i], key, detail, sizes, buffers, n_buffers))
+        {
+          g_atomic_pointer_add (&priv->remote_hits, 1);
+          goto exit;
+        }
+    }
+
+  g_atomic_pointer_add (&priv->misses, 1);
+  status = FALSE;
+
+exit:
+  hyscan_cached_scan_update (priv->scan, status);
+
+  hyscan_cache_counters_add_latency (priv->counters,
+                                     HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_OP_GET * HYSCAN_CACHE_STATS_N_BINS,
+                                     start);
+
+  return status;
+}
+
+/* Функция считывает объект из кэша. */
+static gboolean
+hyscan_cache_numa_get (HyScanCache  *cache,
+                       guint64       key,
+                       guint64       detail,
+                       guint32       size1,
+                       HyScanBuffer *buffer1,
+                       HyScanBuffer *buffer2)
+{
+  HyScanBuffer *buffers[2] = { buffer1, buffer2 };
+
+  if (buffer1 == NULL && buffer2 != NULL)
+    return FALSE;
+
+  return hyscan_cache_numa_getv (cache, key, detail, &size1, buffers, 2);
+}
+
+/* Функция считывает часть данных объекта из кэша. */
+static gboolean
+hyscan_cache_numa_get_range (HyScanCache  *cache,
+                             guint64       key,
+                             guint64       detail,
+                             guint32       offset,
+                             guint32       size,
+                             HyScanBuffer *buffer)
+{
+  HyScanCacheNuma *numa = HYSCAN_CACHE_NUMA (cache);
+  HyScanCacheNumaPrivate *priv = numa->priv;
+  gboolean status = TRUE;
+  guint node;
+  guint i;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  node = hyscan_cache_numa_current_node (priv);
+
+  if (hyscan_cache_get_rangei (priv->shards[node], key, detail, offset, size, buffer))
+    {
+      g_atomic_pointer_add (&priv->local_hits, 1);
+      goto exit;
+    }
+
+  for (i = 0; i < priv->n_nodes; i++)
+    {
+      if (i == node)
+        continue;
+
+      if (hyscan_cache_get_rangei (priv->shards[i], key, detail, offset, size, buffer))
+        {
+          g_atomic_pointer_add (&priv->remote_hits, 1);
+          goto exit;
+        }
+    }
+
+  g_atomic_pointer_add (&priv->misses, 1);
+  status = FALSE;
+
+exit:
+  hyscan_cache_counters_add_latency (priv->counters,
+                                     HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_OP_GET * HYSCAN_CACHE_STATS_N_BINS,
+                                     start);
+
+  return status;
+}
+
+/* Функция возвращает информацию об объекте. */
+static gboolean
+hyscan_cache_numa_query (HyScanCache *cache,
+                         guint64      key,
+                         guint64     *detail,
+                         guint32     *size)
+{
+  HyScanCacheNuma *numa = HYSCAN_CACHE_NUMA (cache);
+  HyScanCacheNumaPrivate *priv = numa->priv;
+  guint node;
+  guint i;
+
+  node = hyscan_cache_numa_current_node (priv);
+  if (hyscan_cache_queryi (priv->shards[node], key, detail, size))
+    return TRUE;
+
+  for (i = 0; i < priv->n_nodes; i++)
+    {
+      if (i == node)
+        continue;
+
+      if (hyscan_cache_queryi (priv->shards[i], key, detail, size))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Функция проверяет наличие в кэше нескольких объектов. Объект
+   находится только в одной из частей кэша, поэтому результаты
+   проверки частей объединяются. */
+static guint
+hyscan_cache_numa_contains_batch (HyScanCache   *cache,
+                                  const guint64 *keys,
+                                  guint          n_keys,
+                                  gboolean      *found)
+{
+  HyScanCacheNuma *numa = HYSCAN_CACHE_NUMA (cache);
+  HyScanCacheNumaPrivate *priv = numa->priv;
+  gboolean *shard_found;
+  gboolean *result;
+  guint n_found = 0;
+  guint i, j;
+
+  shard_found = g_new (gboolean, n_keys);
+  result = g_new0 (gboolean, n_keys);
+
+  for (i = 0; i < priv->n_nodes; i++)
+    {
+      if (hyscan_cache_contains_batchi (priv->shards[i], keys, n_keys, shard_found) == 0)
+        continue;
+
+      for (j = 0; j < n_keys; j++)
+        result[j] = result[j] || shard_found[j];
+    }
+
+  for (j = 0; j < n_keys; j++)
+    {
+      if (found != NULL)
+        found[j] = result[j];
+      if (result[j])
+        n_found += 1;
+    }
+
+  g_free (shard_found);
+  g_free (result);
+
+  return n_found;
+}
+
+/* Функция возвращает статистику работы кэша. Число попаданий, промахов и
+   операций записи учитывается по всему кэшу, остальные данные суммируются
+   по частям кэша узлов. */
+static gboolean
+hyscan_cache_numa_get_stats (HyScanCache      *cache,
+                             HyScanCacheStats *stats)
+{
+  HyScanCacheNuma *numa = HYSCAN_CACHE_NUMA (cache);
+  HyScanCacheNumaPrivate *priv = numa->priv;
+  guint64 local_hits, remote_hits, misses;
+  guint i;
+
+  hyscan_cache_counters_get_stats (priv->counters, stats);
+
+  for (i = 0; i < priv->n_nodes; i++)
+    {
+      HyScanCacheStats shard_stats;
+
+      hyscan_cache_get_stats (priv->shards[i], &shard_stats);
+
+      stats->detail_mismatches += shard_stats.detail_mismatches;
+      stats->evictions += shard_stats.evictions;
+      stats->used_size += shard_stats.used_size;
+      stats->max_size += shard_stats.max_size;
+      stats->n_objects += shard_stats.n_objects;
+    }
+
+  /* Объект хранится только в одной части кэша, поэтому несовпадение
+     вспомогательной информации учитывается только один раз. */
+  hyscan_cache_numa_get_hits (numa, &local_hits, &remote_hits, &misses);
+  stats->hits = local_hits + remote_hits;
+  stats->misses = misses - MIN (misses, stats->detail_mismatches);
+
+  return TRUE;
+}
+
+/* Функция считывает объект из кэша по 128-ми битному ключу. */
+static gboolean
+hyscan_cache_numa_get128 (HyScanCache  *cache,
+                          guint64       key_lo,
+                          guint64       key_hi,
+                          const gchar  *key,
+                          guint64       detail,
+                          guint32       size1,
+                          HyScanBuffer *buffer1,
+                          HyScanBuffer *buffer2)
+{
+  HyScanCacheNuma *numa = HYSCAN_CACHE_NUMA (cache);
+  HyScanCacheNumaPrivate *priv = numa->priv;
+  gboolean status = TRUE;
+  guint node;
+  guint i;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  node = hyscan_cache_numa_current_node (priv);
+
+  /* Сначала ищем объект в части кэша текущего узла. */
+  if (hyscan_cache_get128i (priv->shards[node], key_lo, key_hi, key, detail, size1, buffer1, buffer2))
+    {
+      g_atomic_pointer_add (&priv->local_hits, 1);
+      goto exit;
+    }
+
+  /* Затем в частях кэша других узлов. */
+  for (i = 0; i < priv->n_nodes; i++)
+    {
+      if (i == node)
+        continue;
+
+      if (hyscan_cache_get128i (priv->shards[i], key_lo, key_hi, key, detail, size1, buffer1, buffer2))
+        {
+          g_atomic_pointer_add (&priv->remote_hits, 1);
+          goto exit;
+        }
+    }
+
+  g_atomic_pointer_add (&priv->misses, 1);
+  status = FALSE;
+
+exit:
+  hyscan_cached_scan_update (priv->scan, status);
+
+  hyscan_cache_counters_add_latency (priv->counters,
+                                     HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_OP_GET * HYSCAN_CACHE_STATS_N_BINS,
+                                     start);
+
+  return status;
+}
+
+static void
+hyscan_cache_numa_interface_init (HyScanCacheInterface *iface)
+{
+  iface->set = hyscan_cache_numa_set;
+  iface->get = hyscan_cache_numa_get;
+  iface->get_stats = hyscan_cache_numa_get_stats;
+  iface->append = hyscan_cache_numa_append;
+  iface->get_range = hyscan_cache_numa_get_range;
+  iface->setv = hyscan_cache_numa_setv;
+  iface->getv = hyscan_cache_numa_getv;
+  iface->query = hyscan_cache_numa_query;
+  iface->contains_batch = hyscan_cache_numa_contains_batch;
+  iface->set128 = hyscan_cache_numa_set128;
+  iface->get128 = hyscan_cache_numa_get128;
+}
@@ -0,0 +1,103 @@
+/* hyscan-cache-numa.h
+ *
+ * Copyright 2015-2019 Screen LLC, Andrei Fadeev <andrei@webcontrol.ru>
+ *
+ * This file is part of HyScanCache.
+ *
+ * HyScanCache is dual-licensed: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HyScanCache is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Alternatively, you can license this code under a commercial license.
+ * Contact the Screen LLC in this case - <info@screen-co.ru>.
+ */
+
+/* HyScanCache имеет двойную лицензию.
+ *
+ * Во-первых, вы можете распространять HyScanCache на условиях Стандартной
+ * Общественной Лицензии GNU версии 3, либо по любой более поздней версии
+ * лицензии (по вашему выбору). Полные положения лицензии GNU приведены в
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Во-вторых, этот программный код можно использовать по коммерческой
+ * лицензии. Для этого свяжитесь с ООО Экран - <info@screen-co.ru>.
+ */
+
+
+#ifndef __HYSCAN_CACHE_NUMA_H__
+#define __HYSCAN_CACHE_NUMA_H__
+
+#include <hyscan-cache.h>
+
+G_BEGIN_DECLS
+
+#define HYSCAN_TYPE_CACHE_NUMA             (hyscan_cache_numa_get_type ())
+#define HYSCAN_CACHE_NUMA(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), HYSCAN_TYPE_CACHE_NUMA, HyScanCacheNuma))
+#define HYSCAN_IS_CACHE_NUMA(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), HYSCAN_TYPE_CACHE_NUMA))
+#define HYSCAN_CACHE_NUMA_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), HYSCAN_TYPE_CACHE_NUMA, HyScanCacheNumaClass))
+#define HYSCAN_IS_CACHE_NUMA_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), HYSCAN_TYPE_CACHE_NUMA))
+#define HYSCAN_CACHE_NUMA_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), HYSCAN_TYPE_CACHE_NUMA, HyScanCacheNumaClass))
+
+typedef struct _HyScanCacheNuma HyScanCacheNuma;
+typedef struct _HyScanCacheNumaPrivate HyScanCacheNumaPrivate;
+typedef struct _HyScanCacheNumaClass HyScanCacheNumaClass;
+
+struct _HyScanCacheNuma
+{
+  GObject parent_instance;
+
+  HyScanCacheNumaPrivate *priv;
+};
+
+struct _HyScanCacheNumaClass
+{
+  GObjectClass parent_class;
+};
+
+HYSCAN_API
+GType                  hyscan_cache_numa_get_type      (void);
+
+HYSCAN_API
+HyScanCacheNuma       *hyscan_cache_numa_new           (guint32                cache_size);
+
+HYSCAN_API
+guint                  hyscan_cache_numa_get_n_nodes   (HyScanCacheNuma       *numa);
+
+HYSCAN_API
+gboolean               hyscan_cache_numa_bind_thread   (HyScanCacheNuma       *numa,
+                                                        guint                  node);
+
+HYSCAN_API
+void                   hyscan_cache_numa_get_hits      (HyScanCacheNuma       *numa,
+                                                        guint64               *local_hits,
+                                                        guint64               *remote_hits,
+                                                        guint64               *misses);
+
+HYSCAN_API
+void                   hyscan_cache_numa_set_key_verification (HyScanCacheNuma *numa,
+                                                        gboolean               enable);
+
+HYSCAN_API
+void                   hyscan_cache_numa_set_checksums (HyScanCacheNuma       *numa,
+                                                        gboolean               enable);
+
+HYSCAN_API
+void                   hyscan_cache_numa_set_scrub_rate (HyScanCacheNuma      *numa,
+                                                        guint                  rate);
+
+HYSCAN_API
+void                   hyscan_cache_numa_set_scan_threshold (HyScanCacheNuma  *numa,
+                                                        guint                  threshold);
+
+G_END_DECLS
+
+#endif /* __HYSCAN_CACHE_NUMA_H__ */
@@ -0,0 +1,551 @@
+/* hyscan-cache-prefetch.c
+ *
+ * Copyright 2015-2019 Screen LLC, Andrei Fadeev <andrei@webcontrol.ru>
+ *
+ * This file is part of HyScanCache.
+ *
+ * HyScanCache is dual-licensed: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HyScanCache is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Alternatively, you can license this code under a commercial license.
+ * Contact the Screen LLC in this case - <info@screen-co.ru>.
+ */
+
+/* HyScanCache имеет двойную лицензию.
+ *
+ * Во-первых, вы можете распространять HyScanCache на условиях Стандартной
+ * Общественной Лицензии GNU версии 3, либо по любой более поздней версии
+ * лицензии (по вашему выбору). Полные положения лицензии GNU приведены в
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Во-вторых, этот программный код можно использовать по коммерческой
+ * лицензии. Для этого свяжитесь с ООО Экран - <info@screen-co.ru>.
+ */
+
+/**
+ * SECTION: hyscan-cache-prefetch
+ * @Short_description: упреждающее заполнение кэша
+ * @Title: HyScanCachePrefetch
+ *
+ * HyScanCachePrefetch заполняет кэш данными, которые будут запрошены в
+ * ближайшее время, например при последовательном просмотре строк.
+ *
+ * Приложение регистрирует источник данных функцией
+ * #hyscan_cache_prefetch_add_producer. Источник определяется функцией
+ * #HyScanCachePrefetchFunc, которая формирует элемент данных с указанным
+ * индексом и записывает его в кэш. Проверять наличие данных в кэше перед их
+ * формированием должна сама функция, например с помощью #hyscan_cache_contains.
+ *
+ * Функцией #hyscan_cache_prefetch_hint задаётся диапазон индексов, которые
+ * потребуются в ближайшее время. Диапазон заменяет предыдущий, поэтому
+ * индексы, вышедшие из области просмотра, отменяются. Если новый диапазон
+ * продолжает предыдущий, уже сформированные элементы повторно не
+ * запрашиваются. Функция #hyscan_cache_prefetch_cancel отменяет диапазон
+ * источника целиком.
+ *
+ * Данные формируются фиксированным числом рабочих потоков в порядке
+ * возрастания индексов, источники обслуживаются по очереди. В Linux
+ * рабочие потоки выполняются с минимальным приоритетом (SCHED_IDLE), чтобы
+ * не мешать потокам, обрабатывающим запросы пользователя.
+ *
+ * Функции класса можно вызывать из разных потоков, кроме функций
+ * #HyScanCachePrefetchFunc.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#include <sched.h>
+#endif
+
+#include "hyscan-cache-prefetch.h"
+
+#define MAX_THREADS        64                          /* Максимальное число рабочих потоков. */
+
+enum
+{
+  PROP_O,
+  PROP_N_THREADS
+};
+
+/* Источник данных. */
+typedef struct
+{
+  guint                id;                     /* Идентификатор источника. */
+  HyScanCachePrefetchFunc func;                /* Функция формирования данных. */
+  gpointer             user_data;              /* Пользовательские данные. */
+  GDestroyNotify       destroy;                /* Функция освобождения пользовательских данных. */
+
+  gboolean             hinted;                 /* Признак наличия диапазона. */
+  guint64              first;                  /* Первый индекс диапазона. */
+  guint64              last;                   /* Последний индекс диапазона. */
+  guint64              next;                   /* Следующий формируемый индекс. */
+
+  guint                busy;                   /* Число выполняющихся вызовов функции. */
+} HyScanCachePrefetchProducer;
+
+/* Внутренние данные объекта. */
+struct _HyScanCachePrefetchPrivate
+{
+  guint                n_threads;              /* Число рабочих потоков. */
+  GThread            **threads;                /* Рабочие потоки. */
+
+  GMutex               lock;                   /* Блокировка доступа к источникам. */
+  GCond                work_cond;              /* Появление новых диапазонов. */
+  GCond                done_cond;              /* Завершение вызовов функций источников. */
+  gboolean             stop;                   /* Признак завершения работы. */
+
+  GPtrArray           *producers;              /* Источники данных. */
+  guint                next_producer;          /* Следующий обслуживаемый источник. */
+  guint                last_id;                /* Последний выданный идентификатор. */
+
+  guint64              produced;               /* Число сформированных элементов. */
+  guint64              cancelled;              /* Число отменённых элементов. */
+};
+
+static void            hyscan_cache_prefetch_set_property      (GObject                *object,
+                                                                guint                   prop_id,
+                                                                const GValue           *value,
+                                                                GParamSpec             *pspec);
+static void            hyscan_cache_prefetch_object_constructed (GObject               *object);
+static void            hyscan_cache_prefetch_object_finalize   (GObject                *object);
+
+static gpointer        hyscan_cache_prefetch_worker            (gpointer                data);
+static HyScanCachePrefetchProducer *
+                       hyscan_cache_prefetch_lookup            (HyScanCachePrefetchPrivate *priv,
+                                                                guint                   producer,
+                                                                guint                  *position);
+static guint64         hyscan_cache_prefetch_remains           (HyScanCachePrefetchProducer *producer);
+
+G_DEFINE_TYPE_WITH_PRIVATE (HyScanCachePrefetch, hyscan_cache_prefetch, G_TYPE_OBJECT)
+
+static void
+hyscan_cache_prefetch_class_init (HyScanCachePrefetchClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->set_property = hyscan_cache_prefetch_set_property;
+  object_class->constructed = hyscan_cache_prefetch_object_constructed;
+  object_class->finalize = hyscan_cache_prefetch_object_finalize;
+
+  g_object_class_install_property (object_class, PROP_N_THREADS,
+                                   g_param_spec_uint ("n-threads", "Threads", "Number of worker threads",
+                                                      1, MAX_THREADS, 1,
+                                                      G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
+}
+
+static void
+hyscan_cache_prefetch_init (HyScanCachePrefetch *prefetch)
+{
+  prefetch->priv = hyscan_cache_prefetch_get_instance_private (prefetch);
+}
+
+static void
+hyscan_cache_prefetch_set_property (GObject      *object,
+                                    guint         prop_id,
+                                    const GValue *value,
+                                    GParamSpec   *pspec)
+{
+  HyScanCachePrefetch *prefetch = HYSCAN_CACHE_PREFETCH (object);
+  HyScanCachePrefetchPrivate *priv = prefetch->priv;
+
+  switch (prop_id)
+    {
+    case PROP_N_THREADS:
+      priv->n_threads = g_value_get_uint (value);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+hyscan_cache_prefetch_object_constructed (GObject *object)
+{
+  HyScanCachePrefetch *prefetch = HYSCAN_CACHE_PREFETCH (object);
+  HyScanCachePrefetchPrivate *priv = prefetch->priv;
+  guint i;
+
+  g_mutex_init (&priv->lock);
+  g_cond_init (&priv->work_cond);
+  g_cond_init (&priv->done_cond);
+
+  priv->producers = g_ptr_array_new ();
+
+  priv->threads = g_new0 (GThread *, priv->n_threads);
+  for (i = 0; i < priv->n_threads; i++)
+    priv->threads[i] = g_thread_new ("cache-prefetch", hyscan_cache_prefetch_worker, priv);
+}
+
+static void
+hyscan_cache_prefetch_object_finalize (GObject *object)
+{
+  HyScanCachePrefetch *prefetch = HYSCAN_CACHE_PREFETCH (object);
+  HyScanCachePrefetchPrivate *priv = prefetch->priv;
+  guint i;
+
+  g_mutex_lock (&priv->lock);
+  priv->stop = TRUE;
+  g_cond_broadcast (&priv->work_cond);
+  g_mutex_unlock (&priv->lock);
+
+  for (i = 0; i < priv->n_threads; i++)
+    g_thread_join (priv->threads[i]);
+  g_free (priv->threads);
+
+  for (i = 0; i < priv->producers->len; i++)
+    {
+      HyScanCachePrefetchProducer *producer = g_ptr_array_index (priv->producers, i);
+
+      if (producer->destroy != NULL)
+        producer->destroy (producer->user_data);
+      g_slice_free (HyScanCachePrefetchProducer, producer);
+    }
+  g_ptr_array_unref (priv->producers);
+
+  g_cond_clear (&priv->done_cond);
+  g_cond_clear (&priv->work_cond);
+  g_mutex_clear (&priv->lock);
+
+  G_OBJECT_CLASS (hyscan_cache_prefetch_parent_class)->finalize (object);
+}
+
+/* Рабочий поток. */
+static gpointer
+hyscan_cache_prefetch_worker (gpointer data)
+{
+  HyScanCachePrefetchPrivate *priv = data;
+
+#ifdef __linux__
+  /* Упреждающее чтение выполняется, только если процессор не занят. */
+  {
+    struct sched_param param = { 0 };
+
+    sched_setscheduler (0, SCHED_IDLE, &param);
+  }
+#endif
+
+  g_mutex_lock (&priv->lock);
+
+  while (!priv->stop)
+    {
+      HyScanCachePrefetchProducer *producer = NULL;
+      guint64 index;
+      guint i;
+
+      /* Источники с несформированными элементами обслуживаются по очереди. */
+      for (i = 0; i < priv->producers->len; i++)
+        {
+          guint position = (priv->next_producer + i) % priv->producers->len;
+          HyScanCachePrefetchProducer *candidate = g_ptr_array_index (priv->producers, position);
+
+          if (hyscan_cache_prefetch_remains (candidate) > 0)
+            {
+              producer = candidate;
+              priv->next_producer = position + 1;
+              break;
+            }
+        }
+
+      if (producer == NULL)
+        {
+          g_cond_wait (&priv->work_cond, &priv->lock);
+          continue;
+        }
+
+      index = producer->next++;
+      producer->busy += 1;
+      g_mutex_unlock (&priv->lock);
+
+      producer->func (index, producer->user_data);
+
+      g_mutex_lock (&priv->lock);
+      producer->busy -= 1;
+      priv->produced += 1;
+      if (producer->busy == 0)
+        g_cond_broadcast (&priv->done_cond);
+    }
+
+  g_mutex_unlock (&priv->lock);
+
+  return NULL;
+}
+
+/* Функция ищет источник по идентификатору. Вызывается при захваченной
+   блокировке lock. */
+static HyScanCachePrefetchProducer *
+hyscan_cache_prefetch_lookup (HyScanCachePrefetchPrivate *priv,
+                              guint                       producer,
+                              guint                      *position)
+{
+  guint i;
+
+  for (i = 0; i < priv->producers->len; i++)
+    {
+      HyScanCachePrefetchProducer *info = g_ptr_array_index (priv->producers, i);
+
+      if (info->id == producer)
+        {
+          if (position != NULL)
+            *position = i;
+
+          return info;
+        }
+    }
+
+  return NULL;
+}
+
+/* Функция возвращает число несформированных элементов источника.
+   Сформированы или формируются элементы с first до next. */
+static guint64
+hyscan_cache_prefetch_remains (HyScanCachePrefetchProducer *producer)
+{
+  if (!producer->hinted || producer->next > producer->last)
+    return 0;
+
+  return producer->last - producer->next + 1;
+}
+
+/**
+ * hyscan_cache_prefetch_new:
+ * @n_threads: число рабочих потоков
+ *
+ * Функция создаёт новый объект #HyScanCachePrefetch.
+ *
+ * Returns: #HyScanCachePrefetch. Для удаления #g_object_unref.
+ */
+HyScanCachePrefetch *
+hyscan_cache_prefetch_new (guint n_threads)
+{
+  n_threads = CLAMP (n_threads, 1, MAX_THREADS);
+
+  return g_object_new (HYSCAN_TYPE_CACHE_PREFETCH,
+                       "n-threads", n_threads,
+                       NULL);
+}
+
+/**
+ * hyscan_cache_prefetch_add_producer:
+ * @prefetch: указатель на #HyScanCachePrefetch
+ * @func: функция формирования данных
+ * @user_data: пользовательские данные
+ * @destroy: (nullable): функция освобождения пользовательских данных
+ *
+ * Функция регистрирует источник данных.
+ *
+ * Returns: Идентификатор источника или 0 в случае ошибки.
+ */
+guint
+hyscan_cache_prefetch_add_producer (HyScanCachePrefetch     *prefetch,
+                                    HyScanCachePrefetchFunc  func,
+                                    gpointer                 user_data,
+                                    GDestroyNotify           destroy)
+{
+  HyScanCachePrefetchPrivate *priv;
+  HyScanCachePrefetchProducer *producer;
+
+  g_return_val_if_fail (HYSCAN_IS_CACHE_PREFETCH (prefetch), 0);
+  g_return_val_if_fail (func != NULL, 0);
+
+  priv = prefetch->priv;
+
+  producer = g_slice_new0 (HyScanCachePrefetchProducer);
+  producer->func = func;
+  producer->user_data = user_data;
+  producer->destroy = destroy;
+
+  g_mutex_lock (&priv->lock);
+
+  /* Идентификатор 0 не используется. */
+  do
+    priv->last_id += 1;
+  while (priv->last_id == 0 || hyscan_cache_prefetch_lookup (priv, priv->last_id, NULL) != NULL);
+
+  producer->id = priv->last_id;
+  g_ptr_array_add (priv->producers, producer);
+
+  g_mutex_unlock (&priv->lock);
+
+  return producer->id;
+}
+
+/**
+ * hyscan_cache_prefetch_remove_producer:
+ * @prefetch: указатель на #HyScanCachePrefetch
+ * @producer: идентификатор источника
+ *
+ * Функция удаляет источник данных. Функция дожидается завершения
+ * выполняющихся вызовов функции источника, поэтому её нельзя вызывать
+ * из #HyScanCachePrefetchFunc.
+ */
+void
+hyscan_cache_prefetch_remove_producer (HyScanCachePrefetch *prefetch,
+                                       guint                producer)
+{
+  HyScanCachePrefetchPrivate *priv;
+  HyScanCachePrefetchProducer *info;
+  guint position;
+
+  g_return_if_fail (HYSCAN_IS_CACHE_PREFETCH (prefetch));
+
+  priv = prefetch->priv;
+
+  g_mutex_lock (&priv->lock);
+
+  info = hyscan_cache_prefetch_lookup (priv, producer, &position);
+  if (info == NULL)
+    {
+      g_mutex_unlock (&priv->lock);
+      g_warning ("HyScanCachePrefetch: unknown producer %u", producer);
+      return;
+    }
+
+  priv->cancelled += hyscan_cache_prefetch_remains (info);
+  g_ptr_array_remove_index (priv->producers, position);
+
+  while (info->busy > 0)
+    g_cond_wait (&priv->done_cond, &priv->lock);
+
+  g_mutex_unlock (&priv->lock);
+
+  if (info->destroy != NULL)
+    info->destroy (info->user_data);
+  g_slice_free (HyScanCachePrefetchProducer, info);
+}
+
+/**
+ * hyscan_cache_prefetch_hint:
+ * @prefetch: указатель на #HyScanCachePrefetch
+ * @producer: идентификатор источника
+ * @first: первый индекс диапазона
+ * @last: последний индекс диапазона, меньше G_MAXUINT64
+ *
+ * Функция задаёт диапазон индексов данных источника, которые потребуются
+ * в ближайшее время. Несформированные элементы предыдущего диапазона,
+ * не попадающие в новый, отменяются.
+ */
+void
+hyscan_cache_prefetch_hint (HyScanCachePrefetch *prefetch,
+                            guint                producer,
+                            guint64              first,
+                            guint64              last)
+{
+  HyScanCachePrefetchPrivate *priv;
+  HyScanCachePrefetchProducer *info;
+  guint64 remains;
+  guint64 next;
+
+  g_return_if_fail (HYSCAN_IS_CACHE_PREFETCH (prefetch));
+  g_return_if_fail (first <= last && last < G_MAXUINT64);
+
+  priv = prefetch->priv;
+
+  g_mutex_lock (&priv->lock);
+
+  info = hyscan_cache_prefetch_lookup (priv, producer, NULL);
+  if (info == NULL)
+    {
+      g_mutex_unlock (&priv->lock);
+      g_warning ("HyScanCachePrefetch: unknown producer %u", producer);
+      return;
+    }
+
+  /* Если новый диапазон начинается внутри уже сформированной части
+     предыдущего, эти элементы повторно не запрашиваются. */
+  next = first;
+  if (info->hinted && first >= info->first && first <= info->next)
+    next = info->next;
+
+  /* Отменяются несформированные элементы, не попадающие в новый диапазон. */
+  remains = hyscan_cache_prefetch_remains (info);
+  if (remains > 0 && MAX (info->next, next) <= MIN (info->last, last))
+    remains -= MIN (info->last, last) - MAX (info->next, next) + 1;
+  priv->cancelled += remains;
+
+  info->hinted = TRUE;
+  info->first = first;
+  info->last = last;
+  info->next = next;
+
+  if (next <= last)
+    g_cond_broadcast (&priv->work_cond);
+
+  g_mutex_unlock (&priv->lock);
+}
+
+/**
+ * hyscan_cache_prefetch_cancel:
+ * @prefetch: указатель на #HyScanCachePrefetch
+ * @producer: идентификатор источника
+ *
+ * Функция отменяет формирование несформированных элементов источника.
+ * Выполняющиеся вызовы функции источника не прерываются.
+ */
+void
+hyscan_cache_prefetch_cancel (HyScanCachePrefetch *prefetch,
+                              guint                producer)
+{
+  HyScanCachePrefetchPrivate *priv;
+  HyScanCachePrefetchProducer *info;
+
+  g_return_if_fail (HYSCAN_IS_CACHE_PREFETCH (prefetch));
+
+  priv = prefetch->priv;
+
+  g_mutex_lock (&priv->lock);
+
+  info = hyscan_cache_prefetch_lookup (priv, producer, NULL);
+  if (info != NULL)
+    {
+      priv->cancelled += hyscan_cache_prefetch_remains (info);
+
+      /* Диапазон сокращается до сформированной части. */
+      if (info->next > info->first)
+        info->last = info->next - 1;
+      else
+        info->hinted = FALSE;
+    }
+
+  g_mutex_unlock (&priv->lock);
+}
+
+/**
+ * hyscan_cache_prefetch_get_stats:
+ * @prefetch: указатель на #HyScanCachePrefetch
+ * @produced: (out) (nullable): число сформированных элементов
+ * @cancelled: (out) (nullable): число отменённых элементов
+ *
+ * Функция возвращает статистику работы.
+ */
+void
+hyscan_cache_prefetch_get_stats (HyScanCachePrefetch *prefetch,
+                                 guint64             *produced,
+                                 guint64             *cancelled)
+{
+  HyScanCachePrefetchPrivate *priv;
+
+  g_return_if_fail (HYSCAN_IS_CACHE_PREFETCH (prefetch));
+
+  priv = prefetch->priv;
+
+  g_mutex_lock (&priv->lock);
+
+  if (produced != NULL)
+    *produced = priv->produced;
+  if (cancelled != NULL)
+    *cancelled = priv->cancelled;
+
+  g_mutex_unlock (&priv->lock);
+}
@@ -0,0 +1,111 @@
+/* hyscan-cache-prefetch.h
+ *
+ * Copyright 2015-2019 Screen LLC, Andrei Fadeev <andrei@webcontrol.ru>
+ *
+ * This file is part of HyScanCache.
+ *
+ * HyScanCache is dual-licensed: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HyScanCache is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Alternatively, you can license this code under a commercial license.
+ * Contact the Screen LLC in this case - <info@screen-co.ru>.
+ */
+
+/* HyScanCache имеет двойную лицензию.
+ *
+ * Во-первых, вы можете распространять HyScanCache на условиях Стандартной
+ * Общественной Лицензии GNU версии 3, либо по любой более поздней версии
+ * лицензии (по вашему выбору). Полные положения лицензии GNU приведены в
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Во-вторых, этот программный код можно использовать по коммерческой
+ * лицензии. Для этого свяжитесь с ООО Экран - <info@screen-co.ru>.
+ */
+
+
+#ifndef __HYSCAN_CACHE_PREFETCH_H__
+#define __HYSCAN_CACHE_PREFETCH_H__
+
+#include <glib-object.h>
+#include <hyscan-api.h>
+
+G_BEGIN_DECLS
+
+/**
+ * HyScanCachePrefetchFunc:
+ * @index: индекс элемента данных
+ * @user_data: пользовательские данные
+ *
+ * Функция формирования элемента данных с указанным индексом и записи его
+ * в кэш. Вызывается из рабочих потоков #HyScanCachePrefetch.
+ */
+typedef void (*HyScanCachePrefetchFunc) (guint64                index,
+                                         gpointer               user_data);
+
+#define HYSCAN_TYPE_CACHE_PREFETCH             (hyscan_cache_prefetch_get_type ())
+#define HYSCAN_CACHE_PREFETCH(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), HYSCAN_TYPE_CACHE_PREFETCH, HyScanCachePrefetch))
+#define HYSCAN_IS_CACHE_PREFETCH(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), HYSCAN_TYPE_CACHE_PREFETCH))
+#define HYSCAN_CACHE_PREFETCH_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), HYSCAN_TYPE_CACHE_PREFETCH, HyScanCachePrefetchClass))
+#define HYSCAN_IS_CACHE_PREFETCH_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), HYSCAN_TYPE_CACHE_PREFETCH))
+#define HYSCAN_CACHE_PREFETCH_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), HYSCAN_TYPE_CACHE_PREFETCH, HyScanCachePrefetchClass))
+
+typedef struct _HyScanCachePrefetch HyScanCachePrefetch;
+typedef struct _HyScanCachePrefetchPrivate HyScanCachePrefetchPrivate;
+typedef struct _HyScanCachePrefetchClass HyScanCachePrefetchClass;
+
+struct _HyScanCachePrefetch
+{
+  GObject parent_instance;
+
+  HyScanCachePrefetchPrivate *priv;
+};
+
+struct _HyScanCachePrefetchClass
+{
+  GObjectClass parent_class;
+};
+
+HYSCAN_API
+GType                  hyscan_cache_prefetch_get_type          (void);
+
+HYSCAN_API
+HyScanCachePrefetch   *hyscan_cache_prefetch_new               (guint                  n_threads);
+
+HYSCAN_API
+guint                  hyscan_cache_prefetch_add_producer      (HyScanCachePrefetch   *prefetch,
+                                                                HyScanCachePrefetchFunc func,
+                                                                gpointer               user_data,
+                                                                GDestroyNotify         destroy);
+
+HYSCAN_API
+void                   hyscan_cache_prefetch_remove_producer   (HyScanCachePrefetch   *prefetch,
+                                                                guint                  producer);
+
+HYSCAN_API
+void                   hyscan_cache_prefetch_hint              (HyScanCachePrefetch   *prefetch,
+                                                                guint                  producer,
+                                                                guint64                first,
+                                                                guint64                last);
+
+HYSCAN_API
+void                   hyscan_cache_prefetch_cancel            (HyScanCachePrefetch   *prefetch,
+                                                                guint                  producer);
+
+HYSCAN_API
+void                   hyscan_cache_prefetch_get_stats         (HyScanCachePrefetch   *prefetch,
+                                                                guint64               *produced,
+                                                                guint64               *cancelled);
+
+G_END_DECLS
+
+#endif /* __HYSCAN_CACHE_PREFETCH_H__ */
@@ -13,15 +13,29 @@
 
 #include <urpc-types.h>
 
-#define HYSCAN_CACHE_RPC_VERSION               (20151200)
+#define HYSCAN_CACHE_RPC_VERSION               (20190900)
 #define HYSCAN_CACHE_RPC_STATUS_OK             (1)
 #define HYSCAN_CACHE_RPC_STATUS_FAIL           (0)
+#define HYSCAN_CACHE_RPC_STATUS_CHUNKED        (2)
 
 enum
 {
   HYSCAN_CACHE_RPC_PROC_VERSION = URPC_PROC_USER,
   HYSCAN_CACHE_RPC_PROC_SET,
-  HYSCAN_CACHE_RPC_PROC_GET
+  HYSCAN_CACHE_RPC_PROC_GET,
+  HYSCAN_CACHE_RPC_PROC_STATS,
+  HYSCAN_CACHE_RPC_PROC_APPEND,
+  HYSCAN_CACHE_RPC_PROC_GET_RANGE,
+  HYSCAN_CACHE_RPC_PROC_QUERY,
+  HYSCAN_CACHE_RPC_PROC_CONTAINS_BATCH,
+  HYSCAN_CACHE_RPC_PROC_SET128,
+  HYSCAN_CACHE_RPC_PROC_GET128,
+  HYSCAN_CACHE_RPC_PROC_MSET,
+  HYSCAN_CACHE_RPC_PROC_MGET,
+  HYSCAN_CACHE_RPC_PROC_SET_BEGIN,
+  HYSCAN_CACHE_RPC_PROC_SET_CHUNK,
+  HYSCAN_CACHE_RPC_PROC_SET_COMMIT,
+  HYSCAN_CACHE_RPC_PROC_GET_CHUNK
 };
 
 enum
@@ -30,7 +44,77 @@ enum
   HYSCAN_CACHE_RPC_PARAM_STATUS,
   HYSCAN_CACHE_RPC_PARAM_KEY,
   HYSCAN_CACHE_RPC_PARAM_DETAIL,
-  HYSCAN_CACHE_RPC_PARAM_DATA
+  HYSCAN_CACHE_RPC_PARAM_DATA,
+  HYSCAN_CACHE_RPC_PARAM_CACHE_STATS,
+  HYSCAN_CACHE_RPC_PARAM_PROC_STATS,
+  HYSCAN_CACHE_RPC_PARAM_SESSION_STATS,
+  HYSCAN_CACHE_RPC_PARAM_OFFSET,
+  HYSCAN_CACHE_RPC_PARAM_SIZE,
+  HYSCAN_CACHE_RPC_PARAM_KEYS,
+  HYSCAN_CACHE_RPC_PARAM_FOUND,
+  HYSCAN_CACHE_RPC_PARAM_KEY_HI,
+  HYSCAN_CACHE_RPC_PARAM_KEY_STRING,
+  HYSCAN_CACHE_RPC_PARAM_DETAILS,
+  HYSCAN_CACHE_RPC_PARAM_SIZES,
+  HYSCAN_CACHE_RPC_PARAM_COUNT
 };
 
+/* Статистика передаётся массивами 64-х битных чисел в порядке little endian.
+
+   HYSCAN_CACHE_RPC_PARAM_CACHE_STATS: число операций, число интервалов гистограммы,
+   поля HyScanCacheStats от hits до n_objects, гистограммы операций.
+
+   HYSCAN_CACHE_RPC_PARAM_PROC_STATS: число процедур, число интервалов гистограммы,
+   для каждой процедуры: число вызовов и гистограмма.
+
+   HYSCAN_CACHE_RPC_PARAM_SESSION_STATS: число сессий, для каждой сессии:
+   идентификатор, число запросов и время с момента подключения в микросекундах. */
+#define HYSCAN_CACHE_RPC_CACHE_STATS_FIELDS    (9)
+
+/* HYSCAN_CACHE_RPC_PARAM_KEYS: массив 64-х битных ключей в порядке little endian.
+   HYSCAN_CACHE_RPC_PARAM_FOUND: массив байт с признаками наличия объектов. */
+#define HYSCAN_CACHE_RPC_MAX_BATCH_KEYS        ((URPC_MAX_DATA_SIZE - 1024) / (sizeof (guint64) + 1))
+
+/* HYSCAN_CACHE_RPC_PARAM_KEY и HYSCAN_CACHE_RPC_PARAM_KEY_HI: младшая и старшая
+   половины 128-ми битного ключа. HYSCAN_CACHE_RPC_PARAM_KEY_STRING: строка ключа
+   для проверки, более длинные строки не передаются. */
+#define HYSCAN_CACHE_RPC_MAX_KEY_STRING        (4096)
+
+/* Пакетные процедуры HYSCAN_CACHE_RPC_PROC_MSET и HYSCAN_CACHE_RPC_PROC_MGET.
+
+   HYSCAN_CACHE_RPC_PARAM_KEYS и HYSCAN_CACHE_RPC_PARAM_DETAILS: массивы 64-х
+   битных ключей и вспомогательной информации объектов в порядке little endian.
+   HYSCAN_CACHE_RPC_PARAM_SIZES: массив 32-х битных размеров объектов в порядке
+   little endian, размер HYSCAN_CACHE_RPC_REMOVE_SIZE при записи означает удаление
+   объекта. HYSCAN_CACHE_RPC_PARAM_DATA: данные объектов, записанные
+   подряд. HYSCAN_CACHE_RPC_PARAM_FOUND: признаки записи или чтения объектов.
+
+   Сервер считывает объекты по порядку, пока их данные помещаются в ответ, и
+   возвращает число обработанных ключей в HYSCAN_CACHE_RPC_PARAM_COUNT. Размеры
+   и признаки необработанных ключей равны нулю. */
+#define HYSCAN_CACHE_RPC_MAX_MULTI_KEYS        (4096)
+#define HYSCAN_CACHE_RPC_REMOVE_SIZE           (G_MAXUINT32)
+#define HYSCAN_CACHE_RPC_MAX_MULTI_DATA        (URPC_MAX_DATA_SIZE - 1024 - \
+                                                HYSCAN_CACHE_RPC_MAX_MULTI_KEYS * \
+                                                (2 * sizeof (guint64) + sizeof (guint32)))
+
+/* Передача объектов, не помещающихся в одно сообщение, частями.
+
+   Запись: HYSCAN_CACHE_RPC_PROC_SET_BEGIN с параметрами процедуры
+   HYSCAN_CACHE_RPC_PROC_SET или HYSCAN_CACHE_RPC_PROC_SET128 и полным размером
+   объекта в HYSCAN_CACHE_RPC_PARAM_SIZE, затем HYSCAN_CACHE_RPC_PROC_SET_CHUNK
+   с последовательными частями данных и смещением HYSCAN_CACHE_RPC_PARAM_OFFSET,
+   затем HYSCAN_CACHE_RPC_PROC_SET_COMMIT, записывающая объект в кэш.
+
+   Чтение: если объект не помещается в ответ HYSCAN_CACHE_RPC_PROC_GET или
+   HYSCAN_CACHE_RPC_PROC_GET128, сервер сохраняет его копию в сессии клиента и
+   возвращает статус HYSCAN_CACHE_RPC_STATUS_CHUNKED и размер объекта в
+   HYSCAN_CACHE_RPC_PARAM_SIZE. Данные копии считываются процедурой
+   HYSCAN_CACHE_RPC_PROC_GET_CHUNK с параметрами HYSCAN_CACHE_RPC_PARAM_OFFSET и
+   HYSCAN_CACHE_RPC_PARAM_SIZE. Копия удаляется после чтения последней части.
+
+   Состояние передачи хранится в сессии, поэтому все вызовы должны выполняться
+   через один канал без его освобождения. */
+#define HYSCAN_CACHE_RPC_MAX_CHUNK             (URPC_MAX_DATA_SIZE - 1024)
+
 #endif /* __HYSCAN_CACHE_RPC_H__ */
@@ -45,11 +45,21 @@
  *
  * После создания сервера его необходимо запустить функцией
  * #hyscan_cache_server_start.
+ *
+ * Статистику работы кэша, обслуживаемого сервером, можно узнать функцией
+ * #hyscan_cache_server_get_stats. Функция #hyscan_cache_server_get_server_stats
+ * дополнительно возвращает число вызовов и время выполнения процедур сервера,
+ * а также число запросов в каждой сессии клиента. Эта же статистика доступна
+ * клиентам через функцию #hyscan_cache_client_get_server_stats.
  */
 
 #include "hyscan-cache-server.h"
 #include "hyscan-cache-rpc.h"
 #include "hyscan-cached.h"
+#include "hyscan-cache-numa.h"
+#include "hyscan-cache-counters.h"
+
+#include <string.h>
 
 #include <urpc-server.h>
 
@@ -72,6 +82,29 @@ enum
   PROP_N_CLIENTS
 };
 
+/* Номер счётчика числа вызовов процедуры, за ним следует гистограмма. */
+#define PROC_COUNTER(proc)     ((proc) * (HYSCAN_CACHE_STATS_N_BINS + 1))
+#define N_PROC_COUNTERS        PROC_COUNTER (HYSCAN_CACHE_SERVER_N_PROCS)
+
+/* Сессия клиента. */
+typedef struct
+{
+  guint64              id;                     /* Идентификатор сессии. */
+  gint64               start_time;             /* Время начала сессии. */
+  volatile gsize       requests;               /* Число запросов. */
+
+  HyScanBuffer        *upload;                 /* Данные объекта, записываемого частями. */
+  guint64              upload_key;             /* Ключ записываемого объекта. */
+  guint64              upload_key_hi;          /* Старшая половина 128-ми битного ключа. */
+  gboolean             upload_key128;          /* Признак записи по 128-ми битному ключу. */
+  gchar               *upload_key_string;      /* Строка ключа для проверки. */
+  guint64              upload_detail;          /* Вспомогательная информация объекта. */
+  guint32              upload_size;            /* Размер записываемого объекта. */
+  guint32              upload_received;        /* Объём принятых данных. */
+
+  HyScanBuffer        *download;               /* Копия объекта, считываемого частями. */
+} ServerSession;
+
 struct _HyScanCacheServerPrivate
 {
   volatile gint        running;                /* Признак запуска сервера. */
@@ -82,6 +115,13 @@ struct _HyScanCacheServerPrivate
 
   guint32              n_threads;              /* Число RPC потоков. */
   guint32              n_clients;              /* Максимальное число клиентов. */
+
+  volatile gint        n_bound;                /* Число потоков, закреплённых за NUMA узлами. */
+
+  HyScanCacheCounters *counters;               /* Счётчики вызовов процедур. */
+  GHashTable          *sessions;               /* Сессии клиентов. */
+  guint64              session_id;             /* Идентификатор последней сессии. */
+  GMutex               sessions_lock;          /* Блокировка доступа к сессиям. */
 };
 
 static void    hyscan_cache_server_set_property        (GObject               *object,
@@ -90,6 +130,8 @@ static void    hyscan_cache_server_set_property        (GObject               *o
                                                         GParamSpec            *pspec);
 static void    hyscan_cache_server_object_finalize     (GObject               *object);
 
+static void    hyscan_cache_server_session_free        (gpointer               data);
+
 static gint    hyscan_cache_server_rpc_proc_version    (uRpcData              *urpc_data,
                                                         void                  *thread_data,
                                                         void                  *session_data,
@@ -102,6 +144,58 @@ static gint    hyscan_cache_server_rpc_proc_get        (uRpcData              *u
                                                         void                  *thread_data,
                                                         void                  *session_data,
                                                         void                  *proc_data);
+static gint    hyscan_cache_server_rpc_proc_stats      (uRpcData              *urpc_data,
+                                                        void                  *thread_data,
+                                                        void                  *session_data,
+                                                        void                  *proc_data);
+static gint    hyscan_cache_server_rpc_proc_append     (uRpcData              *urpc_data,
+                                                        void                  *thread_data,
+                                                        void                  *session_data,
+                                                        void                  *proc_data);
+static gint    hyscan_cache_server_rpc_proc_get_range  (uRpcData              *urpc_data,
+                                                        void                  *thread_data,
+                                                        void                  *session_data,
+                                                        void                  *proc_data);
+static gint    hyscan_cache_server_rpc_proc_query      (uRpcData              *urpc_data,
+                                                        void                  *thread_data,
+                                                        void                  *session_data,
+                                                        void                  *proc_data);
+static gint    hyscan_cache_server_rpc_proc_contains_batch (uRpcData          *urpc_data,
+                                                        void                  *thread_data,
+                                                        void                  *session_data,
+                                                        void                  *proc_data);
+static gint    hyscan_cache_server_rpc_proc_set128     (uRpcData              *urpc_data,
+                                                        void                  *thread_data,
+                                                        void                  *session_data,
+                                                        void                  *proc_data);
+static gint    hyscan_cache_server_rpc_proc_get128     (uRpcData              *urpc_data,
+                                                        void                  *thread_data,
+                                                        void                  *session_data,
+                                                        void                  *proc_data);
+static gint    hyscan_cache_server_rpc_proc_mset       (uRpcData              *urpc_data,
+                                                        void                  *thread_data,
+                                                        void                  *session_data,
+                                                        void                  *proc_data);
+static gint    hyscan_cache_server_rpc_proc_mget       (uRpcData              *urpc_data,
+                                                        void                  *thread_data,
+                                                        void                  *session_data,
+                                                        void                  *proc_data);
+static gint    hyscan_cache_server_rpc_proc_set_begin  (uRpcData              *urpc_data,
+                                                        void                  *thread_data,
+                                                        void                  *session_data,
+                                                        void                  *proc_data);
+static gint    hyscan_cache_server_rpc_proc_set_chunk  (uRpcData              *urpc_data,
+                                                        void                  *thread_data,
+                                                        void                  *session_data,
+                                                        void                  *proc_data);
+static gint    hyscan_cache_server_rpc_proc_set_commit (uRpcData              *urpc_data,
+                                                        void                  *thread_data,
+                                                        void                  *session_data,
+                                                        void                  *proc_data);
+static gint    hyscan_cache_server_rpc_proc_get_chunk  (uRpcData              *urpc_data,
+                                                        void                  *thread_data,
+                                                        void                  *session_data,
+                                                        void                  *proc_data);
 
 G_DEFINE_TYPE_WITH_PRIVATE (HyScanCacheServer, hyscan_cache_server, G_TYPE_OBJECT);
 
@@ -135,7 +229,14 @@ hyscan_cache_server_class_init (HyScanCacheServerClass *klass)
 static void
 hyscan_cache_server_init (HyScanCacheServer *server)
 {
+  HyScanCacheServerPrivate *priv;
+
   server->priv = hyscan_cache_server_get_instance_private (server);
+  priv = server->priv;
+
+  priv->counters = hyscan_cache_counters_new (N_PROC_COUNTERS);
+  priv->sessions = g_hash_table_new_full (NULL, NULL, hyscan_cache_server_session_free, NULL);
+  g_mutex_init (&priv->sessions_lock);
 }
 
 static void
@@ -185,13 +286,30 @@ hyscan_cache_server_object_finalize (GObject *object)
 
   g_free (priv->uri);
 
+  hyscan_cache_counters_free (priv->counters);
+  g_hash_table_unref (priv->sessions);
+  g_mutex_clear (&priv->sessions_lock);
+
   G_OBJECT_CLASS (hyscan_cache_server_parent_class)->finalize (object);
 }
 
-/* Функция создаёт буфер данных потока исполнения RPC. */
+/* Функция создаёт буфер данных потока исполнения RPC. Если используется
+ * кэш #HyScanCacheNuma, потоки закрепляются за NUMA узлами по очереди. */
 static void *
 hyscan_cache_server_rpc_thread_start (gpointer user_data)
 {
+  HyScanCacheServerPrivate *priv = user_data;
+
+  if (HYSCAN_IS_CACHE_NUMA (priv->cache))
+    {
+      HyScanCacheNuma *numa = HYSCAN_CACHE_NUMA (priv->cache);
+      guint n_nodes = hyscan_cache_numa_get_n_nodes (numa);
+      guint node = (guint) g_atomic_int_add (&priv->n_bound, 1) % n_nodes;
+
+      if ((n_nodes > 1) && !hyscan_cache_numa_bind_thread (numa, node))
+        g_warning ("HyScanCacheServer: can't bind thread to numa node %u", node);
+    }
+
   return hyscan_buffer_new ();
 }
 
@@ -203,6 +321,279 @@ hyscan_cache_server_rpc_thread_stop (gpointer thread_data,
   g_object_unref (thread_data);
 }
 
+/* Функция прерывает запись объекта частями. */
+static void
+hyscan_cache_server_upload_reset (ServerSession *session)
+{
+  g_clear_object (&session->upload);
+  g_clear_pointer (&session->upload_key_string, g_free);
+  session->upload_received = 0;
+}
+
+/* Функция прерывает запись и чтение объектов частями. Обычные операции
+   чтения и записи в сессии означают, что клиент прервал передачу частями,
+   поэтому память, выделенная для неё, освобождается. */
+static void
+hyscan_cache_server_session_reset (ServerSession *session)
+{
+  if (session == NULL)
+    return;
+
+  hyscan_cache_server_upload_reset (session);
+  g_clear_object (&session->download);
+}
+
+/* Функция освобождает память сессии клиента. */
+static void
+hyscan_cache_server_session_free (gpointer data)
+{
+  ServerSession *session = data;
+
+  hyscan_cache_server_session_reset (session);
+
+  g_free (session);
+}
+
+/* Функция проверяет, может ли кэш принять объект заданного размера.
+   HyScanCached не принимает объекты больше 1/10 своего объёма. Если кэш
+   не сообщает свой объём, размер не ограничивается. */
+static gboolean
+hyscan_cache_server_check_size (HyScanCacheServerPrivate *priv,
+                                guint32                   size)
+{
+  HyScanCacheStats stats;
+
+  if (!hyscan_cache_get_stats (priv->cache, &stats) || stats.max_size == 0)
+    return TRUE;
+
+  return size <= stats.max_size / 10;
+}
+
+/* Функция сохраняет в сессии копию объекта, не помещающегося в ответ RPC,
+   для последующего чтения частями. */
+static gboolean
+hyscan_cache_server_snapshot (HyScanCacheServerPrivate *priv,
+                              ServerSession            *session,
+                              guint64                   key,
+                              const guint64            *key_hi,
+                              const gchar              *key_string,
+                              guint64                   detail,
+                              guint32                  *size)
+{
+  guint64 object_detail;
+  guint32 object_size;
+  gboolean status;
+
+  if (session == NULL)
+    return FALSE;
+
+  if (!hyscan_cache_queryi (priv->cache, key, &object_detail, &object_size) ||
+      object_size <= HYSCAN_CACHE_RPC_MAX_CHUNK)
+    {
+      return FALSE;
+    }
+
+  g_clear_object (&session->download);
+  session->download = hyscan_buffer_new ();
+
+  if (key_hi != NULL)
+    status = hyscan_cache_get128i (priv->cache, key, *key_hi, key_string, detail, G_MAXUINT32, session->download, NULL);
+  else
+    status = hyscan_cache_get2i (priv->cache, key, detail, G_MAXUINT32, session->download, NULL);
+
+  if (!status || hyscan_buffer_get (session->download, NULL, size) == NULL)
+    {
+      g_clear_object (&session->download);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Функция считывает объект в ответ RPC и возвращает статус выполнения
+   процедуры. Размер объекта запрашивается до чтения, поэтому в ответе
+   резервируется ровно необходимый объём, а для отсутствующих объектов
+   память не резервируется. Если объект увеличился между запросом размера
+   и чтением, чтение повторяется с резервированием максимального объёма.
+   Объекты, не помещающиеся в ответ, сохраняются в сессии для чтения частями.
+   Если кэш не умеет возвращать размер объекта без чтения данных, сразу
+   резервируется максимальный объём. */
+static guint32
+hyscan_cache_server_get_object (HyScanCacheServerPrivate *priv,
+                                ServerSession            *session,
+                                HyScanBuffer             *buffer,
+                                uRpcData                 *urpc_data,
+                                guint64                   key,
+                                const guint64            *key_hi,
+                                const gchar              *key_string,
+                                guint64                   detail)
+{
+  gboolean has_query = (HYSCAN_CACHE_GET_IFACE (priv->cache)->query != NULL);
+  guint64 object_detail;
+  guint32 reserved = 0;
+  guint32 size;
+  gboolean status;
+  gpointer data;
+  guint i;
+
+  for (i = 0; i < 2; i++)
+    {
+      if (!has_query)
+        {
+          if (i > 0)
+            break;
+
+          size = HYSCAN_CACHE_RPC_MAX_CHUNK;
+        }
+
+      /* Объекта нет в кэше или он не изменился с прошлой попытки. */
+      else if (!hyscan_cache_queryi (priv->cache, key, &object_detail, &size) || (i > 0 && size <= reserved))
+        {
+          break;
+        }
+
+      /* Объект не помещается в ответ и будет считан частями. */
+      if (size > HYSCAN_CACHE_RPC_MAX_CHUNK)
+        {
+          if (reserved > 0 && urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, NULL, 0) == NULL)
+            hyscan_cache_server_set_error ("data-size");
+
+          if (!hyscan_cache_server_snapshot (priv, session, key, key_hi, key_string, detail, &size))
+            return HYSCAN_CACHE_RPC_STATUS_FAIL;
+
+          if (urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_SIZE, size) != 0)
+            hyscan_cache_server_set_error ("size");
+
+          return HYSCAN_CACHE_RPC_STATUS_CHUNKED;
+        }
+
+      reserved = (i == 0) ? size : HYSCAN_CACHE_RPC_MAX_CHUNK;
+      data = urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, NULL, reserved);
+      if (data == NULL)
+        hyscan_cache_server_set_error ("data");
+
+      hyscan_buffer_wrap (buffer, HYSCAN_DATA_BLOB, data, reserved);
+
+      if (key_hi != NULL)
+        status = hyscan_cache_get128i (priv->cache, key, *key_hi, key_string, detail, G_MAXUINT32, buffer, NULL);
+      else
+        status = hyscan_cache_get2i (priv->cache, key, detail, G_MAXUINT32, buffer, NULL);
+
+      if (status)
+        {
+          if (hyscan_buffer_get (buffer, NULL, &size) == NULL)
+            size = 0;
+
+          if (size != reserved && urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, NULL, size) == NULL)
+            hyscan_cache_server_set_error ("data-size");
+
+          return HYSCAN_CACHE_RPC_STATUS_OK;
+        }
+    }
+
+  /* Зарезервированная память в ответе не нужна. */
+  if (reserved > 0 && urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, NULL, 0) == NULL)
+    hyscan_cache_server_set_error ("data-size");
+
+exit:
+  return HYSCAN_CACHE_RPC_STATUS_FAIL;
+}
+
+/* Функция регистрирует новую сессию клиента. */
+static void *
+hyscan_cache_server_rpc_session_start (gpointer thread_data,
+                                       gpointer user_data)
+{
+  HyScanCacheServerPrivate *priv = user_data;
+  ServerSession *session;
+
+  session = g_new0 (ServerSession, 1);
+  session->start_time = g_get_monotonic_time ();
+
+  g_mutex_lock (&priv->sessions_lock);
+  session->id = ++priv->session_id;
+  g_hash_table_add (priv->sessions, session);
+  g_mutex_unlock (&priv->sessions_lock);
+
+  return session;
+}
+
+/* Функция удаляет сессию клиента. */
+static void
+hyscan_cache_server_rpc_session_stop (gpointer thread_data,
+                                      gpointer session_data,
+                                      gpointer user_data)
+{
+  HyScanCacheServerPrivate *priv = user_data;
+
+  g_mutex_lock (&priv->sessions_lock);
+  g_hash_table_remove (priv->sessions, session_data);
+  g_mutex_unlock (&priv->sessions_lock);
+}
+
+/* Функция учитывает вызов процедуры proc, начатый в момент start. */
+static void
+hyscan_cache_server_account (HyScanCacheServerPrivate *priv,
+                             gpointer                  session_data,
+                             HyScanCacheServerProc     proc,
+                             gint64                    start)
+{
+  ServerSession *session = session_data;
+
+  hyscan_cache_counters_add (priv->counters, PROC_COUNTER (proc), 1);
+  hyscan_cache_counters_add_latency (priv->counters, PROC_COUNTER (proc) + 1, start);
+
+  if (session != NULL)
+    g_atomic_pointer_add (&session->requests, 1);
+}
+
+/* Функция собирает статистику работы сервера. */
+static HyScanCacheServerStats *
+hyscan_cache_server_get_server_stats_internal (HyScanCacheServerPrivate *priv)
+{
+  HyScanCacheServerStats *stats;
+  guint64 values[N_PROC_COUNTERS];
+  GHashTableIter iter;
+  gpointer session_data;
+  gint64 now;
+  guint i;
+
+  stats = g_new0 (HyScanCacheServerStats, 1);
+
+  if (priv->cache != NULL)
+    hyscan_cache_get_stats (priv->cache, &stats->cache);
+
+  /* Статистика процедур. */
+  hyscan_cache_counters_sum (priv->counters, 0, N_PROC_COUNTERS, values);
+  for (i = 0; i < HYSCAN_CACHE_SERVER_N_PROCS; i++)
+    {
+      stats->requests[i] = values[PROC_COUNTER (i)];
+      memcpy (stats->latency[i], values + PROC_COUNTER (i) + 1, sizeof (stats->latency[i]));
+    }
+
+  /* Статистика сессий. */
+  now = g_get_monotonic_time ();
+
+  g_mutex_lock (&priv->sessions_lock);
+
+  stats->sessions = g_new0 (HyScanCacheServerSession, g_hash_table_size (priv->sessions) + 1);
+
+  g_hash_table_iter_init (&iter, priv->sessions);
+  while (g_hash_table_iter_next (&iter, &session_data, NULL))
+    {
+      ServerSession *session = session_data;
+      HyScanCacheServerSession *info = &stats->sessions[stats->n_sessions++];
+
+      info->id = session->id;
+      info->requests = g_atomic_pointer_get (&session->requests);
+      info->duration = (gdouble) (now - session->start_time) / G_USEC_PER_SEC;
+    }
+
+  g_mutex_unlock (&priv->sessions_lock);
+
+  return stats;
+}
+
 /* RPC функция HYSCAN_CACHE_RPC_PROC_VERSION. */
 static gint
 hyscan_cache_server_rpc_proc_version (uRpcData *urpc_data,
@@ -234,6 +625,10 @@ hyscan_cache_server_rpc_proc_set (uRpcData *urpc_data,
   gpointer data;
   guint32  size;
 
+  gint64 start = hyscan_cache_counters_now ();
+
+  hyscan_cache_server_session_reset (session_data);
+
   if (urpc_data_get_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY, &key) != 0)
     hyscan_cache_server_get_error ("key");
 
@@ -253,6 +648,49 @@ hyscan_cache_server_rpc_proc_set (uRpcData *urpc_data,
 
 exit:
   urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, rpc_status);
+  hyscan_cache_server_account (priv, session_data, HYSCAN_CACHE_SERVER_PROC_SET, start);
+  return 0;
+}
+
+/* RPC функция HYSCAN_CACHE_RPC_PROC_APPEND. */
+static gint
+hyscan_cache_server_rpc_proc_append (uRpcData *urpc_data,
+                                     void     *thread_data,
+                                     void     *session_data,
+                                     void     *proc_data)
+{
+  HyScanCacheServerPrivate *priv = proc_data;
+
+  guint32 rpc_status = HYSCAN_CACHE_RPC_STATUS_FAIL;
+  HyScanBuffer *buffer = thread_data;
+
+  guint64  key;
+  guint64  detail;
+  gpointer data;
+  guint32  size;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  hyscan_cache_server_session_reset (session_data);
+
+  if (urpc_data_get_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY, &key) != 0)
+    hyscan_cache_server_get_error ("key");
+
+  if (urpc_data_get_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_DETAIL, &detail) != 0)
+    detail = 0;
+
+  data = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, &size);
+  if (data == NULL)
+    hyscan_cache_server_get_error ("data");
+
+  hyscan_buffer_wrap (buffer, HYSCAN_DATA_BLOB, data, size);
+
+  if (hyscan_cache_appendi (priv->cache, key, detail, buffer))
+    rpc_status = HYSCAN_CACHE_RPC_STATUS_OK;
+
+exit:
+  urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, rpc_status);
+  hyscan_cache_server_account (priv, session_data, HYSCAN_CACHE_SERVER_PROC_APPEND, start);
   return 0;
 }
 
@@ -265,14 +703,51 @@ hyscan_cache_server_rpc_proc_get (uRpcData *urpc_data,
 {
   HyScanCacheServerPrivate *priv = proc_data;
 
+  guint32 rpc_status = HYSCAN_CACHE_RPC_STATUS_FAIL;
+
+  guint64  key;
+  guint64  detail;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  hyscan_cache_server_session_reset (session_data);
+
+  if (urpc_data_get_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY, &key) != 0)
+    hyscan_cache_server_get_error ("key");
+
+  if (urpc_data_get_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_DETAIL, &detail) != 0)
+    detail = 0;
+
+  rpc_status = hyscan_cache_server_get_object (priv, session_data, thread_data, urpc_data,
+                                               key, NULL, NULL, detail);
+
+exit:
+  urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, rpc_status);
+  hyscan_cache_server_account (priv, session_data, HYSCAN_CACHE_SERVER_PROC_GET, start);
+  return 0;
+}
+
+/* RPC функция HYSCAN_CACHE_RPC_PROC_GET_RANGE. */
+static gint
+hyscan_cache_server_rpc_proc_get_range (uRpcData *urpc_data,
+                                        void     *thread_data,
+                                        void     *session_data,
+                                        void     *proc_data)
+{
+  HyScanCacheServerPrivate *priv = proc_data;
+
   guint32 rpc_status = HYSCAN_CACHE_RPC_STATUS_FAIL;
   HyScanBuffer *buffer = thread_data;
 
   guint64  key;
   guint64  detail;
-  gpointer data;
+  guint32  offset;
   guint32  size;
-  gboolean status = FALSE;
+  gpointer data;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  hyscan_cache_server_session_reset (session_data);
 
   if (urpc_data_get_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY, &key) != 0)
     hyscan_cache_server_get_error ("key");
@@ -280,20 +755,26 @@ hyscan_cache_server_rpc_proc_get (uRpcData *urpc_data,
   if (urpc_data_get_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_DETAIL, &detail) != 0)
     detail = 0;
 
-  size = URPC_MAX_DATA_SIZE - 1024;
+  if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_OFFSET, &offset) != 0)
+    hyscan_cache_server_get_error ("offset");
+
+  if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_SIZE, &size) != 0)
+    hyscan_cache_server_get_error ("size");
+
+  /* Размер данных ограничен размером буфера RPC. */
+  size = MIN (size, URPC_MAX_DATA_SIZE - 1024);
   data = urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, NULL, size);
   if (data == NULL)
     hyscan_cache_server_set_error ("data");
 
   hyscan_buffer_wrap (buffer, HYSCAN_DATA_BLOB, data, size);
 
-  status = hyscan_cache_get2i (priv->cache, key, detail, G_MAXUINT32, buffer, NULL);
-  if (status)
+  if (hyscan_cache_get_rangei (priv->cache, key, detail, offset, size, buffer))
     {
       if (hyscan_buffer_get (buffer, NULL, &size) == NULL)
         size = 0;
 
-      if (urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, NULL, size) == NULL )
+      if (urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, NULL, size) == NULL)
         hyscan_cache_server_set_error ("data-size");
 
       rpc_status = HYSCAN_CACHE_RPC_STATUS_OK;
@@ -301,51 +782,723 @@ hyscan_cache_server_rpc_proc_get (uRpcData *urpc_data,
 
 exit:
   urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, rpc_status);
+  hyscan_cache_server_account (priv, session_data, HYSCAN_CACHE_SERVER_PROC_GET_RANGE, start);
   return 0;
 }
 
-/**
- * hyscan_cache_server_new:
- * @uri: адрес сервера
- * @cache: объект в который транслируются запросы клиентов
- * @n_threads: число потоков сервера
- * @n_clients: максимальное число клиентов сервера
- *
- * Функция создаёт новый объект #HyScanCacheServer.
- *
- * Returns: #HyScanCacheServer. Для удаления #g_object_unref.
- */
-HyScanCacheServer *
-hyscan_cache_server_new (const gchar *uri,
-                         HyScanCache *cache,
-                         guint32      n_threads,
-                         guint32      n_clients)
+/* RPC функция HYSCAN_CACHE_RPC_PROC_QUERY. */
+static gint
+hyscan_cache_server_rpc_proc_query (uRpcData *urpc_data,
+                                    void     *thread_data,
+                                    void     *session_data,
+                                    void     *proc_data)
 {
-  return g_object_new (HYSCAN_TYPE_CACHE_SERVER,
-                       "uri", uri,
-                       "cache", cache,
-                       "n-threads", n_threads,
-                       "n-clients", n_clients,
-                       NULL);
-}
+  HyScanCacheServerPrivate *priv = proc_data;
 
-/**
- * hyscan_cache_server_start:
- * @server: указатель на #HyScanCacheServer
- *
- * Функция запускает сервер системы кэширования в работу.
- *
- * Returns: %TRUE если сервер запущен, иначе %FALSE.
- */
-gboolean
-hyscan_cache_server_start (HyScanCacheServer *server)
-{
-  HyScanCacheServerPrivate *priv;
+  guint32 rpc_status = HYSCAN_CACHE_RPC_STATUS_FAIL;
 
-  uRpcType rpc_type;
-  gint status;
+  guint64 key;
+  guint64 detail;
+  guint32 size;
 
-  g_return_val_if_fail (HYSCAN_IS_CACHE_SERVER (server), FALSE);
+  gint64 start = hyscan_cache_counters_now ();
+
+  if (urpc_data_get_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY, &key) != 0)
+    hyscan_cache_server_get_error ("key");
+
+  if (hyscan_cache_queryi (priv->cache, key, &detail, &size))
+    {
+      if (urpc_data_set_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_DETAIL, detail) != 0)
+        hyscan_cache_server_set_error ("detail");
+
+      if (urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_SIZE, size) != 0)
+        hyscan_cache_server_set_error ("size");
+
+      rpc_status = HYSCAN_CACHE_RPC_STATUS_OK;
+    }
+
+exit:
+  urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, rpc_status);
+  hyscan_cache_server_account (priv, session_data, HYSCAN_CACHE_SERVER_PROC_QUERY, start);
+  return 0;
+}
+
+/* RPC функция HYSCAN_CACHE_RPC_PROC_CONTAINS_BATCH. */
+static gint
+hyscan_cache_server_rpc_proc_contains_batch (uRpcData *urpc_data,
+                                             void     *thread_data,
+                                             void     *session_data,
+                                             void     *proc_data)
+{
+  HyScanCacheServerPrivate *priv = proc_data;
+
+  guint32 rpc_status = HYSCAN_CACHE_RPC_STATUS_FAIL;
+
+  guint64 *keys = NULL;
+  gboolean *found = NULL;
+  guint64 *data;
+  guint8 *result;
+  guint32 size;
+  guint n_keys;
+  guint i;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  data = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEYS, &size);
+  if (data == NULL)
+    hyscan_cache_server_get_error ("keys");
+
+  n_keys = size / sizeof (guint64);
+  if (n_keys == 0 || n_keys > HYSCAN_CACHE_RPC_MAX_BATCH_KEYS)
+    hyscan_cache_server_get_error ("keys");
+
+  keys = g_new (guint64, n_keys);
+  found = g_new (gboolean, n_keys);
+  for (i = 0; i < n_keys; i++)
+    keys[i] = GUINT64_FROM_LE (data[i]);
+
+  hyscan_cache_contains_batchi (priv->cache, keys, n_keys, found);
+
+  result = urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_FOUND, NULL, n_keys);
+  if (result == NULL)
+    hyscan_cache_server_set_error ("found");
+
+  for (i = 0; i < n_keys; i++)
+    result[i] = found[i] ? 1 : 0;
+
+  rpc_status = HYSCAN_CACHE_RPC_STATUS_OK;
+
+exit:
+  g_free (keys);
+  g_free (found);
+
+  urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, rpc_status);
+  hyscan_cache_server_account (priv, session_data, HYSCAN_CACHE_SERVER_PROC_CONTAINS_BATCH, start);
+  return 0;
+}
+
+/* RPC функция HYSCAN_CACHE_RPC_PROC_SET128. */
+static gint
+hyscan_cache_server_rpc_proc_set128 (uRpcData *urpc_data,
+                                     void     *thread_data,
+                                     void     *session_data,
+                                     void     *proc_data)
+{
+  HyScanCacheServerPrivate *priv = proc_data;
+
+  guint32 rpc_status = HYSCAN_CACHE_RPC_STATUS_FAIL;
+  HyScanBuffer *buffer = NULL;
+
+  guint64  key_lo;
+  guint64  key_hi;
+  guint64  detail;
+  const gchar *key;
+  gpointer data;
+  guint32  size;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  hyscan_cache_server_session_reset (session_data);
+
+  if (urpc_data_get_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY, &key_lo) != 0)
+    hyscan_cache_server_get_error ("key");
+
+  if (urpc_data_get_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY_HI, &key_hi) != 0)
+    hyscan_cache_server_get_error ("key-hi");
+
+  if (urpc_data_get_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_DETAIL, &detail) != 0)
+    detail = 0;
+
+  key = urpc_data_get_string (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY_STRING, HYSCAN_CACHE_RPC_MAX_KEY_STRING);
+
+  data = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, &size);
+  if (data != NULL)
+    {
+      buffer = thread_data;
+      hyscan_buffer_wrap (buffer, HYSCAN_DATA_BLOB, data, size);
+    }
+
+  if (hyscan_cache_set128i (priv->cache, key_lo, key_hi, key, detail, buffer, NULL))
+    rpc_status = HYSCAN_CACHE_RPC_STATUS_OK;
+
+exit:
+  urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, rpc_status);
+  hyscan_cache_server_account (priv, session_data, HYSCAN_CACHE_SERVER_PROC_SET128, start);
+  return 0;
+}
+
+/* RPC функция HYSCAN_CACHE_RPC_PROC_GET128. */
+static gint
+hyscan_cache_server_rpc_proc_get128 (uRpcData *urpc_data,
+                                     void     *thread_data,
+                                     void     *session_data,
+                                     void     *proc_data)
+{
+  HyScanCacheServerPrivate *priv = proc_data;
+
+  guint32 rpc_status = HYSCAN_CACHE_RPC_STATUS_FAIL;
+
+  guint64  key_lo;
+  guint64  key_hi;
+  guint64  detail;
+  gchar   *key = NULL;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  hyscan_cache_server_session_reset (session_data);
+
+  if (urpc_data_get_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY, &key_lo) != 0)
+    hyscan_cache_server_get_error ("key");
+
+  if (urpc_data_get_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY_HI, &key_hi) != 0)
+    hyscan_cache_server_get_error ("key-hi");
+
+  if (urpc_data_get_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_DETAIL, &detail) != 0)
+    detail = 0;
+
+  /* Строку ключа необходимо скопировать до записи данных ответа. */
+  key = g_strdup (urpc_data_get_string (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY_STRING, HYSCAN_CACHE_RPC_MAX_KEY_STRING));
+
+  rpc_status = hyscan_cache_server_get_object (priv, session_data, thread_data, urpc_data,
+                                               key_lo, &key_hi, key, detail);
+
+exit:
+  g_free (key);
+
+  urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, rpc_status);
+  hyscan_cache_server_account (priv, session_data, HYSCAN_CACHE_SERVER_PROC_GET128, start);
+  return 0;
+}
+
+/* RPC функция HYSCAN_CACHE_RPC_PROC_MSET. */
+static gint
+hyscan_cache_server_rpc_proc_mset (uRpcData *urpc_data,
+                                   void     *thread_data,
+                                   void     *session_data,
+                                   void     *proc_data)
+{
+  HyScanCacheServerPrivate *priv = proc_data;
+
+  guint32 rpc_status = HYSCAN_CACHE_RPC_STATUS_FAIL;
+  HyScanBuffer *buffer = thread_data;
+
+  guint8 *stored = NULL;
+  guint64 *keys;
+  guint64 *details;
+  guint32 *sizes;
+  guint8 *data;
+  guint32 size;
+  guint32 offset = 0;
+  guint n_keys;
+  guint i;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  hyscan_cache_server_session_reset (session_data);
+
+  keys = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEYS, &size);
+  if (keys == NULL)
+    hyscan_cache_server_get_error ("keys");
+
+  n_keys = size / sizeof (guint64);
+  if (n_keys == 0 || n_keys > HYSCAN_CACHE_RPC_MAX_MULTI_KEYS)
+    hyscan_cache_server_get_error ("keys");
+
+  details = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_DETAILS, &size);
+  if (details != NULL && size != n_keys * sizeof (guint64))
+    hyscan_cache_server_get_error ("details");
+
+  sizes = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_SIZES, &size);
+  if (sizes == NULL || size != n_keys * sizeof (guint32))
+    hyscan_cache_server_get_error ("sizes");
+
+  data = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, &size);
+  if (data == NULL)
+    size = 0;
+
+  /* Все объекты записываются до формирования ответа, так как он
+     размещается на месте параметров запроса. */
+  stored = g_new0 (guint8, n_keys);
+  for (i = 0; i < n_keys; i++)
+    {
+      guint64 detail = (details != NULL) ? GUINT64_FROM_LE (details[i]) : 0;
+      guint32 part = GUINT32_FROM_LE (sizes[i]);
+      HyScanBuffer *object = NULL;
+
+      if (part == HYSCAN_CACHE_RPC_REMOVE_SIZE)
+        {
+          part = 0;
+        }
+      else
+        {
+          if (part > size - offset)
+            break;
+
+          object = buffer;
+          hyscan_buffer_wrap (object, HYSCAN_DATA_BLOB, data + offset, part);
+        }
+
+      if (hyscan_cache_set2i (priv->cache, GUINT64_FROM_LE (keys[i]), detail, object, NULL))
+        stored[i] = 1;
+
+      offset += part;
+    }
+
+  if (urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_FOUND, stored, n_keys) == NULL)
+    hyscan_cache_server_set_error ("found");
+
+  rpc_status = HYSCAN_CACHE_RPC_STATUS_OK;
+
+exit:
+  g_free (stored);
+
+  urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, rpc_status);
+  hyscan_cache_server_account (priv, session_data, HYSCAN_CACHE_SERVER_PROC_MSET, start);
+  return 0;
+}
+
+/* RPC функция HYSCAN_CACHE_RPC_PROC_MGET. */
+static gint
+hyscan_cache_server_rpc_proc_mget (uRpcData *urpc_data,
+                                   void     *thread_data,
+                                   void     *session_data,
+                                   void     *proc_data)
+{
+  HyScanCacheServerPrivate *priv = proc_data;
+
+  guint32 rpc_status = HYSCAN_CACHE_RPC_STATUS_FAIL;
+  HyScanBuffer *buffer = thread_data;
+
+  guint64 *keys = NULL;
+  guint64 *details = NULL;
+  guint64 *param;
+  guint8 *found;
+  guint32 *sizes;
+  guint8 *data;
+  guint32 size;
+  guint32 offset = 0;
+  guint n_keys;
+  guint i;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  hyscan_cache_server_session_reset (session_data);
+
+  param = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEYS, &size);
+  if (param == NULL)
+    hyscan_cache_server_get_error ("keys");
+
+  n_keys = size / sizeof (guint64);
+  if (n_keys == 0 || n_keys > HYSCAN_CACHE_RPC_MAX_MULTI_KEYS)
+    hyscan_cache_server_get_error ("keys");
+
+  /* Ключи необходимо скопировать до записи данных ответа. */
+  keys = g_new (guint64, n_keys);
+  details = g_new0 (guint64, n_keys);
+  for (i = 0; i < n_keys; i++)
+    keys[i] = GUINT64_FROM_LE (param[i]);
+
+  param = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_DETAILS, &size);
+  if (param != NULL)
+    {
+      if (size != n_keys * sizeof (guint64))
+        hyscan_cache_server_get_error ("details");
+
+      for (i = 0; i < n_keys; i++)
+        details[i] = GUINT64_FROM_LE (param[i]);
+    }
+
+  found = urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_FOUND, NULL, n_keys);
+  if (found == NULL)
+    hyscan_cache_server_set_error ("found");
+
+  sizes = urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_SIZES, NULL, n_keys * sizeof (guint32));
+  if (sizes == NULL)
+    hyscan_cache_server_set_error ("sizes");
+
+  size = HYSCAN_CACHE_RPC_MAX_MULTI_DATA;
+  data = urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, NULL, size);
+  if (data == NULL)
+    hyscan_cache_server_set_error ("data");
+
+  memset (found, 0, n_keys);
+  memset (sizes, 0, n_keys * sizeof (guint32));
+
+  /* Объекты считываются прямо в ответ, пока их данные в нём помещаются. */
+  for (i = 0; i < n_keys; i++)
+    {
+      guint64 object_detail;
+      guint32 object_size;
+      guint32 part;
+
+      hyscan_buffer_wrap (buffer, HYSCAN_DATA_BLOB, data + offset, size - offset);
+
+      if (hyscan_cache_get2i (priv->cache, keys[i], details[i], G_MAXUINT32, buffer, NULL))
+        {
+          if (hyscan_buffer_get (buffer, NULL, &part) == NULL)
+            part = 0;
+
+          found[i] = 1;
+          sizes[i] = GUINT32_TO_LE (part);
+          offset += part;
+        }
+
+      /* Объект есть в кэше, но не поместился в ответ. */
+      else if (hyscan_cache_queryi (priv->cache, keys[i], &object_detail, &object_size) &&
+               (details[i] == 0 || object_detail == details[i]) && object_size > size - offset)
+        {
+          break;
+        }
+    }
+
+  if (urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, NULL, offset) == NULL)
+    hyscan_cache_server_set_error ("data-size");
+
+  if (urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_COUNT, i) != 0)
+    hyscan_cache_server_set_error ("count");
+
+  rpc_status = HYSCAN_CACHE_RPC_STATUS_OK;
+
+exit:
+  g_free (keys);
+  g_free (details);
+
+  urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, rpc_status);
+  hyscan_cache_server_account (priv, session_data, HYSCAN_CACHE_SERVER_PROC_MGET, start);
+  return 0;
+}
+
+/* RPC функция HYSCAN_CACHE_RPC_PROC_SET_BEGIN. */
+static gint
+hyscan_cache_server_rpc_proc_set_begin (uRpcData *urpc_data,
+                                        void     *thread_data,
+                                        void     *session_data,
+                                        void     *proc_data)
+{
+  HyScanCacheServerPrivate *priv = proc_data;
+  ServerSession *session = session_data;
+
+  guint32 rpc_status = HYSCAN_CACHE_RPC_STATUS_FAIL;
+
+  guint64 key;
+  guint64 key_hi;
+  guint64 detail;
+  guint32 size;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  if (session == NULL)
+    hyscan_cache_server_get_error ("session");
+
+  hyscan_cache_server_session_reset (session);
+
+  if (urpc_data_get_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY, &key) != 0)
+    hyscan_cache_server_get_error ("key");
+
+  if (urpc_data_get_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_DETAIL, &detail) != 0)
+    detail = 0;
+
+  if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_SIZE, &size) != 0)
+    hyscan_cache_server_get_error ("size");
+
+  /* Память не выделяется для объектов, которые кэш не примет. */
+  if (!hyscan_cache_server_check_size (priv, size))
+    goto exit;
+
+  session->upload_key128 = (urpc_data_get_uint64 (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY_HI, &key_hi) == 0);
+  if (session->upload_key128)
+    {
+      session->upload_key_hi = key_hi;
+      session->upload_key_string = g_strdup (urpc_data_get_string (urpc_data, HYSCAN_CACHE_RPC_PARAM_KEY_STRING,
+                                                                   HYSCAN_CACHE_RPC_MAX_KEY_STRING));
+    }
+
+  session->upload = hyscan_buffer_new ();
+  if (!hyscan_buffer_set_data_size (session->upload, size))
+    goto exit;
+
+  session->upload_key = key;
+  session->upload_detail = detail;
+  session->upload_size = size;
+
+  rpc_status = HYSCAN_CACHE_RPC_STATUS_OK;
+
+exit:
+  if (rpc_status != HYSCAN_CACHE_RPC_STATUS_OK && session != NULL)
+    hyscan_cache_server_upload_reset (session);
+
+  urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, rpc_status);
+  hyscan_cache_server_account (priv, session_data, HYSCAN_CACHE_SERVER_PROC_SET_BEGIN, start);
+  return 0;
+}
+
+/* RPC функция HYSCAN_CACHE_RPC_PROC_SET_CHUNK. */
+static gint
+hyscan_cache_server_rpc_proc_set_chunk (uRpcData *urpc_data,
+                                        void     *thread_data,
+                                        void     *session_data,
+                                        void     *proc_data)
+{
+  HyScanCacheServerPrivate *priv = proc_data;
+  ServerSession *session = session_data;
+
+  guint32 rpc_status = HYSCAN_CACHE_RPC_STATUS_FAIL;
+
+  guint8  *object;
+  gpointer data;
+  guint32  offset;
+  guint32  size;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  if (session == NULL || session->upload == NULL)
+    hyscan_cache_server_get_error ("upload");
+
+  if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_OFFSET, &offset) != 0)
+    hyscan_cache_server_get_error ("offset");
+
+  data = urpc_data_get (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, &size);
+  if (data == NULL)
+    hyscan_cache_server_get_error ("data");
+
+  /* Части данных должны передаваться последовательно. */
+  if (offset != session->upload_received || size > session->upload_size - offset)
+    hyscan_cache_server_get_error ("offset");
+
+  object = hyscan_buffer_get (session->upload, NULL, NULL);
+  memcpy (object + offset, data, size);
+  session->upload_received += size;
+
+  rpc_status = HYSCAN_CACHE_RPC_STATUS_OK;
+
+exit:
+  if (rpc_status != HYSCAN_CACHE_RPC_STATUS_OK && session != NULL)
+    hyscan_cache_server_upload_reset (session);
+
+  urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, rpc_status);
+  hyscan_cache_server_account (priv, session_data, HYSCAN_CACHE_SERVER_PROC_SET_CHUNK, start);
+  return 0;
+}
+
+/* RPC функция HYSCAN_CACHE_RPC_PROC_SET_COMMIT. */
+static gint
+hyscan_cache_server_rpc_proc_set_commit (uRpcData *urpc_data,
+                                         void     *thread_data,
+                                         void     *session_data,
+                                         void     *proc_data)
+{
+  HyScanCacheServerPrivate *priv = proc_data;
+  ServerSession *session = session_data;
+
+  guint32 rpc_status = HYSCAN_CACHE_RPC_STATUS_FAIL;
+  gboolean status;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  if (session == NULL || session->upload == NULL)
+    hyscan_cache_server_get_error ("upload");
+
+  if (session->upload_received != session->upload_size)
+    hyscan_cache_server_get_error ("data");
+
+  if (session->upload_key128)
+    {
+      status = hyscan_cache_set128i (priv->cache, session->upload_key, session->upload_key_hi,
+                                     session->upload_key_string, session->upload_detail,
+                                     session->upload, NULL);
+    }
+  else
+    {
+      status = hyscan_cache_set2i (priv->cache, session->upload_key, session->upload_detail,
+                                   session->upload, NULL);
+    }
+
+  if (status)
+    rpc_status = HYSCAN_CACHE_RPC_STATUS_OK;
+
+exit:
+  if (session != NULL)
+    hyscan_cache_server_upload_reset (session);
+
+  urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, rpc_status);
+  hyscan_cache_server_account (priv, session_data, HYSCAN_CACHE_SERVER_PROC_SET_COMMIT, start);
+  return 0;
+}
+
+/* RPC функция HYSCAN_CACHE_RPC_PROC_GET_CHUNK. */
+static gint
+hyscan_cache_server_rpc_proc_get_chunk (uRpcData *urpc_data,
+                                        void     *thread_data,
+                                        void     *session_data,
+                                        void     *proc_data)
+{
+  HyScanCacheServerPrivate *priv = proc_data;
+  ServerSession *session = session_data;
+
+  guint32 rpc_status = HYSCAN_CACHE_RPC_STATUS_FAIL;
+
+  guint8 *object;
+  guint32 object_size;
+  guint32 offset;
+  guint32 size;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  if (session == NULL || session->download == NULL)
+    hyscan_cache_server_get_error ("download");
+
+  if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_OFFSET, &offset) != 0)
+    hyscan_cache_server_get_error ("offset");
+
+  if (urpc_data_get_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_SIZE, &size) != 0)
+    hyscan_cache_server_get_error ("size");
+
+  object = hyscan_buffer_get (session->download, NULL, &object_size);
+  if (object == NULL || offset > object_size)
+    hyscan_cache_server_get_error ("offset");
+
+  size = MIN (size, object_size - offset);
+  size = MIN (size, HYSCAN_CACHE_RPC_MAX_CHUNK);
+  if (urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_DATA, object + offset, size) == NULL)
+    hyscan_cache_server_set_error ("data");
+
+  /* Копия объекта больше не нужна после чтения последней части. */
+  if (offset + size == object_size)
+    g_clear_object (&session->download);
+
+  rpc_status = HYSCAN_CACHE_RPC_STATUS_OK;
+
+exit:
+  if (rpc_status != HYSCAN_CACHE_RPC_STATUS_OK && session != NULL)
+    g_clear_object (&session->download);
+
+  urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, rpc_status);
+  hyscan_cache_server_account (priv, session_data, HYSCAN_CACHE_SERVER_PROC_GET_CHUNK, start);
+  return 0;
+}
+
+/* RPC функция HYSCAN_CACHE_RPC_PROC_STATS. */
+static gint
+hyscan_cache_server_rpc_proc_stats (uRpcData *urpc_data,
+                                    void     *thread_data,
+                                    void     *session_data,
+                                    void     *proc_data)
+{
+  HyScanCacheServerPrivate *priv = proc_data;
+
+  guint32 rpc_status = HYSCAN_CACHE_RPC_STATUS_FAIL;
+  HyScanCacheServerStats *stats;
+  guint64 *data;
+  guint32 size;
+  guint n_sessions;
+  guint i, j;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  stats = hyscan_cache_server_get_server_stats_internal (priv);
+
+  /* Статистика кэша. */
+  size = (2 + HYSCAN_CACHE_RPC_CACHE_STATS_FIELDS + HYSCAN_CACHE_N_OPS * HYSCAN_CACHE_STATS_N_BINS) * sizeof (guint64);
+  data = urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_CACHE_STATS, NULL, size);
+  if (data == NULL)
+    hyscan_cache_server_set_error ("cache-stats");
+
+  *data++ = GUINT64_TO_LE (HYSCAN_CACHE_N_OPS);
+  *data++ = GUINT64_TO_LE (HYSCAN_CACHE_STATS_N_BINS);
+  *data++ = GUINT64_TO_LE (stats->cache.hits);
+  *data++ = GUINT64_TO_LE (stats->cache.misses);
+  *data++ = GUINT64_TO_LE (stats->cache.detail_mismatches);
+  *data++ = GUINT64_TO_LE (stats->cache.sets);
+  *data++ = GUINT64_TO_LE (stats->cache.evictions);
+  *data++ = GUINT64_TO_LE (stats->cache.rejected);
+  *data++ = GUINT64_TO_LE (stats->cache.used_size);
+  *data++ = GUINT64_TO_LE (stats->cache.max_size);
+  *data++ = GUINT64_TO_LE (stats->cache.n_objects);
+  for (i = 0; i < HYSCAN_CACHE_N_OPS; i++)
+    for (j = 0; j < HYSCAN_CACHE_STATS_N_BINS; j++)
+      *data++ = GUINT64_TO_LE (stats->cache.latency[i][j]);
+
+  /* Статистика процедур. */
+  size = (2 + HYSCAN_CACHE_SERVER_N_PROCS * (HYSCAN_CACHE_STATS_N_BINS + 1)) * sizeof (guint64);
+  data = urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_PROC_STATS, NULL, size);
+  if (data == NULL)
+    hyscan_cache_server_set_error ("proc-stats");
+
+  *data++ = GUINT64_TO_LE (HYSCAN_CACHE_SERVER_N_PROCS);
+  *data++ = GUINT64_TO_LE (HYSCAN_CACHE_STATS_N_BINS);
+  for (i = 0; i < HYSCAN_CACHE_SERVER_N_PROCS; i++)
+    {
+      *data++ = GUINT64_TO_LE (stats->requests[i]);
+      for (j = 0; j < HYSCAN_CACHE_STATS_N_BINS; j++)
+        *data++ = GUINT64_TO_LE (stats->latency[i][j]);
+    }
+
+  /* Статистика сессий, если все сессии не помещаются, передаются только первые. */
+  n_sessions = MIN (stats->n_sessions, (URPC_MAX_DATA_SIZE / 2) / (3 * sizeof (guint64)));
+  size = (1 + 3 * n_sessions) * sizeof (guint64);
+  data = urpc_data_set (urpc_data, HYSCAN_CACHE_RPC_PARAM_SESSION_STATS, NULL, size);
+  if (data == NULL)
+    hyscan_cache_server_set_error ("session-stats");
+
+  *data++ = GUINT64_TO_LE (n_sessions);
+  for (i = 0; i < n_sessions; i++)
+    {
+      *data++ = GUINT64_TO_LE (stats->sessions[i].id);
+      *data++ = GUINT64_TO_LE (stats->sessions[i].requests);
+      *data++ = GUINT64_TO_LE ((guint64) (stats->sessions[i].duration * G_USEC_PER_SEC));
+    }
+
+  rpc_status = HYSCAN_CACHE_RPC_STATUS_OK;
+
+exit:
+  hyscan_cache_server_stats_free (stats);
+  urpc_data_set_uint32 (urpc_data, HYSCAN_CACHE_RPC_PARAM_STATUS, rpc_status);
+  hyscan_cache_server_account (priv, session_data, HYSCAN_CACHE_SERVER_PROC_STATS, start);
+  return 0;
+}
+
+/**
+ * hyscan_cache_server_new:
+ * @uri: адрес сервера
+ * @cache: объект в который транслируются запросы клиентов
+ * @n_threads: число потоков сервера
+ * @n_clients: максимальное число клиентов сервера
+ *
+ * Функция создаёт новый объект #HyScanCacheServer.
+ *
+ * Returns: #HyScanCacheServer. Для удаления #g_object_unref.
+ */
+HyScanCacheServer *
+hyscan_cache_server_new (const gchar *uri,
+                         HyScanCache *cache,
+                         guint32      n_threads,
+                         guint32      n_clients)
+{
+  return g_object_new (HYSCAN_TYPE_CACHE_SERVER,
+                       "uri", uri,
+                       "cache", cache,
+                       "n-threads", n_threads,
+                       "n-clients", n_clients,
+                       NULL);
+}
+
+/**
+ * hyscan_cache_server_start:
+ * @server: указатель на #HyScanCacheServer
+ *
+ * Функция запускает сервер системы кэширования в работу.
+ *
+ * Returns: %TRUE если сервер запущен, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_server_start (HyScanCacheServer *server)
+{
+  HyScanCacheServerPrivate *priv;
+
+  uRpcType rpc_type;
+  gint status;
+
+  g_return_val_if_fail (HYSCAN_IS_CACHE_SERVER (server), FALSE);
 
   priv = server->priv;
 
@@ -377,7 +1530,7 @@ hyscan_cache_server_start (HyScanCacheServer *server)
   /* Функции инициализации потоков исполнения. */
   status = urpc_server_add_thread_start_callback (priv->rpc,
                                                   hyscan_cache_server_rpc_thread_start,
-                                                  NULL);
+                                                  priv);
   if (status != 0)
     goto fail;
 
@@ -387,6 +1540,19 @@ hyscan_cache_server_start (HyScanCacheServer *server)
   if (status != 0)
     goto fail;
 
+  /* Функции учёта сессий клиентов. */
+  status = urpc_server_add_session_start_callback (priv->rpc,
+                                                   hyscan_cache_server_rpc_session_start,
+                                                   priv);
+  if (status != 0)
+    goto fail;
+
+  status = urpc_server_add_session_stop_callback (priv->rpc,
+                                                  hyscan_cache_server_rpc_session_stop,
+                                                  priv);
+  if (status != 0)
+    goto fail;
+
   status = urpc_server_add_callback (priv->rpc, HYSCAN_CACHE_RPC_PROC_VERSION,
                                      hyscan_cache_server_rpc_proc_version, priv);
   if (status != 0)
@@ -402,6 +1568,71 @@ hyscan_cache_server_start (HyScanCacheServer *server)
   if (status != 0)
     goto fail;
 
+  status = urpc_server_add_callback (priv->rpc, HYSCAN_CACHE_RPC_PROC_STATS,
+                                     hyscan_cache_server_rpc_proc_stats, priv);
+  if (status != 0)
+    goto fail;
+
+  status = urpc_server_add_callback (priv->rpc, HYSCAN_CACHE_RPC_PROC_APPEND,
+                                     hyscan_cache_server_rpc_proc_append, priv);
+  if (status != 0)
+    goto fail;
+
+  status = urpc_server_add_callback (priv->rpc, HYSCAN_CACHE_RPC_PROC_GET_RANGE,
+                                     hyscan_cache_server_rpc_proc_get_range, priv);
+  if (status != 0)
+    goto fail;
+
+  status = urpc_server_add_callback (priv->rpc, HYSCAN_CACHE_RPC_PROC_QUERY,
+                                     hyscan_cache_server_rpc_proc_query, priv);
+  if (status != 0)
+    goto fail;
+
+  status = urpc_server_add_callback (priv->rpc, HYSCAN_CACHE_RPC_PROC_CONTAINS_BATCH,
+                                     hyscan_cache_server_rpc_proc_contains_batch, priv);
+  if (status != 0)
+    goto fail;
+
+  status = urpc_server_add_callback (priv->rpc, HYSCAN_CACHE_RPC_PROC_SET128,
+                                     hyscan_cache_server_rpc_proc_set128, priv);
+  if (status != 0)
+    goto fail;
+
+  status = urpc_server_add_callback (priv->rpc, HYSCAN_CACHE_RPC_PROC_GET128,
+                                     hyscan_cache_server_rpc_proc_get128, priv);
+  if (status != 0)
+    goto fail;
+
+  status = urpc_server_add_callback (priv->rpc, HYSCAN_CACHE_RPC_PROC_MSET,
+                                     hyscan_cache_server_rpc_proc_mset, priv);
+  if (status != 0)
+    goto fail;
+
+  status = urpc_server_add_callback (priv->rpc, HYSCAN_CACHE_RPC_PROC_MGET,
+                                     hyscan_cache_server_rpc_proc_mget, priv);
+  if (status != 0)
+    goto fail;
+
+  status = urpc_server_add_callback (priv->rpc, HYSCAN_CACHE_RPC_PROC_SET_BEGIN,
+                                     hyscan_cache_server_rpc_proc_set_begin, priv);
+  if (status != 0)
+    goto fail;
+
+  status = urpc_server_add_callback (priv->rpc, HYSCAN_CACHE_RPC_PROC_SET_CHUNK,
+                                     hyscan_cache_server_rpc_proc_set_chunk, priv);
+  if (status != 0)
+    goto fail;
+
+  status = urpc_server_add_callback (priv->rpc, HYSCAN_CACHE_RPC_PROC_SET_COMMIT,
+                                     hyscan_cache_server_rpc_proc_set_commit, priv);
+  if (status != 0)
+    goto fail;
+
+  status = urpc_server_add_callback (priv->rpc, HYSCAN_CACHE_RPC_PROC_GET_CHUNK,
+                                     hyscan_cache_server_rpc_proc_get_chunk, priv);
+  if (status != 0)
+    goto fail;
+
   /* Запуск RPC сервера. */
   status = urpc_server_bind (priv->rpc);
   if (status != 0)
@@ -415,3 +1646,56 @@ fail:
   priv->rpc = NULL;
   return FALSE;
 }
+
+/**
+ * hyscan_cache_server_get_stats:
+ * @server: указатель на #HyScanCacheServer
+ * @stats: (out): статистика работы кэша
+ *
+ * Функция возвращает статистику работы кэша, в который транслируются
+ * запросы клиентов.
+ *
+ * Returns: %TRUE если статистика получена, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_server_get_stats (HyScanCacheServer *server,
+                               HyScanCacheStats  *stats)
+{
+  g_return_val_if_fail (HYSCAN_IS_CACHE_SERVER (server), FALSE);
+
+  return hyscan_cache_get_stats (server->priv->cache, stats);
+}
+
+/**
+ * hyscan_cache_server_get_server_stats:
+ * @server: указатель на #HyScanCacheServer
+ *
+ * Функция возвращает статистику работы сервера: статистику кэша, число
+ * вызовов и время выполнения процедур и число запросов в сессиях клиентов.
+ *
+ * Returns: (transfer full): #HyScanCacheServerStats. Для удаления
+ * #hyscan_cache_server_stats_free.
+ */
+HyScanCacheServerStats *
+hyscan_cache_server_get_server_stats (HyScanCacheServer *server)
+{
+  g_return_val_if_fail (HYSCAN_IS_CACHE_SERVER (server), NULL);
+
+  return hyscan_cache_server_get_server_stats_internal (server->priv);
+}
+
+/**
+ * hyscan_cache_server_stats_free:
+ * @stats: статистика работы сервера
+ *
+ * Функция удаляет статистику работы сервера.
+ */
+void
+hyscan_cache_server_stats_free (HyScanCacheServerStats *stats)
+{
+  if (stats == NULL)
+    return;
+
+  g_free (stats->sessions);
+  g_free (stats);
+}
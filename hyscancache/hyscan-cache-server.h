@@ -46,6 +46,82 @@ G_BEGIN_DECLS
 #define HYSCAN_IS_CACHE_SERVER_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), HYSCAN_TYPE_CACHE_SERVER))
 #define HYSCAN_CACHE_SERVER_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), HYSCAN_TYPE_CACHE_SERVER, HyScanCacheServerClass))
 
+/**
+ * HyScanCacheServerProc:
+ * @HYSCAN_CACHE_SERVER_PROC_SET: запись данных
+ * @HYSCAN_CACHE_SERVER_PROC_GET: чтение данных
+ * @HYSCAN_CACHE_SERVER_PROC_STATS: чтение статистики
+ * @HYSCAN_CACHE_SERVER_PROC_APPEND: добавление данных
+ * @HYSCAN_CACHE_SERVER_PROC_GET_RANGE: чтение части данных
+ * @HYSCAN_CACHE_SERVER_PROC_QUERY: запрос информации об объекте
+ * @HYSCAN_CACHE_SERVER_PROC_CONTAINS_BATCH: проверка наличия объектов
+ * @HYSCAN_CACHE_SERVER_PROC_SET128: запись данных по 128-ми битному ключу
+ * @HYSCAN_CACHE_SERVER_PROC_GET128: чтение данных по 128-ми битному ключу
+ * @HYSCAN_CACHE_SERVER_PROC_MSET: запись нескольких объектов
+ * @HYSCAN_CACHE_SERVER_PROC_MGET: чтение нескольких объектов
+ * @HYSCAN_CACHE_SERVER_PROC_SET_BEGIN: начало записи объекта частями
+ * @HYSCAN_CACHE_SERVER_PROC_SET_CHUNK: запись части объекта
+ * @HYSCAN_CACHE_SERVER_PROC_SET_COMMIT: завершение записи объекта частями
+ * @HYSCAN_CACHE_SERVER_PROC_GET_CHUNK: чтение части объекта
+ * @HYSCAN_CACHE_SERVER_N_PROCS: число процедур
+ *
+ * Процедуры сервера, для которых ведётся статистика.
+ */
+typedef enum
+{
+  HYSCAN_CACHE_SERVER_PROC_SET,
+  HYSCAN_CACHE_SERVER_PROC_GET,
+  HYSCAN_CACHE_SERVER_PROC_STATS,
+  HYSCAN_CACHE_SERVER_PROC_APPEND,
+  HYSCAN_CACHE_SERVER_PROC_GET_RANGE,
+  HYSCAN_CACHE_SERVER_PROC_QUERY,
+  HYSCAN_CACHE_SERVER_PROC_CONTAINS_BATCH,
+  HYSCAN_CACHE_SERVER_PROC_SET128,
+  HYSCAN_CACHE_SERVER_PROC_GET128,
+  HYSCAN_CACHE_SERVER_PROC_MSET,
+  HYSCAN_CACHE_SERVER_PROC_MGET,
+  HYSCAN_CACHE_SERVER_PROC_SET_BEGIN,
+  HYSCAN_CACHE_SERVER_PROC_SET_CHUNK,
+  HYSCAN_CACHE_SERVER_PROC_SET_COMMIT,
+  HYSCAN_CACHE_SERVER_PROC_GET_CHUNK,
+  HYSCAN_CACHE_SERVER_N_PROCS
+} HyScanCacheServerProc;
+
+/**
+ * HyScanCacheServerSession:
+ * @id: идентификатор сессии
+ * @requests: число запросов в сессии
+ * @duration: время с момента подключения клиента, с
+ *
+ * Статистика сессии клиента.
+ */
+typedef struct
+{
+  guint64                      id;
+  guint64                      requests;
+  gdouble                      duration;
+} HyScanCacheServerSession;
+
+/**
+ * HyScanCacheServerStats:
+ * @cache: статистика работы кэша
+ * @requests: число вызовов процедур
+ * @latency: гистограммы времени выполнения процедур, аналогичные #HyScanCacheStats
+ * @n_sessions: число сессий клиентов
+ * @sessions: статистика сессий клиентов
+ *
+ * Статистика работы сервера. Для удаления используется функция
+ * #hyscan_cache_server_stats_free.
+ */
+typedef struct
+{
+  HyScanCacheStats             cache;
+  guint64                      requests[HYSCAN_CACHE_SERVER_N_PROCS];
+  guint64                      latency[HYSCAN_CACHE_SERVER_N_PROCS][HYSCAN_CACHE_STATS_N_BINS];
+  guint                        n_sessions;
+  HyScanCacheServerSession    *sessions;
+} HyScanCacheServerStats;
+
 typedef struct _HyScanCacheServer HyScanCacheServer;
 typedef struct _HyScanCacheServerPrivate HyScanCacheServerPrivate;
 typedef struct _HyScanCacheServerClass HyScanCacheServerClass;
@@ -74,6 +150,16 @@ HyScanCacheServer     *hyscan_cache_server_new         (const gchar           *u
 HYSCAN_API
 gboolean               hyscan_cache_server_start       (HyScanCacheServer     *server);
 
+HYSCAN_API
+gboolean               hyscan_cache_server_get_stats   (HyScanCacheServer     *server,
+                                                        HyScanCacheStats      *stats);
+
+HYSCAN_API
+HyScanCacheServerStats *hyscan_cache_server_get_server_stats (HyScanCacheServer *server);
+
+HYSCAN_API
+void                   hyscan_cache_server_stats_free  (HyScanCacheServerStats *stats);
+
 G_END_DECLS
 
 #endif /* __HYSCAN__H__ */
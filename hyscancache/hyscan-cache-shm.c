@@ -0,0 +1,978 @@
+/* hyscan-cache-shm.c
+ *
+ * Copyright 2015-2019 Screen LLC, Andrei Fadeev <andrei@webcontrol.ru>
+ *
+ * This file is part of HyScanCache.
+ *
+ * HyScanCache is dual-licensed: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HyScanCache is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Alternatively, you can license this code under a commercial license.
+ * Contact the Screen LLC in this case - <info@screen-co.ru>.
+ */
+
+/* HyScanCache имеет двойную лицензию.
+ *
+ * Во-первых, вы можете распространять HyScanCache на условиях Стандартной
+ * Общественной Лицензии GNU версии 3, либо по любой более поздней версии
+ * лицензии (по вашему выбору). Полные положения лицензии GNU приведены в
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Во-вторых, этот программный код можно использовать по коммерческой
+ * лицензии. Для этого свяжитесь с ООО Экран - <info@screen-co.ru>.
+ */
+
+
+/**
+ * SECTION: hyscan-cache-shm
+ * @Short_description: кэширование данных в разделяемой памяти
+ * @Title: HyScanCacheShm
+ *
+ * HyScanCacheShm реализация интерфейса #HyScanCache, хранящая индекс и
+ * данные объектов в именованном сегменте разделяемой памяти. Все процессы,
+ * создавшие объект HyScanCacheShm с одинаковым именем, работают с общим
+ * кэшем напрямую, без обращения к серверу кэширования.
+ *
+ * Объект HyScanCacheShm создаётся при помощи функции #hyscan_cache_shm_new.
+ * Если сегмент с указанным именем уже существует, используется он и его
+ * размер, иначе создаётся новый сегмент указанного размера. Сегмент
+ * существует до вызова функции #hyscan_cache_shm_unlink, даже если все
+ * процессы, использовавшие его, завершили работу.
+ *
+ * Данные объектов размещаются в кольцевом журнале: новые и изменённые
+ * объекты записываются в его начало, а при исчерпании памяти удаляются
+ * объекты, записанные раньше всех. Индекс объектов представляет собой
+ * таблицу из групп по несколько ячеек, при заполнении группы из индекса
+ * удаляется самый старый объект.
+ *
+ * Чтение данных выполняется без блокировок: после копирования данных
+ * проверяется, что область журнала с объектом не была перезаписана, иначе
+ * чтение повторяется. Запись данных выполняется под межпроцессной
+ * блокировкой. Структуры кэша изменяются в таком порядке, что остаются
+ * согласованными на любом шаге, поэтому аварийное завершение процесса во
+ * время записи не нарушает работу остальных процессов.
+ *
+ * Разделяемая память поддерживается только в POSIX системах.
+ */
+
+#include "hyscan-cache-shm.h"
+
+#include <string.h>
+
+#ifdef G_OS_UNIX
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef CPU_ARCH_X32
+  #define MIN_CACHE_SIZE     64
+  #define MAX_CACHE_SIZE     2048
+#else
+  #define MIN_CACHE_SIZE     64
+  #define MAX_CACHE_SIZE     131072
+#endif
+
+#define SHM_MAGIC            G_GUINT64_CONSTANT (0x314d485348435348)   /* "HSCHSHM1" */
+#define SHM_VERSION          1
+#define SHM_HEADER_SIZE      4096
+#define SHM_BUCKET_SLOTS     4
+#define SHM_BYTES_PER_SLOT   256
+#define SHM_MIN_BUCKETS      1024
+#define SHM_READ_ATTEMPTS    4
+#define SHM_OPEN_ATTEMPTS    1000
+#define SHM_FLAG_PADDING     1
+#define SHM_RECORD_SIZE      sizeof (ShmRecord)
+#define SHM_ALIGN(s)         (((s) + 7) & ~((guint64) 7))
+
+/* Атомарный доступ к полям, разделяемым между процессами. */
+#define shm_load(p)          __atomic_load_n ((p), __ATOMIC_ACQUIRE)
+#define shm_store(p, v)      __atomic_store_n ((p), (v), __ATOMIC_RELEASE)
+
+enum
+{
+  PROP_O,
+  PROP_NAME,
+  PROP_CACHE_SIZE
+};
+
+/* Заголовок сегмента разделяемой памяти. Позиции в журнале монотонно
+   возрастают, смещение записи в области данных равно позиции по модулю
+   её размера. Записи с позициями в диапазоне [tail, head) действительны. */
+typedef struct _ShmHeader ShmHeader;
+struct _ShmHeader
+{
+  guint64              magic;                  /* Идентификатор сегмента, записывается последним. */
+  guint32              version;                /* Версия формата сегмента. */
+  guint32              n_buckets;              /* Число групп ячеек индекса, степень двойки. */
+  guint64              data_size;              /* Размер области данных. */
+  guint64              index_offset;           /* Смещение индекса от начала сегмента. */
+  guint64              data_offset;            /* Смещение области данных от начала сегмента. */
+
+  guint64              head;                   /* Позиция для записи следующего объекта. */
+  guint64              tail;                   /* Позиция самого старого объекта. */
+
+#ifdef G_OS_UNIX
+  pthread_mutex_t      lock;                   /* Межпроцессная блокировка записи. */
+#endif
+};
+
+/* Ячейка индекса, нулевая позиция означает пустую ячейку. */
+typedef struct _ShmSlot ShmSlot;
+struct _ShmSlot
+{
+  guint64              key;                    /* Хэш идентификатора объекта. */
+  guint64              pos;                    /* Позиция объекта в журнале. */
+};
+
+/* Группа ячеек индекса, занимает одну строку кэша процессора. */
+typedef struct _ShmBucket ShmBucket;
+struct _ShmBucket
+{
+  ShmSlot              slots[SHM_BUCKET_SLOTS];
+};
+
+/* Заголовок записи в журнале, за ним следуют данные объекта. */
+typedef struct _ShmRecord ShmRecord;
+struct _ShmRecord
+{
+  guint64              pos;                    /* Позиция записи в журнале. */
+  guint64              key;                    /* Хэш идентификатора объекта. */
+  guint64              detail;                 /* Хэш дополнительной информации объекта. */
+  guint32              size;                   /* Размер объекта. */
+  guint32              flags;                  /* Признаки записи. */
+};
+
+/* Внутренние данные объекта. */
+struct _HyScanCacheShmPrivate
+{
+  gchar               *name;                   /* Имя сегмента разделяемой памяти. */
+  guint64              cache_size;             /* Размер области данных нового сегмента. */
+
+  gint                 fd;                     /* Дескриптор сегмента. */
+  gpointer             segment;                /* Адрес отображения сегмента. */
+  gsize                segment_size;           /* Размер сегмента. */
+
+  ShmHeader           *header;                 /* Заголовок сегмента. */
+  ShmBucket           *buckets;                /* Индекс объектов. */
+  guint8              *data;                   /* Область данных. */
+};
+
+static void            hyscan_cache_shm_interface_init         (HyScanCacheInterface  *iface);
+static void            hyscan_cache_shm_set_property           (GObject               *object,
+                                                                guint                  prop_id,
+                                                                const GValue          *value,
+                                                                GParamSpec            *pspec);
+static void            hyscan_cache_shm_object_constructed     (GObject               *object);
+static void            hyscan_cache_shm_object_finalize        (GObject               *object);
+
+static gchar          *hyscan_cache_shm_segment_name           (const gchar           *name);
+static gboolean        hyscan_cache_shm_open                   (HyScanCacheShmPrivate *priv);
+static void            hyscan_cache_shm_close                  (HyScanCacheShmPrivate *priv);
+
+static void            hyscan_cache_shm_lock                   (ShmHeader             *header);
+static void            hyscan_cache_shm_unlock                 (ShmHeader             *header);
+
+static ShmSlot        *hyscan_cache_shm_find_slot              (HyScanCacheShmPrivate *priv,
+                                                                guint64                key);
+static ShmSlot        *hyscan_cache_shm_free_slot              (HyScanCacheShmPrivate *priv,
+                                                                guint64                key);
+static void            hyscan_cache_shm_reserve                (HyScanCacheShmPrivate *priv,
+                                                                guint64                head,
+                                                                guint64                size);
+static guint64         hyscan_cache_shm_append                 (HyScanCacheShmPrivate *priv,
+                                                                guint64                key,
+                                                                guint64                detail,
+                                                                gpointer               data1,
+                                                                guint32                size1,
+                                                                gpointer               data2,
+                                                                guint32                size2);
+
+G_DEFINE_TYPE_WITH_CODE (HyScanCacheShm, hyscan_cache_shm, G_TYPE_OBJECT,
+                         G_ADD_PRIVATE (HyScanCacheShm)
+                         G_IMPLEMENT_INTERFACE (HYSCAN_TYPE_CACHE, hyscan_cache_shm_interface_init));
+
+static void
+hyscan_cache_shm_class_init (HyScanCacheShmClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->set_property = hyscan_cache_shm_set_property;
+  object_class->constructed = hyscan_cache_shm_object_constructed;
+  object_class->finalize = hyscan_cache_shm_object_finalize;
+
+  g_object_class_install_property (object_class, PROP_NAME,
+                                   g_param_spec_string ("name", "Name", "Shared memory name", NULL,
+                                                        G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
+
+  g_object_class_install_property (object_class, PROP_CACHE_SIZE,
+                                   g_param_spec_uint ("cache-size", "Cache size", "Cache size, Mb",
+                                                      MIN_CACHE_SIZE, MAX_CACHE_SIZE, MIN_CACHE_SIZE,
+                                                      G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
+}
+
+static void
+hyscan_cache_shm_init (HyScanCacheShm *shm)
+{
+  shm->priv = hyscan_cache_shm_get_instance_private (shm);
+  shm->priv->fd = -1;
+}
+
+static void
+hyscan_cache_shm_set_property (GObject      *object,
+                               guint         prop_id,
+                               const GValue *value,
+                               GParamSpec   *pspec)
+{
+  HyScanCacheShm *shm = HYSCAN_CACHE_SHM (object);
+  HyScanCacheShmPrivate *priv = shm->priv;
+
+  switch (prop_id)
+    {
+    case PROP_NAME:
+      priv->name = g_value_dup_string (value);
+      break;
+
+    case PROP_CACHE_SIZE:
+      priv->cache_size = g_value_get_uint (value);
+      priv->cache_size *= 1024 * 1024;
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+hyscan_cache_shm_object_constructed (GObject *object)
+{
+  HyScanCacheShm *shm = HYSCAN_CACHE_SHM (object);
+  HyScanCacheShmPrivate *priv = shm->priv;
+
+  if (priv->name == NULL)
+    return;
+
+  if (!hyscan_cache_shm_open (priv))
+    hyscan_cache_shm_close (priv);
+}
+
+static void
+hyscan_cache_shm_object_finalize (GObject *object)
+{
+  HyScanCacheShm *shm = HYSCAN_CACHE_SHM (object);
+  HyScanCacheShmPrivate *priv = shm->priv;
+
+  hyscan_cache_shm_close (priv);
+
+  g_free (priv->name);
+
+  G_OBJECT_CLASS (hyscan_cache_shm_parent_class)->finalize (object);
+}
+
+/* Функция возвращает имя сегмента разделяемой памяти. */
+static gchar *
+hyscan_cache_shm_segment_name (const gchar *name)
+{
+  return g_strdup_printf ("/hyscan-cache-%s", name);
+}
+
+#ifdef G_OS_UNIX
+
+/* Функция подключает сегмент разделяемой памяти, при необходимости создавая его. */
+static gboolean
+hyscan_cache_shm_open (HyScanCacheShmPrivate *priv)
+{
+  gchar *segment_name;
+  gboolean created = FALSE;
+  struct stat st;
+  guint i;
+
+  segment_name = hyscan_cache_shm_segment_name (priv->name);
+
+  /* Пытаемся создать новый сегмент, если он уже есть - подключаемся к нему. */
+  priv->fd = shm_open (segment_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (priv->fd >= 0)
+    created = TRUE;
+  else if (errno == EEXIST)
+    priv->fd = shm_open (segment_name, O_RDWR, 0600);
+
+  if (priv->fd < 0)
+    {
+      g_warning ("HyScanCacheShm: can't open shared memory '%s'", priv->name);
+      goto fail;
+    }
+
+  /* Создаём новый сегмент. */
+  if (created)
+    {
+      pthread_mutexattr_t attr;
+      ShmHeader *header;
+      guint64 n_buckets;
+      gsize index_size;
+
+      /* Число групп ячеек индекса - степень двойки. */
+      n_buckets = SHM_MIN_BUCKETS;
+      while (n_buckets * SHM_BUCKET_SLOTS * SHM_BYTES_PER_SLOT < priv->cache_size)
+        n_buckets *= 2;
+
+      index_size = n_buckets * sizeof (ShmBucket);
+      priv->segment_size = SHM_HEADER_SIZE + index_size + priv->cache_size;
+
+      if (ftruncate (priv->fd, priv->segment_size) != 0)
+        {
+          g_warning ("HyScanCacheShm: can't allocate shared memory '%s'", priv->name);
+          goto fail;
+        }
+
+      priv->segment = mmap (NULL, priv->segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, priv->fd, 0);
+      if (priv->segment == MAP_FAILED)
+        {
+          priv->segment = NULL;
+          g_warning ("HyScanCacheShm: can't map shared memory '%s'", priv->name);
+          goto fail;
+        }
+
+      /* Память сегмента после ftruncate заполнена нулями, что соответствует
+         пустому индексу. Позиции в журнале начинаются с размера области
+         данных, поэтому нулевая позиция никогда не используется. */
+      header = priv->segment;
+      header->version = SHM_VERSION;
+      header->n_buckets = n_buckets;
+      header->data_size = priv->cache_size;
+      header->index_offset = SHM_HEADER_SIZE;
+      header->data_offset = SHM_HEADER_SIZE + index_size;
+      header->head = priv->cache_size;
+      header->tail = priv->cache_size;
+
+      pthread_mutexattr_init (&attr);
+      pthread_mutexattr_setpshared (&attr, PTHREAD_PROCESS_SHARED);
+      pthread_mutexattr_setrobust (&attr, PTHREAD_MUTEX_ROBUST);
+      pthread_mutex_init (&header->lock, &attr);
+      pthread_mutexattr_destroy (&attr);
+
+      shm_store (&header->magic, SHM_MAGIC);
+    }
+
+  /* Подключаемся к существующему сегменту. Процесс, создающий сегмент,
+     может ещё не закончить его инициализацию. */
+  else
+    {
+      for (i = 0; i < SHM_OPEN_ATTEMPTS; i++)
+        {
+          if (fstat (priv->fd, &st) != 0)
+            break;
+          if (st.st_size >= SHM_HEADER_SIZE)
+            break;
+          g_usleep (1000);
+        }
+
+      if (i == SHM_OPEN_ATTEMPTS || st.st_size < SHM_HEADER_SIZE)
+        {
+          g_warning ("HyScanCacheShm: shared memory '%s' is not initialized", priv->name);
+          goto fail;
+        }
+
+      priv->segment_size = st.st_size;
+      priv->segment = mmap (NULL, priv->segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, priv->fd, 0);
+      if (priv->segment == MAP_FAILED)
+        {
+          priv->segment = NULL;
+          g_warning ("HyScanCacheShm: can't map shared memory '%s'", priv->name);
+          goto fail;
+        }
+
+      for (i = 0; i < SHM_OPEN_ATTEMPTS; i++)
+        {
+          if (shm_load (&((ShmHeader *) priv->segment)->magic) == SHM_MAGIC)
+            break;
+          g_usleep (1000);
+        }
+
+      if (i == SHM_OPEN_ATTEMPTS || ((ShmHeader *) priv->segment)->version != SHM_VERSION)
+        {
+          g_warning ("HyScanCacheShm: shared memory '%s' has unknown format", priv->name);
+          goto fail;
+        }
+    }
+
+  priv->header = priv->segment;
+  priv->buckets = (ShmBucket *) ((guint8 *) priv->segment + priv->header->index_offset);
+  priv->data = (guint8 *) priv->segment + priv->header->data_offset;
+
+  if (priv->header->data_offset + priv->header->data_size > priv->segment_size)
+    {
+      g_warning ("HyScanCacheShm: shared memory '%s' is corrupted", priv->name);
+      priv->header = NULL;
+      goto fail;
+    }
+
+  g_free (segment_name);
+
+  return TRUE;
+
+fail:
+  /* Недостроенный сегмент удаляется, иначе следующие процессы подключатся
+     к нему вместо создания нового. */
+  if (created)
+    shm_unlink (segment_name);
+
+  g_free (segment_name);
+
+  return FALSE;
+}
+
+/* Функция отключает сегмент разделяемой памяти. */
+static void
+hyscan_cache_shm_close (HyScanCacheShmPrivate *priv)
+{
+  if (priv->segment != NULL)
+    munmap (priv->segment, priv->segment_size);
+
+  if (priv->fd >= 0)
+    close (priv->fd);
+
+  priv->header = NULL;
+  priv->buckets = NULL;
+  priv->data = NULL;
+  priv->segment = NULL;
+  priv->fd = -1;
+}
+
+/* Функция захватывает межпроцессную блокировку. */
+static void
+hyscan_cache_shm_lock (ShmHeader *header)
+{
+  /* Процесс, владевший блокировкой, аварийно завершился. Структуры кэша
+     изменяются в таком порядке, что остаются согласованными на любом
+     шаге, поэтому достаточно восстановить блокировку. */
+  if (pthread_mutex_lock (&header->lock) == EOWNERDEAD)
+    pthread_mutex_consistent (&header->lock);
+}
+
+/* Функция освобождает межпроцессную блокировку. */
+static void
+hyscan_cache_shm_unlock (ShmHeader *header)
+{
+  pthread_mutex_unlock (&header->lock);
+}
+
+#else /* G_OS_UNIX */
+
+static gboolean
+hyscan_cache_shm_open (HyScanCacheShmPrivate *priv)
+{
+  g_warning ("HyScanCacheShm: shared memory is not supported");
+  return FALSE;
+}
+
+static void
+hyscan_cache_shm_close (HyScanCacheShmPrivate *priv)
+{
+}
+
+static void
+hyscan_cache_shm_lock (ShmHeader *header)
+{
+}
+
+static void
+hyscan_cache_shm_unlock (ShmHeader *header)
+{
+}
+
+#endif /* G_OS_UNIX */
+
+/* Функция ищет ячейку индекса с действительным объектом. */
+static ShmSlot *
+hyscan_cache_shm_find_slot (HyScanCacheShmPrivate *priv,
+                            guint64                key)
+{
+  ShmBucket *bucket = &priv->buckets[key & (priv->header->n_buckets - 1)];
+  guint64 tail = shm_load (&priv->header->tail);
+  guint i;
+
+  for (i = 0; i < SHM_BUCKET_SLOTS; i++)
+    {
+      ShmSlot *slot = &bucket->slots[i];
+      guint64 pos = shm_load (&slot->pos);
+
+      if (pos >= tail && shm_load (&slot->key) == key)
+        return slot;
+    }
+
+  return NULL;
+}
+
+/* Функция выбирает ячейку индекса для нового объекта: пустую, с удалённым
+   из журнала объектом или, если таких нет, с самым старым объектом. */
+static ShmSlot *
+hyscan_cache_shm_free_slot (HyScanCacheShmPrivate *priv,
+                            guint64                key)
+{
+  ShmBucket *bucket = &priv->buckets[key & (priv->header->n_buckets - 1)];
+  ShmSlot *oldest = &bucket->slots[0];
+  guint64 tail = priv->header->tail;
+  guint i;
+
+  for (i = 0; i < SHM_BUCKET_SLOTS; i++)
+    {
+      ShmSlot *slot = &bucket->slots[i];
+
+      if (slot->pos < tail)
+        return slot;
+
+      if (slot->pos < oldest->pos)
+        oldest = slot;
+    }
+
+  return oldest;
+}
+
+/* Функция удаляет из журнала старые записи, пока между позицией head и
+   концом новой записи размером size не освободится достаточно места. */
+static void
+hyscan_cache_shm_reserve (HyScanCacheShmPrivate *priv,
+                          guint64                head,
+                          guint64                size)
+{
+  ShmHeader *header = priv->header;
+  guint64 data_size = header->data_size;
+  guint64 tail = header->tail;
+
+  while (head + size - tail > data_size)
+    {
+      guint64 offset = tail % data_size;
+
+      /* Неиспользуемый остаток в конце области данных. */
+      if (data_size - offset < SHM_RECORD_SIZE)
+        {
+          tail += data_size - offset;
+        }
+      else
+        {
+          ShmRecord *record = (ShmRecord *) (priv->data + offset);
+          tail += SHM_ALIGN (SHM_RECORD_SIZE + record->size);
+        }
+    }
+
+  /* Новая позиция tail должна стать видна читателям до того,
+     как освобождённая область будет перезаписана. */
+  shm_store (&header->tail, tail);
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+}
+
+/* Функция записывает объект в журнал и возвращает его позицию. */
+static guint64
+hyscan_cache_shm_append (HyScanCacheShmPrivate *priv,
+                         guint64                key,
+                         guint64                detail,
+                         gpointer               data1,
+                         guint32                size1,
+                         gpointer               data2,
+                         guint32                size2)
+{
+  ShmHeader *header = priv->header;
+  guint64 data_size = header->data_size;
+  guint64 size = SHM_ALIGN (SHM_RECORD_SIZE + size1 + size2);
+  guint64 head = header->head;
+  guint64 offset = head % data_size;
+  ShmRecord *record;
+
+  /* Запись не помещается до конца области данных, остаток
+     помечается как пустая запись и журнал продолжается с начала. */
+  if (data_size - offset < size)
+    {
+      guint64 padding = data_size - offset;
+
+      hyscan_cache_shm_reserve (priv, head, padding);
+      if (padding >= SHM_RECORD_SIZE)
+        {
+          record = (ShmRecord *) (priv->data + offset);
+          record->pos = head;
+          record->key = 0;
+          record->detail = 0;
+          record->size = padding - SHM_RECORD_SIZE;
+          record->flags = SHM_FLAG_PADDING;
+        }
+
+      head += padding;
+      offset = 0;
+      shm_store (&header->head, head);
+    }
+
+  hyscan_cache_shm_reserve (priv, head, size);
+
+  record = (ShmRecord *) (priv->data + offset);
+  record->pos = head;
+  record->key = key;
+  record->detail = detail;
+  record->size = size1 + size2;
+  record->flags = 0;
+
+  if (size1 > 0)
+    memcpy (record + 1, data1, size1);
+  if (size2 > 0)
+    memcpy ((guint8 *) (record + 1) + size1, data2, size2);
+
+  /* Запись становится частью журнала только после копирования данных. */
+  shm_store (&header->head, head + size);
+
+  return head;
+}
+
+/**
+ * hyscan_cache_shm_new:
+ * @name: имя сегмента разделяемой памяти
+ * @cache_size: объём памяти для данных, Мб
+ *
+ * Функция создаёт новый объект #HyScanCacheShm. Если сегмент с указанным
+ * именем уже существует, параметр cache_size не используется.
+ *
+ * Returns: #HyScanCacheShm. Для удаления #g_object_unref.
+ */
+HyScanCacheShm *
+hyscan_cache_shm_new (const gchar *name,
+                      guint32      cache_size)
+{
+  return g_object_new (HYSCAN_TYPE_CACHE_SHM,
+                       "name", name,
+                       "cache-size", cache_size,
+                       NULL);
+}
+
+/**
+ * hyscan_cache_shm_unlink:
+ * @name: имя сегмента разделяемой памяти
+ *
+ * Функция удаляет сегмент разделяемой памяти. Процессы, уже подключенные
+ * к сегменту, продолжают работать с ним, память освобождается после их
+ * отключения.
+ *
+ * Returns: %TRUE если сегмент удалён, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_shm_unlink (const gchar *name)
+{
+#ifdef G_OS_UNIX
+  gchar *segment_name;
+  gint status;
+
+  g_return_val_if_fail (name != NULL, FALSE);
+
+  segment_name = hyscan_cache_shm_segment_name (name);
+  status = shm_unlink (segment_name);
+  g_free (segment_name);
+
+  return (status == 0);
+#else
+  return FALSE;
+#endif
+}
+
+/* Функция добавляет или изменяет объект в кэше. */
+static gboolean
+hyscan_cache_shm_set (HyScanCache  *cache,
+                      guint64       key,
+                      guint64       detail,
+                      HyScanBuffer *buffer1,
+                      HyScanBuffer *buffer2)
+{
+  HyScanCacheShm *shm = HYSCAN_CACHE_SHM (cache);
+  HyScanCacheShmPrivate *priv = shm->priv;
+
+  ShmSlot *slot;
+  guint64 pos;
+
+  gpointer data1 = NULL;
+  gpointer data2 = NULL;
+  guint32 size1 = 0;
+  guint32 size2 = 0;
+  guint32 size;
+
+  if (priv->header == NULL)
+    return FALSE;
+
+  if (buffer1 != NULL)
+    data1 = hyscan_buffer_get (buffer1, NULL, &size1);
+  if (buffer2 != NULL)
+    data2 = hyscan_buffer_get (buffer2, NULL, &size2);
+
+  size = size1 + size2;
+
+  /* Если размер нового объекта слишком большой, не сохраняем его. */
+  if (size > priv->header->data_size / 10)
+    return FALSE;
+
+  hyscan_cache_shm_lock (priv->header);
+
+  slot = hyscan_cache_shm_find_slot (priv, key);
+
+  /* Если размер объекта равен нулю, удаляем объект. */
+  if (size == 0)
+    {
+      if (slot != NULL)
+        shm_store (&slot->pos, 0);
+
+      goto exit;
+    }
+
+  /* Записываем объект в журнал. */
+  pos = hyscan_cache_shm_append (priv, key, detail, data1, size1, data2, size2);
+
+  /* Обновляем индекс. Ячейка сначала помечается пустой, чтобы читатель
+     не увидел новый ключ вместе со старой позицией. */
+  if (slot == NULL)
+    slot = hyscan_cache_shm_free_slot (priv, key);
+
+  shm_store (&slot->pos, 0);
+  shm_store (&slot->key, key);
+  shm_store (&slot->pos, pos);
+
+exit:
+  hyscan_cache_shm_unlock (priv->header);
+
+  return TRUE;
+}
+
+/* Функция считывает объект из кэша. */
+static gboolean
+hyscan_cache_shm_get (HyScanCache  *cache,
+                      guint64       key,
+                      guint64       detail,
+                      guint32       size1,
+                      HyScanBuffer *buffer1,
+                      HyScanBuffer *buffer2)
+{
+  HyScanCacheShm *shm = HYSCAN_CACHE_SHM (cache);
+  HyScanCacheShmPrivate *priv = shm->priv;
+
+  guint64 data_size;
+  guint i;
+
+  if (priv->header == NULL)
+    return FALSE;
+
+  /* Проверка буферов. */
+  if (buffer1 == NULL && buffer2 != NULL)
+    return FALSE;
+
+  data_size = priv->header->data_size;
+
+  for (i = 0; i < SHM_READ_ATTEMPTS; i++)
+    {
+      ShmRecord record;
+      ShmSlot *slot;
+      guint8 *data;
+      guint64 offset;
+      guint64 pos;
+      guint32 part1;
+      guint32 part2;
+
+      /* Ищем объект в индексе. */
+      slot = hyscan_cache_shm_find_slot (priv, key);
+      if (slot == NULL)
+        return FALSE;
+
+      pos = shm_load (&slot->pos);
+      if (pos == 0)
+        return FALSE;
+
+      /* Заголовок записи может изменяться одновременно с чтением, поэтому
+         проверяем его согласованность с индексом. */
+      offset = pos % data_size;
+      memcpy (&record, priv->data + offset, SHM_RECORD_SIZE);
+      data = priv->data + offset + SHM_RECORD_SIZE;
+
+      if (record.pos != pos || record.key != key || record.flags != 0 ||
+          record.size > data_size - offset - SHM_RECORD_SIZE)
+        {
+          continue;
+        }
+
+      /* Не совпадает дополнительная информация. */
+      if (detail != 0 && record.detail != detail)
+        {
+          __atomic_thread_fence (__ATOMIC_ACQUIRE);
+          if (shm_load (&priv->header->tail) > pos)
+            continue;
+
+          return FALSE;
+        }
+
+      /* Копируем данные объекта. */
+      part1 = MIN (size1, record.size);
+      part2 = record.size - part1;
+
+      if (buffer1 != NULL)
+        {
+          if (!hyscan_buffer_set_data_size (buffer1, part1))
+            return FALSE;
+
+          memcpy (hyscan_buffer_get (buffer1, NULL, &part1), data, part1);
+        }
+
+      if (buffer2 != NULL)
+        {
+          if (!hyscan_buffer_set_data_size (buffer2, part2))
+            return FALSE;
+
+          memcpy (hyscan_buffer_get (buffer2, NULL, &part2), data + part1, part2);
+        }
+
+      /* Данные действительны, если запись не была удалена из журнала
+         во время копирования. */
+      __atomic_thread_fence (__ATOMIC_ACQUIRE);
+      if (shm_load (&priv->header->tail) <= pos)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Функция считывает часть данных объекта из кэша. */
+static gboolean
+hyscan_cache_shm_get_range (HyScanCache  *cache,
+                            guint64       key,
+                            guint64       detail,
+                            guint32       offset,
+                            guint32       size,
+                            HyScanBuffer *buffer)
+{
+  HyScanCacheShm *shm = HYSCAN_CACHE_SHM (cache);
+  HyScanCacheShmPrivate *priv = shm->priv;
+
+  guint64 data_size;
+  guint i;
+
+  if (priv->header == NULL)
+    return FALSE;
+
+  data_size = priv->header->data_size;
+
+  for (i = 0; i < SHM_READ_ATTEMPTS; i++)
+    {
+      ShmRecord record;
+      ShmSlot *slot;
+      guint8 *data;
+      guint64 pos;
+      guint32 part;
+
+      /* Ищем объект в индексе. */
+      slot = hyscan_cache_shm_find_slot (priv, key);
+      if (slot == NULL)
+        return FALSE;
+
+      pos = shm_load (&slot->pos);
+      if (pos == 0)
+        return FALSE;
+
+      /* Проверяем согласованность заголовка записи с индексом. */
+      memcpy (&record, priv->data + pos % data_size, SHM_RECORD_SIZE);
+      data = priv->data + pos % data_size + SHM_RECORD_SIZE;
+
+      if (record.pos != pos || record.key != key || record.flags != 0 ||
+          record.size > data_size - pos % data_size - SHM_RECORD_SIZE)
+        {
+          continue;
+        }
+
+      /* Не совпадает дополнительная информация или смещение за пределами объекта. */
+      if ((detail != 0 && record.detail != detail) || offset > record.size)
+        {
+          __atomic_thread_fence (__ATOMIC_ACQUIRE);
+          if (shm_load (&priv->header->tail) > pos)
+            continue;
+
+          return FALSE;
+        }
+
+      /* Копируем запрошенную часть данных. */
+      part = MIN (size, record.size - offset);
+      if (!hyscan_buffer_set_data_size (buffer, part))
+        return FALSE;
+
+      memcpy (hyscan_buffer_get (buffer, NULL, &part), data + offset, part);
+
+      /* Данные действительны, если запись не была удалена из журнала
+         во время копирования. */
+      __atomic_thread_fence (__ATOMIC_ACQUIRE);
+      if (shm_load (&priv->header->tail) <= pos)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Функция возвращает информацию об объекте по заголовку его записи. */
+static gboolean
+hyscan_cache_shm_query (HyScanCache *cache,
+                        guint64      key,
+                        guint64     *detail,
+                        guint32     *size)
+{
+  HyScanCacheShm *shm = HYSCAN_CACHE_SHM (cache);
+  HyScanCacheShmPrivate *priv = shm->priv;
+
+  guint64 data_size;
+  guint i;
+
+  if (priv->header == NULL)
+    return FALSE;
+
+  data_size = priv->header->data_size;
+
+  for (i = 0; i < SHM_READ_ATTEMPTS; i++)
+    {
+      ShmRecord record;
+      ShmSlot *slot;
+      guint64 pos;
+
+      slot = hyscan_cache_shm_find_slot (priv, key);
+      if (slot == NULL)
+        return FALSE;
+
+      pos = shm_load (&slot->pos);
+      if (pos == 0)
+        return FALSE;
+
+      memcpy (&record, priv->data + pos % data_size, SHM_RECORD_SIZE);
+      if (record.pos != pos || record.key != key || record.flags != 0)
+        continue;
+
+      /* Заголовок действителен, если запись не была удалена из журнала
+         во время чтения. */
+      __atomic_thread_fence (__ATOMIC_ACQUIRE);
+      if (shm_load (&priv->header->tail) <= pos)
+        {
+          *detail = record.detail;
+          *size = record.size;
+
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+static void
+hyscan_cache_shm_interface_init (HyScanCacheInterface *iface)
+{
+  iface->set = hyscan_cache_shm_set;
+  iface->get = hyscan_cache_shm_get;
+  iface->get_range = hyscan_cache_shm_get_range;
+  iface->query = hyscan_cache_shm_query;
+}
@@ -0,0 +1,78 @@
+/* hyscan-cache-shm.h
+ *
+ * Copyright 2015-2019 Screen LLC, Andrei Fadeev <andrei@webcontrol.ru>
+ *
+ * This file is part of HyScanCache.
+ *
+ * HyScanCache is dual-licensed: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HyScanCache is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Alternatively, you can license this code under a commercial license.
+ * Contact the Screen LLC in this case - <info@screen-co.ru>.
+ */
+
+/* HyScanCache имеет двойную лицензию.
+ *
+ * Во-первых, вы можете распространять HyScanCache на условиях Стандартной
+ * Общественной Лицензии GNU версии 3, либо по любой более поздней версии
+ * лицензии (по вашему выбору). Полные положения лицензии GNU приведены в
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Во-вторых, этот программный код можно использовать по коммерческой
+ * лицензии. Для этого свяжитесь с ООО Экран - <info@screen-co.ru>.
+ */
+
+
+#ifndef __HYSCAN_CACHE_SHM_H__
+#define __HYSCAN_CACHE_SHM_H__
+
+#include <hyscan-cache.h>
+
+G_BEGIN_DECLS
+
+#define HYSCAN_TYPE_CACHE_SHM             (hyscan_cache_shm_get_type ())
+#define HYSCAN_CACHE_SHM(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), HYSCAN_TYPE_CACHE_SHM, HyScanCacheShm))
+#define HYSCAN_IS_CACHE_SHM(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), HYSCAN_TYPE_CACHE_SHM))
+#define HYSCAN_CACHE_SHM_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), HYSCAN_TYPE_CACHE_SHM, HyScanCacheShmClass))
+#define HYSCAN_IS_CACHE_SHM_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), HYSCAN_TYPE_CACHE_SHM))
+#define HYSCAN_CACHE_SHM_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), HYSCAN_TYPE_CACHE_SHM, HyScanCacheShmClass))
+
+typedef struct _HyScanCacheShm HyScanCacheShm;
+typedef struct _HyScanCacheShmPrivate HyScanCacheShmPrivate;
+typedef struct _HyScanCacheShmClass HyScanCacheShmClass;
+
+struct _HyScanCacheShm
+{
+  GObject parent_instance;
+
+  HyScanCacheShmPrivate *priv;
+};
+
+struct _HyScanCacheShmClass
+{
+  GObjectClass parent_class;
+};
+
+HYSCAN_API
+GType                  hyscan_cache_shm_get_type       (void);
+
+HYSCAN_API
+HyScanCacheShm        *hyscan_cache_shm_new            (const gchar           *name,
+                                                        guint32                cache_size);
+
+HYSCAN_API
+gboolean               hyscan_cache_shm_unlink         (const gchar           *name);
+
+G_END_DECLS
+
+#endif /* __HYSCAN_CACHE_SHM_H__ */
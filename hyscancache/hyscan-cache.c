@@ -72,11 +72,54 @@
  * функциям #hyscan_cache_set2 и #hyscan_cache_get2, но отличающиеся способом
  * задания ключа и вспомогательной информации. В этих функциях ключ и
  * вспомогательная информация задаются как 64-х битное целое беззнаковое число.
+ *
+ * Если данные объекта состоят из большего числа частей, используются функции
+ * #hyscan_cache_setv и #hyscan_cache_getv. Они принимают массив буферов и
+ * размеры частей при чтении, что исключает промежуточное копирование данных.
+ *
+ * Для постепенно растущих данных предназначены функции #hyscan_cache_append и
+ * #hyscan_cache_appendi, добавляющие данные в конец существующего объекта без
+ * повторной передачи всего объекта.
+ *
+ * Если требуется только часть данных объекта, можно использовать функции
+ * #hyscan_cache_get_range и #hyscan_cache_get_rangei. Они копируют только
+ * запрошенный диапазон данных.
+ *
+ * Проверить наличие объекта в кэше, не считывая его данные, можно функциями
+ * #hyscan_cache_query, #hyscan_cache_contains, #hyscan_cache_get_size и
+ * #hyscan_cache_get_detail.
+ * Для проверки сразу нескольких объектов предназначена функция
+ * #hyscan_cache_contains_batch. Эти функции не изменяют порядок удаления
+ * объектов из кэша. Если реализация кэша не поддерживает получение
+ * информации об объекте, эти функции считывают объект целиком, что
+ * перемещает его в начало очереди на удаление.
+ *
+ * В кэшах с очень большим числом объектов вероятность совпадения 64-х битных
+ * хэшей разных ключей становится заметной, а при совпадении хэшей будут
+ * считаны данные другого объекта. Функции #hyscan_cache_set128 и
+ * #hyscan_cache_get128 идентифицируют объект по 128-ми битному хэшу ключа
+ * (FarmHash Fingerprint128). Реализация кэша может дополнительно сохранять
+ * сам ключ и сравнивать его при чтении (см. #hyscan_cached_set_key_verification).
+ * Если реализация не поддерживает 128-ми битные ключи, используется младшая
+ * половина хэша. Объекты, записанные функциями #hyscan_cache_set128 и
+ * #hyscan_cache_set128i, необходимо считывать соответствующими функциями
+ * #hyscan_cache_get128 и #hyscan_cache_get128i.
+ *
+ * Для записи и чтения сразу нескольких объектов предназначены функции
+ * #hyscan_cache_set_batch и #hyscan_cache_get_batch. Удалённый кэш выполняет
+ * такие операции за один обмен с сервером, в остальных реализациях они
+ * эквивалентны последовательным вызовам #hyscan_cache_set и #hyscan_cache_get.
+ *
+ * Статистику работы кэша: число попаданий и промахов, объём используемой
+ * памяти, время выполнения операций и т.п., можно узнать функцией
+ * #hyscan_cache_get_stats.
  */
 
 #include "hyscan-cache.h"
 #include "hyscan-hash.h"
 
+#include <string.h>
+
 G_DEFINE_INTERFACE (HyScanCache, hyscan_cache, G_TYPE_OBJECT);
 
 static void
@@ -271,3 +314,1021 @@ hyscan_cache_get2i (HyScanCache  *cache,
 
   return FALSE;
 }
+
+/**
+ * hyscan_cache_setv:
+ * @cache: указатель на #HyScanCache
+ * @key: ключ объекта
+ * @detail: (nullable): вспомогательная информация
+ * @buffers: (array length=n_buffers) (nullable): буферы с частями сохраняемых данных
+ * @n_buffers: число буферов
+ *
+ * Функция помещает в одну запись кэша данные из нескольких буферов. Части
+ * данных располагаются в записи в порядке следования буферов. Буферы, равные
+ * NULL, пропускаются. Если данных нет, объект удаляется из кэша.
+ *
+ * Returns: %TRUE если сохранены в кэше, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_setv (HyScanCache   *cache,
+                   const gchar   *key,
+                   const gchar   *detail,
+                   HyScanBuffer **buffers,
+                   guint          n_buffers)
+{
+  return hyscan_cache_setvi (cache, hyscan_hash64 (key), hyscan_hash64 (detail), buffers, n_buffers);
+}
+
+/**
+ * hyscan_cache_setvi:
+ * @cache: указатель на #HyScanCache
+ * @key: ключ объекта
+ * @detail: вспомогательная информация
+ * @buffers: (array length=n_buffers) (nullable): буферы с частями сохраняемых данных
+ * @n_buffers: число буферов
+ *
+ * Функция помещает в одну запись кэша данные из нескольких буферов. Функция
+ * работает аналогично функции #hyscan_cache_setv.
+ *
+ * Returns: %TRUE если сохранены в кэше, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_setvi (HyScanCache   *cache,
+                    guint64        key,
+                    guint64        detail,
+                    HyScanBuffer **buffers,
+                    guint          n_buffers)
+{
+  HyScanCacheInterface *iface = HYSCAN_CACHE_GET_IFACE (cache);
+  HyScanBuffer *head;
+  guint8 *data;
+  guint32 size;
+  gboolean status;
+  guint i;
+
+  if (buffers == NULL)
+    n_buffers = 0;
+
+  if (iface->setv != NULL)
+    return iface->setv (cache, key, detail, buffers, n_buffers);
+
+  if (iface->set == NULL)
+    return FALSE;
+
+  if (n_buffers <= 2)
+    {
+      return iface->set (cache, key, detail,
+                         (n_buffers > 0) ? buffers[0] : NULL,
+                         (n_buffers > 1) ? buffers[1] : NULL);
+    }
+
+  /* Объединяем все части, кроме последней, в один буфер. */
+  for (size = 0, i = 0; i + 1 < n_buffers; i++)
+    {
+      guint32 part = 0;
+
+      if (buffers[i] != NULL && hyscan_buffer_get (buffers[i], NULL, &part) != NULL)
+        size += part;
+    }
+
+  head = hyscan_buffer_new ();
+  if (!hyscan_buffer_set_data_size (head, size))
+    {
+      g_object_unref (head);
+      return FALSE;
+    }
+
+  data = hyscan_buffer_get (head, NULL, &size);
+  for (i = 0; i + 1 < n_buffers; i++)
+    {
+      gpointer part_data;
+      guint32 part = 0;
+
+      if (buffers[i] == NULL)
+        continue;
+
+      part_data = hyscan_buffer_get (buffers[i], NULL, &part);
+      if (part_data == NULL || part == 0)
+        continue;
+
+      memcpy (data, part_data, part);
+      data += part;
+    }
+
+  status = iface->set (cache, key, detail, head, buffers[n_buffers - 1]);
+
+  g_object_unref (head);
+
+  return status;
+}
+
+/**
+ * hyscan_cache_getv:
+ * @cache: указатель на #HyScanCache
+ * @key: ключ объекта
+ * @detail: (nullable): вспомогательная информация
+ * @sizes: (array length=n_buffers): максимальные размеры частей данных
+ * @buffers: (array length=n_buffers): буферы для частей данных
+ * @n_buffers: число буферов
+ *
+ * Функция считывает данные из кэша в несколько буферов. В буфер с номером i
+ * записывается не более sizes[i] байт данных, в последний буфер записываются
+ * все оставшиеся данные, его размер в массиве sizes не учитывается. Если
+ * данных в объекте меньше, чем суммарный размер частей, последние буферы
+ * будут содержать меньше данных или будут пустыми. Буферы, равные NULL,
+ * пропускаются вместе с соответствующими им частями данных.
+ *
+ * Returns: %TRUE если данные считаны из кэша, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_getv (HyScanCache    *cache,
+                   const gchar    *key,
+                   const gchar    *detail,
+                   const guint32  *sizes,
+                   HyScanBuffer  **buffers,
+                   guint           n_buffers)
+{
+  return hyscan_cache_getvi (cache, hyscan_hash64 (key), hyscan_hash64 (detail), sizes, buffers, n_buffers);
+}
+
+/**
+ * hyscan_cache_getvi:
+ * @cache: указатель на #HyScanCache
+ * @key: ключ объекта
+ * @detail: вспомогательная информация
+ * @sizes: (array length=n_buffers): максимальные размеры частей данных
+ * @buffers: (array length=n_buffers): буферы для частей данных
+ * @n_buffers: число буферов
+ *
+ * Функция считывает данные из кэша в несколько буферов. Функция работает
+ * аналогично функции #hyscan_cache_getv.
+ *
+ * Returns: %TRUE если данные считаны из кэша, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_getvi (HyScanCache    *cache,
+                    guint64         key,
+                    guint64         detail,
+                    const guint32  *sizes,
+                    HyScanBuffer  **buffers,
+                    guint           n_buffers)
+{
+  HyScanCacheInterface *iface = HYSCAN_CACHE_GET_IFACE (cache);
+  HyScanBuffer *object;
+  guint8 *data;
+  guint32 size;
+  guint32 offset;
+  gboolean status = FALSE;
+  guint i;
+
+  if (buffers == NULL || (n_buffers > 1 && sizes == NULL))
+    return FALSE;
+
+  if (iface->getv != NULL)
+    return iface->getv (cache, key, detail, sizes, buffers, n_buffers);
+
+  if (iface->get == NULL)
+    return FALSE;
+
+  if (n_buffers == 1)
+    return iface->get (cache, key, detail, G_MAXUINT32, buffers[0], NULL);
+
+  if (n_buffers == 2 && buffers[0] != NULL)
+    return iface->get (cache, key, detail, sizes[0], buffers[0], buffers[1]);
+
+  /* Считываем объект целиком и распределяем данные по буферам. */
+  object = hyscan_buffer_new ();
+
+  if (!iface->get (cache, key, detail, G_MAXUINT32, object, NULL))
+    goto exit;
+
+  data = hyscan_buffer_get (object, NULL, &size);
+  for (offset = 0, i = 0; i < n_buffers; i++)
+    {
+      guint32 part = size - offset;
+
+      if (i + 1 < n_buffers)
+        part = MIN (part, sizes[i]);
+
+      if (buffers[i] != NULL)
+        hyscan_buffer_set (buffers[i], HYSCAN_DATA_BLOB, data + offset, part);
+
+      offset += part;
+    }
+
+  status = TRUE;
+
+exit:
+  g_object_unref (object);
+
+  return status;
+}
+
+/**
+ * hyscan_cache_append:
+ * @cache: указатель на #HyScanCache
+ * @key: ключ объекта
+ * @detail: (nullable): вспомогательная информация
+ * @buffer: указатель на добавляемые данные
+ *
+ * Функция добавляет данные в конец объекта. Если объекта в кэше нет, он
+ * создаётся из добавляемых данных. Если вспомогательная информация указана
+ * и отличается от информации объекта в кэше, данные объекта считаются
+ * устаревшими и объект создаётся заново из добавляемых данных.
+ *
+ * Если реализация кэша не поддерживает добавление данных, объект считывается
+ * и записывается заново. В этом случае одновременное добавление данных в один
+ * объект из нескольких потоков не допускается.
+ *
+ * Returns: %TRUE если данные добавлены, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_append (HyScanCache  *cache,
+                     const gchar  *key,
+                     const gchar  *detail,
+                     HyScanBuffer *buffer)
+{
+  return hyscan_cache_appendi (cache, hyscan_hash64 (key), hyscan_hash64 (detail), buffer);
+}
+
+/**
+ * hyscan_cache_appendi:
+ * @cache: указатель на #HyScanCache
+ * @key: ключ объекта
+ * @detail: вспомогательная информация
+ * @buffer: указатель на добавляемые данные
+ *
+ * Функция добавляет данные в конец объекта. Функция работает аналогично
+ * функции #hyscan_cache_append.
+ *
+ * Returns: %TRUE если данные добавлены, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_appendi (HyScanCache  *cache,
+                      guint64       key,
+                      guint64       detail,
+                      HyScanBuffer *buffer)
+{
+  HyScanCacheInterface *iface = HYSCAN_CACHE_GET_IFACE (cache);
+  HyScanBuffer *current;
+  gboolean status;
+
+  if (buffer == NULL)
+    return FALSE;
+
+  if (iface->append != NULL)
+    return iface->append (cache, key, detail, buffer);
+
+  if (iface->get == NULL || iface->set == NULL)
+    return FALSE;
+
+  /* Считываем объект и записываем его вместе с новыми данными. */
+  current = hyscan_buffer_new ();
+
+  if (iface->get (cache, key, detail, G_MAXUINT32, current, NULL))
+    status = iface->set (cache, key, detail, current, buffer);
+  else
+    status = iface->set (cache, key, detail, buffer, NULL);
+
+  g_object_unref (current);
+
+  return status;
+}
+
+/**
+ * hyscan_cache_get_range:
+ * @cache: указатель на #HyScanCache
+ * @key: ключ объекта
+ * @detail: (nullable): вспомогательная информация
+ * @offset: смещение до начала считываемых данных
+ * @size: размер считываемых данных
+ * @buffer: указатель на буфер для данных
+ *
+ * Функция считывает часть данных объекта, начиная со смещения offset. Если
+ * объект короче offset + size, считываются данные до конца объекта. Если
+ * смещение больше размера объекта, функция возвращает %FALSE.
+ *
+ * Returns: %TRUE если данные считаны, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_get_range (HyScanCache  *cache,
+                        const gchar  *key,
+                        const gchar  *detail,
+                        guint32       offset,
+                        guint32       size,
+                        HyScanBuffer *buffer)
+{
+  return hyscan_cache_get_rangei (cache, hyscan_hash64 (key), hyscan_hash64 (detail), offset, size, buffer);
+}
+
+/**
+ * hyscan_cache_get_rangei:
+ * @cache: указатель на #HyScanCache
+ * @key: ключ объекта
+ * @detail: вспомогательная информация
+ * @offset: смещение до начала считываемых данных
+ * @size: размер считываемых данных
+ * @buffer: указатель на буфер для данных
+ *
+ * Функция считывает часть данных объекта. Функция работает аналогично
+ * функции #hyscan_cache_get_range.
+ *
+ * Returns: %TRUE если данные считаны, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_get_rangei (HyScanCache  *cache,
+                         guint64       key,
+                         guint64       detail,
+                         guint32       offset,
+                         guint32       size,
+                         HyScanBuffer *buffer)
+{
+  HyScanCacheInterface *iface = HYSCAN_CACHE_GET_IFACE (cache);
+  HyScanBuffer *object;
+  guint8 *data;
+  guint32 object_size;
+  gboolean status = FALSE;
+
+  if (buffer == NULL)
+    return FALSE;
+
+  if (iface->get_range != NULL)
+    return iface->get_range (cache, key, detail, offset, size, buffer);
+
+  if (iface->get == NULL)
+    return FALSE;
+
+  /* Считываем объект целиком и копируем запрошенную часть. */
+  object = hyscan_buffer_new ();
+
+  if (!iface->get (cache, key, detail, G_MAXUINT32, object, NULL))
+    goto exit;
+
+  data = hyscan_buffer_get (object, NULL, &object_size);
+  if (offset > object_size)
+    goto exit;
+
+  size = MIN (size, object_size - offset);
+  hyscan_buffer_set (buffer, HYSCAN_DATA_BLOB, data + offset, size);
+  status = TRUE;
+
+exit:
+  g_object_unref (object);
+
+  return status;
+}
+
+/* Функция определяет размер объекта, считывая его данные. Используется,
+   если реализация кэша не поддерживает получение информации об объекте. */
+static gboolean
+hyscan_cache_read_size (HyScanCache *cache,
+                        guint64      key,
+                        guint64      detail,
+                        guint32     *size)
+{
+  HyScanCacheInterface *iface = HYSCAN_CACHE_GET_IFACE (cache);
+  HyScanBuffer *object;
+  gboolean status;
+
+  if (iface->get == NULL)
+    return FALSE;
+
+  object = hyscan_buffer_new ();
+
+  status = iface->get (cache, key, detail, G_MAXUINT32, object, NULL);
+  if (status && hyscan_buffer_get (object, NULL, size) == NULL)
+    *size = 0;
+
+  g_object_unref (object);
+
+  return status;
+}
+
+/**
+ * hyscan_cache_query:
+ * @cache: указатель на #HyScanCache
+ * @key: ключ объекта
+ * @detail: (out): хэш вспомогательной информации объекта
+ * @size: (out): размер данных объекта
+ *
+ * Функция возвращает хэш вспомогательной информации и размер данных объекта,
+ * не считывая его данные. Положение объекта в очереди на удаление не
+ * изменяется. Если реализация кэша не поддерживает получение информации об
+ * объекте, объект считывается целиком и перемещается в начало очереди на
+ * удаление, а в detail записывается ноль.
+ *
+ * Returns: %TRUE если объект есть в кэше, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_query (HyScanCache *cache,
+                    const gchar *key,
+                    guint64     *detail,
+                    guint32     *size)
+{
+  return hyscan_cache_queryi (cache, hyscan_hash64 (key), detail, size);
+}
+
+/**
+ * hyscan_cache_queryi:
+ * @cache: указатель на #HyScanCache
+ * @key: ключ объекта
+ * @detail: (out): хэш вспомогательной информации объекта
+ * @size: (out): размер данных объекта
+ *
+ * Функция возвращает информацию об объекте. Функция работает аналогично
+ * функции #hyscan_cache_query.
+ *
+ * Returns: %TRUE если объект есть в кэше, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_queryi (HyScanCache *cache,
+                     guint64      key,
+                     guint64     *detail,
+                     guint32     *size)
+{
+  HyScanCacheInterface *iface = HYSCAN_CACHE_GET_IFACE (cache);
+  gboolean status;
+
+  if (detail == NULL || size == NULL)
+    return FALSE;
+
+  if (iface->query != NULL)
+    return iface->query (cache, key, detail, size);
+
+  /* Вспомогательная информация в этом случае неизвестна. */
+  status = hyscan_cache_read_size (cache, key, 0, size);
+  if (status)
+    *detail = 0;
+
+  return status;
+}
+
+/**
+ * hyscan_cache_contains:
+ * @cache: указатель на #HyScanCache
+ * @key: ключ объекта
+ * @detail: (nullable): вспомогательная информация
+ *
+ * Функция проверяет наличие объекта в кэше. Если переменная detail = NULL,
+ * вспомогательная информация не проверяется. Данные объекта не считываются,
+ * а его положение в очереди на удаление не изменяется, если реализация кэша
+ * поддерживает получение информации об объекте (см. #hyscan_cache_query).
+ *
+ * Returns: %TRUE если объект есть в кэше, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_contains (HyScanCache *cache,
+                       const gchar *key,
+                       const gchar *detail)
+{
+  return hyscan_cache_containsi (cache, hyscan_hash64 (key), hyscan_hash64 (detail));
+}
+
+/**
+ * hyscan_cache_containsi:
+ * @cache: указатель на #HyScanCache
+ * @key: ключ объекта
+ * @detail: вспомогательная информация
+ *
+ * Функция проверяет наличие объекта в кэше. Функция работает аналогично
+ * функции #hyscan_cache_contains.
+ *
+ * Returns: %TRUE если объект есть в кэше, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_containsi (HyScanCache *cache,
+                        guint64      key,
+                        guint64      detail)
+{
+  return hyscan_cache_get_sizei (cache, key, detail, NULL);
+}
+
+/**
+ * hyscan_cache_get_size:
+ * @cache: указатель на #HyScanCache
+ * @key: ключ объекта
+ * @detail: (nullable): вспомогательная информация
+ * @size: (out) (optional): размер данных объекта
+ *
+ * Функция возвращает размер данных объекта, не считывая его данные.
+ *
+ * Returns: %TRUE если объект есть в кэше, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_get_size (HyScanCache *cache,
+                       const gchar *key,
+                       const gchar *detail,
+                       guint32     *size)
+{
+  return hyscan_cache_get_sizei (cache, hyscan_hash64 (key), hyscan_hash64 (detail), size);
+}
+
+/**
+ * hyscan_cache_get_sizei:
+ * @cache: указатель на #HyScanCache
+ * @key: ключ объекта
+ * @detail: вспомогательная информация
+ * @size: (out) (optional): размер данных объекта
+ *
+ * Функция возвращает размер данных объекта. Функция работает аналогично
+ * функции #hyscan_cache_get_size.
+ *
+ * Returns: %TRUE если объект есть в кэше, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_get_sizei (HyScanCache *cache,
+                        guint64      key,
+                        guint64      detail,
+                        guint32     *size)
+{
+  HyScanCacheInterface *iface = HYSCAN_CACHE_GET_IFACE (cache);
+  guint64 object_detail;
+  guint32 object_size;
+
+  /* Вспомогательную информацию проверяет функция чтения. */
+  if (iface->query == NULL)
+    return hyscan_cache_read_size (cache, key, detail, (size != NULL) ? size : &object_size);
+
+  if (!hyscan_cache_queryi (cache, key, &object_detail, &object_size))
+    return FALSE;
+
+  /* Вспомогательная информация проверяется так же, как при чтении. */
+  if (detail != 0 && object_detail != detail)
+    return FALSE;
+
+  if (size != NULL)
+    *size = object_size;
+
+  return TRUE;
+}
+
+/**
+ * hyscan_cache_get_detail:
+ * @cache: указатель на #HyScanCache
+ * @key: ключ объекта
+ * @detail: (out): хэш вспомогательной информации объекта
+ *
+ * Функция возвращает хэш вспомогательной информации объекта, не считывая
+ * его данные. Если реализация кэша не хранит вспомогательную информацию
+ * отдельно от данных, возвращается ноль.
+ *
+ * Returns: %TRUE если объект есть в кэше, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_get_detail (HyScanCache *cache,
+                         const gchar *key,
+                         guint64     *detail)
+{
+  return hyscan_cache_get_detaili (cache, hyscan_hash64 (key), detail);
+}
+
+/**
+ * hyscan_cache_get_detaili:
+ * @cache: указатель на #HyScanCache
+ * @key: ключ объекта
+ * @detail: (out): хэш вспомогательной информации объекта
+ *
+ * Функция возвращает хэш вспомогательной информации объекта. Функция
+ * работает аналогично функции #hyscan_cache_get_detail.
+ *
+ * Returns: %TRUE если объект есть в кэше, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_get_detaili (HyScanCache *cache,
+                          guint64      key,
+                          guint64     *detail)
+{
+  guint32 size;
+
+  if (detail == NULL)
+    return FALSE;
+
+  return hyscan_cache_queryi (cache, key, detail, &size);
+}
+
+/**
+ * hyscan_cache_contains_batch:
+ * @cache: указатель на #HyScanCache
+ * @keys: (array length=n_keys): ключи объектов
+ * @n_keys: число ключей
+ * @found: (array length=n_keys) (out caller-allocates) (optional): признаки наличия объектов
+ *
+ * Функция проверяет наличие в кэше нескольких объектов. Для каждого ключа
+ * в массив found записывается признак наличия объекта. Вспомогательная
+ * информация не проверяется.
+ *
+ * Returns: Число объектов, найденных в кэше.
+ */
+guint
+hyscan_cache_contains_batch (HyScanCache  *cache,
+                             const gchar **keys,
+                             guint         n_keys,
+                             gboolean     *found)
+{
+  guint64 *hashes;
+  guint n_found;
+  guint i;
+
+  if (keys == NULL || n_keys == 0)
+    return 0;
+
+  hashes = g_new (guint64, n_keys);
+  for (i = 0; i < n_keys; i++)
+    hashes[i] = hyscan_hash64 (keys[i]);
+
+  n_found = hyscan_cache_contains_batchi (cache, hashes, n_keys, found);
+
+  g_free (hashes);
+
+  return n_found;
+}
+
+/**
+ * hyscan_cache_contains_batchi:
+ * @cache: указатель на #HyScanCache
+ * @keys: (array length=n_keys): ключи объектов
+ * @n_keys: число ключей
+ * @found: (array length=n_keys) (out caller-allocates) (optional): признаки наличия объектов
+ *
+ * Функция проверяет наличие в кэше нескольких объектов. Функция работает
+ * аналогично функции #hyscan_cache_contains_batch.
+ *
+ * Returns: Число объектов, найденных в кэше.
+ */
+guint
+hyscan_cache_contains_batchi (HyScanCache   *cache,
+                              const guint64 *keys,
+                              guint          n_keys,
+                              gboolean      *found)
+{
+  HyScanCacheInterface *iface = HYSCAN_CACHE_GET_IFACE (cache);
+  guint n_found = 0;
+  guint i;
+
+  if (keys == NULL || n_keys == 0)
+    return 0;
+
+  if (iface->contains_batch != NULL)
+    return iface->contains_batch (cache, keys, n_keys, found);
+
+  for (i = 0; i < n_keys; i++)
+    {
+      gboolean present = hyscan_cache_containsi (cache, keys[i], 0);
+
+      if (found != NULL)
+        found[i] = present;
+      if (present)
+        n_found += 1;
+    }
+
+  return n_found;
+}
+
+/**
+ * hyscan_cache_set128:
+ * @cache: указатель на #HyScanCache
+ * @key: ключ объекта
+ * @detail: (nullable): вспомогательная информация
+ * @buffer1: (nullable): указатель на первую часть сохраняемых данных
+ * @buffer2: (nullable): указатель на вторую часть сохраняемых данных
+ *
+ * Функция помещает данные в кэш, идентифицируя объект 128-ми битным хэшем
+ * ключа. Строка ключа передаётся реализации кэша для сохранения, если
+ * включена проверка ключей. В остальном функция работает аналогично
+ * функции #hyscan_cache_set2.
+ *
+ * Returns: %TRUE если сохранены в кэше, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_set128 (HyScanCache  *cache,
+                     const gchar  *key,
+                     const gchar  *detail,
+                     HyScanBuffer *buffer1,
+                     HyScanBuffer *buffer2)
+{
+  guint64 key_lo, key_hi;
+
+  hyscan_hash128 (key, &key_lo, &key_hi);
+
+  return hyscan_cache_set128i (cache, key_lo, key_hi, key, hyscan_hash64 (detail), buffer1, buffer2);
+}
+
+/**
+ * hyscan_cache_set128i:
+ * @cache: указатель на #HyScanCache
+ * @key_lo: младшая половина 128-ми битного ключа объекта
+ * @key_hi: старшая половина 128-ми битного ключа объекта
+ * @key: (nullable): строка ключа объекта
+ * @detail: вспомогательная информация
+ * @buffer1: (nullable): указатель на первую часть сохраняемых данных
+ * @buffer2: (nullable): указатель на вторую часть сохраняемых данных
+ *
+ * Функция помещает данные в кэш, идентифицируя объект 128-ми битным ключом.
+ * Функция работает аналогично функции #hyscan_cache_set128, но хэш ключа
+ * вычисляется вызывающей стороной. Строку ключа необходимо передать, если
+ * она должна проверяться при чтении.
+ *
+ * Returns: %TRUE если сохранены в кэше, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_set128i (HyScanCache  *cache,
+                      guint64       key_lo,
+                      guint64       key_hi,
+                      const gchar  *key,
+                      guint64       detail,
+                      HyScanBuffer *buffer1,
+                      HyScanBuffer *buffer2)
+{
+  HyScanCacheInterface *iface = HYSCAN_CACHE_GET_IFACE (cache);
+
+  if (iface->set128 != NULL)
+    return iface->set128 (cache, key_lo, key_hi, key, detail, buffer1, buffer2);
+
+  return hyscan_cache_set2i (cache, key_lo, detail, buffer1, buffer2);
+}
+
+/**
+ * hyscan_cache_get128:
+ * @cache: указатель на #HyScanCache
+ * @key: ключ объекта
+ * @detail: (nullable): вспомогательная информация
+ * @size1: размер данных в первом буфере
+ * @buffer1: указатель на первый буфер для записи данных
+ * @buffer2: (nullable): указатель на второй буфер для записи данных
+ *
+ * Функция считывает данные объекта, записанного функцией #hyscan_cache_set128.
+ * Объект считается отсутствующим, если не совпадает старшая половина хэша
+ * ключа или, при включённой проверке ключей, сохранённая строка ключа.
+ * В остальном функция работает аналогично функции #hyscan_cache_get2.
+ *
+ * Returns: %TRUE если данные считаны из кэша, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_get128 (HyScanCache  *cache,
+                     const gchar  *key,
+                     const gchar  *detail,
+                     guint32       size1,
+                     HyScanBuffer *buffer1,
+                     HyScanBuffer *buffer2)
+{
+  guint64 key_lo, key_hi;
+
+  hyscan_hash128 (key, &key_lo, &key_hi);
+
+  return hyscan_cache_get128i (cache, key_lo, key_hi, key, hyscan_hash64 (detail), size1, buffer1, buffer2);
+}
+
+/**
+ * hyscan_cache_get128i:
+ * @cache: указатель на #HyScanCache
+ * @key_lo: младшая половина 128-ми битного ключа объекта
+ * @key_hi: старшая половина 128-ми битного ключа объекта
+ * @key: (nullable): строка ключа объекта
+ * @detail: вспомогательная информация
+ * @size1: размер данных в первом буфере
+ * @buffer1: указатель на первый буфер для записи данных
+ * @buffer2: (nullable): указатель на второй буфер для записи данных
+ *
+ * Функция считывает данные объекта, записанного по 128-ми битному ключу.
+ * Функция работает аналогично функции #hyscan_cache_get128, но хэш ключа
+ * вычисляется вызывающей стороной. Если key = NULL, строка ключа не
+ * проверяется.
+ *
+ * Returns: %TRUE если данные считаны из кэша, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_get128i (HyScanCache  *cache,
+                      guint64       key_lo,
+                      guint64       key_hi,
+                      const gchar  *key,
+                      guint64       detail,
+                      guint32       size1,
+                      HyScanBuffer *buffer1,
+                      HyScanBuffer *buffer2)
+{
+  HyScanCacheInterface *iface = HYSCAN_CACHE_GET_IFACE (cache);
+
+  if (iface->get128 != NULL)
+    return iface->get128 (cache, key_lo, key_hi, key, detail, size1, buffer1, buffer2);
+
+  return hyscan_cache_get2i (cache, key_lo, detail, size1, buffer1, buffer2);
+}
+
+/* Функция вычисляет хэши массива строк. Если массив не задан, возвращается NULL. */
+static guint64 *
+hyscan_cache_hash_array (const gchar **strings,
+                         guint         n_strings)
+{
+  guint64 *hashes;
+  guint i;
+
+  if (strings == NULL)
+    return NULL;
+
+  hashes = g_new (guint64, n_strings);
+  for (i = 0; i < n_strings; i++)
+    hashes[i] = hyscan_hash64 (strings[i]);
+
+  return hashes;
+}
+
+/**
+ * hyscan_cache_set_batch:
+ * @cache: указатель на #HyScanCache
+ * @keys: (array length=n_keys): ключи объектов
+ * @details: (array length=n_keys) (nullable): вспомогательная информация объектов
+ * @buffers: (array length=n_keys): данные объектов, элементы могут быть равны NULL
+ * @n_keys: число объектов
+ * @stored: (array length=n_keys) (out caller-allocates) (optional): признаки записи объектов
+ *
+ * Функция помещает в кэш несколько объектов. Для каждого объекта в массив
+ * stored записывается признак его сохранения в кэше. Если массив details
+ * не задан, объекты записываются без вспомогательной информации. Объекты,
+ * для которых буфер не задан, удаляются из кэша.
+ *
+ * Returns: Число объектов, сохранённых в кэше.
+ */
+guint
+hyscan_cache_set_batch (HyScanCache   *cache,
+                        const gchar  **keys,
+                        const gchar  **details,
+                        HyScanBuffer **buffers,
+                        guint          n_keys,
+                        gboolean      *stored)
+{
+  guint64 *key_hashes;
+  guint64 *detail_hashes;
+  guint n_stored;
+
+  if (keys == NULL || buffers == NULL || n_keys == 0)
+    return 0;
+
+  key_hashes = hyscan_cache_hash_array (keys, n_keys);
+  detail_hashes = hyscan_cache_hash_array (details, n_keys);
+
+  n_stored = hyscan_cache_set_batchi (cache, key_hashes, detail_hashes, buffers, n_keys, stored);
+
+  g_free (key_hashes);
+  g_free (detail_hashes);
+
+  return n_stored;
+}
+
+/**
+ * hyscan_cache_set_batchi:
+ * @cache: указатель на #HyScanCache
+ * @keys: (array length=n_keys): ключи объектов
+ * @details: (array length=n_keys) (nullable): вспомогательная информация объектов
+ * @buffers: (array length=n_keys): данные объектов, элементы могут быть равны NULL
+ * @n_keys: число объектов
+ * @stored: (array length=n_keys) (out caller-allocates) (optional): признаки записи объектов
+ *
+ * Функция помещает в кэш несколько объектов. Функция работает аналогично
+ * функции #hyscan_cache_set_batch.
+ *
+ * Returns: Число объектов, сохранённых в кэше.
+ */
+guint
+hyscan_cache_set_batchi (HyScanCache    *cache,
+                         const guint64  *keys,
+                         const guint64  *details,
+                         HyScanBuffer  **buffers,
+                         guint           n_keys,
+                         gboolean       *stored)
+{
+  HyScanCacheInterface *iface = HYSCAN_CACHE_GET_IFACE (cache);
+  guint n_stored = 0;
+  guint i;
+
+  if (keys == NULL || buffers == NULL || n_keys == 0)
+    return 0;
+
+  if (iface->set_batch != NULL)
+    return iface->set_batch (cache, keys, details, buffers, n_keys, stored);
+
+  for (i = 0; i < n_keys; i++)
+    {
+      guint64 detail = (details != NULL) ? details[i] : 0;
+      gboolean status = hyscan_cache_set2i (cache, keys[i], detail, buffers[i], NULL);
+
+      if (stored != NULL)
+        stored[i] = status;
+      if (status)
+        n_stored += 1;
+    }
+
+  return n_stored;
+}
+
+/**
+ * hyscan_cache_get_batch:
+ * @cache: указатель на #HyScanCache
+ * @keys: (array length=n_keys): ключи объектов
+ * @details: (array length=n_keys) (nullable): вспомогательная информация объектов
+ * @buffers: (array length=n_keys): буферы для записи данных объектов
+ * @n_keys: число объектов
+ * @found: (array length=n_keys) (out caller-allocates) (optional): признаки чтения объектов
+ *
+ * Функция считывает из кэша несколько объектов. Данные каждого объекта
+ * целиком записываются в соответствующий буфер. Для каждого объекта в массив
+ * found записывается признак его чтения. Содержимое буферов отсутствующих
+ * объектов не определено.
+ *
+ * Returns: Число объектов, считанных из кэша.
+ */
+guint
+hyscan_cache_get_batch (HyScanCache   *cache,
+                        const gchar  **keys,
+                        const gchar  **details,
+                        HyScanBuffer **buffers,
+                        guint          n_keys,
+                        gboolean      *found)
+{
+  guint64 *key_hashes;
+  guint64 *detail_hashes;
+  guint n_found;
+
+  if (keys == NULL || buffers == NULL || n_keys == 0)
+    return 0;
+
+  key_hashes = hyscan_cache_hash_array (keys, n_keys);
+  detail_hashes = hyscan_cache_hash_array (details, n_keys);
+
+  n_found = hyscan_cache_get_batchi (cache, key_hashes, detail_hashes, buffers, n_keys, found);
+
+  g_free (key_hashes);
+  g_free (detail_hashes);
+
+  return n_found;
+}
+
+/**
+ * hyscan_cache_get_batchi:
+ * @cache: указатель на #HyScanCache
+ * @keys: (array length=n_keys): ключи объектов
+ * @details: (array length=n_keys) (nullable): вспомогательная информация объектов
+ * @buffers: (array length=n_keys): буферы для записи данных объектов
+ * @n_keys: число объектов
+ * @found: (array length=n_keys) (out caller-allocates) (optional): признаки чтения объектов
+ *
+ * Функция считывает из кэша несколько объектов. Функция работает аналогично
+ * функции #hyscan_cache_get_batch.
+ *
+ * Returns: Число объектов, считанных из кэша.
+ */
+guint
+hyscan_cache_get_batchi (HyScanCache    *cache,
+                         const guint64  *keys,
+                         const guint64  *details,
+                         HyScanBuffer  **buffers,
+                         guint           n_keys,
+                         gboolean       *found)
+{
+  HyScanCacheInterface *iface = HYSCAN_CACHE_GET_IFACE (cache);
+  guint n_found = 0;
+  guint i;
+
+  if (keys == NULL || buffers == NULL || n_keys == 0)
+    return 0;
+
+  if (iface->get_batch != NULL)
+    return iface->get_batch (cache, keys, details, buffers, n_keys, found);
+
+  for (i = 0; i < n_keys; i++)
+    {
+      guint64 detail = (details != NULL) ? details[i] : 0;
+      gboolean status = FALSE;
+
+      if (buffers[i] != NULL)
+        status = hyscan_cache_get2i (cache, keys[i], detail, G_MAXUINT32, buffers[i], NULL);
+
+      if (found != NULL)
+        found[i] = status;
+      if (status)
+        n_found += 1;
+    }
+
+  return n_found;
+}
+
+/**
+ * hyscan_cache_get_stats:
+ * @cache: указатель на #HyScanCache
+ * @stats: (out): статистика работы кэша
+ *
+ * Функция возвращает статистику работы кэша. Счётчики накапливаются
+ * с момента создания объекта.
+ *
+ * Returns: %TRUE если статистика получена, иначе %FALSE.
+ */
+gboolean
+hyscan_cache_get_stats (HyScanCache      *cache,
+                        HyScanCacheStats *stats)
+{
+  memset (stats, 0, sizeof (HyScanCacheStats));
+
+  if (HYSCAN_CACHE_GET_IFACE (cache)->get_stats != NULL)
+    return HYSCAN_CACHE_GET_IFACE (cache)->get_stats (cache, stats);
+
+  return FALSE;
+}
@@ -45,14 +45,75 @@ G_BEGIN_DECLS
 #define HYSCAN_IS_CACHE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE (( obj ), HYSCAN_TYPE_CACHE))
 #define HYSCAN_CACHE_GET_IFACE(obj)  (G_TYPE_INSTANCE_GET_INTERFACE (( obj ), HYSCAN_TYPE_CACHE, HyScanCacheInterface))
 
+#define HYSCAN_CACHE_STATS_N_BINS    32
+
 typedef struct _HyScanCache HyScanCache;
 typedef struct _HyScanCacheInterface HyScanCacheInterface;
 
+/**
+ * HyScanCacheOperation:
+ * @HYSCAN_CACHE_OP_SET: запись данных
+ * @HYSCAN_CACHE_OP_GET: чтение данных
+ * @HYSCAN_CACHE_OP_APPEND: добавление данных
+ * @HYSCAN_CACHE_N_OPS: число операций
+ *
+ * Операции с кэшем, для которых ведётся учёт времени выполнения.
+ */
+typedef enum
+{
+  HYSCAN_CACHE_OP_SET,
+  HYSCAN_CACHE_OP_GET,
+  HYSCAN_CACHE_OP_APPEND,
+  HYSCAN_CACHE_N_OPS
+} HyScanCacheOperation;
+
+/**
+ * HyScanCacheStats:
+ * @hits: число успешных чтений данных
+ * @misses: число чтений отсутствующих в кэше объектов
+ * @detail_mismatches: число чтений объектов с другой вспомогательной информацией
+ * @sets: число операций записи данных, удаление объектов не учитывается
+ * @evictions: число объектов, вытесненных из кэша
+ * @rejected: число объектов, не сохранённых в кэше
+ * @used_size: объём памяти, занятый объектами, байт
+ * @max_size: максимальный объём памяти, байт
+ * @n_objects: число объектов в кэше
+ * @latency: гистограммы времени выполнения операций
+ *
+ * Статистика работы кэша. Элемент latency[op][i] содержит число операций op,
+ * выполненных за время от 2^i до 2^(i+1) наносекунд. В последний элемент
+ * гистограммы попадают все операции, выполнявшиеся дольше.
+ */
+typedef struct
+{
+  guint64      hits;
+  guint64      misses;
+  guint64      detail_mismatches;
+  guint64      sets;
+  guint64      evictions;
+  guint64      rejected;
+  guint64      used_size;
+  guint64      max_size;
+  guint64      n_objects;
+  guint64      latency[HYSCAN_CACHE_N_OPS][HYSCAN_CACHE_STATS_N_BINS];
+} HyScanCacheStats;
+
 /**
  * HyScanParamInterface:
  * @g_iface: Базовый интерфейс.
  * @set: Помещает данные в кэш.
  * @get: Считывает данные из кэша.
+ * @get_stats: Возвращает статистику работы кэша.
+ * @append: Добавляет данные в конец объекта.
+ * @get_range: Считывает часть данных объекта.
+ * @setv: Помещает в кэш данные из нескольких буферов.
+ * @getv: Считывает данные из кэша в несколько буферов.
+ * @query: Возвращает информацию об объекте без чтения его данных.
+ * @contains_batch: Проверяет наличие в кэше нескольких объектов.
+ * @set128: Помещает данные в кэш по 128-битному ключу.
+ * @get128: Считывает данные из кэша по 128-битному ключу.
+ * @set_batch: Помещает в кэш несколько объектов.
+ * @get_batch: Считывает из кэша несколько объектов.
  */
 struct _HyScanCacheInterface
 {
@@ -70,6 +131,75 @@ struct _HyScanCacheInterface
                                         guint32                size1,
                                         HyScanBuffer          *buffer1,
                                         HyScanBuffer          *buffer2);
+
+  gboolean     (*get_stats)            (HyScanCache           *cache,
+                                        HyScanCacheStats      *stats);
+
+  gboolean     (*append)               (HyScanCache           *cache,
+                                        guint64                key,
+                                        guint64                detail,
+                                        HyScanBuffer          *buffer);
+
+  gboolean     (*get_range)            (HyScanCache           *cache,
+                                        guint64                key,
+                                        guint64                detail,
+                                        guint32                offset,
+                                        guint32                size,
+                                        HyScanBuffer          *buffer);
+
+  gboolean     (*setv)                 (HyScanCache           *cache,
+                                        guint64                key,
+                                        guint64                detail,
+                                        HyScanBuffer         **buffers,
+                                        guint                  n_buffers);
+
+  gboolean     (*getv)                 (HyScanCache           *cache,
+                                        guint64                key,
+                                        guint64                detail,
+                                        const guint32         *sizes,
+                                        HyScanBuffer         **buffers,
+                                        guint                  n_buffers);
+
+  gboolean     (*query)                (HyScanCache           *cache,
+                                        guint64                key,
+                                        guint64               *detail,
+                                        guint32               *size);
+
+  guint        (*contains_batch)       (HyScanCache           *cache,
+                                        const guint64         *keys,
+                                        guint                  n_keys,
+                                        gboolean              *found);
+
+  gboolean     (*set128)               (HyScanCache           *cache,
+                                        guint64                key_lo,
+                                        guint64                key_hi,
+                                        const gchar           *key,
+                                        guint64                detail,
+                                        HyScanBuffer          *buffer1,
+                                        HyScanBuffer          *buffer2);
+
+  gboolean     (*get128)               (HyScanCache           *cache,
+                                        guint64                key_lo,
+                                        guint64                key_hi,
+                                        const gchar           *key,
+                                        guint64                detail,
+                                        guint32                size1,
+                                        HyScanBuffer          *buffer1,
+                                        HyScanBuffer          *buffer2);
+
+  guint        (*set_batch)            (HyScanCache           *cache,
+                                        const guint64         *keys,
+                                        const guint64         *details,
+                                        HyScanBuffer         **buffers,
+                                        guint                  n_keys,
+                                        gboolean              *stored);
+
+  guint        (*get_batch)            (HyScanCache           *cache,
+                                        const guint64         *keys,
+                                        const guint64         *details,
+                                        HyScanBuffer         **buffers,
+                                        guint                  n_keys,
+                                        gboolean              *found);
 };
 
 HYSCAN_API
@@ -117,6 +247,190 @@ gboolean       hyscan_cache_get2i      (HyScanCache           *cache,
                                         HyScanBuffer          *buffer1,
                                         HyScanBuffer          *buffer2);
 
+HYSCAN_API
+gboolean       hyscan_cache_setv       (HyScanCache           *cache,
+                                        const gchar           *key,
+                                        const gchar           *detail,
+                                        HyScanBuffer         **buffers,
+                                        guint                  n_buffers);
+
+HYSCAN_API
+gboolean       hyscan_cache_setvi      (HyScanCache           *cache,
+                                        guint64                key,
+                                        guint64                detail,
+                                        HyScanBuffer         **buffers,
+                                        guint                  n_buffers);
+
+HYSCAN_API
+gboolean       hyscan_cache_getv       (HyScanCache           *cache,
+                                        const gchar           *key,
+                                        const gchar           *detail,
+                                        const guint32         *sizes,
+                                        HyScanBuffer         **buffers,
+                                        guint                  n_buffers);
+
+HYSCAN_API
+gboolean       hyscan_cache_getvi      (HyScanCache           *cache,
+                                        guint64                key,
+                                        guint64                detail,
+                                        const guint32         *sizes,
+                                        HyScanBuffer         **buffers,
+                                        guint                  n_buffers);
+
+HYSCAN_API
+gboolean       hyscan_cache_append     (HyScanCache           *cache,
+                                        const gchar           *key,
+                                        const gchar           *detail,
+                                        HyScanBuffer          *buffer);
+
+HYSCAN_API
+gboolean       hyscan_cache_appendi    (HyScanCache           *cache,
+                                        guint64                key,
+                                        guint64                detail,
+                                        HyScanBuffer          *buffer);
+
+HYSCAN_API
+gboolean       hyscan_cache_get_range  (HyScanCache           *cache,
+                                        const gchar           *key,
+                                        const gchar           *detail,
+                                        guint32                offset,
+                                        guint32                size,
+                                        HyScanBuffer          *buffer);
+
+HYSCAN_API
+gboolean       hyscan_cache_get_rangei (HyScanCache           *cache,
+                                        guint64                key,
+                                        guint64                detail,
+                                        guint32                offset,
+                                        guint32                size,
+                                        HyScanBuffer          *buffer);
+
+HYSCAN_API
+gboolean       hyscan_cache_query      (HyScanCache           *cache,
+                                        const gchar           *key,
+                                        guint64               *detail,
+                                        guint32               *size);
+
+HYSCAN_API
+gboolean       hyscan_cache_queryi     (HyScanCache           *cache,
+                                        guint64                key,
+                                        guint64               *detail,
+                                        guint32               *size);
+
+HYSCAN_API
+gboolean       hyscan_cache_contains   (HyScanCache           *cache,
+                                        const gchar           *key,
+                                        const gchar           *detail);
+
+HYSCAN_API
+gboolean       hyscan_cache_containsi  (HyScanCache           *cache,
+                                        guint64                key,
+                                        guint64                detail);
+
+HYSCAN_API
+gboolean       hyscan_cache_get_size   (HyScanCache           *cache,
+                                        const gchar           *key,
+                                        const gchar           *detail,
+                                        guint32               *size);
+
+HYSCAN_API
+gboolean       hyscan_cache_get_sizei  (HyScanCache           *cache,
+                                        guint64                key,
+                                        guint64                detail,
+                                        guint32               *size);
+
+HYSCAN_API
+gboolean       hyscan_cache_get_detail (HyScanCache           *cache,
+                                        const gchar           *key,
+                                        guint64               *detail);
+
+HYSCAN_API
+gboolean       hyscan_cache_get_detaili (HyScanCache          *cache,
+                                        guint64                key,
+                                        guint64               *detail);
+
+HYSCAN_API
+guint          hyscan_cache_contains_batch (HyScanCache       *cache,
+                                        const gchar          **keys,
+                                        guint                  n_keys,
+                                        gboolean              *found);
+
+HYSCAN_API
+guint          hyscan_cache_contains_batchi (HyScanCache      *cache,
+                                        const guint64         *keys,
+                                        guint                  n_keys,
+                                        gboolean              *found);
+
+HYSCAN_API
+gboolean       hyscan_cache_set128     (HyScanCache           *cache,
+                                        const gchar           *key,
+                                        const gchar           *detail,
+                                        HyScanBuffer          *buffer1,
+                                        HyScanBuffer          *buffer2);
+
+HYSCAN_API
+gboolean       hyscan_cache_set128i    (HyScanCache           *cache,
+                                        guint64                key_lo,
+                                        guint64                key_hi,
+                                        const gchar           *key,
+                                        guint64                detail,
+                                        HyScanBuffer          *buffer1,
+                                        HyScanBuffer          *buffer2);
+
+HYSCAN_API
+gboolean       hyscan_cache_get128     (HyScanCache           *cache,
+                                        const gchar           *key,
+                                        const gchar           *detail,
+                                        guint32                size1,
+                                        HyScanBuffer          *buffer1,
+                                        HyScanBuffer          *buffer2);
+
+HYSCAN_API
+gboolean       hyscan_cache_get128i    (HyScanCache           *cache,
+                                        guint64                key_lo,
+                                        guint64                key_hi,
+                                        const gchar           *key,
+                                        guint64                detail,
+                                        guint32                size1,
+                                        HyScanBuffer          *buffer1,
+                                        HyScanBuffer          *buffer2);
+
+HYSCAN_API
+guint          hyscan_cache_set_batch  (HyScanCache           *cache,
+                                        const gchar          **keys,
+                                        const gchar          **details,
+                                        HyScanBuffer         **buffers,
+                                        guint                  n_keys,
+                                        gboolean              *stored);
+
+HYSCAN_API
+guint          hyscan_cache_set_batchi (HyScanCache           *cache,
+                                        const guint64         *keys,
+                                        const guint64         *details,
+                                        HyScanBuffer         **buffers,
+                                        guint                  n_keys,
+                                        gboolean              *stored);
+
+HYSCAN_API
+guint          hyscan_cache_get_batch  (HyScanCache           *cache,
+                                        const gchar          **keys,
+                                        const gchar          **details,
+                                        HyScanBuffer         **buffers,
+                                        guint                  n_keys,
+                                        gboolean              *found);
+
+HYSCAN_API
+guint          hyscan_cache_get_batchi (HyScanCache           *cache,
+                                        const guint64         *keys,
+                                        const guint64         *details,
+                                        HyScanBuffer         **buffers,
+                                        guint                  n_keys,
+                                        gboolean              *found);
+
+HYSCAN_API
+gboolean       hyscan_cache_get_stats  (HyScanCache           *cache,
+                                        HyScanCacheStats      *stats);
+
 G_END_DECLS
 
 #endif /* __HYSCAN_CACHE_H__ */
@@ -0,0 +1,422 @@
+/* hyscan-cached.h
+ *
+ * Copyright 2015-2019 Screen LLC, Andrei Fadeev <andrei@webcontrol.ru>
+ *
+ * This file is part of HyScanCache.
+ *
+ * HyScanCache is dual-licensed: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HyScanCache is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Alternatively, you can license this code under a commercial license.
+ * Contact the Screen LLC in this case - <info@screen-co.ru>.
+ */
+
+/* HyScanCache имеет двойную лицензию.
+ *
+ * Во-первых, вы можете распространять HyScanCache на условиях Стандартной
+ * Общественной Лицензии GNU версии 3, либо по любой более поздней версии
+ * лицензии (по вашему выбору). Полные положения лицензии GNU приведены в
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Во-вторых, этот программный код можно использовать по коммерческой
+ * лицензии. Для этого свяжитесь с ООО Экран - <info@screen-co.ru>.
+ */
+
+
+/*
+ * Арена памяти для хранения объектов HyScanCached.
+ *
+ * Арена - это непрерывная область памяти, выделенная одним вызовом mmap
+ * и размещённая на больших страницах: явных (hugetlbfs) или прозрачных (THP).
+ * Это уменьшает число промахов TLB при доступе к большому числу мелких
+ * объектов. При создании арены все её страницы заполняются несколькими
+ * потоками, чтобы первые запросы к кэшу не тратили время на обработку
+ * отказов страниц.
+ *
+ * Память выделяется блоками фиксированных размеров (классов). Блоки до 128
+ * байт имеют размер кратный 16 байтам, большие блоки - четыре размера на
+ * каждую степень двойки. Освобождённые блоки помещаются в список свободных
+ * блоков своего класса и используются повторно. Если свободных блоков нужного
+ * класса нет и арена заполнена, делится свободный блок большего класса: его
+ * начало выделяется, а остаток помещается в списки свободных блоков меньших
+ * классов. Размеры всех классов кратны 16 байтам, поэтому остаток делится
+ * на блоки без потерь. Если свободного блока подходящего размера нет, память
+ * не выделяется, и HyScanCached удаляет из кэша давно использованные объекты.
+ * Память за пределами арены не используется. Когда в арене не остаётся
+ * выделенных блоков, она целиком становится свободной, поэтому после удаления
+ * всех объектов память для нового объекта выделяется всегда.
+ *
+ * Память свободных блоков, занимающих не меньше двух страниц, можно вернуть
+ * системе функцией hyscan_cached_arena_trim. Первая страница блока при этом
+ * сохраняется, так как в ней находится указатель списка свободных блоков.
+ * При повторном использовании блока система выделит страницы заново. Блоки
+ * меньшего размера системе не возвращаются.
+ *
+ * Функции арены не потокобезопасны, HyScanCached вызывает их только
+ * при захваченной блокировке записи.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#endif
+
+#include "hyscan-cached-arena.h"
+
+#include <string.h>
+
+#define N_SMALL_CLASSES        8
+#define SMALL_CLASS_STEP       16
+#define N_CLASSES              (N_SMALL_CLASSES + 4 * 58)
+#define DEFAULT_PAGE_SIZE      (2 * 1024 * 1024)
+#define PREFAULT_MIN_TASK      (256 * 1024 * 1024)
+#define SMALL_PAGE_SIZE        4096
+
+/* Свободный блок памяти. */
+typedef struct _FreeBlock FreeBlock;
+struct _FreeBlock
+{
+  FreeBlock           *next;                   /* Следующий свободный блок. */
+  gboolean             released;               /* Признак возврата страниц блока системе. */
+};
+
+/* Задание на заполнение части страниц арены. */
+typedef struct _PrefaultTask PrefaultTask;
+struct _PrefaultTask
+{
+  gint8               *begin;                  /* Начало области памяти. */
+  gint8               *end;                    /* Конец области памяти. */
+};
+
+struct _HyScanCachedArena
+{
+  gint8               *base;                   /* Начало арены. */
+  guint64              size;                   /* Размер арены. */
+  guint64              used;                   /* Размер распределённой памяти. */
+  guint64              n_blocks;               /* Число выделенных блоков. */
+
+  FreeBlock           *free_blocks[N_CLASSES]; /* Списки свободных блоков. */
+};
+
+/* Функция возвращает номер класса блока памяти. */
+static guint
+hyscan_cached_arena_class (gsize size)
+{
+  guint power;
+  gsize quarter;
+
+  if (size <= N_SMALL_CLASSES * SMALL_CLASS_STEP)
+    return (MAX (size, 1) + SMALL_CLASS_STEP - 1) / SMALL_CLASS_STEP - 1;
+
+  /* 2^power < size <= 2^(power + 1). */
+  power = g_bit_storage (size - 1) - 1;
+  quarter = (gsize) 1 << (power - 2);
+
+  return N_SMALL_CLASSES + 4 * (power - 7) + (size - ((gsize) 1 << power) - 1) / quarter;
+}
+
+/* Функция возвращает размер блоков памяти класса. */
+static gsize
+hyscan_cached_arena_class_size (guint index)
+{
+  guint power;
+
+  if (index < N_SMALL_CLASSES)
+    return (index + 1) * SMALL_CLASS_STEP;
+
+  index -= N_SMALL_CLASSES;
+  power = 7 + index / 4;
+
+  return ((gsize) 1 << power) + ((index % 4) + 1) * ((gsize) 1 << (power - 2));
+}
+
+#ifdef __linux__
+/* Функция возвращает размер больших страниц, используемый системой по умолчанию. */
+static gsize
+hyscan_cached_arena_huge_page_size (void)
+{
+  gchar *meminfo;
+  gchar *line;
+  gsize page_size = DEFAULT_PAGE_SIZE;
+
+  if (!g_file_get_contents ("/proc/meminfo", &meminfo, NULL, NULL))
+    return page_size;
+
+  line = strstr (meminfo, "Hugepagesize:");
+  if (line != NULL)
+    {
+      guint64 kbytes = g_ascii_strtoull (line + strlen ("Hugepagesize:"), NULL, 10);
+
+      if (kbytes > 0)
+        page_size = kbytes * 1024;
+    }
+
+  g_free (meminfo);
+
+  return page_size;
+}
+
+/* Функция заполняет страницы части арены. */
+static gpointer
+hyscan_cached_arena_prefault (gpointer data)
+{
+  PrefaultTask *task = data;
+  volatile gint8 *page;
+
+  for (page = task->begin; page < (volatile gint8 *) task->end; page += SMALL_PAGE_SIZE)
+    *page = 0;
+
+  return NULL;
+}
+#endif
+
+/* Функция создаёт арену памяти указанного размера. Если hugetlb = TRUE,
+   арена размещается на явных больших страницах, иначе на прозрачных. */
+HyScanCachedArena *
+hyscan_cached_arena_new (guint64  size,
+                         gboolean hugetlb)
+{
+#ifdef __linux__
+  HyScanCachedArena *arena;
+  PrefaultTask *tasks;
+  GThread **threads;
+  gpointer base = MAP_FAILED;
+  gsize page_size;
+  guint n_threads;
+  guint i;
+
+  /* Размер арены кратен размеру больших страниц. */
+  page_size = hyscan_cached_arena_huge_page_size ();
+  size = ((size + page_size - 1) / page_size) * page_size;
+
+#ifdef MAP_HUGETLB
+  /* Большие страницы резервируются при отображении: если их в системе
+     недостаточно, mmap завершается ошибкой, а не сигналом SIGBUS при
+     заполнении страниц. */
+  if (hugetlb)
+    {
+      base = mmap (NULL, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (base == MAP_FAILED)
+        g_warning ("HyScanCached: can't allocate %" G_GUINT64_FORMAT " bytes in huge pages, "
+                   "using transparent huge pages", size);
+    }
+#endif
+
+  if (base == MAP_FAILED)
+    {
+      base = mmap (NULL, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if (base == MAP_FAILED)
+        {
+          g_warning ("HyScanCached: can't allocate %" G_GUINT64_FORMAT " bytes arena", size);
+          return NULL;
+        }
+
+#ifdef MADV_HUGEPAGE
+      if (madvise (base, size, MADV_HUGEPAGE) != 0)
+        g_warning ("HyScanCached: transparent huge pages are not available");
+#endif
+    }
+
+  arena = g_new0 (HyScanCachedArena, 1);
+  arena->base = base;
+  arena->size = size;
+
+  /* Заполняем страницы арены параллельно. */
+  n_threads = MIN (g_get_num_processors (), size / PREFAULT_MIN_TASK + 1);
+  tasks = g_new (PrefaultTask, n_threads);
+  threads = g_new0 (GThread *, n_threads);
+  for (i = 0; i < n_threads; i++)
+    {
+      tasks[i].begin = arena->base + ((size / page_size) * i / n_threads) * page_size;
+      tasks[i].end = arena->base + ((size / page_size) * (i + 1) / n_threads) * page_size;
+
+      if (i > 0)
+        threads[i] = g_thread_new ("cached-prefault", hyscan_cached_arena_prefault, &tasks[i]);
+    }
+
+  hyscan_cached_arena_prefault (&tasks[0]);
+  for (i = 1; i < n_threads; i++)
+    g_thread_join (threads[i]);
+
+  g_free (threads);
+  g_free (tasks);
+
+  return arena;
+#else
+  g_warning ("HyScanCached: huge pages arena is not supported on this system");
+
+  return NULL;
+#endif
+}
+
+/* Функция освобождает арену. */
+void
+hyscan_cached_arena_free (HyScanCachedArena *arena)
+{
+  if (arena == NULL)
+    return;
+
+#ifdef __linux__
+  munmap (arena->base, arena->size);
+#endif
+
+  g_free (arena);
+}
+
+/* Функция возвращает размер блока, который будет выделен для запрошенного размера. */
+gsize
+hyscan_cached_arena_round (gsize size)
+{
+  return hyscan_cached_arena_class_size (hyscan_cached_arena_class (size));
+}
+
+/* Функция помещает область памяти в списки свободных блоков. Область
+   делится на блоки наибольших классов, помещающихся в неё. */
+static void
+hyscan_cached_arena_push (HyScanCachedArena *arena,
+                          gint8             *mem,
+                          gsize              size,
+                          gboolean           released)
+{
+  while (size > 0)
+    {
+      guint index = hyscan_cached_arena_class (size);
+      FreeBlock *block = (FreeBlock *) mem;
+
+      /* Класс, размер блоков которого не больше размера области. */
+      if (hyscan_cached_arena_class_size (index) > size)
+        index -= 1;
+
+      block->next = arena->free_blocks[index];
+      block->released = released;
+      arena->free_blocks[index] = block;
+
+      mem += hyscan_cached_arena_class_size (index);
+      size -= hyscan_cached_arena_class_size (index);
+    }
+}
+
+/* Функция выделяет блок памяти. Размер блока можно узнать функцией
+   hyscan_cached_arena_round. Если в арене нет свободной памяти подходящего
+   размера, функция возвращает NULL. */
+gpointer
+hyscan_cached_arena_alloc (HyScanCachedArena *arena,
+                           gsize              size)
+{
+  guint index = hyscan_cached_arena_class (size);
+  FreeBlock *block = NULL;
+  guint i;
+
+  size = hyscan_cached_arena_class_size (index);
+
+  /* Выделенных блоков нет, вся арена свободна. */
+  if (arena->n_blocks == 0)
+    {
+      memset (arena->free_blocks, 0, sizeof (arena->free_blocks));
+      arena->used = 0;
+    }
+
+  /* Свободный блок этого класса. */
+  if (arena->free_blocks[index] != NULL)
+    {
+      block = arena->free_blocks[index];
+      arena->free_blocks[index] = block->next;
+    }
+
+  /* Новый блок из нераспределённой части арены. */
+  else if (arena->size - arena->used >= size)
+    {
+      block = (FreeBlock *) (arena->base + arena->used);
+      arena->used += size;
+    }
+
+  /* Часть свободного блока большего класса. */
+  else
+    {
+      for (i = index + 1; i < N_CLASSES && block == NULL; i++)
+        {
+          block = arena->free_blocks[i];
+          if (block == NULL)
+            continue;
+
+          arena->free_blocks[i] = block->next;
+          hyscan_cached_arena_push (arena, (gint8 *) block + size,
+                                    hyscan_cached_arena_class_size (i) - size,
+                                    block->released);
+        }
+    }
+
+  if (block != NULL)
+    arena->n_blocks += 1;
+
+  return block;
+}
+
+/* Функция освобождает блок памяти, size - запрошенный при выделении размер. */
+void
+hyscan_cached_arena_release (HyScanCachedArena *arena,
+                             gpointer           mem,
+                             gsize              size)
+{
+  guint index = hyscan_cached_arena_class (size);
+  FreeBlock *block = mem;
+
+  block->next = arena->free_blocks[index];
+  block->released = FALSE;
+  arena->free_blocks[index] = block;
+  arena->n_blocks -= 1;
+}
+
+/* Функция возвращает системе память свободных блоков размером не меньше
+   двух страниц. Функция возвращает объём памяти, освобождённой этим вызовом:
+   блоки, память которых уже возвращена системе, повторно не учитываются. */
+gsize
+hyscan_cached_arena_trim (HyScanCachedArena *arena)
+{
+  gsize released = 0;
+
+#if defined (__linux__) && defined (MADV_DONTNEED)
+  guint i;
+
+  for (i = 0; i < N_CLASSES; i++)
+    {
+      gsize size = hyscan_cached_arena_class_size (i);
+      FreeBlock *block;
+
+      if (size < 2 * SMALL_PAGE_SIZE)
+        continue;
+
+      for (block = arena->free_blocks[i]; block != NULL; block = block->next)
+        {
+          gsize begin = GPOINTER_TO_SIZE (block) + SMALL_PAGE_SIZE;
+          gsize end = GPOINTER_TO_SIZE (block) + size;
+
+          if (block->released)
+            continue;
+
+          begin = (begin + SMALL_PAGE_SIZE - 1) & ~((gsize) SMALL_PAGE_SIZE - 1);
+          end = end & ~((gsize) SMALL_PAGE_SIZE - 1);
+
+          if (end > begin && madvise (GSIZE_TO_POINTER (begin), end - begin, MADV_DONTNEED) == 0)
+            {
+              released += end - begin;
+              block->released = TRUE;
+            }
+        }
+    }
+#endif
+
+  return released;
+}
@@ -0,0 +1,63 @@
+/* hyscan-cached-arena.h
+ *
+ * Copyright 2015-2019 Screen LLC, Andrei Fadeev <andrei@webcontrol.ru>
+ *
+ * This file is part of HyScanCache.
+ *
+ * HyScanCache is dual-licensed: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HyScanCache is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Alternatively, you can license this code under a commercial license.
+ * Contact the Screen LLC in this case - <info@screen-co.ru>.
+ */
+
+/* HyScanCache имеет двойную лицензию.
+ *
+ * Во-первых, вы можете распространять HyScanCache на условиях Стандартной
+ * Общественной Лицензии GNU версии 3, либо по любой более поздней версии
+ * лицензии (по вашему выбору). Полные положения лицензии GNU приведены в
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Во-вторых, этот программный код можно использовать по коммерческой
+ * лицензии. Для этого свяжитесь с ООО Экран - <info@screen-co.ru>.
+ */
+
+
+#ifndef __HYSCAN_CACHED_ARENA_H__
+#define __HYSCAN_CACHED_ARENA_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _HyScanCachedArena HyScanCachedArena;
+
+HyScanCachedArena     *hyscan_cached_arena_new         (guint64                size,
+                                                        gboolean               hugetlb);
+
+void                   hyscan_cached_arena_free        (HyScanCachedArena     *arena);
+
+gsize                  hyscan_cached_arena_round       (gsize                  size);
+
+gpointer               hyscan_cached_arena_alloc       (HyScanCachedArena     *arena,
+                                                        gsize                  size);
+
+void                   hyscan_cached_arena_release     (HyScanCachedArena     *arena,
+                                                        gpointer               mem,
+                                                        gsize                  size);
+
+gsize                  hyscan_cached_arena_trim        (HyScanCachedArena     *arena);
+
+G_END_DECLS
+
+#endif /* __HYSCAN_CACHED_ARENA_H__ */
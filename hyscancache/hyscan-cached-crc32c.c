@@ -0,0 +1,346 @@
+/* hyscan-cached-crc32c.c
+ *
+ * Copyright 2015-2019 Screen LLC, Andrei Fadeev <andrei@webcontrol.ru>
+ *
+ * This file is part of HyScanCache.
+ *
+ * HyScanCache is dual-licensed: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HyScanCache is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Alternatively, you can license this code under a commercial license.
+ * Contact the Screen LLC in this case - <info@screen-co.ru>.
+ */
+
+/* HyScanCache имеет двойную лицензию.
+ *
+ * Во-первых, вы можете распространять HyScanCache на условиях Стандартной
+ * Общественной Лицензии GNU версии 3, либо по любой более поздней версии
+ * лицензии (по вашему выбору). Полные положения лицензии GNU приведены в
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Во-вторых, этот программный код можно использовать по коммерческой
+ * лицензии. Для этого свяжитесь с ООО Экран - <info@screen-co.ru>.
+ */
+
+
+
+/*
+ * Вычисление контрольной суммы CRC32C (полином Castagnoli).
+ *
+ * На процессорах x86-64 с поддержкой SSE4.2 и ARMv8 с расширением CRC
+ * используются аппаратные инструкции, наличие которых определяется при
+ * первом вызове. Длинные блоки данных обрабатываются тремя независимыми
+ * потоками, чтобы скрыть задержку инструкций, после чего суммы потоков
+ * объединяются с помощью таблиц сдвига. На остальных процессорах используется
+ * табличный алгоритм с обработкой 8 байт за шаг. Результат не зависит от
+ * способа вычисления.
+ *
+ * Контрольная сумма может вычисляться частями: значение, возвращённое для
+ * предыдущей части данных, передаётся при вычислении следующей. Для первой
+ * части передаётся 0.
+ */
+
+#include "hyscan-cached-crc32c.h"
+
+#include <string.h>
+
+#if defined (__x86_64__) && (defined (__GNUC__) || defined (__clang__))
+#define CRC32C_SSE42
+#include <nmmintrin.h>
+#elif defined (__aarch64__) && defined (__linux__) && (defined (__GNUC__) || defined (__clang__))
+#define CRC32C_ARMV8
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#endif
+
+#define CRC32C_POLY            0x82f63b78      /* Отражённый полином Castagnoli. */
+#define CRC32C_LONG            8192            /* Размер длинного блока одного потока. */
+#define CRC32C_SHORT           256             /* Размер короткого блока одного потока. */
+
+typedef guint32 (*HyScanCachedCrc32cFunc)      (guint32                crc,
+                                                const guint8          *src,
+                                                gsize                  size);
+
+static guint32                 crc32c_table[8][256];
+static guint32                 crc32c_long[4][256];
+static guint32                 crc32c_short[4][256];
+static HyScanCachedCrc32cFunc  crc32c_func;
+
+/* Функция умножает вектор на матрицу над GF(2). */
+static guint32
+hyscan_cached_crc32c_gf2_times (const guint32 *mat,
+                                guint32        vec)
+{
+  guint32 sum = 0;
+
+  while (vec)
+    {
+      if (vec & 1)
+        sum ^= *mat;
+      vec >>= 1;
+      mat++;
+    }
+
+  return sum;
+}
+
+/* Функция возводит матрицу над GF(2) в квадрат. */
+static void
+hyscan_cached_crc32c_gf2_square (guint32       *square,
+                                 const guint32 *mat)
+{
+  guint n;
+
+  for (n = 0; n < 32; n++)
+    square[n] = hyscan_cached_crc32c_gf2_times (mat, mat[n]);
+}
+
+/* Функция строит таблицы сдвига контрольной суммы на size нулевых байт.
+   Размер должен быть степенью двойки. */
+static void
+hyscan_cached_crc32c_zeros (guint32 zeros[4][256],
+                            gsize   size)
+{
+  guint32 even[32];
+  guint32 odd[32];
+  guint32 row = 1;
+  guint n;
+
+  /* Оператор сдвига на один нулевой бит. */
+  odd[0] = CRC32C_POLY;
+  for (n = 1; n < 32; n++)
+    {
+      odd[n] = row;
+      row <<= 1;
+    }
+
+  /* Операторы сдвига на 2 и 4 бита. */
+  hyscan_cached_crc32c_gf2_square (even, odd);
+  hyscan_cached_crc32c_gf2_square (odd, even);
+
+  /* Каждое возведение в квадрат удваивает сдвиг, начиная с одного байта. */
+  do
+    {
+      hyscan_cached_crc32c_gf2_square (even, odd);
+      size >>= 1;
+      if (size == 0)
+        break;
+
+      hyscan_cached_crc32c_gf2_square (odd, even);
+      size >>= 1;
+      if (size == 0)
+        {
+          memcpy (even, odd, sizeof (even));
+          break;
+        }
+    }
+  while (TRUE);
+
+  for (n = 0; n < 256; n++)
+    {
+      zeros[0][n] = hyscan_cached_crc32c_gf2_times (even, n);
+      zeros[1][n] = hyscan_cached_crc32c_gf2_times (even, n << 8);
+      zeros[2][n] = hyscan_cached_crc32c_gf2_times (even, n << 16);
+      zeros[3][n] = hyscan_cached_crc32c_gf2_times (even, n << 24);
+    }
+}
+
+/* Функция сдвигает контрольную сумму по таблицам zeros. */
+static inline guint32
+hyscan_cached_crc32c_shift (guint32 zeros[4][256],
+                            guint32 crc)
+{
+  return zeros[0][crc & 0xff] ^ zeros[1][(crc >> 8) & 0xff] ^
+         zeros[2][(crc >> 16) & 0xff] ^ zeros[3][crc >> 24];
+}
+
+/* Макрос вычисляет контрольную сумму блоков данных размером 3 * block тремя
+   потоками с помощью инструкции step, обрабатывающей 8 байт. */
+#define CRC32C_BLOCKS(step, block, zeros)                                      \
+  while (size >= 3 * (block))                                                  \
+    {                                                                          \
+      guint64 crc1 = 0, crc2 = 0;                                              \
+      const guint8 *end = src + (block);                                       \
+                                                                               \
+      do                                                                       \
+        {                                                                      \
+          guint64 v0, v1, v2;                                                  \
+                                                                               \
+          memcpy (&v0, src, 8);                                                \
+          memcpy (&v1, src + (block), 8);                                      \
+          memcpy (&v2, src + 2 * (block), 8);                                  \
+          crc0 = step (crc0, v0);                                              \
+          crc1 = step (crc1, v1);                                              \
+          crc2 = step (crc2, v2);                                              \
+          src += 8;                                                            \
+        }                                                                      \
+      while (src < end);                                                       \
+                                                                               \
+      crc0 = hyscan_cached_crc32c_shift (zeros, crc0) ^ crc1;                  \
+      crc0 = hyscan_cached_crc32c_shift (zeros, crc0) ^ crc2;                  \
+                                                                               \
+      src += 2 * (block);                                                      \
+      size -= 3 * (block);                                                     \
+    }
+
+/* Табличное вычисление контрольной суммы. */
+static guint32
+hyscan_cached_crc32c_table (guint32        crc,
+                            const guint8  *src,
+                            gsize          size)
+{
+  while (size >= 8)
+    {
+      guint32 lo, hi;
+
+      memcpy (&lo, src, 4);
+      memcpy (&hi, src + 4, 4);
+      lo = GUINT32_FROM_LE (lo) ^ crc;
+      hi = GUINT32_FROM_LE (hi);
+
+      crc = crc32c_table[7][lo & 0xff] ^ crc32c_table[6][(lo >> 8) & 0xff] ^
+            crc32c_table[5][(lo >> 16) & 0xff] ^ crc32c_table[4][lo >> 24] ^
+            crc32c_table[3][hi & 0xff] ^ crc32c_table[2][(hi >> 8) & 0xff] ^
+            crc32c_table[1][(hi >> 16) & 0xff] ^ crc32c_table[0][hi >> 24];
+
+      src += 8;
+      size -= 8;
+    }
+
+  while (size-- > 0)
+    crc = crc32c_table[0][(crc ^ *src++) & 0xff] ^ (crc >> 8);
+
+  return crc;
+}
+
+#ifdef CRC32C_SSE42
+/* Вычисление контрольной суммы инструкциями SSE4.2. */
+__attribute__ ((target ("sse4.2")))
+static guint32
+hyscan_cached_crc32c_sse42 (guint32        crc,
+                            const guint8  *src,
+                            gsize          size)
+{
+  guint64 crc0 = crc;
+
+  CRC32C_BLOCKS (_mm_crc32_u64, CRC32C_LONG, crc32c_long);
+  CRC32C_BLOCKS (_mm_crc32_u64, CRC32C_SHORT, crc32c_short);
+
+  while (size >= 8)
+    {
+      guint64 value;
+
+      memcpy (&value, src, 8);
+      crc0 = _mm_crc32_u64 (crc0, value);
+
+      src += 8;
+      size -= 8;
+    }
+
+  crc = (guint32) crc0;
+  while (size-- > 0)
+    crc = _mm_crc32_u8 (crc, *src++);
+
+  return crc;
+}
+#endif
+
+#ifdef CRC32C_ARMV8
+/* Вычисление контрольной суммы инструкциями ARMv8 CRC. */
+__attribute__ ((target ("+crc")))
+static guint32
+hyscan_cached_crc32c_armv8 (guint32        crc,
+                            const guint8  *src,
+                            gsize          size)
+{
+  guint64 crc0 = crc;
+
+  CRC32C_BLOCKS (__crc32cd, CRC32C_LONG, crc32c_long);
+  CRC32C_BLOCKS (__crc32cd, CRC32C_SHORT, crc32c_short);
+
+  crc = (guint32) crc0;
+  while (size >= 8)
+    {
+      guint64 value;
+
+      memcpy (&value, src, 8);
+      crc = __crc32cd (crc, value);
+
+      src += 8;
+      size -= 8;
+    }
+
+  while (size-- > 0)
+    crc = __crc32cb (crc, *src++);
+
+  return crc;
+}
+#endif
+
+/* Функция выбирает способ вычисления контрольной суммы. */
+static HyScanCachedCrc32cFunc
+hyscan_cached_crc32c_init (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      HyScanCachedCrc32cFunc func = hyscan_cached_crc32c_table;
+      guint i, j;
+
+      for (i = 0; i < 256; i++)
+        {
+          guint32 crc = i;
+
+          for (j = 0; j < 8; j++)
+            crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : (crc >> 1);
+
+          crc32c_table[0][i] = crc;
+        }
+
+      for (i = 0; i < 256; i++)
+        for (j = 1; j < 8; j++)
+          crc32c_table[j][i] = (crc32c_table[j - 1][i] >> 8) ^ crc32c_table[0][crc32c_table[j - 1][i] & 0xff];
+
+      hyscan_cached_crc32c_zeros (crc32c_long, CRC32C_LONG);
+      hyscan_cached_crc32c_zeros (crc32c_short, CRC32C_SHORT);
+
+#if defined (CRC32C_SSE42)
+      __builtin_cpu_init ();
+      if (__builtin_cpu_supports ("sse4.2"))
+        func = hyscan_cached_crc32c_sse42;
+#elif defined (CRC32C_ARMV8)
+      if (getauxval (AT_HWCAP) & HWCAP_CRC32)
+        func = hyscan_cached_crc32c_armv8;
+#endif
+
+      g_atomic_pointer_set (&crc32c_func, func);
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return g_atomic_pointer_get (&crc32c_func);
+}
+
+/* Функция вычисляет контрольную сумму данных. */
+guint32
+hyscan_cached_crc32c (guint32       crc,
+                      gconstpointer data,
+                      gsize         size)
+{
+  HyScanCachedCrc32cFunc func = hyscan_cached_crc32c_init ();
+
+  return ~func (~crc, data, size);
+}
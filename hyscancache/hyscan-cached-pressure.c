@@ -0,0 +1,286 @@
+/* hyscan-cached.h
+ *
+ * Copyright 2015-2019 Screen LLC, Andrei Fadeev <andrei@webcontrol.ru>
+ *
+ * This file is part of HyScanCache.
+ *
+ * HyScanCache is dual-licensed: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HyScanCache is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Alternatively, you can license this code under a commercial license.
+ * Contact the Screen LLC in this case - <info@screen-co.ru>.
+ */
+
+/* HyScanCache имеет двойную лицензию.
+ *
+ * Во-первых, вы можете распространять HyScanCache на условиях Стандартной
+ * Общественной Лицензии GNU версии 3, либо по любой более поздней версии
+ * лицензии (по вашему выбору). Полные положения лицензии GNU приведены в
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Во-вторых, этот программный код можно использовать по коммерческой
+ * лицензии. Для этого свяжитесь с ООО Экран - <info@screen-co.ru>.
+ */
+
+
+/*
+ * Определение нехватки оперативной памяти в системе.
+ *
+ * Нехватка памяти определяется по следующим признакам:
+ *
+ * - доля времени, в течение которой процессы ожидали освобождения памяти
+ *   за последние 10 секунд (Linux PSI, memory.pressure или /proc/pressure/memory),
+ *   превышает PSI_THRESHOLD процентов;
+ * - объём памяти, используемый контрольной группой (cgroup v2), приближается
+ *   к ограничению memory.high или memory.max;
+ * - с момента предыдущей проверки увеличились счётчики событий high или max
+ *   в файле memory.events контрольной группы.
+ *
+ * Информация о нехватке памяти доступна только в Linux.
+ */
+
+#include "hyscan-cached-pressure.h"
+
+#include <string.h>
+
+#define PSI_THRESHOLD          10.0            /* Порог времени ожидания памяти, %. */
+#define LIMIT_THRESHOLD        0.95            /* Порог приближения к ограничению памяти. */
+#define LIMIT_TARGET           0.90            /* Желаемая доля используемой памяти. */
+
+struct _HyScanCachedPressure
+{
+  gchar               *psi_path;               /* Путь к файлу PSI. */
+  gchar               *cgroup_path;            /* Путь к каталогу контрольной группы. */
+
+  guint64              high_events;            /* Число событий high при предыдущей проверке. */
+  guint64              max_events;             /* Число событий max при предыдущей проверке. */
+};
+
+#ifdef __linux__
+/* Функция определяет каталог контрольной группы (cgroup v2) процесса. */
+static gchar *
+hyscan_cached_pressure_find_cgroup (void)
+{
+  gchar *contents;
+  gchar **lines;
+  gchar *path = NULL;
+  guint i;
+
+  if (!g_file_get_contents ("/proc/self/cgroup", &contents, NULL, NULL))
+    return NULL;
+
+  lines = g_strsplit (contents, "\n", -1);
+  for (i = 0; lines[i] != NULL; i++)
+    {
+      gchar *memory_current;
+
+      if (!g_str_has_prefix (lines[i], "0::"))
+        continue;
+
+      path = g_build_filename ("/sys/fs/cgroup", lines[i] + 3, NULL);
+      memory_current = g_build_filename (path, "memory.current", NULL);
+      if (!g_file_test (memory_current, G_FILE_TEST_EXISTS))
+        g_clear_pointer (&path, g_free);
+
+      g_free (memory_current);
+      break;
+    }
+
+  g_strfreev (lines);
+  g_free (contents);
+
+  return path;
+}
+
+/* Функция считывает числовое значение из файла контрольной группы.
+   Значение "max" соответствует G_MAXUINT64. */
+static gboolean
+hyscan_cached_pressure_read_value (const gchar *cgroup_path,
+                                   const gchar *name,
+                                   guint64     *value)
+{
+  gchar *path;
+  gchar *contents;
+  gboolean status;
+
+  path = g_build_filename (cgroup_path, name, NULL);
+  status = g_file_get_contents (path, &contents, NULL, NULL);
+  g_free (path);
+
+  if (!status)
+    return FALSE;
+
+  if (g_str_has_prefix (contents, "max"))
+    *value = G_MAXUINT64;
+  else
+    *value = g_ascii_strtoull (contents, NULL, 10);
+
+  g_free (contents);
+
+  return TRUE;
+}
+
+/* Функция считывает значение счётчика name из файла memory.events. */
+static guint64
+hyscan_cached_pressure_read_event (const gchar *events,
+                                   const gchar *name)
+{
+  const gchar *line = events;
+  gsize length = strlen (name);
+
+  while (line != NULL && *line != '\0')
+    {
+      if (strncmp (line, name, length) == 0 && line[length] == ' ')
+        return g_ascii_strtoull (line + length + 1, NULL, 10);
+
+      line = strchr (line, '\n');
+      if (line != NULL)
+        line++;
+    }
+
+  return 0;
+}
+
+/* Функция считывает долю времени ожидания памяти за последние 10 секунд. */
+static gdouble
+hyscan_cached_pressure_read_psi (const gchar *psi_path)
+{
+  gchar *contents;
+  gchar *avg10;
+  gdouble value = 0.0;
+
+  if (psi_path == NULL || !g_file_get_contents (psi_path, &contents, NULL, NULL))
+    return 0.0;
+
+  /* Строка вида "some avg10=1.23 avg60=0.50 avg300=0.10 total=12345". */
+  if (g_str_has_prefix (contents, "some"))
+    {
+      avg10 = strstr (contents, "avg10=");
+      if (avg10 != NULL)
+        value = g_ascii_strtod (avg10 + strlen ("avg10="), NULL);
+    }
+
+  g_free (contents);
+
+  return value;
+}
+#endif
+
+/* Функция создаёт объект определения нехватки памяти. Если информация
+   о нехватке памяти недоступна, функция возвращает NULL. */
+HyScanCachedPressure *
+hyscan_cached_pressure_new (void)
+{
+#ifdef __linux__
+  HyScanCachedPressure *pressure;
+  gchar *psi_path;
+
+  pressure = g_new0 (HyScanCachedPressure, 1);
+  pressure->cgroup_path = hyscan_cached_pressure_find_cgroup ();
+
+  /* PSI контрольной группы или всей системы. */
+  if (pressure->cgroup_path != NULL)
+    {
+      psi_path = g_build_filename (pressure->cgroup_path, "memory.pressure", NULL);
+      if (g_file_test (psi_path, G_FILE_TEST_EXISTS))
+        pressure->psi_path = psi_path;
+      else
+        g_free (psi_path);
+    }
+
+  if (pressure->psi_path == NULL && g_file_test ("/proc/pressure/memory", G_FILE_TEST_EXISTS))
+    pressure->psi_path = g_strdup ("/proc/pressure/memory");
+
+  if (pressure->psi_path == NULL && pressure->cgroup_path == NULL)
+    {
+      hyscan_cached_pressure_free (pressure);
+      return NULL;
+    }
+
+  /* Начальные значения счётчиков событий. */
+  hyscan_cached_pressure_check (pressure, NULL);
+
+  return pressure;
+#else
+  return NULL;
+#endif
+}
+
+/* Функция удаляет объект определения нехватки памяти. */
+void
+hyscan_cached_pressure_free (HyScanCachedPressure *pressure)
+{
+  if (pressure == NULL)
+    return;
+
+  g_free (pressure->psi_path);
+  g_free (pressure->cgroup_path);
+  g_free (pressure);
+}
+
+/* Функция проверяет наличие нехватки памяти. Если известно, на сколько
+   используемая память превышает желаемую, этот объём возвращается в excess. */
+gboolean
+hyscan_cached_pressure_check (HyScanCachedPressure *pressure,
+                              guint64              *excess)
+{
+  gboolean status = FALSE;
+  guint64 over = 0;
+
+#ifdef __linux__
+  if (hyscan_cached_pressure_read_psi (pressure->psi_path) >= PSI_THRESHOLD)
+    status = TRUE;
+
+  if (pressure->cgroup_path != NULL)
+    {
+      guint64 current, high, max, limit;
+      gchar *events_path;
+      gchar *events;
+
+      /* Приближение к ограничениям памяти. */
+      if (hyscan_cached_pressure_read_value (pressure->cgroup_path, "memory.current", &current) &&
+          hyscan_cached_pressure_read_value (pressure->cgroup_path, "memory.high", &high) &&
+          hyscan_cached_pressure_read_value (pressure->cgroup_path, "memory.max", &max))
+        {
+          limit = MIN (high, max);
+          if (limit != G_MAXUINT64 && current >= limit * LIMIT_THRESHOLD)
+            {
+              status = TRUE;
+              over = current - (guint64) (limit * LIMIT_TARGET);
+            }
+        }
+
+      /* События превышения ограничений. */
+      events_path = g_build_filename (pressure->cgroup_path, "memory.events", NULL);
+      if (g_file_get_contents (events_path, &events, NULL, NULL))
+        {
+          guint64 high_events = hyscan_cached_pressure_read_event (events, "high");
+          guint64 max_events = hyscan_cached_pressure_read_event (events, "max");
+
+          if (high_events > pressure->high_events || max_events > pressure->max_events)
+            status = TRUE;
+
+          pressure->high_events = high_events;
+          pressure->max_events = max_events;
+
+          g_free (events);
+        }
+      g_free (events_path);
+    }
+#endif
+
+  if (excess != NULL)
+    *excess = over;
+
+  return status;
+}
@@ -0,0 +1,139 @@
+/* hyscan-cached-scan.c
+ *
+ * Copyright 2015-2019 Screen LLC, Andrei Fadeev <andrei@webcontrol.ru>
+ *
+ * This file is part of HyScanCache.
+ *
+ * HyScanCache is dual-licensed: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HyScanCache is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Alternatively, you can license this code under a commercial license.
+ * Contact the Screen LLC in this case - <info@screen-co.ru>.
+ */
+
+/* HyScanCache имеет двойную лицензию.
+ *
+ * Во-первых, вы можете распространять HyScanCache на условиях Стандартной
+ * Общественной Лицензии GNU версии 3, либо по любой более поздней версии
+ * лицензии (по вашему выбору). Полные положения лицензии GNU приведены в
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Во-вторых, этот программный код можно использовать по коммерческой
+ * лицензии. Для этого свяжитесь с ООО Экран - <info@screen-co.ru>.
+ */
+
+
+/*
+ * Обнаружение последовательного просмотра данных для HyScanCached.
+ *
+ * Для каждого потока хранится таблица числа промахов подряд при чтении,
+ * отдельное значение для каждого состояния обнаружения. Поэтому промахи
+ * в одном кэше не влияют на размещение объектов в другом. Состояние
+ * идентифицируется уникальным номером, а не адресом, чтобы новое
+ * состояние, размещённое по адресу удалённого, не получило его промахи.
+ *
+ * Попадание удаляет значение из таблицы потока, поэтому в ней хранятся
+ * только состояния, в которых последнее чтение было промахом.
+ */
+
+#include "hyscan-cached-scan.h"
+
+struct _HyScanCachedScan
+{
+  guint                id;                     /* Идентификатор в таблицах потоков. */
+  volatile gint        threshold;              /* Число промахов подряд, после которого чтение считается просмотром. */
+};
+
+/* Таблицы числа промахов подряд текущего потока. */
+static GPrivate hyscan_cached_scan_misses = G_PRIVATE_INIT ((GDestroyNotify) g_hash_table_unref);
+
+/* Последний выданный идентификатор. */
+static volatile gint hyscan_cached_scan_last_id = 0;
+
+/* Функция создаёт состояние обнаружения просмотра. Обнаружение выключено. */
+HyScanCachedScan *
+hyscan_cached_scan_new (void)
+{
+  HyScanCachedScan *scan = g_new0 (HyScanCachedScan, 1);
+
+  scan->id = (guint) g_atomic_int_add (&hyscan_cached_scan_last_id, 1) + 1;
+
+  return scan;
+}
+
+/* Функция освобождает состояние обнаружения просмотра. */
+void
+hyscan_cached_scan_free (HyScanCachedScan *scan)
+{
+  g_free (scan);
+}
+
+/* Функция задаёт число промахов подряд, threshold = 0 выключает обнаружение. */
+void
+hyscan_cached_scan_set_threshold (HyScanCachedScan *scan,
+                                  guint             threshold)
+{
+  g_atomic_int_set (&scan->threshold, MIN (threshold, G_MAXINT));
+}
+
+/* Функция учитывает результат чтения объекта текущим потоком. */
+void
+hyscan_cached_scan_update (HyScanCachedScan *scan,
+                           gboolean          hit)
+{
+  GHashTable *misses;
+  gpointer key;
+  guint count;
+
+  if (g_atomic_int_get (&scan->threshold) == 0)
+    return;
+
+  key = GUINT_TO_POINTER (scan->id);
+  misses = g_private_get (&hyscan_cached_scan_misses);
+  if (misses == NULL)
+    {
+      if (hit)
+        return;
+
+      misses = g_hash_table_new (g_direct_hash, g_direct_equal);
+      g_private_set (&hyscan_cached_scan_misses, misses);
+    }
+
+  if (hit)
+    {
+      g_hash_table_remove (misses, key);
+      return;
+    }
+
+  count = GPOINTER_TO_UINT (g_hash_table_lookup (misses, key));
+  if (count < G_MAXUINT)
+    g_hash_table_insert (misses, key, GUINT_TO_POINTER (count + 1));
+}
+
+/* Функция проверяет, выполняет ли текущий поток последовательный просмотр
+   данных: новые объекты записываются после подряд идущих промахов. */
+gboolean
+hyscan_cached_scan_detected (HyScanCachedScan *scan)
+{
+  guint threshold = g_atomic_int_get (&scan->threshold);
+  GHashTable *misses;
+
+  if (threshold == 0)
+    return FALSE;
+
+  misses = g_private_get (&hyscan_cached_scan_misses);
+  if (misses == NULL)
+    return FALSE;
+
+  return GPOINTER_TO_UINT (g_hash_table_lookup (misses, GUINT_TO_POINTER (scan->id))) >= threshold;
+}
@@ -0,0 +1,63 @@
+/* hyscan-cached-scan.h
+ *
+ * Copyright 2015-2019 Screen LLC, Andrei Fadeev <andrei@webcontrol.ru>
+ *
+ * This file is part of HyScanCache.
+ *
+ * HyScanCache is dual-licensed: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * HyScanCache is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Alternatively, you can license this code under a commercial license.
+ * Contact the Screen LLC in this case - <info@screen-co.ru>.
+ */
+
+/* HyScanCache имеет двойную лицензию.
+ *
+ * Во-первых, вы можете распространять HyScanCache на условиях Стандартной
+ * Общественной Лицензии GNU версии 3, либо по любой более поздней версии
+ * лицензии (по вашему выбору). Полные положения лицензии GNU приведены в
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Во-вторых, этот программный код можно использовать по коммерческой
+ * лицензии. Для этого свяжитесь с ООО Экран - <info@screen-co.ru>.
+ */
+
+
+#ifndef __HYSCAN_CACHED_SCAN_H__
+#define __HYSCAN_CACHED_SCAN_H__
+
+#include <hyscan-cached.h>
+
+G_BEGIN_DECLS
+
+typedef struct _HyScanCachedScan HyScanCachedScan;
+
+HyScanCachedScan      *hyscan_cached_scan_new                  (void);
+
+void                   hyscan_cached_scan_free                 (HyScanCachedScan      *scan);
+
+void                   hyscan_cached_scan_set_threshold        (HyScanCachedScan      *scan,
+                                                                guint                  threshold);
+
+void                   hyscan_cached_scan_update               (HyScanCachedScan      *scan,
+                                                                gboolean               hit);
+
+gboolean               hyscan_cached_scan_detected             (HyScanCachedScan      *scan);
+
+/* Реализована в hyscan-cached.c. */
+void                   hyscan_cached_set_scan                  (HyScanCached          *cached,
+                                                                HyScanCachedScan      *scan);
+
+G_END_DECLS
+
+#endif /* __HYSCAN_CACHED_SCAN_H__ */
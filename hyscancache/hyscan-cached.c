@@ -48,12 +48,85 @@
  * В случае исчерпания всего доступного объёма памяти или превышения лимита
  * объектов, HyScanCached удаляет объекты, доступ к которым осуществлялся
  * давно, и использует освободившуюся память для сохранения новых объектов.
+ *
+ * Содержимое кэша можно сохранить в файл функцией #hyscan_cached_save и
+ * загрузить обратно функцией #hyscan_cached_load, например, при перезапуске
+ * сервера кэширования. Объекты записываются последовательно, начиная с
+ * объекта, доступ к которому осуществлялся недавно, поэтому при загрузке
+ * сохраняется порядок вытеснения объектов. Если объём кэша меньше объёма
+ * сохранённых данных, загружаются только недавно использованные объекты.
+ *
+ * При большом числе мелких объектов значительная часть времени доступа к ним
+ * тратится на промахи TLB. Для таких случаев объект можно создать функцией
+ * #hyscan_cached_new_full, указав способ выделения памяти #HyScanCachedMemory.
+ * В этом случае объекты размещаются в заранее выделенной арене на больших
+ * страницах памяти. Все страницы арены заполняются при создании объекта,
+ * поэтому он сразу занимает в памяти весь указанный объём.
+ *
+ * Узнать об удалении объектов из кэша можно, установив функцию обработки
+ * #hyscan_cached_set_evict_func. Информация об удалённых объектах накапливается
+ * во время операции с кэшем и передаётся в функцию обработки одним вызовом
+ * после снятия блокировки, поэтому функция обработки может обращаться к кэшу.
+ * Вызовы из разных потоков могут выполняться одновременно и не упорядочены
+ * между собой.
+ *
+ * Если кэш работает совместно с другими программами, потребляющими много
+ * памяти, можно включить отслеживание нехватки памяти в системе функцией
+ * #hyscan_cached_set_pressure_monitor. При нехватке памяти HyScanCached
+ * постепенно уменьшает допустимый объём данных, удаляет давно использованные
+ * объекты и возвращает освободившуюся память системе. После того как нехватка
+ * памяти прекращается, допустимый объём данных постепенно восстанавливается.
+ * Отслеживание выполняется в отдельном потоке обслуживания кэша.
+ *
+ * По умолчанию давно использованные объекты удаляются во время записи нового
+ * объекта, если для него не хватает памяти. При этом запись большого объекта
+ * может потребовать удаления многих объектов и задержать все обращения к кэшу.
+ * Функцией #hyscan_cached_set_watermarks можно включить удаление объектов в
+ * потоке обслуживания: когда объём данных превышает верхнюю границу, объекты
+ * удаляются до нижней границы. Память удалённых объектов освобождается без
+ * блокировки доступа к кэшу.
+ *
+ * Объекты, записанные по 128-ми битному ключу, дополнительно хранят старшую
+ * половину хэша ключа (16 байт на объект вместе с выравниванием). Функцией
+ * #hyscan_cached_set_key_verification можно включить сохранение строки
+ * ключа рядом с данными объекта. В этом случае при чтении строка сравнивается
+ * с запрошенной, что полностью исключает выдачу данных другого объекта при
+ * совпадении хэшей ценой памяти под строку ключа и её сравнения при чтении.
+ *
+ * Для обнаружения повреждения данных в памяти можно включить вычисление
+ * контрольных сумм объектов функцией #hyscan_cached_set_checksums. Контрольная
+ * сумма CRC32C вычисляется при записи объекта и проверяется при его чтении
+ * целиком, повреждённые объекты удаляются из кэша. Функцией
+ * #hyscan_cached_set_scrub_rate можно включить проверку всех объектов в потоке
+ * обслуживания в то время, когда кэш используется мало.
+ *
+ * Кэш может обнаруживать последовательный просмотр большого объёма данных, при
+ * котором каждый объект читается один раз, например при экспорте галса.
+ * Если поток подряд получает заданное число промахов при чтении, новые
+ * объекты, записываемые этим потоком, помещаются в конец списка используемых
+ * и удаляются из кэша первыми, не вытесняя часто используемые данные. При
+ * повторном чтении такой объект перемещается в начало списка как обычно.
+ * Число промахов задаётся функцией #hyscan_cached_set_scan_threshold, по
+ * умолчанию обнаружение выключено.
  */
 
 #include "hyscan-cached.h"
-
+#include "hyscan-cached-arena.h"
+#include "hyscan-cached-crc32c.h"
+#include "hyscan-cache-counters.h"
+#include "hyscan-cached-pressure.h"
+#include "hyscan-cached-scan.h"
+#include "hyscan-cached-test.h"
+#include "hyscan-hash.h"
+
+#include <glib/gstdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
 #ifdef CPU_ARCH_X32
   #define MIN_CACHE_SIZE   64
@@ -65,10 +138,32 @@
 
 #define OBJECT_HEADER_SIZE offsetof (ObjectInfo, data)
 
+#define OBJECT_FLAG_CRC    (1 << 0)                            /* Для объекта вычислена контрольная сумма. */
+
+#define SNAPSHOT_MAGIC     G_GUINT64_CONSTANT (0x3130484341435348)     /* "HSCACH01" */
+#define SNAPSHOT_VERSION   2
+#define SNAPSHOT_BUFFER    (4 * 1024 * 1024)
+#define SNAPSHOT_ALIGN(s)  (((s) + 7) & ~((guint64) 7))
+#define SNAPSHOT_MIN_TASK  (4096)
+
+#define SERVICE_INTERVAL   (100 * G_TIME_SPAN_MILLISECOND)     /* Период работы потока обслуживания. */
+#define EVICT_BATCH        (256)                               /* Число объектов, удаляемых за один захват блокировки. */
+
+#define PRESSURE_INTERVAL  (G_TIME_SPAN_SECOND)                /* Период проверки нехватки памяти. */
+#define PRESSURE_RECOVER   (10)                                /* Число проверок без нехватки памяти до увеличения объёма. */
+#define PRESSURE_SHRINK    (8)                                 /* Доля уменьшения объёма при нехватке памяти. */
+#define PRESSURE_GROW      (16)                                /* Доля увеличения объёма после нехватки памяти. */
+#define PRESSURE_MIN_LIMIT (10)                                /* Минимальный объём как доля от максимального. */
+
+#define SCRUB_INTERVAL     (SERVICE_INTERVAL)                  /* Период проверки контрольных сумм. */
+#define SCRUB_IDLE_OPS     (1000)                              /* Число операций за период, при котором кэш считается свободным. */
+
+
 enum
 {
   PROP_O,
-  PROP_CACHE_SIZE
+  PROP_CACHE_SIZE,
+  PROP_MEMORY
 };
 
 /* Информация об объекте. */
@@ -79,18 +174,81 @@ struct _ObjectInfo
   ObjectInfo          *next;                   /* Указатель на следующий объект. */
 
   guint64              hash;                   /* Хэш идентификатора объекта. */
+  guint64              hash_hi;                /* Старшая половина 128-ми битного хэша идентификатора. */
   guint64              detail;                 /* Хэш дополнительной информации объекта. */
 
   guint32              allocated;              /* Размер буфера. */
   guint32              size;                   /* Размер объекта. */
+  guint16              key_size;               /* Размер идентификатора, сохранённого после данных. */
+  guint16              flags;                  /* Признаки объекта OBJECT_FLAG_*. */
+  guint32              crc;                    /* Контрольная сумма данных объекта. */
   gint8                data[];                 /* Данные объекта. */
 };
 
+/* Функция обработки удаления объектов. */
+typedef struct _EvictHandler EvictHandler;
+struct _EvictHandler
+{
+  HyScanCachedEvictFunc func;                  /* Функция обработки удаления объектов. */
+  gpointer             data;                   /* Пользовательские данные функции обработки. */
+  GDestroyNotify       destroy;                /* Функция удаления пользовательских данных. */
+  guint                calls;                  /* Число выполняющихся вызовов функции обработки. */
+};
+
+/* Заголовок файла с содержимым кэша. Все поля в порядке little endian. */
+typedef struct _SnapshotHeader SnapshotHeader;
+struct _SnapshotHeader
+{
+  guint64              magic;                  /* Идентификатор формата. */
+  guint32              version;                /* Версия формата. */
+  guint32              reserved;               /* Зарезервировано. */
+  guint64              n_objects;              /* Число объектов в файле. */
+};
+
+/* Заголовок объекта в файле, за ним следуют данные и идентификатор объекта,
+   выровненные на 8 байт. */
+typedef struct _SnapshotRecord SnapshotRecord;
+struct _SnapshotRecord
+{
+  guint64              hash;                   /* Хэш идентификатора объекта. */
+  guint64              hash_hi;                /* Старшая половина 128-ми битного хэша идентификатора. */
+  guint64              detail;                 /* Хэш дополнительной информации объекта. */
+  guint32              size;                   /* Размер объекта. */
+  guint32              key_size;               /* Размер идентификатора объекта. */
+};
+
+/* Заголовок объекта в файле версии 1, за ним следуют данные, выровненные на 8 байт. */
+typedef struct _SnapshotRecordV1 SnapshotRecordV1;
+struct _SnapshotRecordV1
+{
+  guint64              hash;                   /* Хэш идентификатора объекта. */
+  guint64              detail;                 /* Хэш дополнительной информации объекта. */
+  guint32              size;                   /* Размер объекта. */
+  guint32              reserved;               /* Зарезервировано. */
+};
+
+/* Задание на восстановление части объектов из файла. */
+typedef struct _SnapshotTask SnapshotTask;
+struct _SnapshotTask
+{
+  const gchar         *contents;               /* Содержимое файла. */
+  guint32              version;                /* Версия формата файла. */
+  gboolean             checksums;              /* Признак вычисления контрольных сумм. */
+  const guint64       *offsets;                /* Смещения объектов в файле. */
+  ObjectInfo         **objects;                /* Восстановленные объекты. */
+  guint64              first;                  /* Индекс первого объекта задания. */
+  guint64              last;                   /* Индекс объекта, следующего за последним. */
+};
+
 /* Внутренние данные объекта. */
 struct _HyScanCachedPrivate
 {
   guint64              cache_size;             /* Максимальный размер данных в кэше. */
   guint64              used_size;              /* Текущий размер данных в кэше. */
+  guint64              limit;                  /* Текущий допустимый размер данных в кэше. */
+
+  HyScanCachedMemory   memory;                 /* Способ выделения памяти. */
+  HyScanCachedArena   *arena;                  /* Арена памяти для объектов. */
 
   GHashTable          *objects;                /* Таблица объектов кэша. */
 
@@ -99,6 +257,32 @@ struct _HyScanCachedPrivate
 
   GRWLock              data_lock;              /* Блокировка доступа к данным. */
   GRWLock              list_lock;              /* Блокировка доступа к списку объектов. */
+
+  HyScanCacheCounters *counters;               /* Счётчики статистики. */
+
+  EvictHandler        *evict_handler;          /* Функция обработки удаления объектов. */
+  GArray              *evictions;              /* Удалённые объекты, ожидающие обработки. */
+  GMutex               evict_lock;             /* Блокировка замены функции обработки. */
+  GCond                evict_cond;             /* Сигнализация о завершении вызовов функции обработки. */
+
+  GThread             *service;                /* Поток обслуживания кэша. */
+  GMutex               service_lock;           /* Блокировка параметров потока обслуживания. */
+  GCond                service_cond;           /* Сигнализация потоку обслуживания. */
+  gboolean             service_stop;           /* Признак завершения потока обслуживания. */
+  gboolean             pressure_monitor;       /* Признак отслеживания нехватки памяти. */
+
+  gdouble              low_watermark;          /* Нижняя граница объёма данных, доля от допустимого. */
+  gdouble              high_watermark;         /* Верхняя граница объёма данных, доля от допустимого. */
+  volatile gint        reclaim_pending;        /* Признак необходимости удаления объектов. */
+
+  volatile gint        verify_keys;            /* Признак сохранения идентификаторов объектов. */
+
+  volatile gint        checksums;              /* Признак вычисления контрольных сумм. */
+  guint                scrub_rate;             /* Объём проверяемых данных в секунду, Мб. */
+  ObjectInfo          *scrub_cursor;           /* Следующий проверяемый объект. */
+
+  HyScanCachedScan    *scan;                   /* Обнаружение последовательного просмотра. */
+  gboolean             scan_owner;             /* Признак учёта результатов чтения этим кэшем. */
 };
 
 static void            hyscan_cached_interface_init               (HyScanCacheInterface *iface);
@@ -109,30 +293,74 @@ static void            hyscan_cached_set_property                 (GObject
 static void            hyscan_cached_object_constructed           (GObject              *object);
 static void            hyscan_cached_object_finalize              (GObject              *object);
 
+static ObjectInfo     *hyscan_cached_alloc_object                 (HyScanCachedPrivate  *priv,
+                                                                   guint32               size,
+                                                                   gboolean              evict);
+static ObjectInfo     *hyscan_cached_realloc_object               (HyScanCachedPrivate  *priv,
+                                                                   ObjectInfo           *object,
+                                                                   guint32               size,
+                                                                   gboolean              keep_data);
+static void            hyscan_cached_free_object                  (HyScanCachedPrivate  *priv,
+                                                                   ObjectInfo           *object);
+static guint32         hyscan_cached_allocated_size               (HyScanCachedPrivate  *priv,
+                                                                   guint32               size);
+
 static void            hyscan_cached_free_used                    (HyScanCachedPrivate  *priv,
                                                                    guint32               size);
 
+static guint32         hyscan_cached_buffers_size                 (HyScanBuffer        **buffers,
+                                                                   guint                 n_buffers);
+static void            hyscan_cached_copy_buffers                 (gint8                *data,
+                                                                   HyScanBuffer        **buffers,
+                                                                   guint                 n_buffers);
 static ObjectInfo     *hyscan_cached_rise_object                  (HyScanCachedPrivate  *priv,
                                                                    guint64               key,
                                                                    guint64               detail,
-                                                                   gpointer              data1,
-                                                                   guint32               size1,
-                                                                   gpointer              data2,
-                                                                   guint32               size2);
+                                                                   HyScanBuffer        **buffers,
+                                                                   guint                 n_buffers,
+                                                                   guint32               size);
 static ObjectInfo     *hyscan_cached_update_object                (HyScanCachedPrivate  *priv,
                                                                    ObjectInfo           *object,
                                                                    guint64               detail,
-                                                                   gpointer              data1,
-                                                                   guint32               size1,
-                                                                   gpointer              data2,
-                                                                   guint32               size2);
+                                                                   HyScanBuffer        **buffers,
+                                                                   guint                 n_buffers,
+                                                                   guint32               size);
+static void            hyscan_cached_unlink_object                (HyScanCachedPrivate  *priv,
+                                                                   ObjectInfo           *object,
+                                                                   HyScanCachedEvictReason reason);
 static void            hyscan_cached_drop_object                  (HyScanCachedPrivate  *priv,
-                                                                   ObjectInfo           *object);
+                                                                   ObjectInfo           *object,
+                                                                   HyScanCachedEvictReason reason);
+static GArray         *hyscan_cached_take_evictions               (HyScanCachedPrivate  *priv);
+static void            hyscan_cached_notify_evictions             (HyScanCached         *cached,
+                                                                   GArray               *evictions);
 
 static void            hyscan_cached_remove_object_from_used      (HyScanCachedPrivate  *priv,
                                                                    ObjectInfo           *object);
 static void            hyscan_cached_place_object_on_top_of_used  (HyScanCachedPrivate  *priv,
                                                                    ObjectInfo           *object);
+static void            hyscan_cached_place_object_on_bottom_of_used (HyScanCachedPrivate *priv,
+                                                                   ObjectInfo           *object);
+
+static void            hyscan_cached_read_record                  (const gchar          *data,
+                                                                    guint32               version,
+                                                                    SnapshotRecord       *record);
+static gpointer        hyscan_cached_load_task                    (gpointer              data);
+
+static void            hyscan_cached_service_start                (HyScanCached         *cached);
+static gpointer        hyscan_cached_service                      (gpointer              data);
+static void            hyscan_cached_shrink                       (HyScanCached         *cached,
+                                                                   guint64               target);
+static void            hyscan_cached_release_memory               (HyScanCachedPrivate  *priv);
+static void            hyscan_cached_reclaim_task                 (HyScanCached         *cached);
+static void            hyscan_cached_reclaim_wakeup               (HyScanCachedPrivate  *priv);
+static void            hyscan_cached_scrub_task                   (HyScanCached         *cached,
+                                                                   guint64               budget);
+static void            hyscan_cached_drop_corrupted               (HyScanCached         *cached,
+                                                                   guint64               key);
+static void            hyscan_cached_pressure_task                (HyScanCached         *cached,
+                                                                   HyScanCachedPressure *pressure,
+                                                                   guint                *relaxed);
 
 G_DEFINE_TYPE_WITH_CODE (HyScanCached, hyscan_cached, G_TYPE_OBJECT,
                          G_ADD_PRIVATE (HyScanCached)
@@ -151,6 +379,12 @@ hyscan_cached_class_init (HyScanCachedClass *klass)
                                    g_param_spec_uint ("cache-size", "Cache size", "Cache size, Mb",
                                                       MIN_CACHE_SIZE, MAX_CACHE_SIZE, MIN_CACHE_SIZE,
                                                       G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
+
+  g_object_class_install_property (object_class, PROP_MEMORY,
+                                   g_param_spec_uint ("memory", "Memory", "Memory allocation mode",
+                                                      HYSCAN_CACHED_MEMORY_HEAP, HYSCAN_CACHED_MEMORY_HUGETLB,
+                                                      HYSCAN_CACHED_MEMORY_HEAP,
+                                                      G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
 }
 
 static void
@@ -175,6 +409,10 @@ hyscan_cached_set_property (GObject      *object,
       priv->cache_size *= 1024 * 1024;
       break;
 
+    case PROP_MEMORY:
+      priv->memory = g_value_get_uint (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -190,8 +428,27 @@ hyscan_cached_object_constructed (GObject *object)
   g_rw_lock_init (&priv->data_lock);
   g_rw_lock_init (&priv->list_lock);
 
-  /* Таблица объектов кэша. */
-  priv->objects = g_hash_table_new_full (g_int64_hash, g_int64_equal, NULL, g_free);
+  g_mutex_init (&priv->service_lock);
+  g_cond_init (&priv->service_cond);
+
+  g_mutex_init (&priv->evict_lock);
+  g_cond_init (&priv->evict_cond);
+
+  priv->limit = priv->cache_size;
+  priv->counters = hyscan_cache_counters_new (HYSCAN_CACHE_COUNTER_LAST);
+  priv->scan = hyscan_cached_scan_new ();
+  priv->scan_owner = TRUE;
+
+  /* Таблица объектов кэша. Память объектов освобождается функцией hyscan_cached_free_object. */
+  priv->objects = g_hash_table_new (g_int64_hash, g_int64_equal);
+
+  /* Арена памяти для объектов. Размер арены больше объёма кэша на 1/8,
+   * так как блоки памяти в арене выделяются с округлением размера. */
+  if (priv->memory != HYSCAN_CACHED_MEMORY_HEAP)
+    {
+      priv->arena = hyscan_cached_arena_new (priv->cache_size + priv->cache_size / 8,
+                                             priv->memory == HYSCAN_CACHED_MEMORY_HUGETLB);
+    }
 }
 
 static void
@@ -199,8 +456,45 @@ hyscan_cached_object_finalize (GObject *object)
 {
   HyScanCached *cached = HYSCAN_CACHED (object);
   HyScanCachedPrivate *priv = cached->priv;
+  GHashTableIter iter;
+  gpointer info;
+
+  /* Завершаем поток обслуживания. */
+  if (priv->service != NULL)
+    {
+      g_mutex_lock (&priv->service_lock);
+      priv->service_stop = TRUE;
+      g_cond_signal (&priv->service_cond);
+      g_mutex_unlock (&priv->service_lock);
+
+      g_thread_join (priv->service);
+    }
+
+  g_mutex_clear (&priv->service_lock);
+  g_cond_clear (&priv->service_cond);
+
+  g_hash_table_iter_init (&iter, priv->objects);
+  while (g_hash_table_iter_next (&iter, NULL, &info))
+    {
+      g_hash_table_iter_steal (&iter);
+      hyscan_cached_free_object (priv, info);
+    }
 
   g_hash_table_unref (priv->objects);
+  hyscan_cached_arena_free (priv->arena);
+  hyscan_cache_counters_free (priv->counters);
+
+  if (priv->scan_owner)
+    hyscan_cached_scan_free (priv->scan);
+
+  if (priv->evictions != NULL)
+    g_array_unref (priv->evictions);
+  if (priv->evict_handler != NULL && priv->evict_handler->destroy != NULL)
+    priv->evict_handler->destroy (priv->evict_handler->data);
+  g_free (priv->evict_handler);
+
+  g_mutex_clear (&priv->evict_lock);
+  g_cond_clear (&priv->evict_cond);
 
   g_rw_lock_clear (&priv->list_lock);
   g_rw_lock_clear (&priv->data_lock);
@@ -208,6 +502,128 @@ hyscan_cached_object_finalize (GObject *object)
   G_OBJECT_CLASS (hyscan_cached_parent_class)->finalize (object);
 }
 
+/* Функция выделяет память для объекта размером size. Если в арене нет блока
+   нужного размера и установлен признак evict, из кэша удаляются давно
+   использованные объекты. Функция возвращает NULL, если память выделить
+   не удалось. */
+static ObjectInfo *
+hyscan_cached_alloc_object (HyScanCachedPrivate *priv,
+                            guint32              size,
+                            gboolean             evict)
+{
+  ObjectInfo *object;
+
+  if (priv->arena == NULL)
+    {
+      object = g_malloc (OBJECT_HEADER_SIZE + size);
+      object->allocated = size;
+
+      return object;
+    }
+
+  object = hyscan_cached_arena_alloc (priv->arena, OBJECT_HEADER_SIZE + size);
+  while (object == NULL && evict && priv->bottom_object != NULL)
+    {
+      hyscan_cached_drop_object (priv, priv->bottom_object, HYSCAN_CACHED_EVICT_CAPACITY);
+      hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_EVICTIONS, 1);
+      object = hyscan_cached_arena_alloc (priv->arena, OBJECT_HEADER_SIZE + size);
+    }
+
+  if (object == NULL)
+    return NULL;
+
+  object->allocated = hyscan_cached_allocated_size (priv, size);
+
+  return object;
+}
+
+/* Функция изменяет размер памяти объекта. Данные объекта сохраняются только
+   если установлен признак keep_data. Объект не должен находиться в списке
+   используемых, так как при нехватке памяти арены объекты из этого списка
+   удаляются. */
+static ObjectInfo *
+hyscan_cached_realloc_object (HyScanCachedPrivate *priv,
+                              ObjectInfo          *object,
+                              guint32              size,
+                              gboolean             keep_data)
+{
+  ObjectInfo *new_object = NULL;
+  ObjectInfo header;
+  gpointer data = NULL;
+
+  if (priv->arena == NULL)
+    {
+      object = g_realloc (object, OBJECT_HEADER_SIZE + size);
+      object->allocated = size;
+
+      return object;
+    }
+
+  header = *object;
+
+  /* Блок объекта можно использовать повторно, если данные не нужны. */
+  if (keep_data)
+    new_object = hyscan_cached_alloc_object (priv, size, TRUE);
+
+  /* Если памяти не хватило даже после удаления всех объектов, данные
+     временно копируются, а блок объекта освобождается. Других выделенных
+     блоков в арене нет, поэтому повторное выделение будет успешным. */
+  if (new_object == NULL)
+    {
+      if (keep_data)
+        data = g_memdup (object->data, MIN (object->size, size));
+      hyscan_cached_free_object (priv, object);
+      object = NULL;
+
+      new_object = hyscan_cached_alloc_object (priv, size, TRUE);
+    }
+
+  new_object->prev = header.prev;
+  new_object->next = header.next;
+  new_object->hash = header.hash;
+  new_object->hash_hi = header.hash_hi;
+  new_object->detail = header.detail;
+  new_object->size = header.size;
+  new_object->key_size = header.key_size;
+  new_object->flags = header.flags;
+  new_object->crc = header.crc;
+
+  if (object != NULL)
+    {
+      memcpy (new_object->data, object->data, MIN (header.size, size));
+      hyscan_cached_free_object (priv, object);
+    }
+  else if (data != NULL)
+    {
+      memcpy (new_object->data, data, MIN (header.size, size));
+      g_free (data);
+    }
+
+  return new_object;
+}
+
+/* Функция освобождает память объекта. */
+static void
+hyscan_cached_free_object (HyScanCachedPrivate *priv,
+                           ObjectInfo          *object)
+{
+  if (priv->arena != NULL)
+    hyscan_cached_arena_release (priv->arena, object, OBJECT_HEADER_SIZE + object->allocated);
+  else
+    g_free (object);
+}
+
+/* Функция возвращает размер буфера, который будет выделен для объекта размером size. */
+static guint32
+hyscan_cached_allocated_size (HyScanCachedPrivate *priv,
+                              guint32              size)
+{
+  if (priv->arena != NULL)
+    return hyscan_cached_arena_round (OBJECT_HEADER_SIZE + size) - OBJECT_HEADER_SIZE;
+
+  return size;
+}
+
 /* Функция освобождает память в кэше для размещения нового объекта. */
 static void
 hyscan_cached_free_used (HyScanCachedPrivate *priv,
@@ -216,69 +632,111 @@ hyscan_cached_free_used (HyScanCachedPrivate *priv,
   ObjectInfo *object = priv->bottom_object;
 
   /* Удаляем объекты пока не наберём достаточного объёма свободной памяти. */
-  while (object != NULL && priv->cache_size < (priv->used_size + size))
+  while (object != NULL && priv->limit < (priv->used_size + size))
     {
-      hyscan_cached_drop_object (priv, object);
+      hyscan_cached_drop_object (priv, object, HYSCAN_CACHED_EVICT_CAPACITY);
+      hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_EVICTIONS, 1);
       object = priv->bottom_object;
     }
 }
 
+/* Функция возвращает суммарный размер данных в буферах. */
+static guint32
+hyscan_cached_buffers_size (HyScanBuffer **buffers,
+                            guint          n_buffers)
+{
+  guint32 size = 0;
+  guint i;
+
+  for (i = 0; i < n_buffers; i++)
+    {
+      guint32 part = 0;
+
+      if (buffers[i] != NULL && hyscan_buffer_get (buffers[i], NULL, &part) != NULL)
+        size += part;
+    }
+
+  return size;
+}
+
+/* Функция последовательно копирует данные из буферов. */
+static void
+hyscan_cached_copy_buffers (gint8         *data,
+                            HyScanBuffer **buffers,
+                            guint          n_buffers)
+{
+  guint i;
+
+  for (i = 0; i < n_buffers; i++)
+    {
+      gpointer part_data;
+      guint32 part = 0;
+
+      if (buffers[i] == NULL)
+        continue;
+
+      part_data = hyscan_buffer_get (buffers[i], NULL, &part);
+      if (part_data == NULL || part == 0)
+        continue;
+
+      memcpy (data, part_data, part);
+      data += part;
+    }
+}
+
 /* Функция выбирает структуру с информацией об объекте из кучи свободных, выделяет память под объект
    и сохраняет данные. */
 static ObjectInfo *
-hyscan_cached_rise_object (HyScanCachedPrivate *priv,
-                           guint64              key,
-                           guint64              detail,
-                           gpointer             data1,
-                           guint32              size1,
-                           gpointer             data2,
-                           guint32              size2)
+hyscan_cached_rise_object (HyScanCachedPrivate  *priv,
+                           guint64               key,
+                           guint64               detail,
+                           HyScanBuffer        **buffers,
+                           guint                 n_buffers,
+                           guint32               size)
 {
   ObjectInfo *object;
-  guint32 size = size1 + size2;
 
   /* Инициализация. */
-  object = g_malloc (OBJECT_HEADER_SIZE + size);
+  object = hyscan_cached_alloc_object (priv, size, TRUE);
   object->next = NULL;
   object->prev = NULL;
 
   /* Хеш идентификатора объекта и дополнительной информации. */
   object->hash = key;
+  object->hash_hi = 0;
   object->detail = detail;
   object->size = size;
+  object->key_size = 0;
+  object->flags = 0;
 
   /* Данные объекта. */
-  object->allocated = size;
-  priv->used_size += (OBJECT_HEADER_SIZE + size);
-  memcpy (object->data, data1, size1);
-  if (size2 > 0)
-    memcpy ((gint8*) object->data + size1, data2, size2);
+  priv->used_size += (OBJECT_HEADER_SIZE + object->allocated);
+  hyscan_cached_copy_buffers (object->data, buffers, n_buffers);
 
   return object;
 }
 
 /* Функция обновляет используемый объект. */
 static ObjectInfo *
-hyscan_cached_update_object (HyScanCachedPrivate *priv,
-                             ObjectInfo          *object,
-                             guint64              detail,
-                             gpointer             data1,
-                             guint32              size1,
-                             gpointer             data2,
-                             guint32              size2)
+hyscan_cached_update_object (HyScanCachedPrivate  *priv,
+                             ObjectInfo           *object,
+                             guint64               detail,
+                             HyScanBuffer        **buffers,
+                             guint                 n_buffers,
+                             guint32               size)
 {
-  guint32 size = size1 + size2;
+  guint32 allocated = hyscan_cached_allocated_size (priv, size);
 
   /* Если текущий размер объекта меньше нового размера или больше нового на 5%, выделяем память заново. */
-  if (object->allocated < size || ((gdouble) size / (gdouble) object->allocated) < 0.95)
+  if (object->allocated < size || ((gdouble) allocated / (gdouble) object->allocated) < 0.95)
     {
       g_hash_table_steal (priv->objects, &object->hash);
-      object = g_realloc (object, OBJECT_HEADER_SIZE + size);
-      g_hash_table_insert (priv->objects, &object->hash, object);
-
       priv->used_size -= (OBJECT_HEADER_SIZE + object->allocated);
-      object->allocated = size;
-      priv->used_size += (OBJECT_HEADER_SIZE + size);
+
+      object = hyscan_cached_realloc_object (priv, object, size, FALSE);
+
+      priv->used_size += (OBJECT_HEADER_SIZE + object->allocated);
+      g_hash_table_insert (priv->objects, &object->hash, object);
     }
 
   /* Новый размер объекта. */
@@ -286,29 +744,105 @@ hyscan_cached_update_object (HyScanCachedPrivate *priv,
   object->detail = detail;
 
   /* Данные объекта. */
-  memcpy (object->data, data1, size1);
-  if (size2 > 0)
-    memcpy ((gint8*) object->data + size1, data2, size2);
+  hyscan_cached_copy_buffers (object->data, buffers, n_buffers);
 
   return object;
 }
 
-/* Функция удаляет объект из кеша и помещает структуру в кучу свободных. */
+/* Функция удаляет объект из таблицы и списка используемых без освобождения памяти. */
 static void
-hyscan_cached_drop_object (HyScanCachedPrivate *priv,
-                           ObjectInfo          *object)
+hyscan_cached_unlink_object (HyScanCachedPrivate     *priv,
+                             ObjectInfo              *object,
+                             HyScanCachedEvictReason  reason)
 {
+  /* Запоминаем удалённый объект для функции обработки. */
+  if (priv->evict_handler != NULL)
+    {
+      HyScanCachedEviction eviction;
+
+      if (priv->evictions == NULL)
+        priv->evictions = g_array_new (FALSE, FALSE, sizeof (HyScanCachedEviction));
+
+      eviction.key = object->hash;
+      eviction.detail = object->detail;
+      eviction.size = object->size;
+      eviction.reason = reason;
+      g_array_append_val (priv->evictions, eviction);
+    }
+
   hyscan_cached_remove_object_from_used (priv, object);
 
   priv->used_size -= (OBJECT_HEADER_SIZE + object->allocated);
   g_hash_table_remove (priv->objects, &object->hash);
 }
 
+/* Функция удаляет объект из кеша и освобождает его память. */
+static void
+hyscan_cached_drop_object (HyScanCachedPrivate     *priv,
+                           ObjectInfo              *object,
+                           HyScanCachedEvictReason  reason)
+{
+  hyscan_cached_unlink_object (priv, object, reason);
+  hyscan_cached_free_object (priv, object);
+}
+
+/* Функция забирает накопленную информацию об удалённых объектах.
+   Вызывается при захваченной блокировке записи. */
+static GArray *
+hyscan_cached_take_evictions (HyScanCachedPrivate *priv)
+{
+  GArray *evictions = priv->evictions;
+
+  priv->evictions = NULL;
+
+  return evictions;
+}
+
+/* Функция передаёт информацию об удалённых объектах в функцию обработки.
+   Вызывается без блокировки. Пока выполняется вызов, пользовательские
+   данные функции обработки не удаляются при её замене. */
+static void
+hyscan_cached_notify_evictions (HyScanCached *cached,
+                                GArray       *evictions)
+{
+  HyScanCachedPrivate *priv = cached->priv;
+  EvictHandler *handler;
+
+  if (evictions == NULL)
+    return;
+
+  g_mutex_lock (&priv->evict_lock);
+  handler = priv->evict_handler;
+  if (handler != NULL)
+    handler->calls += 1;
+  g_mutex_unlock (&priv->evict_lock);
+
+  if (handler == NULL)
+    {
+      g_array_unref (evictions);
+      return;
+    }
+
+  if (evictions->len > 0)
+    handler->func (cached, (HyScanCachedEviction *) evictions->data, evictions->len, handler->data);
+
+  g_mutex_lock (&priv->evict_lock);
+  if (--handler->calls == 0)
+    g_cond_broadcast (&priv->evict_cond);
+  g_mutex_unlock (&priv->evict_lock);
+
+  g_array_unref (evictions);
+}
+
 /* Функция удаляет объект из списка используемых. */
 static void
 hyscan_cached_remove_object_from_used (HyScanCachedPrivate *priv,
                                        ObjectInfo          *object)
 {
+  /* Проверка объектов продолжится со следующего объекта списка. */
+  if (priv->scrub_cursor == object)
+    priv->scrub_cursor = object->prev;
+
   /* Единственный объект в списке */
   if ((priv->top_object == priv->bottom_object) && (priv->top_object == object))
     {
@@ -375,167 +909,1687 @@ hyscan_cached_place_object_on_top_of_used (HyScanCachedPrivate *priv,
   g_rw_lock_writer_unlock (&priv->list_lock);
 }
 
-/**
- * hyscan_cached_new:
- * @cache_size: максимальный объём памяти, Мб
- *
- * Функция создаёт новый объект #HyScanCached.
- *
- * Returns: #HyScanCached. Для удаления #g_object_unref.
- */
-HyScanCached *
-hyscan_cached_new (guint32 cache_size)
+/* Функция помещает объект в конец списка используемых. */
+static void
+hyscan_cached_place_object_on_bottom_of_used (HyScanCachedPrivate *priv,
+                                              ObjectInfo          *object)
 {
-  return g_object_new (HYSCAN_TYPE_CACHED, "cache-size", cache_size, NULL);
-}
+  g_rw_lock_writer_lock (&priv->list_lock);
 
-/* Функция добавляет или изменяет объект в кэше. */
-static gboolean
-hyscan_cached_set (HyScanCache  *cache,
-                   guint64       key,
-                   guint64       detail,
-                   HyScanBuffer *buffer1,
-                   HyScanBuffer *buffer2)
-{
-  HyScanCached *cached = HYSCAN_CACHED (cache);
-  HyScanCachedPrivate *priv = cached->priv;
+  /* "Вынимаем" объект из цепочки используемых. */
+  hyscan_cached_remove_object_from_used (priv, object);
 
-  ObjectInfo *object;
+  /* Первый объект в кэше. */
+  if ((priv->top_object == NULL) && (priv->bottom_object == NULL))
+    {
+      priv->top_object = object;
+      priv->bottom_object = object;
+    }
 
-  gpointer data1 = NULL;
-  gpointer data2 = NULL;
-  guint32 size1 = 0;
-  guint32 size2 = 0;
-  guint32 size;
+  /* "Вставляем" после последнего объекта в цепочке. */
+  else
+    {
+      priv->bottom_object->next = object;
+      object->prev = priv->bottom_object;
+      priv->bottom_object = object;
+    }
 
-  if (buffer1 != NULL)
-    data1 = hyscan_buffer_get (buffer1, NULL, &size1);
-  if (buffer2 != NULL)
-    data2 = hyscan_buffer_get (buffer2, NULL, &size2);
+  g_rw_lock_writer_unlock (&priv->list_lock);
+}
 
-  size = size1 + size2;
+/* Функция считывает заголовок объекта из файла версии version и
+   преобразует поля в порядок байт процессора. */
+static void
+hyscan_cached_read_record (const gchar    *data,
+                           guint32         version,
+                           SnapshotRecord *record)
+{
+  if (version == 1)
+    {
+      SnapshotRecordV1 record_v1;
 
-  /* Если размер нового объекта слишком большой, не сохраняем его. */
-  if (size > priv->cache_size / 10)
-    return FALSE;
+      memcpy (&record_v1, data, sizeof (record_v1));
+      record->hash = GUINT64_FROM_LE (record_v1.hash);
+      record->hash_hi = 0;
+      record->detail = GUINT64_FROM_LE (record_v1.detail);
+      record->size = GUINT32_FROM_LE (record_v1.size);
+      record->key_size = 0;
 
-  g_rw_lock_writer_lock (&priv->data_lock);
+      return;
+    }
 
-  /* Ищем объект в кэше. */
-  object = g_hash_table_lookup (priv->objects, &key);
+  memcpy (record, data, sizeof (SnapshotRecord));
+  record->hash = GUINT64_FROM_LE (record->hash);
+  record->hash_hi = GUINT64_FROM_LE (record->hash_hi);
+  record->detail = GUINT64_FROM_LE (record->detail);
+  record->size = GUINT32_FROM_LE (record->size);
+  record->key_size = GUINT32_FROM_LE (record->key_size);
+}
 
-  /* Если размер объекта равен нулю, удаляем объект. */
-  if (size == 0)
-    {
-      if (object != NULL)
-        hyscan_cached_drop_object (priv, object);
+/* Функция восстанавливает часть объектов из файла в заранее выделенную
+   для них память. Выполняется параллельно в нескольких потоках. */
+static gpointer
+hyscan_cached_load_task (gpointer data)
+{
+  SnapshotTask *task = data;
 
-      goto exit;
-    }
+  gsize record_size = (task->version == 1) ? sizeof (SnapshotRecordV1) : sizeof (SnapshotRecord);
+  guint64 i;
 
-  /* Очищаем кэш если достигнут лимит используемой памяти. */
-  if (priv->used_size + OBJECT_HEADER_SIZE + size > priv->cache_size)
+  for (i = task->first; i < task->last; i++)
     {
-      hyscan_cached_free_used (priv, OBJECT_HEADER_SIZE + size);
-      object = g_hash_table_lookup (priv->objects, &key);
-    }
+      const gchar *data = task->contents + task->offsets[i];
+      SnapshotRecord record;
+      ObjectInfo *object;
 
-  /* Если объект уже был в кэше, изменяем его. */
-  if (object != NULL)
-    {
-      hyscan_cached_remove_object_from_used (priv, object);
-      object = hyscan_cached_update_object (priv, object, detail, data1, size1, data2, size2);
+      hyscan_cached_read_record (data, task->version, &record);
+
+      object = task->objects[i];
+      object->next = NULL;
+      object->prev = NULL;
+      object->hash = record.hash;
+      object->hash_hi = record.hash_hi;
+      object->detail = record.detail;
+      object->size = record.size;
+      object->key_size = record.key_size;
+      object->flags = 0;
+      memcpy (object->data, data + record_size, record.size + record.key_size);
+
+      if (task->checksums)
+        {
+          object->crc = hyscan_cached_crc32c (0, object->data, object->size);
+          object->flags |= OBJECT_FLAG_CRC;
+        }
     }
 
-  /* Если объекта в кэше не было, создаём новый и добавляем в кэш. */
-  else
+  return NULL;
+}
+
+/* Функция запускает поток обслуживания кэша, если он ещё не запущен.
+   Вызывается при захваченной блокировке service_lock. */
+static void
+hyscan_cached_service_start (HyScanCached *cached)
+{
+  HyScanCachedPrivate *priv = cached->priv;
+
+  if (priv->service == NULL)
+    priv->service = g_thread_new ("cached-service", hyscan_cached_service, cached);
+}
+
+/* Поток обслуживания кэша. */
+static gpointer
+hyscan_cached_service (gpointer data)
+{
+  HyScanCached *cached = data;
+  HyScanCachedPrivate *priv = cached->priv;
+  HyScanCachedPressure *pressure = NULL;
+  gint64 pressure_time = 0;
+  gint64 scrub_time = 0;
+  guint64 scrub_ops = 0;
+  guint relaxed = 0;
+
+  g_mutex_lock (&priv->service_lock);
+
+  while (!priv->service_stop)
+    {
+      gint64 now = g_get_monotonic_time ();
+
+      /* Отслеживание нехватки памяти. */
+      if (priv->pressure_monitor && pressure == NULL)
+        {
+          pressure = hyscan_cached_pressure_new ();
+          relaxed = 0;
+        }
+      else if (!priv->pressure_monitor && pressure != NULL)
+        {
+          g_clear_pointer (&pressure, hyscan_cached_pressure_free);
+
+          g_rw_lock_writer_lock (&priv->data_lock);
+          priv->limit = priv->cache_size;
+          g_rw_lock_writer_unlock (&priv->data_lock);
+        }
+
+      if (pressure != NULL && now >= pressure_time)
+        {
+          g_mutex_unlock (&priv->service_lock);
+          hyscan_cached_pressure_task (cached, pressure, &relaxed);
+          g_mutex_lock (&priv->service_lock);
+
+          pressure_time = now + PRESSURE_INTERVAL;
+        }
+
+      /* Удаление объектов при превышении верхней границы объёма данных. */
+      g_mutex_unlock (&priv->service_lock);
+      hyscan_cached_reclaim_task (cached);
+      g_mutex_lock (&priv->service_lock);
+
+      /* Проверка контрольных сумм, если за прошедший период кэш использовался
+         мало. Поток просыпается и для удаления объектов, поэтому проверка
+         выполняется не чаще одного раза за период. */
+      if (priv->scrub_rate > 0 && now >= scrub_time)
+        {
+          guint64 values[HYSCAN_CACHE_COUNTER_SETS + 1];
+          guint64 budget;
+          guint64 ops;
+          guint i;
+
+          hyscan_cache_counters_sum (priv->counters, HYSCAN_CACHE_COUNTER_HITS, G_N_ELEMENTS (values), values);
+          for (i = 0, ops = 0; i < G_N_ELEMENTS (values); i++)
+            ops += values[i];
+
+          budget = ((guint64) priv->scrub_rate << 20) * SCRUB_INTERVAL / G_TIME_SPAN_SECOND;
+
+          /* Число операций за первый период неизвестно, проверка начинается со второго. */
+          if (scrub_time > 0 && ops - scrub_ops < SCRUB_IDLE_OPS)
+            {
+              g_mutex_unlock (&priv->service_lock);
+              hyscan_cached_scrub_task (cached, budget);
+              g_mutex_lock (&priv->service_lock);
+            }
+
+          scrub_ops = ops;
+          scrub_time = now + SCRUB_INTERVAL;
+        }
+
+      if (priv->service_stop || g_atomic_int_get (&priv->reclaim_pending))
+        continue;
+
+      g_cond_wait_until (&priv->service_cond, &priv->service_lock, now + SERVICE_INTERVAL);
+    }
+
+  g_mutex_unlock (&priv->service_lock);
+
+  hyscan_cached_pressure_free (pressure);
+
+  return NULL;
+}
+
+/* Функция удаляет давно использованные объекты, пока объём данных в кэше
+   не станет меньше target. Объекты удаляются частями, чтобы не блокировать
+   доступ к кэшу надолго. Память объектов, выделенная из кучи, освобождается
+   после снятия блокировки. */
+static void
+hyscan_cached_shrink (HyScanCached *cached,
+                      guint64       target)
+{
+  HyScanCachedPrivate *priv = cached->priv;
+  ObjectInfo *dropped[EVICT_BATCH];
+  gboolean done = FALSE;
+
+  while (!done)
+    {
+      GArray *evictions;
+      guint n_evicted = 0;
+      guint n_dropped = 0;
+      guint i;
+
+      g_rw_lock_writer_lock (&priv->data_lock);
+
+      while (priv->bottom_object != NULL && priv->used_size > target && n_evicted < EVICT_BATCH)
+        {
+          ObjectInfo *object = priv->bottom_object;
+
+          hyscan_cached_unlink_object (priv, object, HYSCAN_CACHED_EVICT_CAPACITY);
+          n_evicted += 1;
+
+          /* Арена не допускает освобождения памяти без блокировки. */
+          if (priv->arena != NULL)
+            hyscan_cached_free_object (priv, object);
+          else
+            dropped[n_dropped++] = object;
+        }
+
+      done = (priv->bottom_object == NULL || priv->used_size <= target);
+      evictions = hyscan_cached_take_evictions (priv);
+
+      g_rw_lock_writer_unlock (&priv->data_lock);
+
+      for (i = 0; i < n_dropped; i++)
+        hyscan_cached_free_object (priv, dropped[i]);
+
+      hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_EVICTIONS, n_evicted);
+      hyscan_cached_notify_evictions (cached, evictions);
+    }
+}
+
+/* Функция проверяет контрольные суммы объектов, начиная с давно
+   использованных. За один вызов проверяется не более budget байт данных,
+   проверка продолжается при следующем вызове. Объекты проверяются частями
+   при захваченной блокировке чтения, повреждённые объекты удаляются. */
+static void
+hyscan_cached_scrub_task (HyScanCached *cached,
+                          guint64       budget)
+{
+  HyScanCachedPrivate *priv = cached->priv;
+  guint64 corrupted[EVICT_BATCH];
+  guint64 checked = 0;
+  gboolean done = FALSE;
+
+  while (!done && checked < budget)
+    {
+      guint n_corrupted = 0;
+      guint n_checked = 0;
+      guint i;
+
+      g_rw_lock_reader_lock (&priv->data_lock);
+
+      while (!done && checked < budget && n_checked < EVICT_BATCH)
+        {
+          ObjectInfo *object;
+
+          /* Положение в списке изменяется при чтении объектов. */
+          g_rw_lock_writer_lock (&priv->list_lock);
+          object = (priv->scrub_cursor != NULL) ? priv->scrub_cursor : priv->bottom_object;
+          priv->scrub_cursor = (object != NULL) ? object->prev : NULL;
+          done = (priv->scrub_cursor == NULL);
+          g_rw_lock_writer_unlock (&priv->list_lock);
+
+          if (object == NULL)
+            break;
+
+          if ((object->flags & OBJECT_FLAG_CRC) &&
+              hyscan_cached_crc32c (0, object->data, object->size) != object->crc)
+            {
+              corrupted[n_corrupted++] = object->hash;
+            }
+
+          checked += OBJECT_HEADER_SIZE + object->size;
+          n_checked += 1;
+        }
+
+      g_rw_lock_reader_unlock (&priv->data_lock);
+
+      for (i = 0; i < n_corrupted; i++)
+        hyscan_cached_drop_corrupted (cached, corrupted[i]);
+    }
+}
+
+/* Функция удаляет объект, если его данные повреждены. */
+static void
+hyscan_cached_drop_corrupted (HyScanCached *cached,
+                              guint64       key)
+{
+  HyScanCachedPrivate *priv = cached->priv;
+  ObjectInfo *object;
+  GArray *evictions;
+
+  g_rw_lock_writer_lock (&priv->data_lock);
+
+  /* Объект мог быть изменён после проверки. */
+  object = g_hash_table_lookup (priv->objects, &key);
+  if (object != NULL && (object->flags & OBJECT_FLAG_CRC) &&
+      hyscan_cached_crc32c (0, object->data, object->size) != object->crc)
+    {
+      g_warning ("HyScanCached: object 0x%016" G_GINT64_MODIFIER "x is corrupted", key);
+      hyscan_cached_drop_object (priv, object, HYSCAN_CACHED_EVICT_CORRUPTED);
+    }
+
+  evictions = hyscan_cached_take_evictions (priv);
+
+  g_rw_lock_writer_unlock (&priv->data_lock);
+
+  hyscan_cached_notify_evictions (cached, evictions);
+}
+
+/* Функция удаляет объекты до нижней границы объёма данных, если он
+   превысил верхнюю границу. */
+static void
+hyscan_cached_reclaim_task (HyScanCached *cached)
+{
+  HyScanCachedPrivate *priv = cached->priv;
+  gboolean reclaim;
+  guint64 target;
+
+  g_atomic_int_set (&priv->reclaim_pending, 0);
+
+  g_rw_lock_reader_lock (&priv->data_lock);
+  reclaim = (priv->high_watermark > 0.0 && priv->used_size > priv->limit * priv->high_watermark);
+  target = priv->limit * priv->low_watermark;
+  g_rw_lock_reader_unlock (&priv->data_lock);
+
+  if (reclaim)
+    hyscan_cached_shrink (cached, target);
+}
+
+/* Функция будит поток обслуживания для удаления объектов до нижнего порога. */
+static void
+hyscan_cached_reclaim_wakeup (HyScanCachedPrivate *priv)
+{
+  if (!g_atomic_int_compare_and_exchange (&priv->reclaim_pending, 0, 1))
+    return;
+
+  g_mutex_lock (&priv->service_lock);
+  g_cond_signal (&priv->service_cond);
+  g_mutex_unlock (&priv->service_lock);
+}
+
+/* Функция возвращает системе освободившуюся память. */
+static void
+hyscan_cached_release_memory (HyScanCachedPrivate *priv)
+{
+  if (priv->arena != NULL)
+    {
+      g_rw_lock_writer_lock (&priv->data_lock);
+      hyscan_cached_arena_trim (priv->arena);
+      g_rw_lock_writer_unlock (&priv->data_lock);
+    }
+  else
+    {
+#ifdef __GLIBC__
+      malloc_trim (0);
+#endif
+    }
+}
+
+/* Функция проверяет нехватку памяти и изменяет допустимый объём данных в кэше.
+   При нехватке памяти объём уменьшается на 1/PRESSURE_SHRINK или на объём,
+   превышающий ограничение контрольной группы. Если нехватки памяти нет в
+   течение PRESSURE_RECOVER проверок, объём увеличивается на 1/PRESSURE_GROW
+   от максимального при каждой следующей проверке. */
+static void
+hyscan_cached_pressure_task (HyScanCached         *cached,
+                             HyScanCachedPressure *pressure,
+                             guint                *relaxed)
+{
+  HyScanCachedPrivate *priv = cached->priv;
+  guint64 min_limit = priv->cache_size / PRESSURE_MIN_LIMIT;
+  guint64 excess;
+  guint64 limit;
+
+  if (hyscan_cached_pressure_check (pressure, &excess))
+    {
+      *relaxed = 0;
+
+      g_rw_lock_writer_lock (&priv->data_lock);
+
+      limit = MIN (priv->limit, priv->used_size);
+      excess = MAX (excess, limit / PRESSURE_SHRINK);
+      priv->limit = (limit > min_limit + excess) ? limit - excess : min_limit;
+      limit = priv->limit;
+
+      g_rw_lock_writer_unlock (&priv->data_lock);
+
+      hyscan_cached_shrink (cached, limit);
+      hyscan_cached_release_memory (priv);
+    }
+  else if (++(*relaxed) >= PRESSURE_RECOVER)
+    {
+      g_rw_lock_writer_lock (&priv->data_lock);
+
+      priv->limit = MIN (priv->limit + priv->cache_size / PRESSURE_GROW, priv->cache_size);
+
+      g_rw_lock_writer_unlock (&priv->data_lock);
+    }
+}
+
+/**
+ * hyscan_cached_new:
+ * @cache_size: максимальный объём памяти, Мб
+ *
+ * Функция создаёт новый объект #HyScanCached.
+ *
+ * Returns: #HyScanCached. Для удаления #g_object_unref.
+ */
+HyScanCached *
+hyscan_cached_new (guint32 cache_size)
+{
+  return g_object_new (HYSCAN_TYPE_CACHED, "cache-size", cache_size, NULL);
+}
+
+/**
+ * hyscan_cached_new_full:
+ * @cache_size: максимальный объём памяти, Мб
+ * @memory: способ выделения памяти
+ *
+ * Функция создаёт новый объект #HyScanCached с указанным способом выделения
+ * памяти для объектов. Если арену на больших страницах создать не удалось,
+ * память выделяется для каждого объекта отдельно.
+ *
+ * Returns: #HyScanCached. Для удаления #g_object_unref.
+ */
+HyScanCached *
+hyscan_cached_new_full (guint32            cache_size,
+                        HyScanCachedMemory memory)
+{
+  return g_object_new (HYSCAN_TYPE_CACHED, "cache-size", cache_size, "memory", memory, NULL);
+}
+
+/**
+ * hyscan_cached_set_evict_func:
+ * @cached: указатель на #HyScanCached
+ * @func: (nullable): функция обработки удаления объектов
+ * @user_data: пользовательские данные
+ * @destroy: (nullable): функция удаления пользовательских данных
+ *
+ * Функция устанавливает функцию обработки удаления объектов из кэша.
+ * Функция обработки вызывается после завершения операции, во время
+ * которой объекты были удалены, в потоке, выполнявшем эту операцию.
+ * Для отключения обработки необходимо передать func = NULL.
+ *
+ * Перед удалением пользовательских данных предыдущей функции обработки
+ * ожидается завершение её выполняющихся вызовов, поэтому изменять функцию
+ * обработки из неё самой нельзя.
+ */
+void
+hyscan_cached_set_evict_func (HyScanCached          *cached,
+                              HyScanCachedEvictFunc  func,
+                              gpointer               user_data,
+                              GDestroyNotify         destroy)
+{
+  HyScanCachedPrivate *priv;
+  EvictHandler *handler = NULL;
+  EvictHandler *old_handler;
+
+  g_return_if_fail (HYSCAN_IS_CACHED (cached));
+
+  priv = cached->priv;
+
+  if (func != NULL)
+    {
+      handler = g_new0 (EvictHandler, 1);
+      handler->func = func;
+      handler->data = user_data;
+      handler->destroy = destroy;
+    }
+
+  g_mutex_lock (&priv->evict_lock);
+
+  /* Наличие функции обработки проверяется при удалении объектов. */
+  g_rw_lock_writer_lock (&priv->data_lock);
+  old_handler = priv->evict_handler;
+  priv->evict_handler = handler;
+  g_rw_lock_writer_unlock (&priv->data_lock);
+
+  /* Ожидаем завершения вызовов предыдущей функции обработки. Новые
+     вызовы выполняются с новой функцией и не задерживают замену. */
+  while (old_handler != NULL && old_handler->calls > 0)
+    g_cond_wait (&priv->evict_cond, &priv->evict_lock);
+
+  g_mutex_unlock (&priv->evict_lock);
+
+  if (old_handler == NULL)
+    return;
+
+  if (old_handler->destroy != NULL)
+    old_handler->destroy (old_handler->data);
+
+  g_free (old_handler);
+}
+
+/**
+ * hyscan_cached_set_pressure_monitor:
+ * @cached: указатель на #HyScanCached
+ * @enable: включить или выключить отслеживание
+ *
+ * Функция включает или выключает отслеживание нехватки памяти в системе.
+ * Нехватка памяти определяется по информации Linux PSI и ограничениям
+ * контрольной группы (cgroup v2) memory.high и memory.max. При выключении
+ * отслеживания допустимый объём данных в кэше восстанавливается.
+ *
+ * Returns: %TRUE если отслеживание нехватки памяти возможно, иначе %FALSE.
+ */
+gboolean
+hyscan_cached_set_pressure_monitor (HyScanCached *cached,
+                                    gboolean      enable)
+{
+  HyScanCachedPrivate *priv;
+  HyScanCachedPressure *pressure;
+
+  g_return_val_if_fail (HYSCAN_IS_CACHED (cached), FALSE);
+
+  priv = cached->priv;
+
+  /* Проверяем доступность информации о нехватке памяти. */
+  pressure = hyscan_cached_pressure_new ();
+  if (enable && pressure == NULL)
+    {
+      g_warning ("HyScanCached: memory pressure information is not available");
+      return FALSE;
+    }
+  hyscan_cached_pressure_free (pressure);
+
+  g_mutex_lock (&priv->service_lock);
+
+  priv->pressure_monitor = enable;
+  if (enable)
+    hyscan_cached_service_start (cached);
+  g_cond_signal (&priv->service_cond);
+
+  g_mutex_unlock (&priv->service_lock);
+
+  return TRUE;
+}
+
+/**
+ * hyscan_cached_set_watermarks:
+ * @cached: указатель на #HyScanCached
+ * @low: нижняя граница объёма данных
+ * @high: верхняя граница объёма данных
+ *
+ * Функция включает удаление объектов в потоке обслуживания кэша. Границы
+ * задаются как доля от допустимого объёма данных и должны удовлетворять
+ * условию 0 < low < high <= 1. Когда объём данных превышает верхнюю
+ * границу, давно использованные объекты удаляются до нижней границы.
+ * Для выключения необходимо передать high = 0.
+ *
+ * Returns: %TRUE если границы установлены, иначе %FALSE.
+ */
+gboolean
+hyscan_cached_set_watermarks (HyScanCached *cached,
+                              gdouble       low,
+                              gdouble       high)
+{
+  HyScanCachedPrivate *priv;
+
+  g_return_val_if_fail (HYSCAN_IS_CACHED (cached), FALSE);
+
+  priv = cached->priv;
+
+  if (high != 0.0 && (low <= 0.0 || low >= high || high > 1.0))
+    {
+      g_warning ("HyScanCached: invalid watermarks %.3f, %.3f", low, high);
+      return FALSE;
+    }
+
+  g_rw_lock_writer_lock (&priv->data_lock);
+  priv->low_watermark = low;
+  priv->high_watermark = high;
+  g_rw_lock_writer_unlock (&priv->data_lock);
+
+  g_mutex_lock (&priv->service_lock);
+  if (high != 0.0)
+    hyscan_cached_service_start (cached);
+  g_cond_signal (&priv->service_cond);
+  g_mutex_unlock (&priv->service_lock);
+
+  return TRUE;
+}
+
+/**
+ * hyscan_cached_set_checksums:
+ * @cached: указатель на #HyScanCached
+ * @enable: признак вычисления контрольных сумм
+ *
+ * Функция включает вычисление контрольных сумм данных объектов при записи.
+ * Контрольная сумма проверяется при чтении объекта целиком, при её
+ * несовпадении объект считается отсутствующим и удаляется из кэша с
+ * причиной #HYSCAN_CACHED_EVICT_CORRUPTED. При чтении части данных
+ * объекта контрольная сумма не проверяется. Режим влияет только на
+ * объекты, записанные после его изменения.
+ */
+void
+hyscan_cached_set_checksums (HyScanCached *cached,
+                             gboolean      enable)
+{
+  g_return_if_fail (HYSCAN_IS_CACHED (cached));
+
+  g_atomic_int_set (&cached->priv->checksums, enable ? 1 : 0);
+}
+
+/**
+ * hyscan_cached_set_scrub_rate:
+ * @cached: указатель на #HyScanCached
+ * @rate: объём проверяемых данных в секунду, Мб
+ *
+ * Функция включает фоновую проверку контрольных сумм всех объектов кэша в
+ * потоке обслуживания. Проверка выполняется только в те периоды, когда
+ * кэш используется мало, и не более rate мегабайт данных в секунду.
+ * Повреждённые объекты удаляются из кэша. Для выключения необходимо
+ * передать rate = 0.
+ */
+void
+hyscan_cached_set_scrub_rate (HyScanCached *cached,
+                              guint         rate)
+{
+  HyScanCachedPrivate *priv;
+
+  g_return_if_fail (HYSCAN_IS_CACHED (cached));
+
+  priv = cached->priv;
+
+  g_mutex_lock (&priv->service_lock);
+  priv->scrub_rate = rate;
+  if (rate > 0)
+    hyscan_cached_service_start (cached);
+  g_cond_signal (&priv->service_cond);
+  g_mutex_unlock (&priv->service_lock);
+}
+
+/* Функция изменяет первый байт данных объекта, не изменяя его контрольную
+   сумму. Функция используется только при проверке обнаружения повреждения
+   данных, её объявление находится в hyscan-cached-test.h. */
+gboolean
+hyscan_cached_corrupt (HyScanCached *cached,
+                       const gchar  *key)
+{
+  HyScanCachedPrivate *priv;
+  ObjectInfo *object;
+  gboolean status = FALSE;
+  guint64 hash;
+
+  g_return_val_if_fail (HYSCAN_IS_CACHED (cached), FALSE);
+  g_return_val_if_fail (key != NULL, FALSE);
+
+  priv = cached->priv;
+  hash = hyscan_hash64 (key);
+
+  g_rw_lock_writer_lock (&priv->data_lock);
+
+  object = g_hash_table_lookup (priv->objects, &hash);
+  if (object != NULL && object->size > 0)
+    {
+      object->data[0] ^= 0xff;
+      status = TRUE;
+    }
+
+  g_rw_lock_writer_unlock (&priv->data_lock);
+
+  return status;
+}
+
+/**
+ * hyscan_cached_set_key_verification:
+ * @cached: указатель на #HyScanCached
+ * @enable: признак проверки ключей
+ *
+ * Функция включает сохранение строк ключей объектов, записываемых функцией
+ * #hyscan_cache_set128. При чтении таких объектов функцией
+ * #hyscan_cache_get128 строка ключа сравнивается с сохранённой, и при
+ * несовпадении объект считается отсутствующим. Режим влияет только на
+ * объекты, записанные после его изменения. Строка ключа занимает память
+ * кэша наравне с данными объекта.
+ */
+void
+hyscan_cached_set_key_verification (HyScanCached *cached,
+                                    gboolean      enable)
+{
+  g_return_if_fail (HYSCAN_IS_CACHED (cached));
+
+  g_atomic_int_set (&cached->priv->verify_keys, enable ? 1 : 0);
+}
+
+/**
+ * hyscan_cached_set_scan_threshold:
+ * @cached: указатель на #HyScanCached
+ * @threshold: число промахов подряд
+ *
+ * Функция задаёт число промахов при чтении подряд, после которого
+ * чтение потоком считается последовательным просмотром данных. Новые
+ * объекты, записываемые этим потоком, помещаются в конец списка
+ * используемых. Промахи учитываются отдельно для каждого потока и кэша.
+ *
+ * При доступе через #HyScanCacheServer чтение выполняют потоки сервера,
+ * поэтому промахи клиентов, обслуживаемых одним потоком, учитываются вместе.
+ *
+ * По умолчанию обнаружение выключено. Для выключения обнаружения необходимо
+ * передать threshold = 0.
+ */
+void
+hyscan_cached_set_scan_threshold (HyScanCached *cached,
+                                  guint         threshold)
+{
+  g_return_if_fail (HYSCAN_IS_CACHED (cached));
+
+  hyscan_cached_scan_set_threshold (cached->priv->scan, threshold);
+}
+
+/* Функция задаёт внешнее состояние обнаружения просмотра. Результаты чтения
+   в этом состоянии учитывает его владелец, кэш только использует его при
+   записи объектов. Функция вызывается до начала работы с кэшем. */
+void
+hyscan_cached_set_scan (HyScanCached     *cached,
+                        HyScanCachedScan *scan)
+{
+  HyScanCachedPrivate *priv;
+
+  g_return_if_fail (HYSCAN_IS_CACHED (cached));
+
+  priv = cached->priv;
+
+  if (priv->scan_owner)
+    hyscan_cached_scan_free (priv->scan);
+
+  priv->scan = scan;
+  priv->scan_owner = FALSE;
+}
+
+/**
+ * hyscan_cached_save:
+ * @cached: указатель на #HyScanCached
+ * @file_name: имя файла
+ *
+ * Функция сохраняет все объекты кэша в файл. Объекты записываются
+ * последовательно в порядке от недавно использованных к давно
+ * использованным. Данные сначала записываются во временный файл,
+ * который заменяет указанный файл после успешной записи. Во время
+ * сохранения запись в кэш блокируется, чтение объектов не блокируется.
+ *
+ * Returns: %TRUE если данные сохранены, иначе %FALSE.
+ */
+gboolean
+hyscan_cached_save (HyScanCached *cached,
+                    const gchar  *file_name)
+{
+  HyScanCachedPrivate *priv;
+
+  SnapshotHeader header;
+  ObjectInfo *object;
+  GPtrArray *list;
+  gchar *tmp_name;
+  gchar *buffer;
+  FILE *file;
+  guint i;
+
+  gboolean status = FALSE;
+
+  g_return_val_if_fail (HYSCAN_IS_CACHED (cached), FALSE);
+  g_return_val_if_fail (file_name != NULL, FALSE);
+
+  priv = cached->priv;
+
+  tmp_name = g_strdup_printf ("%s.tmp", file_name);
+  file = g_fopen (tmp_name, "wb");
+  if (file == NULL)
+    {
+      g_warning ("HyScanCached: can't create file '%s'", tmp_name);
+      g_free (tmp_name);
+      return FALSE;
+    }
+
+  /* Большой буфер, чтобы запись велась последовательно крупными блоками. */
+  buffer = g_malloc (SNAPSHOT_BUFFER);
+  setvbuf (file, buffer, _IOFBF, SNAPSHOT_BUFFER);
+
+  /* Блокировка чтения запрещает изменение и удаление объектов, но не их
+   * чтение. Порядок объектов изменяется при чтении, поэтому он копируется
+   * при захваченной блокировке списка. */
+  g_rw_lock_reader_lock (&priv->data_lock);
+
+  list = g_ptr_array_sized_new (g_hash_table_size (priv->objects));
+  g_rw_lock_reader_lock (&priv->list_lock);
+  for (object = priv->top_object; object != NULL; object = object->next)
+    g_ptr_array_add (list, object);
+  g_rw_lock_reader_unlock (&priv->list_lock);
+
+  header.magic = GUINT64_TO_LE (SNAPSHOT_MAGIC);
+  header.version = GUINT32_TO_LE (SNAPSHOT_VERSION);
+  header.reserved = 0;
+  header.n_objects = GUINT64_TO_LE (list->len);
+
+  if (fwrite (&header, sizeof (header), 1, file) != 1)
+    goto exit;
+
+  for (i = 0; i < list->len; i++)
+    {
+      static const gchar padding[8] = {0};
+      SnapshotRecord record;
+      gsize padding_size;
+      gsize size;
+
+      object = g_ptr_array_index (list, i);
+
+      record.hash = GUINT64_TO_LE (object->hash);
+      record.hash_hi = GUINT64_TO_LE (object->hash_hi);
+      record.detail = GUINT64_TO_LE (object->detail);
+      record.size = GUINT32_TO_LE (object->size);
+      record.key_size = GUINT32_TO_LE (object->key_size);
+      size = (gsize) object->size + object->key_size;
+      padding_size = SNAPSHOT_ALIGN (size) - size;
+
+      if (fwrite (&record, sizeof (record), 1, file) != 1)
+        goto exit;
+      if (size > 0 && fwrite (object->data, size, 1, file) != 1)
+        goto exit;
+      if (padding_size > 0 && fwrite (padding, padding_size, 1, file) != 1)
+        goto exit;
+    }
+
+  status = TRUE;
+
+exit:
+  g_rw_lock_reader_unlock (&priv->data_lock);
+  g_ptr_array_unref (list);
+
+  if (fclose (file) != 0)
+    status = FALSE;
+
+  g_free (buffer);
+
+  if (status && g_rename (tmp_name, file_name) != 0)
+    status = FALSE;
+
+  if (!status)
+    {
+      g_warning ("HyScanCached: can't write file '%s'", file_name);
+      g_unlink (tmp_name);
+    }
+
+  g_free (tmp_name);
+
+  return status;
+}
+
+/**
+ * hyscan_cached_load:
+ * @cached: указатель на #HyScanCached
+ * @file_name: имя файла
+ *
+ * Функция загружает объекты из файла, созданного функцией
+ * #hyscan_cached_save. Файл отображается в память, а объекты
+ * восстанавливаются параллельно в нескольких потоках. Загруженные
+ * объекты размещаются после объектов, уже находящихся в кэше, а
+ * объекты с совпадающими ключами не загружаются. Если объём кэша
+ * недостаточен, загружаются только недавно использованные объекты.
+ * Во время загрузки доступ к кэшу блокируется.
+ *
+ * Returns: %TRUE если данные загружены, иначе %FALSE.
+ */
+gboolean
+hyscan_cached_load (HyScanCached *cached,
+                    const gchar  *file_name)
+{
+  HyScanCachedPrivate *priv;
+
+  GMappedFile *mapped;
+  GError *error = NULL;
+  const SnapshotHeader *header;
+  const gchar *contents;
+  gsize length;
+
+  guint64 *offsets = NULL;
+  ObjectInfo **objects = NULL;
+  SnapshotTask *tasks = NULL;
+  GThread **threads = NULL;
+  guint64 n_objects;
+  guint64 n_loaded;
+  guint64 used_size;
+  guint64 offset;
+  guint64 i;
+  guint32 version;
+  gsize record_size;
+  guint n_threads;
+
+  gboolean truncated = FALSE;
+  gboolean status = FALSE;
+
+  g_return_val_if_fail (HYSCAN_IS_CACHED (cached), FALSE);
+  g_return_val_if_fail (file_name != NULL, FALSE);
+
+  priv = cached->priv;
+
+  mapped = g_mapped_file_new (file_name, FALSE, &error);
+  if (mapped == NULL)
+    {
+      g_warning ("HyScanCached: %s", error->message);
+      g_error_free (error);
+      return FALSE;
+    }
+
+  contents = g_mapped_file_get_contents (mapped);
+  length = g_mapped_file_get_length (mapped);
+
+  /* Проверка заголовка файла. */
+  header = (const SnapshotHeader *) contents;
+  if (length < sizeof (SnapshotHeader) ||
+      GUINT64_FROM_LE (header->magic) != SNAPSHOT_MAGIC)
+    {
+      g_warning ("HyScanCached: '%s' is not a cache snapshot", file_name);
+      goto exit;
+    }
+
+  /* Файлы версии 1 не содержат 128-ми битных ключей. */
+  version = GUINT32_FROM_LE (header->version);
+  if (version != 1 && version != SNAPSHOT_VERSION)
+    {
+      g_warning ("HyScanCached: unsupported snapshot version %u in '%s'", version, file_name);
+      goto exit;
+    }
+  record_size = (version == 1) ? sizeof (SnapshotRecordV1) : sizeof (SnapshotRecord);
+
+  n_objects = GUINT64_FROM_LE (header->n_objects);
+  if (n_objects > (length - sizeof (SnapshotHeader)) / record_size)
+    {
+      g_warning ("HyScanCached: '%s' is corrupted", file_name);
+      goto exit;
+    }
+
+  g_rw_lock_writer_lock (&priv->data_lock);
+
+  /* Находим объекты, которые поместятся в кэш. Объекты, превышающие
+   * максимально допустимый размер, пропускаются. */
+  offsets = g_new (guint64, n_objects + 1);
+  used_size = priv->used_size;
+  offset = sizeof (SnapshotHeader);
+  for (i = 0, n_loaded = 0; i < n_objects; i++)
+    {
+      SnapshotRecord record;
+      guint64 size;
+
+      if (length - offset < record_size)
+        {
+          truncated = TRUE;
+          break;
+        }
+
+      hyscan_cached_read_record (contents + offset, version, &record);
+      size = (guint64) record.size + record.key_size;
+      if (SNAPSHOT_ALIGN (size) > length - offset - record_size)
+        {
+          truncated = TRUE;
+          break;
+        }
+
+      if (record.size > 0 && record.key_size <= G_MAXUINT16 && size <= priv->cache_size / 10)
+        {
+          guint32 allocated = hyscan_cached_allocated_size (priv, size);
+
+          if (used_size + OBJECT_HEADER_SIZE + allocated > priv->limit)
+            break;
+
+          used_size += OBJECT_HEADER_SIZE + allocated;
+          offsets[n_loaded++] = offset;
+        }
+
+      offset += record_size + SNAPSHOT_ALIGN (size);
+    }
+
+  if (truncated)
+    g_warning ("HyScanCached: '%s' is truncated", file_name);
+
+  /* Выделяем память для объектов. Арена не допускает параллельного
+   * выделения памяти, поэтому оно выполняется до запуска потоков.
+   * Объекты кэша ради загружаемых не удаляются: если в арене не хватает
+   * памяти, оставшиеся объекты не загружаются. */
+  objects = g_new (ObjectInfo *, n_loaded + 1);
+  for (i = 0; i < n_loaded; i++)
+    {
+      SnapshotRecord record;
+
+      hyscan_cached_read_record (contents + offsets[i], version, &record);
+      objects[i] = hyscan_cached_alloc_object (priv, record.size + record.key_size, FALSE);
+      if (objects[i] == NULL)
+        {
+          n_loaded = i;
+          break;
+        }
+    }
+
+  /* Восстанавливаем объекты параллельно. */
+  n_threads = MIN (g_get_num_processors (), n_loaded / SNAPSHOT_MIN_TASK + 1);
+  tasks = g_new (SnapshotTask, n_threads);
+  threads = g_new0 (GThread *, n_threads);
+  for (i = 0; i < n_threads; i++)
+    {
+      tasks[i].contents = contents;
+      tasks[i].version = version;
+      tasks[i].checksums = g_atomic_int_get (&priv->checksums);
+      tasks[i].offsets = offsets;
+      tasks[i].objects = objects;
+      tasks[i].first = (n_loaded * i) / n_threads;
+      tasks[i].last = (n_loaded * (i + 1)) / n_threads;
+
+      if (i > 0)
+        threads[i] = g_thread_new ("cached-load", hyscan_cached_load_task, &tasks[i]);
+    }
+
+  hyscan_cached_load_task (&tasks[0]);
+  for (i = 1; i < n_threads; i++)
+    g_thread_join (threads[i]);
+
+  /* Добавляем объекты в таблицу и в конец списка используемых. */
+  for (i = 0; i < n_loaded; i++)
+    {
+      ObjectInfo *object = objects[i];
+
+      if (g_hash_table_contains (priv->objects, &object->hash))
+        {
+          hyscan_cached_free_object (priv, object);
+          continue;
+        }
+
+      priv->used_size += (OBJECT_HEADER_SIZE + object->allocated);
+      g_hash_table_insert (priv->objects, &object->hash, object);
+      hyscan_cached_place_object_on_bottom_of_used (priv, object);
+    }
+
+  g_rw_lock_writer_unlock (&priv->data_lock);
+
+  status = TRUE;
+
+exit:
+  g_mapped_file_unref (mapped);
+  g_free (threads);
+  g_free (tasks);
+  g_free (objects);
+  g_free (offsets);
+
+  return status;
+}
+
+/* Функция добавляет или изменяет объект в кэше. Данные объекта
+   собираются из нескольких буферов. Если задан идентификатор объекта
+   и включена проверка идентификаторов, он сохраняется после данных. */
+static gboolean
+hyscan_cached_store (HyScanCached  *cached,
+                     guint64        key,
+                     guint64        key_hi,
+                     const gchar   *key_string,
+                     guint64        detail,
+                     HyScanBuffer **buffers,
+                     guint          n_buffers)
+{
+  HyScanCachedPrivate *priv = cached->priv;
+
+  ObjectInfo *object;
+  GArray *evictions;
+  gboolean reclaim;
+  guint64 total_size;
+  guint32 key_size = 0;
+  guint32 size;
+  gboolean checksum;
+  gboolean scan = FALSE;
+  guint32 crc = 0;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  size = hyscan_cached_buffers_size (buffers, n_buffers);
+  if (key_string != NULL && g_atomic_int_get (&priv->verify_keys))
+    key_size = strlen (key_string);
+  if (key_size > G_MAXUINT16)
+    key_size = 0;
+  total_size = (guint64) size + key_size;
+
+  /* Контрольная сумма вычисляется до захвата блокировки. */
+  checksum = g_atomic_int_get (&priv->checksums);
+  if (checksum && size > 0)
+    {
+      guint i;
+
+      for (i = 0; i < n_buffers; i++)
+        {
+          gpointer part_data;
+          guint32 part = 0;
+
+          if (buffers[i] == NULL)
+            continue;
+
+          part_data = hyscan_buffer_get (buffers[i], NULL, &part);
+          if (part_data != NULL && part > 0)
+            crc = hyscan_cached_crc32c (crc, part_data, part);
+        }
+    }
+
+  /* Если размер нового объекта слишком большой, не сохраняем его. */
+  if (total_size > priv->cache_size / 10)
+    {
+      hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_REJECTED, 1);
+      return FALSE;
+    }
+
+  g_rw_lock_writer_lock (&priv->data_lock);
+
+  /* Ищем объект в кэше. */
+  object = g_hash_table_lookup (priv->objects, &key);
+
+  /* Если размер объекта равен нулю, удаляем объект. */
+  if (size == 0)
+    {
+      if (object != NULL)
+        hyscan_cached_drop_object (priv, object, HYSCAN_CACHED_EVICT_REMOVED);
+
+      goto exit;
+    }
+
+  /* Очищаем кэш если достигнут лимит используемой памяти. */
+  if (priv->used_size + OBJECT_HEADER_SIZE + total_size > priv->limit)
+    {
+      hyscan_cached_free_used (priv, OBJECT_HEADER_SIZE + total_size);
+      object = g_hash_table_lookup (priv->objects, &key);
+    }
+
+  /* Если объект уже был в кэше, изменяем его. */
+  if (object != NULL)
+    {
+      hyscan_cached_remove_object_from_used (priv, object);
+      object = hyscan_cached_update_object (priv, object, detail, buffers, n_buffers, total_size);
+    }
+
+  /* Если объекта в кэше не было, создаём новый и добавляем в кэш. */
+  else
     {
-      object = hyscan_cached_rise_object (priv, key, detail, data1, size1, data2, size2);
+      object = hyscan_cached_rise_object (priv, key, detail, buffers, n_buffers, total_size);
       g_hash_table_insert (priv->objects, &object->hash, object);
+      scan = hyscan_cached_scan_detected (priv->scan);
     }
 
-  /* Перемещаем объект в начало списка используемых. */
-  hyscan_cached_place_object_on_top_of_used (priv, object);
+  /* Идентификатор объекта. */
+  object->size = size;
+  object->hash_hi = key_hi;
+  object->key_size = key_size;
+  if (key_size > 0)
+    memcpy (object->data + size, key_string, key_size);
+
+  /* Контрольная сумма данных. */
+  object->crc = crc;
+  object->flags = checksum ? (object->flags | OBJECT_FLAG_CRC) : (object->flags & ~OBJECT_FLAG_CRC);
+
+  /* Перемещаем объект в начало списка используемых. Новые объекты при
+     последовательном просмотре помещаются в конец списка. */
+  if (scan)
+    hyscan_cached_place_object_on_bottom_of_used (priv, object);
+  else
+    hyscan_cached_place_object_on_top_of_used (priv, object);
 
 exit:
+  evictions = hyscan_cached_take_evictions (priv);
+  reclaim = (priv->high_watermark > 0.0 && priv->used_size > priv->limit * priv->high_watermark);
+
   g_rw_lock_writer_unlock (&priv->data_lock);
 
+  hyscan_cached_notify_evictions (cached, evictions);
+
+  /* Будим поток обслуживания для удаления объектов. */
+  if (reclaim)
+    hyscan_cached_reclaim_wakeup (priv);
+
+  /* Удаление объекта не учитывается как запись. */
+  if (size > 0)
+    hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_SETS, 1);
+  hyscan_cache_counters_add_latency (priv->counters,
+                                     HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_OP_SET * HYSCAN_CACHE_STATS_N_BINS,
+                                     start);
+
   return TRUE;
 }
 
-/* Функция считывает объект из кэша. */
+/* Функция добавляет или изменяет объект в кэше. Данные объекта
+   собираются из нескольких буферов. */
 static gboolean
-hyscan_cached_get (HyScanCache  *cache,
+hyscan_cached_setv (HyScanCache   *cache,
+                    guint64        key,
+                    guint64        detail,
+                    HyScanBuffer **buffers,
+                    guint          n_buffers)
+{
+  return hyscan_cached_store (HYSCAN_CACHED (cache), key, 0, NULL, detail, buffers, n_buffers);
+}
+
+/* Функция добавляет или изменяет объект в кэше. */
+static gboolean
+hyscan_cached_set (HyScanCache  *cache,
                    guint64       key,
                    guint64       detail,
-                   guint32       size1,
                    HyScanBuffer *buffer1,
                    HyScanBuffer *buffer2)
+{
+  HyScanBuffer *buffers[2] = { buffer1, buffer2 };
+
+  return hyscan_cached_setv (cache, key, detail, buffers, 2);
+}
+
+/* Функция добавляет или изменяет объект в кэше по 128-ми битному ключу. */
+static gboolean
+hyscan_cached_set128 (HyScanCache  *cache,
+                      guint64       key_lo,
+                      guint64       key_hi,
+                      const gchar  *key,
+                      guint64       detail,
+                      HyScanBuffer *buffer1,
+                      HyScanBuffer *buffer2)
+{
+  HyScanBuffer *buffers[2] = { buffer1, buffer2 };
+
+  return hyscan_cached_store (HYSCAN_CACHED (cache), key_lo, key_hi, key, detail, buffers, 2);
+}
+
+/* Функция добавляет данные в конец объекта. */
+static gboolean
+hyscan_cached_append (HyScanCache  *cache,
+                      guint64       key,
+                      guint64       detail,
+                      HyScanBuffer *buffer)
 {
   HyScanCached *cached = HYSCAN_CACHED (cache);
   HyScanCachedPrivate *priv = cached->priv;
 
   gboolean status = FALSE;
   ObjectInfo *object;
-  guint32 size2 = 0;
+  GArray *evictions;
+  gboolean reclaim;
 
-  /* Проверка буферов. */
-  if (buffer1 == NULL && buffer2 != NULL)
+  gpointer data;
+  guint32 size;
+  guint64 max_size = MIN (priv->cache_size / 10, G_MAXUINT32);
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  data = hyscan_buffer_get (buffer, NULL, &size);
+  if (size == 0)
+    return TRUE;
+
+  if (size > max_size)
+    {
+      hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_REJECTED, 1);
+      return FALSE;
+    }
+
+  g_rw_lock_writer_lock (&priv->data_lock);
+
+  /* Ищем объект в кэше. */
+  object = g_hash_table_lookup (priv->objects, &key);
+
+  /* Данные объекта с другой дополнительной информацией устарели,
+     объект заменяется добавляемыми данными. */
+  if (object != NULL && detail != 0 && object->detail != detail)
+    {
+      hyscan_cached_drop_object (priv, object, HYSCAN_CACHED_EVICT_REMOVED);
+      object = NULL;
+    }
+
+  /* Если объекта нет, создаём его из добавляемых данных. */
+  if (object == NULL)
+    {
+      if (priv->used_size + OBJECT_HEADER_SIZE + size > priv->limit)
+        hyscan_cached_free_used (priv, OBJECT_HEADER_SIZE + size);
+
+      object = hyscan_cached_rise_object (priv, key, detail, &buffer, 1, size);
+      g_hash_table_insert (priv->objects, &object->hash, object);
+
+      if (g_atomic_int_get (&priv->checksums))
+        {
+          object->crc = hyscan_cached_crc32c (0, data, size);
+          object->flags |= OBJECT_FLAG_CRC;
+        }
+    }
+
+  /* Объект есть в кэше, дописываем данные в его конец. */
+  else
+    {
+      guint64 new_size = (guint64) object->size + size;
+
+      /* Размер объекта превысит допустимый, удаляем его. */
+      if (new_size > max_size)
+        {
+          hyscan_cached_drop_object (priv, object, HYSCAN_CACHED_EVICT_REMOVED);
+          hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_REJECTED, 1);
+          goto exit;
+        }
+
+      /* Объект убирается из списка используемых, чтобы он не был удалён при очистке кэша. */
+      hyscan_cached_remove_object_from_used (priv, object);
+
+      /* Сохранённый идентификатор объекта затирается добавляемыми данными. */
+      object->key_size = 0;
+
+      /* Память выделяется с запасом, чтобы последующие добавления не требовали
+         копирования объекта. */
+      if (object->allocated < new_size)
+        {
+          guint32 alloc_size = MIN (MAX (new_size, (guint64) object->allocated * 3 / 2), max_size);
+          guint32 delta = hyscan_cached_allocated_size (priv, alloc_size) - object->allocated;
+
+          if (priv->used_size + delta > priv->limit)
+            hyscan_cached_free_used (priv, delta);
+
+          g_hash_table_steal (priv->objects, &object->hash);
+          priv->used_size -= (OBJECT_HEADER_SIZE + object->allocated);
+
+          object = hyscan_cached_realloc_object (priv, object, alloc_size, TRUE);
+
+          priv->used_size += (OBJECT_HEADER_SIZE + object->allocated);
+          g_hash_table_insert (priv->objects, &object->hash, object);
+        }
+
+      memcpy ((gint8*) object->data + object->size, data, size);
+      object->size = new_size;
+
+      /* Контрольная сумма продолжается по добавленным данным. */
+      if (object->flags & OBJECT_FLAG_CRC)
+        object->crc = hyscan_cached_crc32c (object->crc, data, size);
+    }
+
+  /* Перемещаем объект в начало списка используемых. */
+  hyscan_cached_place_object_on_top_of_used (priv, object);
+
+  status = TRUE;
+
+exit:
+  evictions = hyscan_cached_take_evictions (priv);
+  reclaim = (priv->high_watermark > 0.0 && priv->used_size > priv->limit * priv->high_watermark);
+
+  g_rw_lock_writer_unlock (&priv->data_lock);
+
+  hyscan_cached_notify_evictions (cached, evictions);
+
+  if (reclaim)
+    hyscan_cached_reclaim_wakeup (priv);
+
+  if (status)
+    hyscan_cache_counters_add (priv->counters, HYSCAN_CACHE_COUNTER_SETS, 1);
+  hyscan_cache_counters_add_latency (priv->counters,
+                                     HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_OP_APPEND * HYSCAN_CACHE_STATS_N_BINS,
+                                     start);
+
+  return status;
+}
+
+/* Функция проверяет совпадение 128-ми битного ключа объекта. Сохранённый
+   идентификатор объекта сравнивается, если он есть у объекта и задан
+   при чтении. */
+static inline gboolean
+hyscan_cached_match_key (ObjectInfo  *object,
+                         guint64      key_hi,
+                         const gchar *key_string)
+{
+  if (object->hash_hi != key_hi)
     return FALSE;
 
+  if (object->key_size == 0 || key_string == NULL)
+    return TRUE;
+
+  return (strncmp (key_string, (const gchar *) object->data + object->size, object->key_size) == 0 &&
+          key_string[object->key_size] == '\0');
+}
+
+/* Функция считывает объект из кэша. Данные объекта последовательно
+   распределяются по буферам: в буфер i записывается не более sizes[i] байт,
+   в последний буфер записываются оставшиеся данные. Если задана старшая
+   половина ключа key_hi, проверяется совпадение 128-ми битного ключа. */
+static gboolean
+hyscan_cached_fetch (HyScanCached   *cached,
+                     guint64         key,
+                     const guint64  *key_hi,
+                     const gchar    *key_string,
+                     guint64         detail,
+                     const guint32  *sizes,
+                     HyScanBuffer  **buffers,
+                     guint           n_buffers)
+{
+  HyScanCachedPrivate *priv = cached->priv;
+
+  gboolean status = FALSE;
+  gboolean corrupted = FALSE;
+  ObjectInfo *object;
+  guint32 offset = 0;
+  guint counter;
+  guint i;
+
+  gint64 start = hyscan_cache_counters_now ();
+
   g_rw_lock_reader_lock (&priv->data_lock);
 
   /* Ищем объект в кэше. */
   object = g_hash_table_lookup (priv->objects, &key);
 
-  /* Объекта в кэше нет. */
+  /* Объекта в кэше нет или совпадает только младшая половина ключа. */
+  counter = HYSCAN_CACHE_COUNTER_MISSES;
   if (object == NULL)
     goto exit;
+  if (key_hi != NULL && !hyscan_cached_match_key (object, *key_hi, key_string))
+    goto exit;
 
   /* Не совпадает дополнительная информация. */
+  counter = HYSCAN_CACHE_COUNTER_DETAIL_MISMATCHES;
   if (detail != 0 && object->detail != detail)
     goto exit;
 
+  /* Данные объекта повреждены. */
+  counter = HYSCAN_CACHE_COUNTER_MISSES;
+  if ((object->flags & OBJECT_FLAG_CRC) &&
+      hyscan_cached_crc32c (0, object->data, object->size) != object->crc)
+    {
+      corrupted = TRUE;
+      goto exit;
+    }
+
+  counter = HYSCAN_CACHE_COUNTER_HITS;
+
   /* Перемещаем объект в начало списка используемых. */
   hyscan_cached_place_object_on_top_of_used (priv, object);
 
-  /* Копируем первую часть данных объекта. */
-  size1 = MIN (size1, object->size);
-  if ((buffer1 != NULL))
+  /* Копируем данные объекта. */
+  for (i = 0; i < n_buffers; i++)
     {
+      guint32 part = object->size - offset;
       gpointer data;
 
-      if (!hyscan_buffer_set_data_size (buffer1, size1))
-        goto exit;
+      if (i + 1 < n_buffers)
+        part = MIN (part, sizes[i]);
 
-      data = hyscan_buffer_get (buffer1, NULL, &size1);
-      memcpy (data, object->data, size1);
+      if (buffers[i] != NULL)
+        {
+          if (!hyscan_buffer_set_data_size (buffers[i], part))
+            goto exit;
+
+          data = hyscan_buffer_get (buffers[i], NULL, &part);
+          memcpy (data, object->data + offset, part);
+        }
+
+      offset += part;
     }
 
-  /* Копируем вторую часть данных объекта. */
-  size2 = object->size - size1;
-  if (buffer2 != NULL)
-    {
-      gpointer data;
+  status = TRUE;
 
-      if (!hyscan_buffer_set_data_size (buffer2, size2))
-        goto exit;
+exit:
+  g_rw_lock_reader_unlock (&priv->data_lock);
 
-      data = hyscan_buffer_get (buffer2, NULL, &size2);
-      memcpy (data, object->data + size1, size2);
-    }
+  if (corrupted)
+    hyscan_cached_drop_corrupted (cached, key);
+
+  if (priv->scan_owner)
+    hyscan_cached_scan_update (priv->scan, counter == HYSCAN_CACHE_COUNTER_HITS);
+
+  hyscan_cache_counters_add (priv->counters, counter, 1);
+  hyscan_cache_counters_add_latency (priv->counters,
+                                     HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_OP_GET * HYSCAN_CACHE_STATS_N_BINS,
+                                     start);
+
+  return status;
+}
+
+/* Функция считывает объект из кэша в несколько буферов. */
+static gboolean
+hyscan_cached_getv (HyScanCache    *cache,
+                    guint64         key,
+                    guint64         detail,
+                    const guint32  *sizes,
+                    HyScanBuffer  **buffers,
+                    guint           n_buffers)
+{
+  return hyscan_cached_fetch (HYSCAN_CACHED (cache), key, NULL, NULL, detail, sizes, buffers, n_buffers);
+}
+
+/* Функция считывает объект из кэша. */
+static gboolean
+hyscan_cached_get (HyScanCache  *cache,
+                   guint64       key,
+                   guint64       detail,
+                   guint32       size1,
+                   HyScanBuffer *buffer1,
+                   HyScanBuffer *buffer2)
+{
+  HyScanBuffer *buffers[2] = { buffer1, buffer2 };
+
+  /* Проверка буферов. */
+  if (buffer1 == NULL && buffer2 != NULL)
+    return FALSE;
+
+  return hyscan_cached_getv (cache, key, detail, &size1, buffers, 2);
+}
+
+/* Функция считывает объект из кэша по 128-ми битному ключу. */
+static gboolean
+hyscan_cached_get128 (HyScanCache  *cache,
+                      guint64       key_lo,
+                      guint64       key_hi,
+                      const gchar  *key,
+                      guint64       detail,
+                      guint32       size1,
+                      HyScanBuffer *buffer1,
+                      HyScanBuffer *buffer2)
+{
+  HyScanBuffer *buffers[2] = { buffer1, buffer2 };
+
+  /* Проверка буферов. */
+  if (buffer1 == NULL && buffer2 != NULL)
+    return FALSE;
+
+  return hyscan_cached_fetch (HYSCAN_CACHED (cache), key_lo, &key_hi, key, detail, &size1, buffers, 2);
+}
+
+/* Функция считывает часть данных объекта из кэша. */
+static gboolean
+hyscan_cached_get_range (HyScanCache  *cache,
+                         guint64       key,
+                         guint64       detail,
+                         guint32       offset,
+                         guint32       size,
+                         HyScanBuffer *buffer)
+{
+  HyScanCached *cached = HYSCAN_CACHED (cache);
+  HyScanCachedPrivate *priv = cached->priv;
+
+  gboolean status = FALSE;
+  ObjectInfo *object;
+  gpointer data;
+  guint counter;
+
+  gint64 start = hyscan_cache_counters_now ();
+
+  g_rw_lock_reader_lock (&priv->data_lock);
+
+  /* Ищем объект в кэше. */
+  object = g_hash_table_lookup (priv->objects, &key);
+
+  /* Объекта в кэше нет. */
+  counter = HYSCAN_CACHE_COUNTER_MISSES;
+  if (object == NULL)
+    goto exit;
+
+  /* Не совпадает дополнительная информация. */
+  counter = HYSCAN_CACHE_COUNTER_DETAIL_MISMATCHES;
+  if (detail != 0 && object->detail != detail)
+    goto exit;
+
+  /* Смещение за пределами объекта, запрошенных данных в кэше нет. */
+  counter = HYSCAN_CACHE_COUNTER_MISSES;
+  if (offset > object->size)
+    goto exit;
+
+  counter = HYSCAN_CACHE_COUNTER_HITS;
+
+  /* Перемещаем объект в начало списка используемых. */
+  hyscan_cached_place_object_on_top_of_used (priv, object);
+
+  /* Копируем запрошенную часть данных. */
+  size = MIN (size, object->size - offset);
+  if (!hyscan_buffer_set_data_size (buffer, size))
+    goto exit;
+
+  data = hyscan_buffer_get (buffer, NULL, &size);
+  memcpy (data, object->data + offset, size);
 
   status = TRUE;
 
 exit:
   g_rw_lock_reader_unlock (&priv->data_lock);
 
+  hyscan_cache_counters_add (priv->counters, counter, 1);
+  hyscan_cache_counters_add_latency (priv->counters,
+                                     HYSCAN_CACHE_COUNTER_LATENCY + HYSCAN_CACHE_OP_GET * HYSCAN_CACHE_STATS_N_BINS,
+                                     start);
+
   return status;
 }
 
+/* Функция возвращает информацию об объекте. Положение объекта в списке
+   используемых не изменяется. */
+static gboolean
+hyscan_cached_query (HyScanCache *cache,
+                     guint64      key,
+                     guint64     *detail,
+                     guint32     *size)
+{
+  HyScanCached *cached = HYSCAN_CACHED (cache);
+  HyScanCachedPrivate *priv = cached->priv;
+  ObjectInfo *object;
+
+  g_rw_lock_reader_lock (&priv->data_lock);
+
+  object = g_hash_table_lookup (priv->objects, &key);
+  if (object != NULL)
+    {
+      *detail = object->detail;
+      *size = object->size;
+    }
+
+  g_rw_lock_reader_unlock (&priv->data_lock);
+
+  return (object != NULL);
+}
+
+/* Функция проверяет наличие в кэше нескольких объектов. */
+static guint
+hyscan_cached_contains_batch (HyScanCache   *cache,
+                              const guint64 *keys,
+                              guint          n_keys,
+                              gboolean      *found)
+{
+  HyScanCached *cached = HYSCAN_CACHED (cache);
+  HyScanCachedPrivate *priv = cached->priv;
+  guint n_found = 0;
+  guint i;
+
+  g_rw_lock_reader_lock (&priv->data_lock);
+
+  for (i = 0; i < n_keys; i++)
+    {
+      gboolean present = g_hash_table_contains (priv->objects, &keys[i]);
+
+      if (found != NULL)
+        found[i] = present;
+      if (present)
+        n_found += 1;
+    }
+
+  g_rw_lock_reader_unlock (&priv->data_lock);
+
+  return n_found;
+}
+
+/* Функция возвращает статистику работы кэша. */
+static gboolean
+hyscan_cached_get_stats (HyScanCache      *cache,
+                         HyScanCacheStats *stats)
+{
+  HyScanCached *cached = HYSCAN_CACHED (cache);
+  HyScanCachedPrivate *priv = cached->priv;
+
+  hyscan_cache_counters_get_stats (priv->counters, stats);
+
+  g_rw_lock_reader_lock (&priv->data_lock);
+
+  stats->used_size = priv->used_size;
+  stats->max_size = priv->cache_size;
+  stats->n_objects = g_hash_table_size (priv->objects);
+
+  g_rw_lock_reader_unlock (&priv->data_lock);
+
+  return TRUE;
+}
+
 static void
 hyscan_cached_interface_init (HyScanCacheInterface *iface)
 {
   iface->set = hyscan_cached_set;
   iface->get = hyscan_cached_get;
+  iface->get_stats = hyscan_cached_get_stats;
+  iface->append = hyscan_cached_append;
+  iface->get_range = hyscan_cached_get_range;
+  iface->setv = hyscan_cached_setv;
+  iface->getv = hyscan_cached_getv;
+  iface->query = hyscan_cached_query;
+  iface->contains_batch = hyscan_cached_contains_batch;
+  iface->set128 = hyscan_cached_set128;
+  iface->get128 = hyscan_cached_get128;
 }
@@ -46,6 +46,53 @@ G_BEGIN_DECLS
 #define HYSCAN_IS_CACHED_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), HYSCAN_TYPE_CACHED))
 #define HYSCAN_CACHED_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), HYSCAN_TYPE_CACHED, HyScanCachedClass))
 
+/**
+ * HyScanCachedMemory:
+ * @HYSCAN_CACHED_MEMORY_HEAP: память для каждого объекта выделяется отдельно
+ * @HYSCAN_CACHED_MEMORY_THP: объекты размещаются в арене на прозрачных больших страницах
+ * @HYSCAN_CACHED_MEMORY_HUGETLB: объекты размещаются в арене на явных больших страницах
+ *
+ * Способы выделения памяти для объектов кэша.
+ */
+typedef enum
+{
+  HYSCAN_CACHED_MEMORY_HEAP,
+  HYSCAN_CACHED_MEMORY_THP,
+  HYSCAN_CACHED_MEMORY_HUGETLB
+} HyScanCachedMemory;
+
+/**
+ * HyScanCachedEvictReason:
+ * @HYSCAN_CACHED_EVICT_CAPACITY: объект вытеснен из-за нехватки памяти
+ * @HYSCAN_CACHED_EVICT_REMOVED: объект удалён пользователем
+ * @HYSCAN_CACHED_EVICT_CORRUPTED: данные объекта повреждены
+ *
+ * Причины удаления объектов из кэша.
+ */
+typedef enum
+{
+  HYSCAN_CACHED_EVICT_CAPACITY,
+  HYSCAN_CACHED_EVICT_REMOVED,
+  HYSCAN_CACHED_EVICT_CORRUPTED
+} HyScanCachedEvictReason;
+
+/**
+ * HyScanCachedEviction:
+ * @key: ключ объекта
+ * @detail: вспомогательная информация объекта
+ * @size: размер объекта
+ * @reason: причина удаления объекта
+ *
+ * Информация об удалённом из кэша объекте.
+ */
+typedef struct
+{
+  guint64                  key;
+  guint64                  detail;
+  guint32                  size;
+  HyScanCachedEvictReason  reason;
+} HyScanCachedEviction;
+
 typedef struct _HyScanCached HyScanCached;
 typedef struct _HyScanCachedPrivate HyScanCachedPrivate;
 typedef struct _HyScanCachedClass HyScanCachedClass;
@@ -62,12 +109,69 @@ struct _HyScanCachedClass
   GObjectClass parent_class;
 };
 
+/**
+ * HyScanCachedEvictFunc:
+ * @cached: указатель на #HyScanCached
+ * @evictions: (array length=n_evictions): удалённые объекты
+ * @n_evictions: число удалённых объектов
+ * @user_data: пользовательские данные
+ *
+ * Функция обработки удаления объектов из кэша.
+ */
+typedef void (*HyScanCachedEvictFunc) (HyScanCached               *cached,
+                                       const HyScanCachedEviction *evictions,
+                                       guint                       n_evictions,
+                                       gpointer                    user_data);
+
 HYSCAN_API
 GType          hyscan_cached_get_type  (void);
 
 HYSCAN_API
 HyScanCached  *hyscan_cached_new       (guint32                cache_size);
 
+HYSCAN_API
+HyScanCached  *hyscan_cached_new_full  (guint32                cache_size,
+                                        HyScanCachedMemory     memory);
+
+HYSCAN_API
+void           hyscan_cached_set_evict_func (HyScanCached     *cached,
+                                        HyScanCachedEvictFunc  func,
+                                        gpointer               user_data,
+                                        GDestroyNotify         destroy);
+
+HYSCAN_API
+gboolean       hyscan_cached_set_pressure_monitor (HyScanCached *cached,
+                                        gboolean               enable);
+
+HYSCAN_API
+gboolean       hyscan_cached_set_watermarks (HyScanCached     *cached,
+                                        gdouble                low,
+                                        gdouble                high);
+
+HYSCAN_API
+void           hyscan_cached_set_checksums (HyScanCached      *cached,
+                                        gboolean               enable);
+
+HYSCAN_API
+void           hyscan_cached_set_scrub_rate (HyScanCached     *cached,
+                                        guint                  rate);
+
+HYSCAN_API
+void           hyscan_cached_set_scan_threshold (HyScanCached *cached,
+                                        guint                  threshold);
+
+HYSCAN_API
+void           hyscan_cached_set_key_verification (HyScanCached *cached,
+                                        gboolean               enable);
+
+HYSCAN_API
+gboolean       hyscan_cached_save      (HyScanCached          *cached,
+                                        const gchar           *file_name);
+
+HYSCAN_API
+gboolean       hyscan_cached_load      (HyScanCached          *cached,
+                                        const gchar           *file_name);
+
 G_END_DECLS
 
 #endif /* __HYSCAN_CACHED_H__ */
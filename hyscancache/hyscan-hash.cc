@@ -3,10 +3,40 @@
 #include "farmhash.h"
 #include <string.h>
 
+/* Результат util::Hash64 зависит от набора инструкций, с которым собрана
+   библиотека, и от режима отладки. Ключи должны совпадать у клиентов и
+   серверов, работающих на разных процессорах, поэтому используется
+   переносимый вариант FarmHash, выбор оптимизированной версии которого
+   производится при загрузке библиотеки. */
+namespace farmhashxo
+{
+  uint64_t Hash64 (const char *s, size_t len);
+}
+
 guint64
 hyscan_hash64 (const gchar *name)
 {
 
-  return name != NULL ? util::Hash64 (name, strlen (name)) : 0;
+  return name != NULL ? farmhashxo::Hash64 (name, strlen (name)) : 0;
+
+}
+
+/* Для 128-битных ключей используется FarmHash Fingerprint128, значение
+   которого не зависит от процессора и параметров сборки. */
+void
+hyscan_hash128 (const gchar *name,
+                guint64     *lo,
+                guint64     *hi)
+{
+  util::uint128_t hash;
+
+  if (name == NULL)
+    {
+      *lo = *hi = 0;
+      return;
+    }
 
+  hash = util::Fingerprint128 (name, strlen (name));
+  *lo = util::Uint128Low64 (hash);
+  *hi = util::Uint128High64 (hash);
 }
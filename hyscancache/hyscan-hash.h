@@ -2,11 +2,18 @@
 #define __HYSCAN_HASH_H__
 
 #include <glib.h>
+#include <hyscan-api.h>
 
 G_BEGIN_DECLS
 
+HYSCAN_API
 guint64 hyscan_hash64 (const gchar *name);
 
+HYSCAN_API
+void    hyscan_hash128 (const gchar *name,
+                        guint64     *lo,
+                        guint64     *hi);
+
 G_END_DECLS
 
 #endif /* __HYSCAN_HASH_H__ */
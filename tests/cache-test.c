@@ -1,11 +1,39 @@
 #include <hyscan-cache-server.h>
 #include <hyscan-cache-client.h>
+#include <hyscan-cache-shm.h>
+#include <hyscan-cache-numa.h>
+#include <hyscan-cache-prefetch.h>
 #include <hyscan-cached.h>
+#include <hyscan-cached-test.h>
+#include <hyscan-hash.h>
+#include <glib/gstdio.h>
 #include <string.h>
 
+#ifdef G_OS_UNIX
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #define MAX_THREADS (32)
 #define MAX_SIZE    (1024 * 1024)
 #define MIN_SIZE    (4)
+#define PREFETCH    (200)
+#define MAX_BATCH   (256)
+#define MAX_LARGE   (1024)
+#define LOW_MARK    (0.7)
+#define HIGH_MARK   (0.9)
+#define SCAN_CACHE  (16)
+#define SCAN_OBJECT (64 * 1024)
+#define SCAN_HOT    (64)
+#define SCAN_MISSES (16)
+#define NEAR_ROUNDS (10000)
+#define BIG_OBJECT  (16 * 1024 * 1024)
+#define BATCH_MIXED (5)
+#define STATS_CACHE (16)
+#define VECTOR_PART (1000)
+#define VECTOR_TAIL (24)
+#define STATS_SETS  (64)
+#define STATS_MISS  (16)
 
 gdouble duration = 10.0;
 gint cache_size = 0;
@@ -15,15 +43,43 @@ gint n_objects = 0;
 gint small_size = 0;
 gint big_size = 0;
 gboolean rpc = FALSE;
+gboolean shm = FALSE;
+gint n_processes = 0;
+gboolean numa = FALSE;
+gint memory = HYSCAN_CACHED_MEMORY_HEAP;
 gboolean preload = FALSE;
 gboolean update = FALSE;
+gboolean append = FALSE;
+gboolean range = FALSE;
+gboolean vector = FALSE;
+gboolean query = FALSE;
+gboolean key128 = FALSE;
+gboolean verify = FALSE;
+gboolean checksums = FALSE;
+gboolean prefetch = FALSE;
+gint n_channels = 0;
+gint near_size = 0;
+gint batch = 0;
+gint large_size = 0;
+gboolean direct = FALSE;
+gboolean snapshot = FALSE;
+gboolean evictions = FALSE;
+gboolean pressure = FALSE;
+gboolean watermarks = FALSE;
+gboolean scan = FALSE;
 
 HyScanCache *cache[MAX_THREADS+2];
 HyScanCacheServer *server = NULL;
+HyScanCachePrefetch *prefetcher = NULL;
 
 gint pattern_size;
 guint8 **patterns;
 
+GHashTable *known_keys = NULL;
+volatile gint evicted_capacity = 0;
+volatile gint evicted_other = 0;
+
+gint near_stop = 0;
 gint started_threads = 0;
 gint start = 0;
 gint stop = 0;
@@ -34,12 +90,23 @@ data_writer (gpointer thread_data)
 {
   HyScanBuffer *buffer1;
   HyScanBuffer *buffer2;
+  HyScanBuffer *buffers[3];
+  HyScanBuffer *batch_buffers[MAX_BATCH];
+  gchar batch_keys[MAX_BATCH][16];
+  const gchar *batch_key_ptrs[MAX_BATCH];
   gint data_index;
   gchar key[16];
   gint i;
 
   buffer1 = hyscan_buffer_new ();
   buffer2 = hyscan_buffer_new ();
+  for (i = 0; i < 3; i++)
+    buffers[i] = hyscan_buffer_new ();
+  for (i = 0; i < batch; i++)
+    {
+      batch_buffers[i] = hyscan_buffer_new ();
+      batch_key_ptrs[i] = batch_keys[i];
+    }
 
   /* Сигнализация запуска потока. */
   g_atomic_int_inc (&started_threads);
@@ -60,8 +127,15 @@ data_writer (gpointer thread_data)
           hyscan_buffer_wrap (buffer2, HYSCAN_DATA_BLOB, data, size2);
 
           g_snprintf (key, sizeof(key), "%09d", i);
-          if (!hyscan_cache_set2 (cache[data_index], key, NULL, buffer1, buffer2))
-            g_message ("data_writer: '%s' set error", key);
+          if (key128)
+            {
+              if (!hyscan_cache_set128 (cache[data_index], key, NULL, buffer1, buffer2))
+                g_message ("data_writer: '%s' set128 error", key);
+            }
+          else if (!hyscan_cache_set2 (cache[data_index], key, NULL, buffer1, buffer2))
+            {
+              g_message ("data_writer: '%s' set error", key);
+            }
         }
     }
 
@@ -73,27 +147,192 @@ data_writer (gpointer thread_data)
   /* Обновление кэша. */
   while (update && g_atomic_int_get (&stop) == 0)
     {
-      gint key_id = 2 * g_random_int_range (0, n_objects / 2) + data_index;
-      gpointer data = patterns[key_id % n_patterns];
-      gint32 size1 = (data_index ? big_size : small_size);
-      gint32 size2 = size1 * g_random_double_range (0.5, 1.0);
+      gint key_id;
+      gpointer data;
+      gint32 size1;
+      gint32 size2;
+
+      /* Пакетная запись объектов. */
+      if (batch > 0)
+        {
+          for (i = 0; i < batch; i++)
+            {
+              key_id = 2 * g_random_int_range (0, n_objects / 2) + data_index;
+              g_snprintf (batch_keys[i], sizeof (batch_keys[i]), "%09d", key_id);
+              hyscan_buffer_wrap (batch_buffers[i], HYSCAN_DATA_BLOB, patterns[key_id % n_patterns],
+                                  data_index ? big_size : small_size);
+            }
+
+          if (hyscan_cache_set_batch (cache[data_index], batch_key_ptrs, NULL, batch_buffers, batch, NULL) == 0)
+            g_message ("data_writer: set batch error");
+
+          g_usleep (batch);
+          continue;
+        }
+
+      key_id = 2 * g_random_int_range (0, n_objects / 2) + data_index;
+      data = patterns[key_id % n_patterns];
+      size1 = (data_index ? big_size : small_size);
+      size2 = size1 * g_random_double_range (0.5, 1.0);
 
       hyscan_buffer_wrap (buffer1, HYSCAN_DATA_BLOB, data, size1);
       hyscan_buffer_wrap (buffer2, HYSCAN_DATA_BLOB, data, size2);
 
       g_snprintf (key, sizeof (key), "%09d", key_id);
-      if (!hyscan_cache_set2 (cache[data_index], key, NULL, buffer1, buffer2))
-        g_message ("data_writer: '%s' set error", key);
+      if (vector)
+        {
+          hyscan_buffer_wrap (buffers[0], HYSCAN_DATA_BLOB, data, size1 / 2);
+          hyscan_buffer_wrap (buffers[1], HYSCAN_DATA_BLOB, (guint8*) data + size1 / 2, size1 - size1 / 2);
+          hyscan_buffer_wrap (buffers[2], HYSCAN_DATA_BLOB, data, size2);
+
+          if (!hyscan_cache_setv (cache[data_index], key, NULL, buffers, 3))
+            g_message ("data_writer: '%s' setv error", key);
+        }
+      else if (key128)
+        {
+          if (!hyscan_cache_set128 (cache[data_index], key, NULL, buffer1, buffer2))
+            g_message ("data_writer: '%s' set128 error", key);
+        }
+      else if (append)
+        {
+          if (!hyscan_cache_set (cache[data_index], key, NULL, buffer1))
+            g_message ("data_writer: '%s' set error", key);
+          else if (!hyscan_cache_append (cache[data_index], key, NULL, buffer2))
+            g_message ("data_writer: '%s' append error", key);
+        }
+      else if (!hyscan_cache_set2 (cache[data_index], key, NULL, buffer1, buffer2))
+        {
+          g_message ("data_writer: '%s' set error", key);
+        }
 
       g_usleep (1);
     }
 
   g_object_unref (buffer1);
   g_object_unref (buffer2);
+  for (i = 0; i < 3; i++)
+    g_object_unref (buffers[i]);
+  for (i = 0; i < batch; i++)
+    g_object_unref (batch_buffers[i]);
 
   return NULL;
 }
 
+/* Упреждающая запись данных в кэш. */
+void
+data_prefetch (guint64  index,
+               gpointer user_data)
+{
+  HyScanCache *cached = user_data;
+  HyScanBuffer *buffer;
+  gchar key[16];
+  gint key_id;
+
+  key_id = index % n_objects;
+  g_snprintf (key, sizeof (key), "%09d", key_id);
+  if (hyscan_cache_contains (cached, key, NULL))
+    return;
+
+  buffer = hyscan_buffer_new ();
+  hyscan_buffer_wrap (buffer, HYSCAN_DATA_BLOB, patterns[key_id % n_patterns],
+                      (key_id % 2) ? big_size : small_size);
+
+  if (!hyscan_cache_set (cached, key, NULL, buffer))
+    g_message ("data_prefetch: '%s' set error", key);
+
+  g_object_unref (buffer);
+}
+
+/* Счётчик объектов, об удалении которых сообщила одна функция обработки. */
+typedef struct
+{
+  volatile gint capacity;
+  volatile gint other;
+} EvictCounter;
+
+/* Функция обработки удаления объектов. */
+void
+evict_count (HyScanCached               *cached,
+             const HyScanCachedEviction *evicted,
+             guint                       n_evicted,
+             gpointer                    user_data)
+{
+  EvictCounter *counter = user_data;
+  guint i;
+
+  for (i = 0; i < n_evicted; i++)
+    {
+      if (!g_hash_table_contains (known_keys, &evicted[i].key))
+        g_error ("unknown evicted key 0x%016" G_GINT64_MODIFIER "x", evicted[i].key);
+
+      if (evicted[i].reason == HYSCAN_CACHED_EVICT_CAPACITY)
+        g_atomic_int_inc (&counter->capacity);
+      else
+        g_atomic_int_inc (&counter->other);
+    }
+}
+
+/* Функция удаления счётчика функции обработки. */
+void
+evict_counter_free (gpointer data)
+{
+  EvictCounter *counter = data;
+
+  g_atomic_int_add (&evicted_capacity, counter->capacity);
+  g_atomic_int_add (&evicted_other, counter->other);
+
+  /* Обращение к счётчику после удаления будет заметно по его значению. */
+  counter->capacity = G_MININT;
+  counter->other = G_MININT;
+  g_free (counter);
+}
+
+/* Функция создаёт таблицу хэшей всех ключей теста. */
+GHashTable *
+known_keys_new (guint64 **storage)
+{
+  GHashTable *table = g_hash_table_new (g_int64_hash, g_int64_equal);
+  guint64 *hashes = g_new (guint64, 2 * n_objects + 1);
+  gint i;
+
+  for (i = 0; i < n_objects; i++)
+    {
+      guint64 hi;
+      gchar key[16];
+
+      g_snprintf (key, sizeof (key), "%09d", i);
+      hashes[2 * i] = hyscan_hash64 (key);
+      hyscan_hash128 (key, &hashes[2 * i + 1], &hi);
+      g_hash_table_add (table, &hashes[2 * i]);
+      g_hash_table_add (table, &hashes[2 * i + 1]);
+    }
+
+  hashes[2 * n_objects] = hyscan_hash64 ("large");
+  g_hash_table_add (table, &hashes[2 * n_objects]);
+
+  *storage = hashes;
+
+  return table;
+}
+
+/* Проверка целого объекта: шаблон и, возможно, начало шаблона. */
+void
+check_object (gint         thread_id,
+              const gchar *key,
+              gint         key_id,
+              gconstpointer data,
+              guint32      size)
+{
+  guint32 base_size = ((key_id % 2) ? big_size : small_size);
+  const guint8 *pattern = patterns[key_id % n_patterns];
+
+  if (size < base_size || size > 2 * base_size)
+    g_error ("test thread %d: '%s' object size mismatch %d", thread_id, key, size);
+  else if (memcmp (data, pattern, base_size) ||
+           memcmp ((const guint8 *) data + base_size, pattern, size - base_size))
+    g_error ("test thread %d: '%s' object data mismatch", thread_id, key);
+}
+
 /* Чтение данных из кэша. */
 gpointer
 data_reader (gpointer data)
@@ -102,8 +341,16 @@ data_reader (gpointer data)
 
   HyScanBuffer *buffer1;
   HyScanBuffer *buffer2;
+  HyScanBuffer *batch_buffers[MAX_BATCH];
+  gchar batch_keys[MAX_BATCH][16];
+  const gchar *batch_key_ptrs[MAX_BATCH];
+  gboolean batch_found[MAX_BATCH];
+  gint batch_ids[MAX_BATCH];
+
+  guint8 *direct_data = NULL;
 
   gint thread_id;
+  gint i;
 
   GTimer *timer = g_timer_new ();
   gdouble hit_time = 0.0;
@@ -111,12 +358,29 @@ data_reader (gpointer data)
   guint hit = 0;
   guint miss = 0;;
 
+  guint producer = 0;
+  gint key_id = 0;
+
   /* Идентификатор потока. */
   thread_id = g_atomic_int_add (&running_threads, 1);
 
+  /* Последовательное чтение с упреждающей записью. */
+  if (prefetch)
+    {
+      producer = hyscan_cache_prefetch_add_producer (prefetcher, data_prefetch, cache[thread_id+2], NULL);
+      key_id = g_random_int_range (0, n_objects);
+    }
+
   /* Буферы данных. */
   buffer1 = hyscan_buffer_new ();
   buffer2 = hyscan_buffer_new ();
+  for (i = 0; i < batch; i++)
+    {
+      batch_buffers[i] = hyscan_buffer_new ();
+      batch_key_ptrs[i] = batch_keys[i];
+    }
+  if (direct)
+    direct_data = g_malloc (2 * MAX_SIZE);
 
   /* Сигнализация запуска потока. */
   g_atomic_int_inc (&started_threads);
@@ -134,14 +398,145 @@ data_reader (gpointer data)
       gboolean status;
       gdouble req_time;
       gchar key[16];
-      gint key_id;
 
-      key_id = g_random_int_range (0, n_objects);
+      if (prefetch)
+        {
+          key_id = (key_id + 1) % n_objects;
+          if (key_id % (PREFETCH / 2) == 0)
+            hyscan_cache_prefetch_hint (prefetcher, producer, key_id + 1, key_id + PREFETCH);
+        }
+      else
+        {
+          key_id = g_random_int_range (0, n_objects);
+        }
+
       g_snprintf (key, sizeof (key), "%09d", key_id);
 
+      /* Пакетное чтение объектов. */
+      if (batch > 0)
+        {
+          guint n_found;
+
+          for (i = 0; i < batch; i++)
+            {
+              batch_ids[i] = g_random_int_range (0, n_objects);
+              g_snprintf (batch_keys[i], sizeof (batch_keys[i]), "%09d", batch_ids[i]);
+            }
+
+          g_timer_start (timer);
+          n_found = hyscan_cache_get_batch (cache[thread_id+2], batch_key_ptrs, NULL,
+                                            batch_buffers, batch, batch_found);
+          req_time = g_timer_elapsed (timer, NULL) / batch;
+
+          for (i = 0; i < batch; i++)
+            {
+              if (!batch_found[i])
+                continue;
+
+              data1 = hyscan_buffer_get (batch_buffers[i], NULL, &size1);
+              check_object (thread_id, batch_keys[i], batch_ids[i], data1, size1);
+            }
+
+          hit_time += req_time * n_found;
+          hit += n_found;
+          miss_time += req_time * (batch - n_found);
+          miss += batch - n_found;
+
+          continue;
+        }
+
+      /* Чтение данных объекта в память теста. */
+      if (direct)
+        {
+          size1 = 2 * MAX_SIZE;
+
+          g_timer_start (timer);
+          status = hyscan_cache_client_get_data (HYSCAN_CACHE_CLIENT (cache[thread_id+2]), key, NULL,
+                                                 direct_data, &size1);
+          req_time = g_timer_elapsed (timer, NULL);
+
+          if (status)
+            {
+              check_object (thread_id, key, key_id, direct_data, size1);
+              hit_time += req_time;
+              hit += 1;
+            }
+          else
+            {
+              miss_time += req_time;
+              miss += 1;
+            }
+
+          continue;
+        }
+
+      /* Проверка размера объекта без чтения данных. */
+      if (query)
+        {
+          guint32 object_size;
+
+          size1 = ((key_id % 2) ? big_size : small_size);
+
+          g_timer_start (timer);
+          status = hyscan_cache_get_size (cache[thread_id+2], key, NULL, &object_size);
+          req_time = g_timer_elapsed (timer, NULL);
+
+          if (status)
+            {
+              if (object_size < size1 || object_size > 2 * size1)
+                g_error ("test thread %d: '%s' object size %d out of range", thread_id, key, object_size);
+
+              hit_time += req_time;
+              hit += 1;
+            }
+          else
+            {
+              miss_time += req_time;
+              miss += 1;
+            }
+
+          continue;
+        }
+
+      /* Чтение части первой половины объекта. */
+      if (range)
+        {
+          guint32 offset;
+
+          size1 = ((key_id % 2) ? big_size : small_size) / 2;
+          offset = g_random_int_range (0, size1 + 1);
+
+          g_timer_start (timer);
+          status = hyscan_cache_get_range (cache[thread_id+2], key, NULL, offset, size1, buffer1);
+          req_time = g_timer_elapsed (timer, NULL);
+
+          if (status)
+            {
+              data1 = hyscan_buffer_get (buffer1, NULL, &size2);
+
+              if (size1 != size2)
+                g_error ("test thread %d: '%s' range size mismatch %d != %d", thread_id, key, size2, size1);
+              else if (memcmp (data1, patterns[key_id % n_patterns] + offset, size1))
+                g_error ("test thread %d: '%s' range data mismatch", thread_id, key);
+
+              hit_time += req_time;
+              hit += 1;
+            }
+          else
+            {
+              miss_time += req_time;
+              miss += 1;
+            }
+
+          continue;
+        }
+
       g_timer_start (timer);
       size1 = ((key_id % 2) ? big_size : small_size);
-      status = hyscan_cache_get2 (cache[thread_id+2], key, NULL, size1, buffer1, buffer2);
+      if (key128)
+        status = hyscan_cache_get128 (cache[thread_id+2], key, NULL, size1, buffer1, buffer2);
+      else
+        status = hyscan_cache_get2 (cache[thread_id+2], key, NULL, size1, buffer1, buffer2);
       req_time = g_timer_elapsed (timer, NULL);
 
       if (status)
@@ -180,8 +575,14 @@ data_reader (gpointer data)
 
   g_timer_destroy (timer);
 
+  if (prefetch)
+    hyscan_cache_prefetch_remove_producer (prefetcher, producer);
+
   g_object_unref (buffer1);
   g_object_unref (buffer2);
+  for (i = 0; i < batch; i++)
+    g_object_unref (batch_buffers[i]);
+  g_free (direct_data);
 
   g_message ("thread %d: hits: number = %d time = %.3lf us/req, misses: number = %d time = %.3lf us/req",
              thread_id, hit, (1000000.0 * hit_time) / hit, miss, (1000000.0 * miss_time) / miss);
@@ -189,14 +590,739 @@ data_reader (gpointer data)
   return NULL;
 }
 
+/* Измерение скорости записи и чтения больших объектов. */
+void
+large_benchmark (HyScanCache *writer,
+                 HyScanCache *reader)
+{
+  HyScanBuffer *buffer1 = hyscan_buffer_new ();
+  HyScanBuffer *buffer2 = hyscan_buffer_new ();
+  GTimer *timer = g_timer_new ();
+  gint size_mb;
+
+  for (size_mb = 16; size_mb <= large_size; size_mb *= 2)
+    {
+      guint32 size = size_mb * 1024 * 1024;
+      gdouble set_time, get_time;
+      guint8 *data1;
+      gpointer data2;
+      guint32 size2;
+      guint32 i;
+
+      data1 = g_malloc (size);
+      for (i = 0; i < size; i++)
+        data1[i] = i * 7 + size_mb;
+
+      hyscan_buffer_wrap (buffer1, HYSCAN_DATA_BLOB, data1, size);
+
+      g_timer_start (timer);
+      if (!hyscan_cache_set (writer, "large", NULL, buffer1))
+        g_error ("large object %d Mb set error", size_mb);
+      set_time = g_timer_elapsed (timer, NULL);
+
+      g_timer_start (timer);
+      if (!hyscan_cache_get (reader, "large", NULL, buffer2))
+        g_error ("large object %d Mb get error", size_mb);
+      get_time = g_timer_elapsed (timer, NULL);
+
+      data2 = hyscan_buffer_get (buffer2, NULL, &size2);
+      if (size2 != size)
+        g_error ("large object %d Mb size mismatch %u", size_mb, size2);
+      if (memcmp (data1, data2, size))
+        g_error ("large object %d Mb data mismatch", size_mb);
+
+      g_message ("large object %4d Mb: set %.1f Mb/s, get %.1f Mb/s",
+                 size_mb, size_mb / set_time, size_mb / get_time);
+
+      g_free (data1);
+    }
+
+  g_timer_destroy (timer);
+  g_object_unref (buffer1);
+  g_object_unref (buffer2);
+}
+
+/* Проверка сохранения кэша в файл и загрузки в новый кэш. */
+void
+snapshot_check (HyScanCache *cached)
+{
+  HyScanBuffer *buffer1 = hyscan_buffer_new ();
+  HyScanBuffer *buffer2 = hyscan_buffer_new ();
+  HyScanCacheStats stats1, stats2;
+  HyScanCached *loaded;
+  gchar *file_name;
+  guint n_checked = 0;
+  gint i;
+
+  file_name = g_build_filename (g_get_tmp_dir (), "cache-test.snapshot", NULL);
+
+  if (!hyscan_cached_save (HYSCAN_CACHED (cached), file_name))
+    g_error ("can't save cache snapshot");
+
+  loaded = hyscan_cached_new (cache_size);
+  if (!hyscan_cached_load (loaded, file_name))
+    g_error ("can't load cache snapshot");
+
+  hyscan_cache_get_stats (cached, &stats1);
+  hyscan_cache_get_stats (HYSCAN_CACHE (loaded), &stats2);
+  if (stats1.n_objects != stats2.n_objects)
+    {
+      g_error ("snapshot objects number mismatch %" G_GUINT64_FORMAT " != %" G_GUINT64_FORMAT,
+               stats2.n_objects, stats1.n_objects);
+    }
+
+  /* Каждый объект исходного кэша должен быть в загруженном с теми же данными. */
+  for (i = 0; i < n_objects; i++)
+    {
+      gpointer data1, data2;
+      guint32 size1, size2;
+      gchar key[16];
+
+      g_snprintf (key, sizeof (key), "%09d", i);
+      if (!hyscan_cache_get (cached, key, NULL, buffer1))
+        continue;
+      if (!hyscan_cache_get (HYSCAN_CACHE (loaded), key, NULL, buffer2))
+        g_error ("snapshot: '%s' object is lost", key);
+
+      data1 = hyscan_buffer_get (buffer1, NULL, &size1);
+      data2 = hyscan_buffer_get (buffer2, NULL, &size2);
+      if (size1 != size2 || memcmp (data1, data2, size1))
+        g_error ("snapshot: '%s' object data mismatch", key);
+
+      check_object (0, key, i, data2, size2);
+      n_checked += 1;
+    }
+
+  g_message ("snapshot: %u objects restored", n_checked);
+
+  g_unlink (file_name);
+  g_free (file_name);
+  g_object_unref (loaded);
+  g_object_unref (buffer1);
+  g_object_unref (buffer2);
+}
+
+/* Проверка чтения объектов непосредственно в память вызывающей стороны:
+   маленького и большого, считываемого частями, в недостаточную память
+   и большого объекта целиком. */
+void
+direct_check (HyScanCache *client)
+{
+  const guint32 sizes[2] = { 4096, BIG_OBJECT };
+  const gchar *keys[2] = { "direct-small", "direct-large" };
+  HyScanBuffer *buffer;
+  gchar *data;
+  gchar *object;
+  guint32 size;
+  gint i;
+
+  data = g_malloc (BIG_OBJECT);
+  object = g_malloc (BIG_OBJECT);
+  buffer = hyscan_buffer_new ();
+
+  for (i = 0; i < 2; i++)
+    {
+      memset (data, i + 1, sizes[i]);
+      hyscan_buffer_wrap (buffer, HYSCAN_DATA_BLOB, data, sizes[i]);
+      if (!hyscan_cache_set (client, keys[i], NULL, buffer))
+        g_error ("direct: set error");
+
+      /* Объект не помещается в память, возвращается его размер. */
+      size = 1024;
+      if (hyscan_cache_client_get_data (HYSCAN_CACHE_CLIENT (client), keys[i], NULL, object, &size))
+        g_error ("direct: object %s is read into small memory", keys[i]);
+      if (size != sizes[i])
+        g_error ("direct: object %s size %u, expected %u", keys[i], size, sizes[i]);
+
+      size = BIG_OBJECT;
+      if (!hyscan_cache_client_get_data (HYSCAN_CACHE_CLIENT (client), keys[i], NULL, object, &size))
+        g_error ("direct: object %s is not read", keys[i]);
+      if (size != sizes[i] || memcmp (object, data, size) != 0)
+        g_error ("direct: object %s data mismatch", keys[i]);
+    }
+
+  g_message ("direct: small and large objects checked");
+
+  g_object_unref (buffer);
+  g_free (object);
+  g_free (data);
+}
+
+/* Проверка пакетной записи и чтения объектов, не помещающихся в один обмен
+   с сервером. Большие объекты чередуются с маленькими, поэтому большой объект
+   записывается отдельно, ответ на чтение содержит только часть объектов,
+   а запрос, начинающийся с большого объекта, не возвращает ни одного. */
+void
+batch_check (HyScanCache *client)
+{
+  HyScanBuffer *buffers[BATCH_MIXED];
+  gchar keys[BATCH_MIXED][32];
+  const gchar *key_ptrs[BATCH_MIXED];
+  gboolean flags[BATCH_MIXED];
+  gchar *data[BATCH_MIXED];
+  guint32 sizes[BATCH_MIXED];
+  gint i;
+
+  for (i = 0; i < BATCH_MIXED; i++)
+    {
+      sizes[i] = (i % 2) ? BIG_OBJECT : 1024;
+      data[i] = g_malloc (sizes[i]);
+      memset (data[i], i + 1, sizes[i]);
+
+      g_snprintf (keys[i], sizeof (keys[i]), "batch-mixed-%d", i);
+      key_ptrs[i] = keys[i];
+
+      buffers[i] = hyscan_buffer_new ();
+      hyscan_buffer_wrap (buffers[i], HYSCAN_DATA_BLOB, data[i], sizes[i]);
+    }
+
+  if (hyscan_cache_set_batch (client, key_ptrs, NULL, buffers, BATCH_MIXED, flags) != BATCH_MIXED)
+    g_error ("batch: set error");
+  for (i = 0; i < BATCH_MIXED; i++)
+    if (!flags[i])
+      g_error ("batch: object %s is not stored", keys[i]);
+
+  for (i = 0; i < BATCH_MIXED; i++)
+    {
+      g_object_unref (buffers[i]);
+      buffers[i] = hyscan_buffer_new ();
+    }
+
+  if (hyscan_cache_get_batch (client, key_ptrs, NULL, buffers, BATCH_MIXED, flags) != BATCH_MIXED)
+    g_error ("batch: get error");
+
+  for (i = 0; i < BATCH_MIXED; i++)
+    {
+      gpointer object;
+      guint32 size;
+
+      if (!flags[i])
+        g_error ("batch: object %s is not found", keys[i]);
+
+      object = hyscan_buffer_get (buffers[i], NULL, &size);
+      if (size != sizes[i] || memcmp (object, data[i], size) != 0)
+        g_error ("batch: object %s data mismatch", keys[i]);
+    }
+
+  g_message ("batch: large objects checked");
+
+  for (i = 0; i < BATCH_MIXED; i++)
+    {
+      g_object_unref (buffers[i]);
+      g_free (data[i]);
+    }
+}
+
+/* Поток постоянно считывает объект, изменяемый при проверке ближнего кэша. */
+gpointer
+near_reader (gpointer data)
+{
+  HyScanCache *client = data;
+  HyScanBuffer *buffer = hyscan_buffer_new ();
+
+  while (!g_atomic_int_get (&near_stop))
+    hyscan_cache_get (client, "near-coherence", NULL, buffer);
+
+  g_object_unref (buffer);
+
+  return NULL;
+}
+
+/* Проверка согласованности ближнего кэша: после записи объекта клиент должен
+   считывать записанные данные, даже если другой поток этого клиента в то же
+   время читает прежние данные с сервера. Время аренды выбрано большим, чтобы
+   устаревшие данные не удалялись из ближнего кэша до окончания проверки. */
+void
+near_check (void)
+{
+  HyScanCache *client;
+  HyScanBuffer *buffer1;
+  HyScanBuffer *buffer2;
+  GThread *reader;
+  guint32 version;
+  guint32 *value;
+  guint32 size;
+
+  client = HYSCAN_CACHE (hyscan_cache_client_new_full ("shm://local", 2));
+  hyscan_cache_client_set_near_cache (HYSCAN_CACHE_CLIENT (client), (gsize) near_size * 1024 * 1024, 60000);
+
+  buffer1 = hyscan_buffer_new ();
+  buffer2 = hyscan_buffer_new ();
+
+  g_atomic_int_set (&near_stop, 0);
+  reader = g_thread_new ("near-reader", near_reader, client);
+
+  for (version = 1; version <= NEAR_ROUNDS; version++)
+    {
+      hyscan_buffer_wrap (buffer1, HYSCAN_DATA_BLOB, &version, sizeof (version));
+      if (!hyscan_cache_set (client, "near-coherence", NULL, buffer1))
+        g_error ("near: set error");
+
+      if (!hyscan_cache_get (client, "near-coherence", NULL, buffer2))
+        g_error ("near: get error");
+
+      value = hyscan_buffer_get (buffer2, NULL, &size);
+      if (value == NULL || size != sizeof (version))
+        g_error ("near: wrong object size %u", size);
+      if (*value != version)
+        g_error ("near: stale data %u, expected %u", *value, version);
+    }
+
+  g_atomic_int_set (&near_stop, 1);
+  g_thread_join (reader);
+
+  g_message ("near: %d updates are coherent", NEAR_ROUNDS);
+
+  g_object_unref (buffer1);
+  g_object_unref (buffer2);
+  g_object_unref (client);
+}
+
+/* Функция читает горячие объекты, затем просматривает объём данных в четыре
+   раза больше кэша и возвращает число горячих объектов, оставшихся в кэше. */
+gint
+scan_run (guint threshold)
+{
+  HyScanCache *cache;
+  HyScanBuffer *buffer;
+  gchar *data;
+  gchar key[32];
+  gint n_hot;
+  gint i;
+
+  if (numa)
+    {
+      cache = HYSCAN_CACHE (hyscan_cache_numa_new (SCAN_CACHE));
+      hyscan_cache_numa_set_scan_threshold (HYSCAN_CACHE_NUMA (cache), threshold);
+    }
+  else
+    {
+      cache = HYSCAN_CACHE (hyscan_cached_new (SCAN_CACHE));
+      hyscan_cached_set_scan_threshold (HYSCAN_CACHED (cache), threshold);
+    }
+
+  data = g_malloc0 (SCAN_OBJECT);
+  buffer = hyscan_buffer_new ();
+  hyscan_buffer_wrap (buffer, HYSCAN_DATA_BLOB, data, SCAN_OBJECT);
+
+  for (i = 0; i < SCAN_HOT; i++)
+    {
+      g_snprintf (key, sizeof (key), "hot-%d", i);
+      if (!hyscan_cache_set (cache, key, NULL, buffer))
+        g_error ("scan: set error");
+    }
+
+  /* Просмотр: каждый объект отсутствует в кэше, читается из источника
+     и записывается в кэш. */
+  for (i = 0; i < 4 * SCAN_CACHE * 1024 * 1024 / SCAN_OBJECT; i++)
+    {
+      HyScanBuffer *scan_buffer = hyscan_buffer_new ();
+
+      g_snprintf (key, sizeof (key), "scan-%d", i);
+      if (hyscan_cache_get (cache, key, NULL, scan_buffer))
+        g_error ("scan: object %s is in cache", key);
+      if (!hyscan_cache_set (cache, key, NULL, buffer))
+        g_error ("scan: set error");
+
+      g_object_unref (scan_buffer);
+    }
+
+  for (i = 0, n_hot = 0; i < SCAN_HOT; i++)
+    {
+      g_snprintf (key, sizeof (key), "hot-%d", i);
+      if (hyscan_cache_contains (cache, key, NULL))
+        n_hot += 1;
+    }
+
+  g_object_unref (buffer);
+  g_object_unref (cache);
+  g_free (data);
+
+  return n_hot;
+}
+
+/* Проверка того, что последовательный просмотр данных не вытесняет из кэша
+   часто используемые объекты, а без обнаружения просмотра вытесняет. */
+void
+scan_check (void)
+{
+  gint n_hot;
+
+  n_hot = scan_run (0);
+  if (n_hot == SCAN_HOT)
+    g_error ("scan: hot objects are not evicted without scan detection");
+
+  n_hot = scan_run (SCAN_MISSES);
+  if (n_hot != SCAN_HOT)
+    g_error ("scan: %d of %d hot objects are evicted", SCAN_HOT - n_hot, SCAN_HOT);
+
+  g_message ("scan: hot objects kept");
+}
+
+/* Проверка удаления повреждённых объектов при чтении и при фоновой проверке. */
+void
+checksums_check (HyScanCache *cached)
+{
+  HyScanBuffer *buffer1 = hyscan_buffer_new ();
+  HyScanBuffer *buffer2 = hyscan_buffer_new ();
+  gint i;
+
+  hyscan_buffer_wrap (buffer1, HYSCAN_DATA_BLOB, patterns[0], small_size);
+
+  /* Повреждённый объект считается отсутствующим и удаляется при чтении. */
+  if (!hyscan_cache_set (cached, "corrupted-get", NULL, buffer1))
+    g_error ("checksums: set error");
+  if (!hyscan_cached_corrupt (HYSCAN_CACHED (cached), "corrupted-get"))
+    g_error ("checksums: can't corrupt object");
+  if (hyscan_cache_get (cached, "corrupted-get", NULL, buffer2))
+    g_error ("checksums: corrupted object is read");
+  if (hyscan_cache_contains (cached, "corrupted-get", NULL))
+    g_error ("checksums: corrupted object is not removed on read");
+
+  /* Повреждённый объект удаляется при фоновой проверке. */
+  if (!hyscan_cache_set (cached, "corrupted-scrub", NULL, buffer1))
+    g_error ("checksums: set error");
+  if (!hyscan_cached_corrupt (HYSCAN_CACHED (cached), "corrupted-scrub"))
+    g_error ("checksums: can't corrupt object");
+
+  for (i = 0; i < 1000; i++)
+    {
+      if (!hyscan_cache_contains (cached, "corrupted-scrub", NULL))
+        break;
+
+      g_usleep (10000);
+    }
+
+  if (i == 1000)
+    g_error ("checksums: corrupted object is not removed by scrubbing");
+
+  g_message ("checksums: corrupted objects removed");
+
+  g_object_unref (buffer1);
+  g_object_unref (buffer2);
+}
+
+/* Проверка того, что объём данных после записи устанавливается между
+   нижней и верхней границами. */
+void
+watermarks_check (HyScanCache *cached)
+{
+  HyScanCacheStats stats;
+  gint i;
+
+  /* Объекты удаляются в потоке обслуживания кэша. */
+  for (i = 0; i < 100; i++)
+    {
+      hyscan_cache_get_stats (cached, &stats);
+      if (stats.used_size <= HIGH_MARK * stats.max_size)
+        break;
+
+      g_usleep (10000);
+    }
+
+  g_message ("watermarks: used %" G_GUINT64_FORMAT " of %" G_GUINT64_FORMAT " bytes",
+             stats.used_size, stats.max_size);
+
+  if (stats.used_size > HIGH_MARK * stats.max_size)
+    g_error ("used size is above high watermark");
+  if (stats.used_size < (LOW_MARK - 0.05) * stats.max_size)
+    g_error ("used size is below low watermark");
+}
+
+/* Проверка добавления данных к объекту с другой дополнительной информацией:
+   прежние данные объекта должны быть заменены добавляемыми. */
+void
+append_check (HyScanCache *cache)
+{
+  HyScanBuffer *buffer1;
+  HyScanBuffer *buffer2;
+  gchar data[1024];
+  gchar *object;
+  guint32 size;
+
+  buffer1 = hyscan_buffer_new ();
+  buffer2 = hyscan_buffer_new ();
+
+  memset (data, 1, 1024);
+  hyscan_buffer_wrap (buffer1, HYSCAN_DATA_BLOB, data, 1024);
+  if (!hyscan_cache_set (cache, "append-detail", "old", buffer1))
+    g_error ("append: set error");
+
+  memset (data, 2, 512);
+  hyscan_buffer_wrap (buffer1, HYSCAN_DATA_BLOB, data, 512);
+  if (!hyscan_cache_append (cache, "append-detail", "new", buffer1))
+    g_error ("append: append error");
+
+  memset (data + 512, 3, 512);
+  hyscan_buffer_wrap (buffer1, HYSCAN_DATA_BLOB, data + 512, 512);
+  if (!hyscan_cache_append (cache, "append-detail", "new", buffer1))
+    g_error ("append: append error");
+
+  if (hyscan_cache_get (cache, "append-detail", "old", buffer2))
+    g_error ("append: object with old detail is read");
+  if (!hyscan_cache_get (cache, "append-detail", "new", buffer2))
+    g_error ("append: get error");
+
+  object = hyscan_buffer_get (buffer2, NULL, &size);
+  if (size != 1024)
+    g_error ("append: object size %u, expected 1024", size);
+  if (memcmp (object, data, size) != 0)
+    g_error ("append: stale data is kept");
+
+  g_message ("append: object with other detail replaced");
+
+  g_object_unref (buffer1);
+  g_object_unref (buffer2);
+}
+
+/* Проверка чтения объекта в несколько буферов через клиента: объект
+   записывается из трёх частей и считывается в четыре буфера, последний
+   из которых получает оставшиеся данные меньшего размера. */
+void
+vector_check (HyScanCache *client)
+{
+  const guint32 sizes[3] = { VECTOR_PART, VECTOR_PART, VECTOR_PART };
+  const guint32 total = 3 * VECTOR_PART + VECTOR_TAIL;
+  HyScanBuffer *buffers[4];
+  gchar *data;
+  guint32 offset;
+  gint i;
+
+  data = g_malloc (total);
+  for (offset = 0; offset < total; offset++)
+    data[offset] = offset % 251;
+
+  for (i = 0; i < 4; i++)
+    buffers[i] = hyscan_buffer_new ();
+
+  /* Части записи не совпадают с частями чтения. */
+  hyscan_buffer_wrap (buffers[0], HYSCAN_DATA_BLOB, data, 100);
+  hyscan_buffer_wrap (buffers[1], HYSCAN_DATA_BLOB, data + 100, 2000);
+  hyscan_buffer_wrap (buffers[2], HYSCAN_DATA_BLOB, data + 2100, total - 2100);
+  if (!hyscan_cache_setv (client, "vector-parts", NULL, buffers, 3))
+    g_error ("vector: setv error");
+
+  for (i = 0; i < 4; i++)
+    {
+      g_object_unref (buffers[i]);
+      buffers[i] = hyscan_buffer_new ();
+    }
+
+  if (!hyscan_cache_getv (client, "vector-parts", NULL, sizes, buffers, 4))
+    g_error ("vector: getv error");
+
+  for (i = 0, offset = 0; i < 4; i++)
+    {
+      guint32 expected = (i < 3) ? VECTOR_PART : VECTOR_TAIL;
+      gpointer part;
+      guint32 size;
+
+      part = hyscan_buffer_get (buffers[i], NULL, &size);
+      if (size != expected)
+        g_error ("vector: part %d size %u, expected %u", i, size, expected);
+      if (memcmp (part, data + offset, size) != 0)
+        g_error ("vector: part %d data mismatch", i);
+
+      offset += size;
+    }
+
+  g_message ("vector: object read into four buffers");
+
+  for (i = 0; i < 4; i++)
+    g_object_unref (buffers[i]);
+  g_free (data);
+}
+
+/* Функция возвращает суммарное число операций в гистограмме времени выполнения. */
+guint64
+latency_total (const guint64 *latency)
+{
+  guint64 total = 0;
+  gint i;
+
+  for (i = 0; i < HYSCAN_CACHE_STATS_N_BINS; i++)
+    total += latency[i];
+
+  return total;
+}
+
+/* Проверка статистики кэша после известной последовательности операций:
+   записи, успешного чтения, чтения отсутствующих объектов, чтения с другой
+   дополнительной информацией, чтения за пределами объекта, добавления данных
+   и записи слишком большого объекта. */
+void
+stats_check (void)
+{
+  HyScanCache *cache;
+  HyScanCacheStats stats;
+  HyScanBuffer *buffer1;
+  HyScanBuffer *buffer2;
+  gchar *data;
+  gchar key[32];
+  gint i;
+
+  cache = HYSCAN_CACHE (hyscan_cached_new_full (STATS_CACHE, memory));
+  data = g_malloc0 (BIG_OBJECT);
+  buffer1 = hyscan_buffer_new ();
+  buffer2 = hyscan_buffer_new ();
+
+  hyscan_buffer_wrap (buffer1, HYSCAN_DATA_BLOB, data, 1024);
+  for (i = 0; i < STATS_SETS; i++)
+    {
+      g_snprintf (key, sizeof (key), "stats-%d", i);
+      if (!hyscan_cache_set (cache, key, "detail", buffer1))
+        g_error ("stats: set error");
+    }
+
+  for (i = 0; i < STATS_SETS; i++)
+    {
+      g_snprintf (key, sizeof (key), "stats-%d", i);
+      if (!hyscan_cache_get (cache, key, "detail", buffer2))
+        g_error ("stats: get error");
+    }
+
+  for (i = 0; i < STATS_MISS; i++)
+    {
+      g_snprintf (key, sizeof (key), "stats-absent-%d", i);
+      if (hyscan_cache_get (cache, key, NULL, buffer2))
+        g_error ("stats: absent object %s is read", key);
+    }
+
+  if (hyscan_cache_get (cache, "stats-0", "other", buffer2))
+    g_error ("stats: object with other detail is read");
+
+  /* Чтение за пределами объекта считается промахом. */
+  if (hyscan_cache_get_range (cache, "stats-0", "detail", 2048, 16, buffer2))
+    g_error ("stats: data beyond the object end is read");
+
+  if (!hyscan_cache_append (cache, "stats-append", NULL, buffer1) ||
+      !hyscan_cache_append (cache, "stats-append", NULL, buffer1))
+    {
+      g_error ("stats: append error");
+    }
+
+  /* Объект больше десятой части кэша не сохраняется. */
+  hyscan_buffer_wrap (buffer1, HYSCAN_DATA_BLOB, data, BIG_OBJECT);
+  if (hyscan_cache_set (cache, "stats-big", NULL, buffer1))
+    g_error ("stats: too big object is stored");
+
+  if (!hyscan_cache_get_stats (cache, &stats))
+    g_error ("stats: can't get stats");
+
+  if (stats.hits != STATS_SETS)
+    g_error ("stats: hits %" G_GUINT64_FORMAT ", expected %d", stats.hits, STATS_SETS);
+  if (stats.misses != STATS_MISS + 1)
+    g_error ("stats: misses %" G_GUINT64_FORMAT ", expected %d", stats.misses, STATS_MISS + 1);
+  if (stats.detail_mismatches != 1)
+    g_error ("stats: detail mismatches %" G_GUINT64_FORMAT ", expected 1", stats.detail_mismatches);
+  if (stats.sets != STATS_SETS + 2)
+    g_error ("stats: sets %" G_GUINT64_FORMAT ", expected %d", stats.sets, STATS_SETS + 2);
+  if (stats.rejected != 1)
+    g_error ("stats: rejected %" G_GUINT64_FORMAT ", expected 1", stats.rejected);
+  if (stats.evictions != 0)
+    g_error ("stats: evictions %" G_GUINT64_FORMAT ", expected 0", stats.evictions);
+  if (stats.n_objects != STATS_SETS + 1)
+    g_error ("stats: objects %" G_GUINT64_FORMAT ", expected %d", stats.n_objects, STATS_SETS + 1);
+
+  /* Отвергнутая запись не учитывается в гистограмме. */
+  if (latency_total (stats.latency[HYSCAN_CACHE_OP_SET]) != STATS_SETS)
+    g_error ("stats: set latency total mismatch");
+  if (latency_total (stats.latency[HYSCAN_CACHE_OP_GET]) != STATS_SETS + STATS_MISS + 2)
+    g_error ("stats: get latency total mismatch");
+  if (latency_total (stats.latency[HYSCAN_CACHE_OP_APPEND]) != 2)
+    g_error ("stats: append latency total mismatch");
+
+  g_message ("stats: counters match operations");
+
+  g_object_unref (buffer1);
+  g_object_unref (buffer2);
+  g_object_unref (cache);
+  g_free (data);
+}
+
+/* Проверка статистики сервера: после завершения тестовых потоков отдельный
+   клиент выполняет известное число запросов, приращения счётчиков запросов
+   и счётчиков кэша должны им соответствовать. */
+void
+server_stats_check (void)
+{
+  HyScanCacheServerStats *before;
+  HyScanCacheServerStats *after;
+  HyScanCache *client;
+  HyScanBuffer *buffer1;
+  HyScanBuffer *buffer2;
+  gchar key[32];
+  gint i;
+
+  client = HYSCAN_CACHE (hyscan_cache_client_new ("shm://local"));
+  buffer1 = hyscan_buffer_new ();
+  buffer2 = hyscan_buffer_new ();
+  hyscan_buffer_wrap (buffer1, HYSCAN_DATA_BLOB, patterns[0], 1024);
+
+  before = hyscan_cache_client_get_server_stats (HYSCAN_CACHE_CLIENT (client));
+  if (before == NULL)
+    g_error ("server stats: can't get stats");
+
+  for (i = 0; i < STATS_SETS; i++)
+    {
+      g_snprintf (key, sizeof (key), "server-stats-%d", i);
+      if (!hyscan_cache_set (client, key, NULL, buffer1))
+        g_error ("server stats: set error");
+      if (!hyscan_cache_get (client, key, NULL, buffer2))
+        g_error ("server stats: get error");
+    }
+
+  for (i = 0; i < STATS_MISS; i++)
+    {
+      g_snprintf (key, sizeof (key), "server-stats-absent-%d", i);
+      if (hyscan_cache_get (client, key, NULL, buffer2))
+        g_error ("server stats: absent object %s is read", key);
+    }
+
+  after = hyscan_cache_client_get_server_stats (HYSCAN_CACHE_CLIENT (client));
+  if (after == NULL)
+    g_error ("server stats: can't get stats");
+
+  g_message ("server stats: set requests %" G_GUINT64_FORMAT ", get requests %" G_GUINT64_FORMAT
+             ", sessions %u", after->requests[HYSCAN_CACHE_SERVER_PROC_SET],
+             after->requests[HYSCAN_CACHE_SERVER_PROC_GET], after->n_sessions);
+
+  if (after->requests[HYSCAN_CACHE_SERVER_PROC_SET] - before->requests[HYSCAN_CACHE_SERVER_PROC_SET] != STATS_SETS)
+    g_error ("server stats: set requests mismatch");
+  if (after->requests[HYSCAN_CACHE_SERVER_PROC_GET] - before->requests[HYSCAN_CACHE_SERVER_PROC_GET] != STATS_SETS + STATS_MISS)
+    g_error ("server stats: get requests mismatch");
+  if (after->requests[HYSCAN_CACHE_SERVER_PROC_STATS] <= before->requests[HYSCAN_CACHE_SERVER_PROC_STATS])
+    g_error ("server stats: stats request is not counted");
+  if (after->n_sessions < 1)
+    g_error ("server stats: no client sessions");
+
+  if (after->cache.sets - before->cache.sets != STATS_SETS)
+    g_error ("server stats: cache sets mismatch");
+  if (after->cache.hits - before->cache.hits != STATS_SETS)
+    g_error ("server stats: cache hits mismatch");
+  if (after->cache.misses - before->cache.misses != STATS_MISS)
+    g_error ("server stats: cache misses mismatch");
+
+  hyscan_cache_server_stats_free (before);
+  hyscan_cache_server_stats_free (after);
+  g_object_unref (buffer1);
+  g_object_unref (buffer2);
+  g_object_unref (client);
+}
+
 int
 main (int argc, char **argv)
 {
-  HyScanCached *cached;
+  HyScanCache *cached;
   GThread *small_data_writer_thread;
   GThread *big_data_writer_thread;
   GThread **threads;
   GTimer *timer;
+  GRand *pattern_rand;
+  guint64 *known_hashes = NULL;
+  guint n_loops = 0;
+  GPid *children = NULL;
+  gboolean child = FALSE;
 
   gint i, j;
 
@@ -210,10 +1336,32 @@ main (int argc, char **argv)
         { "duration", 'd', 0, G_OPTION_ARG_DOUBLE, &duration, "Test duration, seconds", NULL },
         { "cache-size", 'm', 0, G_OPTION_ARG_INT, &cache_size, "Cache size, Mb", NULL },
         { "rpc", 'c', 0, G_OPTION_ARG_NONE, &rpc, "Use rpc interface", NULL },
+        { "shm", 'x', 0, G_OPTION_ARG_NONE, &shm, "Use shared memory cache", NULL },
+        { "processes", 'P', 0, G_OPTION_ARG_INT, &n_processes, "Number of processes sharing shared memory cache", NULL },
+        { "numa", 'a', 0, G_OPTION_ARG_NONE, &numa, "Use numa aware cache", NULL },
+        { "memory", 'g', 0, G_OPTION_ARG_INT, &memory, "Memory mode: 0 - heap, 1 - transparent huge pages, 2 - huge pages", NULL },
         { "preload", 'l', 0, G_OPTION_ARG_NONE, &preload, "Preload cache with data", NULL },
         { "patterns", 'p', 0, G_OPTION_ARG_INT, &n_patterns, "Number of testing patterns", NULL },
         { "threads", 't', 0, G_OPTION_ARG_INT, &n_threads, "Number of working threads", NULL },
         { "updates", 'u', 0, G_OPTION_ARG_NONE, &update, "Update cache data during test", NULL },
+        { "append", 'e', 0, G_OPTION_ARG_NONE, &append, "Update cache data using append", NULL },
+        { "range", 'r', 0, G_OPTION_ARG_NONE, &range, "Read parts of objects", NULL },
+        { "vector", 'v', 0, G_OPTION_ARG_NONE, &vector, "Update cache data from several buffers", NULL },
+        { "query", 'q', 0, G_OPTION_ARG_NONE, &query, "Query object sizes instead of reading data", NULL },
+        { "key128", 'k', 0, G_OPTION_ARG_NONE, &key128, "Use 128-bit keys", NULL },
+        { "verify", 'y', 0, G_OPTION_ARG_NONE, &verify, "Store and verify 128-bit key strings", NULL },
+        { "checksums", 'z', 0, G_OPTION_ARG_NONE, &checksums, "Enable data checksums and background scrubbing", NULL },
+        { "prefetch", 'f', 0, G_OPTION_ARG_NONE, &prefetch, "Read objects sequentially with prefetch", NULL },
+        { "channels", 'n', 0, G_OPTION_ARG_INT, &n_channels, "Share one rpc client with this number of channels", NULL },
+        { "near-cache", 'w', 0, G_OPTION_ARG_INT, &near_size, "Rpc client near cache size, Mb", NULL },
+        { "large", 'L', 0, G_OPTION_ARG_INT, &large_size, "Measure 16 Mb .. this size (Mb) objects throughput", NULL },
+        { "direct", 'D', 0, G_OPTION_ARG_NONE, &direct, "Read rpc objects directly into test memory", NULL },
+        { "snapshot", 'S', 0, G_OPTION_ARG_NONE, &snapshot, "Save cache to file and load it into a new cache", NULL },
+        { "evictions", 'E', 0, G_OPTION_ARG_NONE, &evictions, "Check eviction notifications", NULL },
+        { "pressure", 'M', 0, G_OPTION_ARG_NONE, &pressure, "Shrink cache under system memory pressure", NULL },
+        { "watermarks", 'W', 0, G_OPTION_ARG_NONE, &watermarks, "Evict objects in background between watermarks", NULL },
+        { "scan", 'j', 0, G_OPTION_ARG_NONE, &scan, "Check that sequential scan does not evict hot objects", NULL },
+        { "batch", 'i', 0, G_OPTION_ARG_INT, &batch, "Read and update objects in batches of this size", NULL },
         { "objects", 'o', 0, G_OPTION_ARG_INT, &n_objects, "Number of unique objects", NULL },
         { "small-size", 's', 0, G_OPTION_ARG_INT, &small_size, "Maximum small objects size, bytes", NULL },
         { "big-size", 'b', 0, G_OPTION_ARG_INT, &big_size, "Maximum big objects size, bytes", NULL },
@@ -266,17 +1414,122 @@ main (int argc, char **argv)
   if (big_size % 2 != 0)
     big_size -= 1;
 
+  if (direct && !rpc)
+    direct = FALSE;
+
+  if (snapshot && numa)
+    snapshot = FALSE;
+
+  if (evictions && (numa || shm))
+    evictions = FALSE;
+
+  if (pressure && numa)
+    pressure = FALSE;
+
+  if (watermarks && (numa || shm))
+    watermarks = FALSE;
+
+  if (large_size > MAX_LARGE)
+    large_size = MAX_LARGE;
+
+  if (batch > MAX_BATCH)
+    batch = MAX_BATCH;
+  if (batch < 0)
+    batch = 0;
+
+  /* Процессы, работающие с общим кэшем, создают сегмент одновременно. */
+  if (shm)
+    hyscan_cache_shm_unlink ("cache-test");
+
+#ifdef G_OS_UNIX
+  if (shm && n_processes > 1)
+    {
+      children = g_new0 (GPid, n_processes);
+      for (i = 1; i < n_processes; i++)
+        {
+          children[i] = fork ();
+          if (children[i] < 0)
+            g_error ("can't start test process");
+
+          if (children[i] == 0)
+            {
+              child = TRUE;
+              break;
+            }
+        }
+    }
+#endif
+
   /* Создаём кэш. */
-  cached = hyscan_cached_new (cache_size);
+  if (numa)
+    cached = HYSCAN_CACHE (hyscan_cache_numa_new (cache_size));
+  else
+    cached = HYSCAN_CACHE (hyscan_cached_new_full (cache_size, memory));
+
+  if (verify && numa)
+    hyscan_cache_numa_set_key_verification (HYSCAN_CACHE_NUMA (cached), TRUE);
+  else if (verify)
+    hyscan_cached_set_key_verification (HYSCAN_CACHED (cached), TRUE);
+  if (checksums && numa)
+    {
+      hyscan_cache_numa_set_checksums (HYSCAN_CACHE_NUMA (cached), TRUE);
+      hyscan_cache_numa_set_scrub_rate (HYSCAN_CACHE_NUMA (cached), 256);
+    }
+  else if (checksums)
+    {
+      hyscan_cached_set_checksums (HYSCAN_CACHED (cached), TRUE);
+      hyscan_cached_set_scrub_rate (HYSCAN_CACHED (cached), 256);
+    }
+  /* Отслеживание нехватки памяти доступно не во всех системах. */
+  if (pressure && !hyscan_cached_set_pressure_monitor (HYSCAN_CACHED (cached), TRUE))
+    g_message ("memory pressure monitor is not available");
+
+  if (watermarks && !hyscan_cached_set_watermarks (HYSCAN_CACHED (cached), LOW_MARK, HIGH_MARK))
+    g_error ("can't set watermarks");
+
+  /* Функция обработки удаления объектов заменяется во время теста. */
+  if (evictions)
+    {
+      known_keys = known_keys_new (&known_hashes);
+      hyscan_cached_set_evict_func (HYSCAN_CACHED (cached), evict_count,
+                                    g_new0 (EvictCounter, 1), evict_counter_free);
+    }
+
   if (rpc)
     {
-      server = hyscan_cache_server_new ("shm://local", HYSCAN_CACHE (cached),
-                                        n_threads, n_threads + 2);
+      /* Два дополнительных канала используются при проверке ближнего кэша. */
+      server = hyscan_cache_server_new ("shm://local", cached,
+                                        n_threads, n_threads + 4 + n_channels);
       if (!hyscan_cache_server_start(server))
         g_error ("can't start cache server");
 
+      /* Все потоки используют одного клиента с пулом каналов. */
+      if (n_channels > 0)
+        {
+          cache[0] = HYSCAN_CACHE (hyscan_cache_client_new_full ("shm://local", n_channels));
+          for (i = 1; i < n_threads + 2; i++)
+            cache[i] = HYSCAN_CACHE (g_object_ref (cache[0]));
+        }
+      else
+        {
+          for (i = 0; i < n_threads + 2; i++)
+            cache[i] = HYSCAN_CACHE (hyscan_cache_client_new ("shm://local"));
+        }
+
+      /* Ближний кэш клиентов со временем аренды объектов 50 мс. */
+      if (near_size > 0)
+        {
+          for (i = 0; i < n_threads + 2; i++)
+            {
+              hyscan_cache_client_set_near_cache (HYSCAN_CACHE_CLIENT (cache[i]),
+                                                  (gsize) near_size * 1024 * 1024, 50);
+            }
+        }
+    }
+  else if (shm)
+    {
       for (i = 0; i < n_threads + 2; i++)
-        cache[i] = HYSCAN_CACHE (hyscan_cache_client_new ("shm://local"));
+        cache[i] = HYSCAN_CACHE (hyscan_cache_shm_new ("cache-test", cache_size));
     }
   else
     {
@@ -284,16 +1537,24 @@ main (int argc, char **argv)
         cache[i] = HYSCAN_CACHE (g_object_ref (cached));
     }
 
+  if (prefetch)
+    prefetcher = hyscan_cache_prefetch_new (2);
+
+  if (large_size > 0)
+    large_benchmark (cache[0], cache[2]);
+
   /* Шаблоны тестирования. */
   g_message ("creating test patterns");
   pattern_size = big_size > small_size ? big_size : small_size;
   patterns = g_malloc (n_patterns * sizeof(gint8*));
+  pattern_rand = (children != NULL) ? g_rand_new_with_seed (n_patterns) : g_rand_new ();
   for (i = 0; i < n_patterns; i++)
     {
       patterns[i] = g_malloc (pattern_size);
       for (j = 0; j < pattern_size; j++)
-        patterns[i][j] = g_random_int ();
+        patterns[i][j] = g_rand_int (pattern_rand);
     }
+  g_rand_free (pattern_rand);
 
   /* Потоки записи данных в кэш. */
   small_data_writer_thread = g_thread_new ("test-thread", data_writer, GINT_TO_POINTER( 0 ));
@@ -319,7 +1580,15 @@ main (int argc, char **argv)
   /* Тестирование в течение указанного времени. */
   timer = g_timer_new ();
   while (g_timer_elapsed (timer, NULL) < duration)
-    g_usleep (10000);
+    {
+      g_usleep (10000);
+
+      if (evictions && (++n_loops % 10) == 0)
+        {
+          hyscan_cached_set_evict_func (HYSCAN_CACHED (cached), evict_count,
+                                        g_new0 (EvictCounter, 1), evict_counter_free);
+        }
+    }
 
   /* Сигнализация о завершении теста. */
   g_atomic_int_set (&stop, 1);
@@ -337,14 +1606,126 @@ main (int argc, char **argv)
   g_thread_join (small_data_writer_thread);
   g_thread_join (big_data_writer_thread);
 
+  if (evictions)
+    hyscan_cached_set_evict_func (HYSCAN_CACHED (cached), NULL, NULL, NULL);
+
+  if (prefetch)
+    {
+      guint64 produced, cancelled;
+
+      hyscan_cache_prefetch_get_stats (prefetcher, &produced, &cancelled);
+      g_message ("prefetch produced %" G_GUINT64_FORMAT ", cancelled %" G_GUINT64_FORMAT,
+                 produced, cancelled);
+
+      g_clear_object (&prefetcher);
+    }
+
+  if (snapshot)
+    snapshot_check (cached);
+
+  if (watermarks)
+    watermarks_check (cached);
+
+  if (scan)
+    scan_check ();
+
+  if (rpc && near_size > 0)
+    near_check ();
+
+  if (rpc && batch > 0)
+    batch_check (cache[0]);
+
+  if (direct)
+    direct_check (cache[0]);
+
+  if (checksums && !numa)
+    checksums_check (cached);
+
+  if (append)
+    append_check (cache[0]);
+
+  if (rpc && vector)
+    vector_check (cache[0]);
+
+  stats_check ();
+
+  if (rpc)
+    server_stats_check ();
+
   for (i = 0; i < n_patterns; i++)
     g_free (patterns[i]);
   g_free (patterns);
 
+  {
+    HyScanCacheStats stats;
+
+    if (hyscan_cache_get_stats (cached, &stats))
+      {
+        g_message ("hits %" G_GUINT64_FORMAT ", misses %" G_GUINT64_FORMAT ", sets %" G_GUINT64_FORMAT
+                   ", evictions %" G_GUINT64_FORMAT ", objects %" G_GUINT64_FORMAT,
+                   stats.hits, stats.misses, stats.sets, stats.evictions, stats.n_objects);
+
+        /* Сообщения должны быть получены обо всех вытесненных объектах. */
+        if (evictions)
+          {
+            g_message ("evict notifications: capacity %d, other %d", evicted_capacity, evicted_other);
+
+            if (stats.evictions == 0)
+              g_error ("no objects were evicted");
+            if (stats.evictions != (guint64) evicted_capacity)
+              g_error ("evict notifications mismatch %d != %" G_GUINT64_FORMAT, evicted_capacity, stats.evictions);
+          }
+      }
+  }
+
+  if (rpc && near_size > 0)
+    {
+      guint64 near_hits, near_expired;
+
+      hyscan_cache_client_get_near_stats (HYSCAN_CACHE_CLIENT (cache[2]), &near_hits, &near_expired);
+      g_message ("near cache hits %" G_GUINT64_FORMAT ", expired %" G_GUINT64_FORMAT,
+                 near_hits, near_expired);
+    }
+
+  if (numa)
+    {
+      guint64 local_hits, remote_hits, misses;
+
+      hyscan_cache_numa_get_hits (HYSCAN_CACHE_NUMA (cached), &local_hits, &remote_hits, &misses);
+      g_message ("numa nodes %u, local hits %" G_GUINT64_FORMAT ", remote hits %" G_GUINT64_FORMAT
+                 ", misses %" G_GUINT64_FORMAT, hyscan_cache_numa_get_n_nodes (HYSCAN_CACHE_NUMA (cached)),
+                 local_hits, remote_hits, misses);
+    }
+
   for (i = 0; i < n_threads + 2; i++)
     g_clear_object (&cache[i]);
   g_clear_object (&server);
   g_clear_object (&cached);
 
+#ifdef G_OS_UNIX
+  /* Ожидаем завершения дополнительных процессов. */
+  if (children != NULL && !child)
+    {
+      for (i = 1; i < n_processes; i++)
+        {
+          gint status;
+
+          if (waitpid (children[i], &status, 0) != children[i] ||
+              !WIFEXITED (status) || WEXITSTATUS (status) != 0)
+            {
+              g_error ("test process %d failed", i);
+            }
+        }
+    }
+#endif
+
+  g_free (children);
+
+  g_clear_pointer (&known_keys, g_hash_table_unref);
+  g_free (known_hashes);
+
+  if (shm && !child)
+    hyscan_cache_shm_unlink ("cache-test");
+
   return 0;
 }
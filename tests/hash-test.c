@@ -0,0 +1,238 @@
+#include <hyscan-hash.h>
+#include <hyscan-cache-key.h>
+#include <string.h>
+
+#define MAX_LENGTH (1024)
+
+/* Эталонные значения хэшей строк вида "ahov..." длиной length. Значения
+   не должны зависеть от процессора и параметров сборки библиотеки. */
+typedef struct
+{
+  guint        length;
+  guint64      hash;
+} HashVector;
+
+static const HashVector vectors[] =
+{
+  {    0, G_GUINT64_CONSTANT (0x9ae16a3b2f90404f) },
+  {    1, G_GUINT64_CONSTANT (0xb3454265b6df75e3) },
+  {    3, G_GUINT64_CONSTANT (0x2d5b0cbcc48fdc6b) },
+  {    8, G_GUINT64_CONSTANT (0x93b52af6d9b92820) },
+  {   15, G_GUINT64_CONSTANT (0xa3a2d5a9cab38c6b) },
+  {   16, G_GUINT64_CONSTANT (0xf496a3696582095e) },
+  {   17, G_GUINT64_CONSTANT (0x1f0c64814df23a1a) },
+  {   31, G_GUINT64_CONSTANT (0x08b2aebb06a4ade5) },
+  {   32, G_GUINT64_CONSTANT (0x9636decce0f119bc) },
+  {   33, G_GUINT64_CONSTANT (0xb0b8caf511da15b0) },
+  {   63, G_GUINT64_CONSTANT (0x24a2424101bc92f1) },
+  {   64, G_GUINT64_CONSTANT (0x28d7b31d1d69208d) },
+  {   65, G_GUINT64_CONSTANT (0x6ed6772e39738fa7) },
+  {   96, G_GUINT64_CONSTANT (0x56849137cd615794) },
+  {   97, G_GUINT64_CONSTANT (0xc8ec84d467837431) },
+  {  255, G_GUINT64_CONSTANT (0xd136d749c7170b37) },
+  {  256, G_GUINT64_CONSTANT (0x2ab95468a424bfc2) },
+  {  257, G_GUINT64_CONSTANT (0xe7c1a25904d67346) },
+  {  511, G_GUINT64_CONSTANT (0x7fb3ebef2f015b45) },
+  {  512, G_GUINT64_CONSTANT (0x7960c7eb9d55e5cb) },
+  {  600, G_GUINT64_CONSTANT (0x3a0dbd26adda4a6b) },
+  { 1024, G_GUINT64_CONSTANT (0x6094d7e076e52697) }
+};
+
+/* Эталонные значения 128-ми битных хэшей тех же строк. */
+typedef struct
+{
+  guint        length;
+  guint64      lo;
+  guint64      hi;
+} Hash128Vector;
+
+static const Hash128Vector vectors128[] =
+{
+  {    0, G_GUINT64_CONSTANT (0x3df09dfc64c09a2b), G_GUINT64_CONSTANT (0x3cb540c392e51e29) },
+  {    1, G_GUINT64_CONSTANT (0x6e97d6bbdfc0a0c4), G_GUINT64_CONSTANT (0x52a71e38f43be561) },
+  {   16, G_GUINT64_CONSTANT (0x01bbf31e1ad0de6c), G_GUINT64_CONSTANT (0x4358df82fb90ce24) },
+  {   17, G_GUINT64_CONSTANT (0xe08c9bbdd3bcd4de), G_GUINT64_CONSTANT (0xf12f232161dc2a0a) },
+  {   33, G_GUINT64_CONSTANT (0x2208d79777137ae9), G_GUINT64_CONSTANT (0x8752c42ccb3b735f) },
+  {   64, G_GUINT64_CONSTANT (0xcdb4aafbe8552d77), G_GUINT64_CONSTANT (0x576cf85eb81f53d5) },
+  {   65, G_GUINT64_CONSTANT (0x32582807a03cb08c), G_GUINT64_CONSTANT (0x4447412b8b7f3484) },
+  {  128, G_GUINT64_CONSTANT (0xbec1377f9a0a7206), G_GUINT64_CONSTANT (0x452be19d5fa5c804) },
+  {  255, G_GUINT64_CONSTANT (0xda33ab7b7a418b15), G_GUINT64_CONSTANT (0x22e2a044f9abf68c) },
+  {  600, G_GUINT64_CONSTANT (0xb3a86432276aad5c), G_GUINT64_CONSTANT (0x55d24618f7d0a421) },
+  { 1024, G_GUINT64_CONSTANT (0x947c9e2648de8853), G_GUINT64_CONSTANT (0x7937236269cc2e6f) }
+};
+
+int
+main (int argc, char **argv)
+{
+  gint n_iterations = 10000000;
+  gchar data[MAX_LENGTH + 8];
+  GTimer *timer;
+  guint i;
+
+  /* Разбор командной строки. */
+  {
+    gchar **args;
+    GError *error = NULL;
+    GOptionContext *context;
+    GOptionEntry entries[] =
+      {
+        { "iterations", 'n', 0, G_OPTION_ARG_INT, &n_iterations, "Number of iterations for each key length", NULL },
+        { NULL }
+      };
+
+#ifdef G_OS_WIN32
+    args = g_win32_get_command_line ();
+#else
+    args = g_strdupv (argv);
+#endif
+
+    context = g_option_context_new ("");
+    g_option_context_set_help_enabled (context, TRUE);
+    g_option_context_add_main_entries (context, entries, NULL);
+    g_option_context_set_ignore_unknown_options (context, FALSE);
+    if (!g_option_context_parse_strv (context, &args, &error))
+      {
+        g_print ("%s\n", error->message);
+        return -1;
+      }
+
+    g_option_context_free (context);
+    g_strfreev (args);
+  }
+
+  for (i = 0; i < sizeof (data); i++)
+    data[i] = 'a' + (i * 7) % 26;
+
+  /* Проверка значений хэшей. */
+  for (i = 0; i < G_N_ELEMENTS (vectors); i++)
+    {
+      gchar *key = g_strndup (data, vectors[i].length);
+      guint64 hash = hyscan_hash64 (key);
+
+      if (hash != vectors[i].hash)
+        {
+          g_error ("hash mismatch for length %u: 0x%016" G_GINT64_MODIFIER "x != 0x%016" G_GINT64_MODIFIER "x",
+                   vectors[i].length, hash, vectors[i].hash);
+        }
+
+      g_free (key);
+    }
+
+  if (hyscan_hash64 (NULL) != 0)
+    g_error ("hash of NULL key is not zero");
+
+  for (i = 0; i < G_N_ELEMENTS (vectors128); i++)
+    {
+      gchar *key = g_strndup (data, vectors128[i].length);
+      guint64 lo, hi;
+
+      hyscan_hash128 (key, &lo, &hi);
+      if (lo != vectors128[i].lo || hi != vectors128[i].hi)
+        {
+          g_error ("hash128 mismatch for length %u: 0x%016" G_GINT64_MODIFIER "x%016" G_GINT64_MODIFIER "x",
+                   vectors128[i].length, hi, lo);
+        }
+
+      g_free (key);
+    }
+
+  /* Проверка построения ключей. */
+  {
+    HyScanCacheKey prefix, key1, key2;
+
+    hyscan_cache_key_init (&prefix, "Project.Track.Channel");
+    if (hyscan_cache_key_get (&prefix) != hyscan_hash64 ("Project.Track.Channel"))
+      g_error ("key prefix mismatch");
+
+    key1 = prefix;
+    hyscan_cache_key_add_int (&key1, 12);
+    hyscan_cache_key_add_int (&key1, 345);
+    if (hyscan_cache_key_get (&key1) != G_GUINT64_CONSTANT (0xb43d460a92a88323))
+      g_error ("integer key mismatch");
+
+    key2 = prefix;
+    hyscan_cache_key_add_int (&key2, 345);
+    hyscan_cache_key_add_int (&key2, 12);
+    if (hyscan_cache_key_get (&key1) == hyscan_cache_key_get (&key2))
+      g_error ("key does not depend on components order");
+
+    key2 = prefix;
+    hyscan_cache_key_add_string (&key2, "Line");
+    if (hyscan_cache_key_get (&key2) != G_GUINT64_CONSTANT (0xdec839346e251f8d))
+      g_error ("string key mismatch");
+  }
+
+  g_message ("hash values ok");
+
+  /* Скорость вычисления хэшей ключей типичной длины. */
+  timer = g_timer_new ();
+  for (i = 16; i <= 128; i *= 2)
+    {
+      volatile guint64 sum = 0;
+      gchar *keys[8];
+      gdouble elapsed;
+      gdouble elapsed128;
+      gint j;
+
+      for (j = 0; j < 8; j++)
+        keys[j] = g_strndup (data + j, i);
+
+      g_timer_start (timer);
+      for (j = 0; j < n_iterations; j++)
+        sum += hyscan_hash64 (keys[j % 8]);
+      elapsed = g_timer_elapsed (timer, NULL);
+
+      g_timer_start (timer);
+      for (j = 0; j < n_iterations; j++)
+        {
+          guint64 lo, hi;
+
+          hyscan_hash128 (keys[j % 8], &lo, &hi);
+          sum += lo ^ hi;
+        }
+      elapsed128 = g_timer_elapsed (timer, NULL);
+
+      g_message ("key length %3u: %.2f ns/hash, 128-bit %.2f ns/hash", i,
+                 (1e9 * elapsed) / n_iterations, (1e9 * elapsed128) / n_iterations);
+
+      for (j = 0; j < 8; j++)
+        g_free (keys[j]);
+    }
+
+  /* Сравнение построения ключа из строки и из составляющих. */
+  {
+    volatile guint64 sum = 0;
+    HyScanCacheKey prefix;
+    gdouble string_time;
+    gdouble key_time;
+    gint j;
+
+    g_timer_start (timer);
+    for (j = 0; j < n_iterations; j++)
+      {
+        gchar *key = g_strdup_printf ("Project.Track.Channel.%d.%d", j / 1000, j % 1000);
+        sum += hyscan_hash64 (key);
+        g_free (key);
+      }
+    string_time = g_timer_elapsed (timer, NULL);
+
+    hyscan_cache_key_init (&prefix, "Project.Track.Channel");
+    g_timer_start (timer);
+    for (j = 0; j < n_iterations; j++)
+      {
+        HyScanCacheKey key = prefix;
+
+        hyscan_cache_key_add_int (&key, j / 1000);
+        hyscan_cache_key_add_int (&key, j % 1000);
+        sum += hyscan_cache_key_get (&key);
+      }
+    key_time = g_timer_elapsed (timer, NULL);
+
+    g_message ("string key: %.2f ns/key, key builder: %.2f ns/key",
+               (1e9 * string_time) / n_iterations, (1e9 * key_time) / n_iterations);
+  }
+
+  g_timer_destroy (timer);
+
+  return 0;
+}